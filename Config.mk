@@ -28,10 +28,29 @@ BIN_DIR := $(OUTPUT_DIR)/bin
 USER_INCLUDE := $(ROOT_DIR)/include
 USER_SRC := $(ROOT_DIR)/src
 
+TOOLS_DIR := $(ROOT_DIR)/tools
+TOOLS_OUTPUT_DIR := $(OUTPUT_DIR)/tools
+
+BENCH_DIR := $(ROOT_DIR)/benchmarks
+BENCH_OUTPUT_DIR := $(OUTPUT_DIR)/benchmarks
+
+TESTS_DIR := $(ROOT_DIR)/tests
+TESTS_OUTPUT_DIR := $(OUTPUT_DIR)/tests
+
 OUTPUT_EXEC := $(OUTPUT_EXEC_NAME)$(EXEC_EXT)
 
 # Setup toolchain
 TOOLCHAIN := 
 
 CC := $(TOOLCHAIN)gcc
-CFLAGS := -Wall -Werror
\ No newline at end of file
+CFLAGS := -Wall -Werror
+
+# Benchmarks are built optimized, with their own copies of the objects they link
+# BENCH_SIMD=avx2|ssse3 opts into the wider x86 paths (image_ops.h kernels, cull.c)
+BENCH_CFLAGS := $(CFLAGS) -O2
+
+ifeq ($(BENCH_SIMD),avx2)
+BENCH_CFLAGS += -mavx2
+else ifeq ($(BENCH_SIMD),ssse3)
+BENCH_CFLAGS += -mssse3
+endif
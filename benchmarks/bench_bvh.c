@@ -0,0 +1,179 @@
+/*
+  BVH benchmark: build time (serial and parallel), refit, and query
+  throughput for frustum, range and ray queries over random boxes.
+  Usage: bench_bvh [primitive count, default 1000000]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <bvh.h>
+#include <cull.h>
+#include <platform.h>
+#include <threading.h>
+
+#define WORLD_SIZE      1000.0f
+#define FRUSTUM_QUERIES 1000
+#define RANGE_QUERIES   100000
+#define RAY_QUERIES     1000000
+#define UPDATE_FRACTION 100     // 1 primitive out of N moves per update pass
+#define VERIFY_QUERIES  16
+
+static uint32_t rng_state = 0x12345678u;
+
+static inline float random_float(float lo, float hi)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return lo + (hi - lo) * (float)(rng_state & 0xffffffu) / (float)0xffffff;
+}
+
+static inline Vector3 random_point(float lo, float hi)
+{
+  return (Vector3){random_float(lo, hi), random_float(lo, hi), random_float(lo, hi)};
+}
+
+static BvhBounds random_box(Vector3 center)
+{
+  Vector3 half = {random_float(0.25f, 1.0f), random_float(0.25f, 1.0f), random_float(0.25f, 1.0f)};
+  return (BvhBounds){Vector3Subtract(center, half), Vector3Add(center, half)};
+}
+
+static Frustum random_frustum(void)
+{
+  Vector3 eye = random_point(0.0f, WORLD_SIZE);
+  Vector3 target = random_point(0.0f, WORLD_SIZE);
+  Matrix view = MatrixLookAt(eye, target, (Vector3){0.0f, 1.0f, 0.0f});
+  Matrix projection = MatrixPerspective(60.0f * DEG2RAD, 16.0f / 9.0f, 0.1, 250.0);
+  return frustum_from_matrix(MatrixMultiply(view, projection));
+}
+
+// Reference for the frustum query: same plane tests as the BVH leaves
+static uint32_t brute_force_frustum(const BvhBounds *bounds, uint32_t count, const Frustum *frustum)
+{
+  uint32_t visible = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    bool inside = true;
+    for (int k = 0; k < 6 && inside; k++) {
+      Vector4 p = frustum->planes[k];
+      float d = p.x * (p.x > 0.0f ? bounds[i].max.x : bounds[i].min.x) +
+                p.y * (p.y > 0.0f ? bounds[i].max.y : bounds[i].min.y) +
+                p.z * (p.z > 0.0f ? bounds[i].max.z : bounds[i].min.z) + p.w;
+      inside = d >= 0.0f;
+    }
+    visible += inside;
+  }
+  return visible;
+}
+
+static void report(const char *name, double seconds, uint32_t operations, const char *unit)
+{
+  printf(
+    "  - %-22s: %9.3f ms, %12.0f %s/s\n",
+    name, seconds * 1000.0, seconds > 0.0 ? operations / seconds : 0.0, unit
+  );
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t count = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+  if (count == 0) {
+    fprintf(stderr, "[ERROR]: Invalid primitive count\n");
+    return EXIT_FAILURE;
+  }
+
+  BvhBounds *bounds = malloc(count * sizeof(BvhBounds));
+  uint32_t *out = malloc(count * sizeof(uint32_t));
+  ThreadPool *pool = thread_pool_create(0);
+  if (bounds == NULL || out == NULL || pool == NULL) {
+    fprintf(stderr, "[ERROR]: Out of memory\n");
+    return EXIT_FAILURE;
+  }
+
+  for (uint32_t i = 0; i < count; i++) bounds[i] = random_box(random_point(0.0f, WORLD_SIZE));
+
+  printf("[BENCH]: bvh, %u primitives, %u threads\n", count, thread_pool_size(pool));
+
+  Bvh bvh;
+  double start = platform_time();
+  if (!bvh_build(&bvh, bounds, count, NULL)) return EXIT_FAILURE;
+  report("build (1 thread)", platform_time() - start, count, "prims");
+  bvh_free(&bvh);
+
+  start = platform_time();
+  if (!bvh_build(&bvh, bounds, count, pool)) return EXIT_FAILURE;
+  report("build (parallel)", platform_time() - start, count, "prims");
+  printf("  - %-22s: %u (%.1f MB)\n", "nodes", bvh.node_count, bvh.node_count * sizeof(BvhNode) / (1024.0 * 1024.0));
+
+  // Move a subset, once incrementally and once through a full refit
+  uint32_t moved = count / UPDATE_FRACTION;
+  start = platform_time();
+  for (uint32_t i = 0; i < moved; i++) {
+    uint32_t primitive = (i * UPDATE_FRACTION) % count;
+    bvh_update(&bvh, primitive, random_box(Vector3Add(random_point(-1.0f, 1.0f), bounds[primitive].min)));
+  }
+  report("incremental updates", platform_time() - start, moved, "updates");
+
+  for (uint32_t i = 0; i < moved; i++) {
+    uint32_t primitive = (i * UPDATE_FRACTION + 1) % count;
+    bvh_set_bounds(&bvh, primitive, random_box(Vector3Add(random_point(-1.0f, 1.0f), bounds[primitive].min)));
+  }
+  start = platform_time();
+  bvh_refit(&bvh);
+  report("full refit", platform_time() - start, bvh.node_count, "nodes");
+
+  // Queries run against the moved boxes, keep the reference in sync
+  memcpy(bounds, bvh.bounds, count * sizeof(BvhBounds));
+
+  uint64_t found = 0;
+  start = platform_time();
+  for (uint32_t i = 0; i < FRUSTUM_QUERIES; i++) {
+    Frustum frustum = random_frustum();
+    found += bvh_query_frustum(&bvh, &frustum, out, count);
+  }
+  report("frustum queries", platform_time() - start, FRUSTUM_QUERIES, "queries");
+  printf("  - %-22s: %.0f\n", "visible per frustum", (double)found / FRUSTUM_QUERIES);
+
+  // Only the brute force scans are timed, the BVH queries checked against them are not
+  double brute_force = 0.0;
+  uint32_t mismatches = 0;
+  for (uint32_t i = 0; i < VERIFY_QUERIES; i++) {
+    Frustum frustum = random_frustum();
+    start = platform_time();
+    uint32_t expected = brute_force_frustum(bounds, count, &frustum);
+    brute_force += platform_time() - start;
+    if (bvh_query_frustum(&bvh, &frustum, out, count) != expected) mismatches++;
+  }
+  report("brute force (verify)", brute_force, VERIFY_QUERIES, "queries");
+  if (mismatches > 0) fprintf(stderr, "[ERROR]: %u frustum queries disagree with brute force\n", mismatches);
+
+  found = 0;
+  start = platform_time();
+  for (uint32_t i = 0; i < RANGE_QUERIES; i++) {
+    Vector3 center = random_point(0.0f, WORLD_SIZE);
+    BvhBounds range = {Vector3SubtractValue(center, 10.0f), Vector3AddValue(center, 10.0f)};
+    found += bvh_query_bounds(&bvh, range, out, count);
+  }
+  report("range queries", platform_time() - start, RANGE_QUERIES, "queries");
+  printf("  - %-22s: %.2f\n", "hits per range", (double)found / RANGE_QUERIES);
+
+  uint32_t hits = 0;
+  start = platform_time();
+  for (uint32_t i = 0; i < RAY_QUERIES; i++) {
+    Vector3 origin = random_point(0.0f, WORLD_SIZE);
+    Vector3 direction = Vector3Normalize(random_point(-1.0f, 1.0f));
+    BvhHit hit;
+    hits += bvh_raycast(&bvh, origin, direction, WORLD_SIZE, NULL, NULL, &hit);
+  }
+  report("raycasts", platform_time() - start, RAY_QUERIES, "rays");
+  printf("  - %-22s: %.1f%%\n", "ray hit rate", 100.0 * hits / RAY_QUERIES);
+
+  bvh_free(&bvh);
+  thread_pool_destroy(pool);
+  free(bounds);
+  free(out);
+  return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,232 @@
+/*
+  ECS benchmark: movement, transform, culling and instance gathering
+  systems over archetype chunks, serial and on the thread pool, next to
+  the same transform pass through random ecs_get lookups.
+  Usage: bench_ecs [entity count, default 1000000]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <ecs.h>
+#include <cull.h>
+#include <platform.h>
+#include <threading.h>
+
+#define WORLD_SIZE 1000.0f
+#define ITERATIONS 10
+
+typedef struct {
+  Vector3 position;
+  float scale;
+} TransformComponent;
+
+typedef struct {
+  Vector3 velocity;
+} VelocityComponent;
+
+typedef struct {
+  Matrix world;
+} WorldComponent;
+
+typedef struct {
+  uint32_t visible;
+} VisibilityComponent;
+
+typedef struct {
+  uint32_t transform;
+  uint32_t velocity;
+  uint32_t world;
+  uint32_t visibility;
+  Frustum frustum;
+  float dt;
+} Systems;
+
+static uint32_t rng_state = 0x9e3779b9u;
+
+static inline float random_float(float lo, float hi)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return lo + (hi - lo) * (float)(rng_state & 0xffffffu) / (float)0xffffff;
+}
+
+static void movement_system(void *user, const EcsView *view, uint32_t worker)
+{
+  const Systems *systems = user;
+  TransformComponent *transforms = ecs_view_column(view, systems->transform);
+  const VelocityComponent *velocities = ecs_view_column(view, systems->velocity);
+
+  for (uint32_t i = 0; i < view->count; i++)
+    transforms[i].position = Vector3Add(transforms[i].position, Vector3Scale(velocities[i].velocity, systems->dt));
+}
+
+// Scale then translate, written out to skip the generic matrix product
+static inline Matrix scale_translate(Vector3 p, float s)
+{
+  return (Matrix){
+    s, 0.0f, 0.0f, p.x,
+    0.0f, s, 0.0f, p.y,
+    0.0f, 0.0f, s, p.z,
+    0.0f, 0.0f, 0.0f, 1.0f,
+  };
+}
+
+static void transform_system(void *user, const EcsView *view, uint32_t worker)
+{
+  const Systems *systems = user;
+  const TransformComponent *transforms = ecs_view_column(view, systems->transform);
+  WorldComponent *worlds = ecs_view_column(view, systems->world);
+
+  for (uint32_t i = 0; i < view->count; i++)
+    worlds[i].world = scale_translate(transforms[i].position, transforms[i].scale);
+}
+
+static void cull_system(void *user, const EcsView *view, uint32_t worker)
+{
+  const Systems *systems = user;
+  const TransformComponent *transforms = ecs_view_column(view, systems->transform);
+  VisibilityComponent *visibility = ecs_view_column(view, systems->visibility);
+  const Vector4 *planes = systems->frustum.planes;
+
+  for (uint32_t i = 0; i < view->count; i++) {
+    Vector3 c = transforms[i].position;
+    float r = transforms[i].scale;
+    uint32_t inside = 1;
+    for (int k = 0; k < 6; k++)
+      inside &= planes[k].x * c.x + planes[k].y * c.y + planes[k].z * c.z + planes[k].w >= -r;
+    visibility[i].visible = inside;
+  }
+}
+
+// Packs visible world matrices contiguously, as an instance buffer upload would
+static uint32_t gather_instances(EcsWorld *world, const Systems *systems, EcsMask mask, Matrix *instances)
+{
+  uint32_t count = 0;
+  EcsQuery query = ecs_query(world, mask);
+  EcsView view;
+
+  while (ecs_query_next(&query, &view)) {
+    const WorldComponent *worlds = ecs_view_column(&view, systems->world);
+    const VisibilityComponent *visibility = ecs_view_column(&view, systems->visibility);
+    for (uint32_t i = 0; i < view.count; i++)
+      if (visibility[i].visible) instances[count++] = worlds[i].world;
+  }
+  return count;
+}
+
+static void report(const char *name, double seconds, uint32_t entities)
+{
+  double per_run = seconds / ITERATIONS;
+  printf("  - %-26s: %8.3f ms, %6.2f ns/entity\n", name, per_run * 1000.0, per_run * 1e9 / entities);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t count = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+  if (count == 0) {
+    fprintf(stderr, "[ERROR]: Invalid entity count\n");
+    return EXIT_FAILURE;
+  }
+
+  EcsWorld world;
+  ecs_init(&world);
+
+  Systems systems;
+  systems.transform = ecs_register_component(&world, sizeof(TransformComponent));
+  systems.velocity = ecs_register_component(&world, sizeof(VelocityComponent));
+  systems.world = ecs_register_component(&world, sizeof(WorldComponent));
+  systems.visibility = ecs_register_component(&world, sizeof(VisibilityComponent));
+  systems.dt = 1.0f / 60.0f;
+
+  // From the middle of the world looking along +x, a fraction of the entities is visible
+  Vector3 eye = {WORLD_SIZE * 0.5f, 50.0f, WORLD_SIZE * 0.5f};
+  Matrix view = MatrixLookAt(eye, (Vector3){WORLD_SIZE, 0.0f, WORLD_SIZE * 0.5f}, (Vector3){0.0f, 1.0f, 0.0f});
+  Matrix projection = MatrixPerspective(60.0f * DEG2RAD, 16.0f / 9.0f, 0.1, WORLD_SIZE * 0.5);
+  systems.frustum = frustum_from_matrix(MatrixMultiply(view, projection));
+
+  const EcsMask moving = ECS_COMPONENT(systems.transform) | ECS_COMPONENT(systems.velocity);
+  const EcsMask renderable = ECS_COMPONENT(systems.transform) | ECS_COMPONENT(systems.world) | ECS_COMPONENT(systems.visibility);
+
+  Entity *entities = malloc(count * sizeof(Entity));
+  Matrix *instances = malloc(count * sizeof(Matrix));
+  ThreadPool *pool = thread_pool_create(0);
+  if (entities == NULL || instances == NULL || pool == NULL) {
+    fprintf(stderr, "[ERROR]: Out of memory\n");
+    return EXIT_FAILURE;
+  }
+
+  double start = platform_time();
+  for (uint32_t i = 0; i < count; i++) {
+    // Half the entities move, so queries span two archetypes
+    entities[i] = ecs_create(&world, renderable | (i % 2 ? ECS_COMPONENT(systems.velocity) : 0));
+    TransformComponent *transform = ecs_get(&world, entities[i], systems.transform);
+    if (transform == NULL) {
+      fprintf(stderr, "[ERROR]: Could not create entity %u\n", i);
+      return EXIT_FAILURE;
+    }
+    transform->position = (Vector3){random_float(0.0f, WORLD_SIZE), random_float(0.0f, 20.0f), random_float(0.0f, WORLD_SIZE)};
+    transform->scale = random_float(0.5f, 2.0f);
+
+    VelocityComponent *velocity = ecs_get(&world, entities[i], systems.velocity);
+    if (velocity) velocity->velocity = (Vector3){random_float(-1.0f, 1.0f), 0.0f, random_float(-1.0f, 1.0f)};
+  }
+
+  printf("[BENCH]: ecs, %u entities, %u archetypes, %u threads\n", count, world.archetype_count, thread_pool_size(pool));
+  printf("  - %-26s: %8.3f ms\n", "create", (platform_time() - start) * 1000.0);
+
+  static const struct { const char *name; bool parallel; } modes[] = {
+    {"serial", false},
+    {"parallel", true},
+  };
+
+  uint32_t visible = 0;
+  for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+    ThreadPool *mode_pool = modes[m].parallel ? pool : NULL;
+    char name[64];
+
+    start = platform_time();
+    for (int it = 0; it < ITERATIONS; it++) ecs_query_parallel(&world, moving, mode_pool, movement_system, &systems);
+    snprintf(name, sizeof(name), "movement (%s)", modes[m].name);
+    report(name, platform_time() - start, count / 2);
+
+    start = platform_time();
+    for (int it = 0; it < ITERATIONS; it++) ecs_query_parallel(&world, renderable, mode_pool, transform_system, &systems);
+    snprintf(name, sizeof(name), "transform (%s)", modes[m].name);
+    report(name, platform_time() - start, count);
+
+    start = platform_time();
+    for (int it = 0; it < ITERATIONS; it++) ecs_query_parallel(&world, renderable, mode_pool, cull_system, &systems);
+    snprintf(name, sizeof(name), "cull (%s)", modes[m].name);
+    report(name, platform_time() - start, count);
+  }
+
+  start = platform_time();
+  for (int it = 0; it < ITERATIONS; it++) visible = gather_instances(&world, &systems, renderable, instances);
+  report("gather instances", platform_time() - start, count);
+  printf("  - %-26s: %u\n", "visible", visible);
+
+  // Same transform pass through handles in random order
+  for (uint32_t i = count - 1; i > 0; i--) {
+    uint32_t j = (uint32_t)(random_float(0.0f, 1.0f) * i);
+    Entity tmp = entities[i]; entities[i] = entities[j]; entities[j] = tmp;
+  }
+  start = platform_time();
+  for (int it = 0; it < ITERATIONS; it++) {
+    for (uint32_t i = 0; i < count; i++) {
+      const TransformComponent *transform = ecs_get(&world, entities[i], systems.transform);
+      WorldComponent *out = ecs_get(&world, entities[i], systems.world);
+      out->world = scale_translate(transform->position, transform->scale);
+    }
+  }
+  report("transform (random get)", platform_time() - start, count);
+
+  thread_pool_destroy(pool);
+  ecs_free(&world);
+  free(entities);
+  free(instances);
+  return EXIT_SUCCESS;
+}
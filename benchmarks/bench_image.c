@@ -0,0 +1,1066 @@
+/*
+  Image decode benchmark: MB/s (decoded pixels) and images/s of stb_image
+  for PNG, JPEG, TGA and HDR, through stbi_load, stbi_load_from_memory and
+  stbi_load_from_callbacks (the stbi_loadf variants for HDR), for several
+  desired_channels values, with vertical flip, and spread over the thread
+  pool with stbi_set_flip_vertically_on_load_thread set per thread.
+  The image_ops.h post-processing kernels (flip, RGB to RGBA, red / blue
+  swap, premultiply, sRGB to linear) are timed against their per byte
+  reference versions on the synthetic pixels, and checked to match them,
+  and 3 channel images also go through the texture_load.h path (decode as
+  RGB, expand with the flip fused in) next to stb_image's own flip and
+  expansion.
+  Inputs are synthesized (smooth gradients, edges and a little noise, so
+  they compress like real textures) at --size (at least IMAGE_MIN_SIZE),
+  written to --dir, and checked by decoding them back before any timing.
+  Image files given on the command line (such as an asset set) are
+  measured the same way.
+  A --large image (4096x4096 by default, 0 skips it) is decoded through
+  texture_decode on 1 to N threads: as JPEG with a restart marker per MCU
+  row (4:4:4 and 4:2:0), which decodes as independent bands, and as PNG,
+  which only has its conversion split. Every result must match the single
+  threaded decode exactly.
+  Usage: bench_image [--size N] [--decodes N] [--large N] [--dir DIR] [image files...]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+
+#include <stb_image.h>
+
+#include <image_write.h>
+#include <image_ops.h>
+#include <texture_load.h>
+#include <platform.h>
+#include <threading.h>
+
+#define IMAGE_DEFAULT_SIZE    1024
+#define IMAGE_MIN_SIZE        32      // Smaller JPEGs are mostly block edges and miss the error bound
+#define IMAGE_DEFAULT_DECODES 16
+#define IMAGE_DEFAULT_LARGE   4096
+#define IMAGE_LARGE_RUNS      3       // Best of, per thread count
+#define IMAGE_MAX_FILES       32
+#define IMAGE_MAX_POOLS       8
+#define IMAGE_PATH_MAX        1024
+#define IMAGE_JPEG_QUALITY    90
+#define IMAGE_HDR_RANGE       4.0f    // Synthetic HDR values span [0, range]
+#define IMAGE_PI              3.14159265358979f
+#define IMAGE_KERNEL_RUNS     5       // Best of, per kernel and version
+
+typedef enum {
+  IMAGE_API_FILE,
+  IMAGE_API_MEMORY,
+  IMAGE_API_CALLBACKS,
+} ImageApi;
+
+typedef struct {
+  char path[IMAGE_PATH_MAX];
+  const char *format;
+  uint8_t *file;          // Whole file, for the memory API
+  size_t file_size;
+  int width;
+  int height;
+  int channels;           // As stored
+  bool hdr;
+} BenchImage;
+
+typedef struct {
+  uint8_t *data;
+  size_t size;
+  size_t capacity;
+  uint32_t bits;          // JPEG entropy coder state
+  uint32_t bit_count;
+  bool failed;
+} ByteBuffer;
+
+typedef struct {
+  const BenchImage *image;
+  ImageApi api;
+  int channels;
+  bool flip;
+  atomic_uint failures;
+} DecodeJob;
+
+static uint32_t rng_state = 0x9e3779b9u;
+
+static inline uint32_t random_u32(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static void buffer_push(ByteBuffer *buffer, const void *data, size_t size)
+{
+  if (buffer->failed) return;
+  if (buffer->size + size > buffer->capacity) {
+    size_t capacity = buffer->capacity ? buffer->capacity * 2 : 65536;
+    while (capacity < buffer->size + size) capacity *= 2;
+    uint8_t *grown = realloc(buffer->data, capacity);
+    if (grown == NULL) {
+      buffer->failed = true;
+      return;
+    }
+    buffer->data = grown;
+    buffer->capacity = capacity;
+  }
+  memcpy(buffer->data + buffer->size, data, size);
+  buffer->size += size;
+}
+
+static inline void buffer_byte(ByteBuffer *buffer, uint8_t byte)
+{
+  buffer_push(buffer, &byte, 1);
+}
+
+static inline void buffer_u16_be(ByteBuffer *buffer, uint32_t value)
+{
+  buffer_byte(buffer, (uint8_t)(value >> 8));
+  buffer_byte(buffer, (uint8_t)value);
+}
+
+static bool buffer_write_file(const ByteBuffer *buffer, const char *path)
+{
+  if (buffer->failed) {
+    fprintf(stderr, "[ERROR]: Out of memory encoding %s\n", path);
+    return false;
+  }
+
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "[ERROR]: Could not open \"%s\" for writing\n", path);
+    return false;
+  }
+  bool ok = fwrite(buffer->data, 1, buffer->size, file) == buffer->size;
+  ok = fclose(file) == 0 && ok;
+  if (!ok) fprintf(stderr, "[ERROR]: Could not write \"%s\"\n", path);
+  return ok;
+}
+
+// Top down RGBA, alpha is a diagonal ramp, rgb (the HDR source) may be NULL
+static void synthesize(uint8_t *rgba, float *rgb, int size)
+{
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      float u = (float)x / size, v = (float)y / size;
+      bool cell = ((x / 64) + (y / 64)) & 1;
+      int noise = (int)(random_u32() % 9) - 4;
+
+      float r = 0.5f + 0.5f * sinf(u * 9.0f + v * 3.0f);
+      float g = 0.5f + 0.5f * cosf(v * 7.0f - u * 2.0f);
+      float b = cell ? 0.8f - 0.5f * u : 0.2f + 0.5f * v;
+
+      uint8_t *p = rgba + ((size_t)y * size + x) * 4;
+      p[0] = (uint8_t)fminf(fmaxf(r * 255.0f + noise, 0.0f), 255.0f);
+      p[1] = (uint8_t)fminf(fmaxf(g * 255.0f + noise, 0.0f), 255.0f);
+      p[2] = (uint8_t)fminf(fmaxf(b * 255.0f + noise, 0.0f), 255.0f);
+      p[3] = (uint8_t)((x + y) * 255 / (2 * size - 2));
+
+      if (rgb == NULL) continue;
+      float *q = rgb + ((size_t)y * size + x) * 3;
+      q[0] = r * r * IMAGE_HDR_RANGE;
+      q[1] = g * g * IMAGE_HDR_RANGE;
+      q[2] = b * b * IMAGE_HDR_RANGE;
+    }
+  }
+}
+
+// Uncompressed 32 bit, top left origin
+static void encode_tga(ByteBuffer *out, const uint8_t *rgba, int width, int height)
+{
+  const uint8_t header[18] = {
+    0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    (uint8_t)width, (uint8_t)(width >> 8), (uint8_t)height, (uint8_t)(height >> 8),
+    32, 0x28,
+  };
+  buffer_push(out, header, sizeof(header));
+
+  for (size_t i = 0; i < (size_t)width * height; i++) {
+    const uint8_t *p = rgba + i * 4;
+    const uint8_t bgra[4] = {p[2], p[1], p[0], p[3]};
+    buffer_push(out, bgra, 4);
+  }
+}
+
+// Radiance RGBE with run length scanlines (literal runs only), width in [8, 32767]
+static void encode_hdr(ByteBuffer *out, const float *rgb, int width, int height, uint8_t *scanline)
+{
+  char header[128];
+  int length = snprintf(header, sizeof(header), "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %d +X %d\n", height, width);
+  buffer_push(out, header, (size_t)length);
+
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const float *p = rgb + ((size_t)y * width + x) * 3;
+      float largest = fmaxf(p[0], fmaxf(p[1], p[2]));
+      uint8_t *e = scanline + x;
+      if (largest < 1e-32f) {
+        e[0] = e[width] = e[width * 2] = e[width * 3] = 0;
+        continue;
+      }
+      int exponent;
+      float scale = frexpf(largest, &exponent) * 256.0f / largest;
+      e[0] = (uint8_t)(p[0] * scale);
+      e[width] = (uint8_t)(p[1] * scale);
+      e[width * 2] = (uint8_t)(p[2] * scale);
+      e[width * 3] = (uint8_t)(exponent + 128);
+    }
+
+    const uint8_t marker[4] = {2, 2, (uint8_t)(width >> 8), (uint8_t)width};
+    buffer_push(out, marker, 4);
+    for (int c = 0; c < 4; c++) {
+      for (int x = 0; x < width; x += 128) {
+        int count = width - x < 128 ? width - x : 128;
+        buffer_byte(out, (uint8_t)count);
+        buffer_push(out, scanline + c * width + x, (size_t)count);
+      }
+    }
+  }
+}
+
+/*
+  Baseline JPEG, 4:4:4 YCbCr with the Annex K quantization and Huffman
+  tables, so the decoder sees what common encoders produce.
+*/
+static const uint8_t jpeg_zigzag[64] = {
+   0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+  12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+  35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+  58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+static const uint8_t jpeg_luma_quant[64] = {
+  16, 11, 10, 16,  24,  40,  51,  61,  12, 12, 14, 19,  26,  58,  60,  55,
+  14, 13, 16, 24,  40,  57,  69,  56,  14, 17, 22, 29,  51,  87,  80,  62,
+  18, 22, 37, 56,  68, 109, 103,  77,  24, 35, 55, 64,  81, 104, 113,  92,
+  49, 64, 78, 87, 103, 121, 120, 101,  72, 92, 95, 98, 112, 100, 103,  99,
+};
+
+static const uint8_t jpeg_chroma_quant[64] = {
+  17, 18, 24, 47, 99, 99, 99, 99,  18, 21, 26, 66, 99, 99, 99, 99,
+  24, 26, 56, 99, 99, 99, 99, 99,  47, 66, 99, 99, 99, 99, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99,
+};
+
+static const uint8_t jpeg_dc_luma_bits[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+static const uint8_t jpeg_dc_chroma_bits[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+static const uint8_t jpeg_dc_values[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+static const uint8_t jpeg_ac_luma_bits[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+static const uint8_t jpeg_ac_luma_values[162] = {
+  0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+  0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+  0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+  0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+  0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+  0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+  0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+  0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+  0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+  0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+  0xf9, 0xfa,
+};
+
+static const uint8_t jpeg_ac_chroma_bits[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+static const uint8_t jpeg_ac_chroma_values[162] = {
+  0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+  0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+  0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+  0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+  0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+  0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+  0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+  0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+  0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+  0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+  0xf9, 0xfa,
+};
+
+typedef struct {
+  uint16_t codes[256];
+  uint8_t lengths[256];
+} JpegHuffman;
+
+typedef struct {
+  JpegHuffman dc[2];
+  JpegHuffman ac[2];
+  float quant[2][64];     // Natural order divisors
+  float cosines[8][8];    // [x][u], with the DCT normalization folded in
+} JpegEncoder;
+
+// Canonical codes from the code length counts
+static void jpeg_huffman_build(JpegHuffman *table, const uint8_t bits[16], const uint8_t *values)
+{
+  uint32_t code = 0, k = 0;
+  for (uint32_t length = 1; length <= 16; length++) {
+    for (uint32_t i = 0; i < bits[length - 1]; i++, k++) {
+      table->codes[values[k]] = (uint16_t)code++;
+      table->lengths[values[k]] = (uint8_t)length;
+    }
+    code <<= 1;
+  }
+}
+
+static inline uint8_t jpeg_quant_scaled(uint8_t base, int quality)
+{
+  int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+  int value = (base * scale + 50) / 100;
+  return (uint8_t)(value < 1 ? 1 : value > 255 ? 255 : value);
+}
+
+static void jpeg_encoder_init(JpegEncoder *encoder, int quality)
+{
+  jpeg_huffman_build(&encoder->dc[0], jpeg_dc_luma_bits, jpeg_dc_values);
+  jpeg_huffman_build(&encoder->dc[1], jpeg_dc_chroma_bits, jpeg_dc_values);
+  jpeg_huffman_build(&encoder->ac[0], jpeg_ac_luma_bits, jpeg_ac_luma_values);
+  jpeg_huffman_build(&encoder->ac[1], jpeg_ac_chroma_bits, jpeg_ac_chroma_values);
+
+  for (uint32_t i = 0; i < 64; i++) {
+    encoder->quant[0][i] = jpeg_quant_scaled(jpeg_luma_quant[i], quality);
+    encoder->quant[1][i] = jpeg_quant_scaled(jpeg_chroma_quant[i], quality);
+  }
+
+  for (uint32_t x = 0; x < 8; x++)
+    for (uint32_t u = 0; u < 8; u++)
+      encoder->cosines[x][u] = 0.5f * (u == 0 ? sqrtf(0.5f) : 1.0f) * cosf((2.0f * x + 1.0f) * u * IMAGE_PI / 16.0f);
+}
+
+// MSB first, 0xff bytes are stuffed with a zero
+static void jpeg_put_bits(ByteBuffer *out, uint32_t code, uint32_t length)
+{
+  out->bits = (out->bits << length) | (code & ((1u << length) - 1));
+  out->bit_count += length;
+  while (out->bit_count >= 8) {
+    uint8_t byte = (uint8_t)(out->bits >> (out->bit_count - 8));
+    buffer_byte(out, byte);
+    if (byte == 0xff) buffer_byte(out, 0);
+    out->bit_count -= 8;
+  }
+}
+
+static inline void jpeg_put_value(ByteBuffer *out, const JpegHuffman *table, uint32_t run, int value)
+{
+  uint32_t magnitude = (uint32_t)(value < 0 ? -value : value), length = 0;
+  while (magnitude >> length) length++;
+
+  uint32_t symbol = (run << 4) | length;
+  jpeg_put_bits(out, table->codes[symbol], table->lengths[symbol]);
+  if (length > 0) jpeg_put_bits(out, (uint32_t)(value < 0 ? value - 1 : value), length);
+}
+
+// block holds level shifted samples, returns its quantized DC for the next block's prediction
+static int jpeg_block(ByteBuffer *out, const JpegEncoder *encoder, const float block[64], uint32_t table, int previous_dc)
+{
+  float rows[64], coefficients[64];
+  for (uint32_t y = 0; y < 8; y++) {
+    for (uint32_t u = 0; u < 8; u++) {
+      float sum = 0.0f;
+      for (uint32_t x = 0; x < 8; x++) sum += block[y * 8 + x] * encoder->cosines[x][u];
+      rows[y * 8 + u] = sum;
+    }
+  }
+  for (uint32_t v = 0; v < 8; v++) {
+    for (uint32_t u = 0; u < 8; u++) {
+      float sum = 0.0f;
+      for (uint32_t y = 0; y < 8; y++) sum += rows[y * 8 + u] * encoder->cosines[y][v];
+      coefficients[v * 8 + u] = sum;
+    }
+  }
+
+  int quantized[64];
+  for (uint32_t i = 0; i < 64; i++) {
+    uint32_t k = jpeg_zigzag[i];
+    quantized[i] = (int)lroundf(coefficients[k] / encoder->quant[table][k]);
+  }
+
+  jpeg_put_value(out, &encoder->dc[table], 0, quantized[0] - previous_dc);
+
+  uint32_t run = 0;
+  for (uint32_t i = 1; i < 64; i++) {
+    if (quantized[i] == 0) {
+      run++;
+      continue;
+    }
+    for (; run > 15; run -= 16) jpeg_put_bits(out, encoder->ac[table].codes[0xf0], encoder->ac[table].lengths[0xf0]);
+    jpeg_put_value(out, &encoder->ac[table], run, quantized[i]);
+    run = 0;
+  }
+  if (run > 0) jpeg_put_bits(out, encoder->ac[table].codes[0x00], encoder->ac[table].lengths[0x00]);
+
+  return quantized[0];
+}
+
+static void jpeg_huffman_segment(ByteBuffer *out, uint8_t id, const uint8_t bits[16], const uint8_t *values)
+{
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < 16; i++) count += bits[i];
+  buffer_byte(out, id);
+  buffer_push(out, bits, 16);
+  buffer_push(out, values, count);
+}
+
+static inline void jpeg_color(const uint8_t *rgba, int width, int height, int x, int y, float ycc[3])
+{
+  // Edge blocks repeat the last row and column
+  int sx = x < width ? x : width - 1;
+  int sy = y < height ? y : height - 1;
+  const uint8_t *p = rgba + ((size_t)sy * width + sx) * 4;
+  float r = p[0], g = p[1], b = p[2];
+  ycc[0] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+  ycc[1] = -0.168736f * r - 0.331264f * g + 0.5f * b;
+  ycc[2] = 0.5f * r - 0.418688f * g - 0.081312f * b;
+}
+
+/*
+  Baseline, one interleaved scan. subsample picks 4:2:0 (16x16 MCUs, chroma
+  averaged over 2x2) over 4:4:4, restarts emits a restart marker after
+  every MCU row, the layout jpeg_split.h can cut into bands.
+*/
+static void encode_jpeg(ByteBuffer *out, const uint8_t *rgba, int width, int height, int quality, bool subsample, bool restarts)
+{
+  JpegEncoder encoder;
+  jpeg_encoder_init(&encoder, quality);
+
+  const uint8_t start[] = {0xff, 0xd8, 0xff, 0xe0, 0, 16, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+  buffer_push(out, start, sizeof(start));
+
+  buffer_u16_be(out, 0xffdb);
+  buffer_u16_be(out, 2 + 2 * 65);
+  for (uint32_t t = 0; t < 2; t++) {
+    buffer_byte(out, (uint8_t)t);
+    for (uint32_t i = 0; i < 64; i++) buffer_byte(out, (uint8_t)encoder.quant[t][jpeg_zigzag[i]]);
+  }
+
+  int mcu_size = subsample ? 16 : 8;
+  const uint8_t frame[] = {
+    0xff, 0xc0, 0, 17, 8,
+    (uint8_t)(height >> 8), (uint8_t)height, (uint8_t)(width >> 8), (uint8_t)width,
+    3, 1, subsample ? 0x22 : 0x11, 0, 2, 0x11, 1, 3, 0x11, 1,
+  };
+  buffer_push(out, frame, sizeof(frame));
+
+  uint32_t mcus_per_row = (uint32_t)((width + mcu_size - 1) / mcu_size);
+  if (restarts) {
+    buffer_u16_be(out, 0xffdd);
+    buffer_u16_be(out, 4);
+    buffer_u16_be(out, mcus_per_row);
+  }
+
+  buffer_u16_be(out, 0xffc4);
+  buffer_u16_be(out, 2 + 4 * 17 + 2 * 12 + 2 * 162);
+  jpeg_huffman_segment(out, 0x00, jpeg_dc_luma_bits, jpeg_dc_values);
+  jpeg_huffman_segment(out, 0x10, jpeg_ac_luma_bits, jpeg_ac_luma_values);
+  jpeg_huffman_segment(out, 0x01, jpeg_dc_chroma_bits, jpeg_dc_values);
+  jpeg_huffman_segment(out, 0x11, jpeg_ac_chroma_bits, jpeg_ac_chroma_values);
+
+  const uint8_t scan[] = {0xff, 0xda, 0, 12, 3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0};
+  buffer_push(out, scan, sizeof(scan));
+
+  out->bits = 0;
+  out->bit_count = 0;
+  int dc[3] = {0};
+  float luma[4][64], chroma[2][64];
+  uint32_t luma_blocks = subsample ? 4 : 1;
+
+  for (int my = 0; my < height; my += mcu_size) {
+    for (int mx = 0; mx < width; mx += mcu_size) {
+      memset(chroma, 0, sizeof(chroma));
+      for (int y = 0; y < mcu_size; y++) {
+        for (int x = 0; x < mcu_size; x++) {
+          float ycc[3];
+          jpeg_color(rgba, width, height, mx + x, my + y, ycc);
+          luma[(y / 8) * 2 + x / 8][(y % 8) * 8 + x % 8] = ycc[0];
+          int c = subsample ? (y / 2) * 8 + x / 2 : y * 8 + x;
+          float weight = subsample ? 0.25f : 1.0f;
+          chroma[0][c] += ycc[1] * weight;
+          chroma[1][c] += ycc[2] * weight;
+        }
+      }
+      for (uint32_t b = 0; b < luma_blocks; b++) dc[0] = jpeg_block(out, &encoder, luma[b], 0, dc[0]);
+      for (uint32_t c = 0; c < 2; c++) dc[c + 1] = jpeg_block(out, &encoder, chroma[c], 1, dc[c + 1]);
+    }
+
+    // Pad the last byte with ones, at the end and before restart markers
+    bool last = my + mcu_size >= height;
+    if ((last || restarts) && out->bit_count > 0) jpeg_put_bits(out, 0x7f, 8 - out->bit_count);
+
+    // Every MCU row but the last ends its restart interval, predictions start over
+    if (restarts && !last) {
+      buffer_u16_be(out, 0xffd0 + (uint32_t)(my / mcu_size) % 8);
+      memset(dc, 0, sizeof(dc));
+    }
+  }
+  buffer_u16_be(out, 0xffd9);
+}
+
+static bool bench_image_load(BenchImage *image, const char *path, const char *format)
+{
+  memset(image, 0, sizeof(*image));
+  snprintf(image->path, sizeof(image->path), "%s", path);
+  image->format = format;
+
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "[ERROR]: Could not open \"%s\"\n", path);
+    return false;
+  }
+
+  long size = -1;
+  if (fseek(file, 0, SEEK_END) == 0) size = ftell(file);
+  if (size > 0 && fseek(file, 0, SEEK_SET) == 0) {
+    image->file = malloc((size_t)size);
+    image->file_size = (size_t)size;
+  }
+  bool ok = image->file != NULL && fread(image->file, 1, image->file_size, file) == image->file_size;
+  fclose(file);
+
+  if (!ok || !stbi_info_from_memory(image->file, (int)image->file_size, &image->width, &image->height, &image->channels)) {
+    fprintf(stderr, "[ERROR]: \"%s\" is not an image stb_image reads (%s)\n", path, ok ? stbi_failure_reason() : "read failed");
+    free(image->file);
+    image->file = NULL;
+    return false;
+  }
+  image->hdr = stbi_is_hdr_from_memory(image->file, (int)image->file_size) != 0;
+  return true;
+}
+
+static int callback_read(void *user, char *data, int size)
+{
+  return (int)fread(data, 1, (size_t)size, user);
+}
+
+static void callback_skip(void *user, int n)
+{
+  fseek(user, n, SEEK_CUR);
+}
+
+static int callback_eof(void *user)
+{
+  return feof((FILE *)user);
+}
+
+static void *decode(const BenchImage *image, ImageApi api, int channels)
+{
+  int width, height, stored;
+  void *pixels = NULL;
+
+  switch (api) {
+    case IMAGE_API_FILE:
+      pixels = image->hdr
+        ? (void *)stbi_loadf(image->path, &width, &height, &stored, channels)
+        : (void *)stbi_load(image->path, &width, &height, &stored, channels);
+      break;
+    case IMAGE_API_MEMORY:
+      pixels = image->hdr
+        ? (void *)stbi_loadf_from_memory(image->file, (int)image->file_size, &width, &height, &stored, channels)
+        : (void *)stbi_load_from_memory(image->file, (int)image->file_size, &width, &height, &stored, channels);
+      break;
+    case IMAGE_API_CALLBACKS: {
+      // A stream the decoder pulls from in small reads, like a package reader would provide
+      static const stbi_io_callbacks callbacks = {callback_read, callback_skip, callback_eof};
+      FILE *file = fopen(image->path, "rb");
+      if (file == NULL) return NULL;
+      pixels = image->hdr
+        ? (void *)stbi_loadf_from_callbacks(&callbacks, file, &width, &height, &stored, channels)
+        : (void *)stbi_load_from_callbacks(&callbacks, file, &width, &height, &stored, channels);
+      fclose(file);
+      break;
+    }
+  }
+  return pixels;
+}
+
+static void decode_range(void *user, uint32_t begin, uint32_t end, uint32_t worker)
+{
+  DecodeJob *job = user;
+  stbi_set_flip_vertically_on_load_thread(job->flip);
+
+  for (uint32_t i = begin; i < end; i++) {
+    void *pixels = decode(job->image, job->api, job->channels);
+    if (pixels == NULL) atomic_fetch_add_explicit(&job->failures, 1, memory_order_relaxed);
+    stbi_image_free(pixels);
+  }
+}
+
+static bool run_decodes(const BenchImage *image, const char *label, ImageApi api, int channels, bool flip,
+                        ThreadPool *pool, uint32_t decodes)
+{
+  DecodeJob job = {image, api, channels, flip};
+  atomic_init(&job.failures, 0);
+
+  double start = platform_time();
+  thread_pool_parallel_for(pool, decodes, 1, decode_range, &job);
+  double seconds = platform_time() - start;
+
+  uint32_t failures = atomic_load(&job.failures);
+  if (failures > 0) {
+    fprintf(stderr, "[ERROR]: %s: %u of %u decodes failed (%s)\n", label, failures, decodes, stbi_failure_reason());
+    return false;
+  }
+
+  double bytes = (double)image->width * image->height * (channels ? channels : image->channels) * (image->hdr ? 4 : 1);
+  printf(
+    "    - %-30s: %9.1f MB/s, %8.1f images/s\n",
+    label, decodes * bytes / seconds / (1024.0 * 1024.0), decodes / seconds
+  );
+  return true;
+}
+
+/*
+  stb_image flipping and expanding to 4 channels against the texture_load.h
+  path, which decodes 3 channels and leaves both to image_rgb_to_rgba
+*/
+static bool bench_expand(const BenchImage *image, uint32_t decodes)
+{
+  size_t count = (size_t)image->width * image->height;
+  uint8_t *rgba = malloc(count * 4);
+  if (rgba == NULL) return false;
+
+  double seconds[2];
+  bool ok = true;
+  for (uint32_t path = 0; ok && path < 2; path++) {
+    stbi_set_flip_vertically_on_load_thread(path == 0);
+    double start = platform_time();
+    for (uint32_t i = 0; ok && i < decodes; i++) {
+      int width, height, stored;
+      uint8_t *pixels = stbi_load_from_memory(image->file, (int)image->file_size, &width, &height, &stored, path == 0 ? 4 : 3);
+      ok = pixels != NULL;
+      if (ok && path == 1) image_rgb_to_rgba(rgba, (size_t)width * 4, pixels, (size_t)width * 3, width, height, true);
+      stbi_image_free(pixels);
+    }
+    seconds[path] = platform_time() - start;
+  }
+  stbi_set_flip_vertically_on_load_thread(0);
+  free(rgba);
+
+  if (!ok) {
+    fprintf(stderr, "[ERROR]: Decode failed (%s)\n", stbi_failure_reason());
+    return false;
+  }
+
+  static const char *labels[2] = {"memory, flipped, to RGBA", "memory, RGB + image_ops flip"};
+  for (uint32_t path = 0; path < 2; path++) {
+    printf(
+      "    - %-30s: %9.1f MB/s, %8.1f images/s\n",
+      labels[path], decodes * count * 4.0 / seconds[path] / (1024.0 * 1024.0), decodes / seconds[path]
+    );
+  }
+  return true;
+}
+
+typedef enum {
+  IMAGE_KERNEL_FLIP,
+  IMAGE_KERNEL_RGB_TO_RGBA,
+  IMAGE_KERNEL_RGB_TO_RGBA_FLIP,
+  IMAGE_KERNEL_SWAP_RED_BLUE,
+  IMAGE_KERNEL_PREMULTIPLY,
+  IMAGE_KERNEL_SRGB_TO_LINEAR,
+  IMAGE_KERNEL_COUNT,
+} ImageKernel;
+
+static const char *image_kernel_labels[IMAGE_KERNEL_COUNT] = {
+  "flip", "rgb to rgba", "rgb to rgba, flipped", "swap red / blue", "premultiply", "srgb to linear",
+};
+
+typedef struct {
+  int size;
+  const uint8_t *source;  // RGBA
+  uint8_t *rgb;
+  uint8_t *rgba;
+  float *linear;
+} KernelBuffers;
+
+// In place kernels run on whatever the previous run left, their cost doesn't depend on the values
+static void run_kernel(ImageKernel kernel, bool reference, const KernelBuffers *buffers)
+{
+  int size = buffers->size;
+  size_t count = (size_t)size * size;
+  size_t stride = (size_t)size * 4;
+
+  switch (kernel) {
+    case IMAGE_KERNEL_FLIP:
+      (reference ? image_flip_vertical_reference : image_flip_vertical)(buffers->rgba, stride, size);
+      break;
+    case IMAGE_KERNEL_RGB_TO_RGBA:
+    case IMAGE_KERNEL_RGB_TO_RGBA_FLIP:
+      (reference ? image_rgb_to_rgba_reference : image_rgb_to_rgba)(
+        buffers->rgba, stride, buffers->rgb, (size_t)size * 3, size, size, kernel == IMAGE_KERNEL_RGB_TO_RGBA_FLIP);
+      break;
+    case IMAGE_KERNEL_SWAP_RED_BLUE:
+      (reference ? image_swap_red_blue_reference : image_swap_red_blue)(buffers->rgba, count);
+      break;
+    case IMAGE_KERNEL_PREMULTIPLY:
+      (reference ? image_premultiply_alpha_reference : image_premultiply_alpha)(buffers->rgba, count);
+      break;
+    case IMAGE_KERNEL_SRGB_TO_LINEAR:
+      (reference ? image_srgb_to_linear_reference : image_srgb_to_linear)(buffers->linear, buffers->rgba, count);
+      break;
+    default:
+      break;
+  }
+}
+
+// One run of each version from the same source, outputs must match exactly
+static bool verify_kernel(ImageKernel kernel, const KernelBuffers *buffers, uint8_t *expected, float *expected_linear)
+{
+  size_t count = (size_t)buffers->size * buffers->size;
+
+  memcpy(buffers->rgba, buffers->source, count * 4);
+  run_kernel(kernel, true, buffers);
+  memcpy(expected, buffers->rgba, count * 4);
+  if (kernel == IMAGE_KERNEL_SRGB_TO_LINEAR) memcpy(expected_linear, buffers->linear, count * 4 * sizeof(float));
+
+  memcpy(buffers->rgba, buffers->source, count * 4);
+  run_kernel(kernel, false, buffers);
+  if (kernel == IMAGE_KERNEL_SRGB_TO_LINEAR) return memcmp(expected_linear, buffers->linear, count * 4 * sizeof(float)) == 0;
+  return memcmp(expected, buffers->rgba, count * 4) == 0;
+}
+
+static bool bench_kernels(const uint8_t *source, int size)
+{
+  size_t count = (size_t)size * size;
+  KernelBuffers buffers = {
+    .size = size,
+    .source = source,
+    .rgb = malloc(count * 3),
+    .rgba = malloc(count * 4),
+    .linear = malloc(count * 4 * sizeof(float)),
+  };
+  uint8_t *expected = malloc(count * 4);
+  float *expected_linear = malloc(count * 4 * sizeof(float));
+
+  bool ok = buffers.rgb != NULL && buffers.rgba != NULL && buffers.linear != NULL && expected != NULL && expected_linear != NULL;
+  if (!ok) fprintf(stderr, "[ERROR]: Out of memory\n");
+
+  if (ok) {
+    for (size_t i = 0; i < count; i++) memcpy(buffers.rgb + i * 3, source + i * 4, 3);
+    printf("  post-processing kernels (%s): %dx%d RGBA, best of %d\n", image_ops_isa(), size, size, IMAGE_KERNEL_RUNS);
+  }
+
+  for (uint32_t k = 0; ok && k < IMAGE_KERNEL_COUNT; k++) {
+    if (!verify_kernel(k, &buffers, expected, expected_linear)) {
+      fprintf(stderr, "[ERROR]: %s does not match its reference\n", image_kernel_labels[k]);
+      ok = false;
+      break;
+    }
+
+    double best[2] = {1e30, 1e30};
+    for (uint32_t version = 0; version < 2; version++) {
+      for (uint32_t run = 0; run < IMAGE_KERNEL_RUNS; run++) {
+        double start = platform_time();
+        run_kernel(k, version == 0, &buffers);
+        double seconds = platform_time() - start;
+        if (seconds < best[version]) best[version] = seconds;
+      }
+    }
+
+    // Throughput in output pixels, 4 bytes each
+    double megabytes = count * 4.0 / (1024.0 * 1024.0);
+    printf(
+      "    - %-30s: %9.1f MB/s reference, %9.1f MB/s, %5.2fx\n",
+      image_kernel_labels[k], megabytes / best[0], megabytes / best[1], best[0] / best[1]
+    );
+  }
+
+  free(buffers.rgb);
+  free(buffers.rgba);
+  free(buffers.linear);
+  free(expected);
+  free(expected_linear);
+  return ok;
+}
+
+static bool bench_image(const BenchImage *image, ThreadPool **pools, const uint32_t *pool_threads, uint32_t pool_count, uint32_t decodes)
+{
+  static const struct { const char *label; ImageApi api; } apis[] = {
+    {"stbi_load", IMAGE_API_FILE},
+    {"stbi_load_from_memory", IMAGE_API_MEMORY},
+    {"stbi_load_from_callbacks", IMAGE_API_CALLBACKS},
+  };
+  static const int channel_counts[] = {1, 3, 4};
+
+  printf("  %s: %s, %dx%d, %d channel(s), %.1f KB%s\n",
+    image->format, image->path, image->width, image->height, image->channels,
+    image->file_size / 1024.0, image->hdr ? ", float output" : "");
+
+  bool ok = true;
+  for (uint32_t i = 0; ok && i < sizeof(apis) / sizeof(apis[0]); i++)
+    ok = run_decodes(image, apis[i].label, apis[i].api, 0, false, NULL, decodes);
+
+  // Channel conversion and the flip, through the memory API so file I/O doesn't blur them
+  char label[64];
+  for (uint32_t i = 0; ok && i < sizeof(channel_counts) / sizeof(channel_counts[0]); i++) {
+    snprintf(label, sizeof(label), "memory, %d channel(s)", channel_counts[i]);
+    ok = run_decodes(image, label, IMAGE_API_MEMORY, channel_counts[i], false, NULL, decodes);
+  }
+  if (ok) ok = run_decodes(image, "memory, flipped", IMAGE_API_MEMORY, 0, true, NULL, decodes);
+  if (ok && !image->hdr && image->channels == 3) ok = bench_expand(image, decodes);
+
+  // Same work per thread, so images/s should scale with the thread count
+  for (uint32_t i = 0; ok && i < pool_count; i++) {
+    snprintf(label, sizeof(label), "memory, flipped, %u thread(s)", pool_threads[i]);
+    ok = run_decodes(image, label, IMAGE_API_MEMORY, 0, true, pools[i], decodes * pool_threads[i]);
+  }
+  return ok;
+}
+
+// Decoding back what was written catches encoder bugs before they pass for decoder speed
+static bool verify_synthetic(const BenchImage *image, const uint8_t *rgba, const float *rgb)
+{
+  int width, height, stored;
+  stbi_set_flip_vertically_on_load_thread(0);
+
+  if (image->hdr) {
+    float *pixels = stbi_loadf_from_memory(image->file, (int)image->file_size, &width, &height, &stored, 3);
+    if (pixels == NULL) return false;
+    // RGBE keeps 8 bits of mantissa relative to the largest component
+    float max_error = 0.0f;
+    for (size_t i = 0; i < (size_t)width * height; i++) {
+      const float *p = pixels + i * 3, *q = rgb + i * 3;
+      float largest = fmaxf(q[0], fmaxf(q[1], q[2])) + 1e-6f;
+      for (uint32_t c = 0; c < 3; c++) max_error = fmaxf(max_error, fabsf(p[c] - q[c]) / largest);
+    }
+    stbi_image_free(pixels);
+    return max_error < 1.0f / 64.0f;
+  }
+
+  uint8_t *pixels = stbi_load_from_memory(image->file, (int)image->file_size, &width, &height, &stored, 4);
+  if (pixels == NULL) return false;
+
+  bool lossy = strcmp(image->format, "jpeg") == 0;
+  double error = 0.0;
+  uint32_t max_error = 0;
+  for (size_t i = 0; i < (size_t)width * height * 4; i++) {
+    if ((i & 3) == 3 && image->channels < 4) continue;
+    uint32_t d = pixels[i] > rgba[i] ? pixels[i] - rgba[i] : rgba[i] - pixels[i];
+    if (d > max_error) max_error = d;
+    error += d;
+  }
+  stbi_image_free(pixels);
+
+  // JPEG at quality 90 stays within a few levels on average
+  return lossy ? error / ((double)width * height * 3) < 3.0 : max_error == 0;
+}
+
+static bool synthesize_images(BenchImage *images, uint32_t *count, const char *dir, int size)
+{
+  static const char *formats[] = {"png", "jpeg", "tga", "hdr"};
+  static const char *extensions[] = {"png", "jpg", "tga", "hdr"};
+
+  uint8_t *rgba = malloc((size_t)size * size * 4);
+  float *rgb = malloc((size_t)size * size * 3 * sizeof(float));
+  uint8_t *scanline = malloc((size_t)size * 4);
+  if (rgba == NULL || rgb == NULL || scanline == NULL) {
+    fprintf(stderr, "[ERROR]: Out of memory\n");
+    free(rgba);
+    free(rgb);
+    free(scanline);
+    return false;
+  }
+  synthesize(rgba, rgb, size);
+
+  ImageWriter writer;
+  image_writer_init(&writer);
+
+  bool ok = true;
+  for (uint32_t f = 0; ok && f < sizeof(formats) / sizeof(formats[0]); f++) {
+    char path[IMAGE_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/bench_image.%s", dir, extensions[f]);
+
+    ByteBuffer out = {0};
+    switch (f) {
+      case 0: ok = image_write_png(&writer, path, size, size, rgba, (size_t)size * 4, false); break;
+      case 1: encode_jpeg(&out, rgba, size, size, IMAGE_JPEG_QUALITY, false, false); break;
+      case 2: encode_tga(&out, rgba, size, size); break;
+      case 3: encode_hdr(&out, rgb, size, size, scanline); break;
+    }
+    if (ok && f > 0) ok = buffer_write_file(&out, path);
+    free(out.data);
+
+    BenchImage *image = &images[*count];
+    if (ok) ok = bench_image_load(image, path, formats[f]);
+    if (ok && !verify_synthetic(image, rgba, rgb)) {
+      fprintf(stderr, "[ERROR]: Synthetic %s does not decode back to its source\n", formats[f]);
+      free(image->file);
+      ok = false;
+    }
+    if (ok) (*count)++;
+  }
+
+  image_writer_free(&writer);
+  free(rgba);
+  free(rgb);
+  free(scanline);
+  return ok;
+}
+
+// Best of IMAGE_LARGE_RUNS, the image of the last run is kept for comparison
+static bool decode_large(TextureImage *image, const char *path, ThreadPool *pool, double *seconds)
+{
+  *seconds = 1e30;
+  for (uint32_t run = 0; run < IMAGE_LARGE_RUNS; run++) {
+    if (run > 0) texture_image_free(image);
+    double start = platform_time();
+    if (!texture_decode(image, path, TEXTURE_LOAD_FLIP, pool)) return false;
+    double elapsed = platform_time() - start;
+    if (elapsed < *seconds) *seconds = elapsed;
+  }
+  return true;
+}
+
+static bool bench_large(const char *dir, int size, ThreadPool **pools, const uint32_t *pool_threads, uint32_t pool_count)
+{
+  static const struct { const char *label; const char *extension; bool subsample; } kinds[] = {
+    {"jpeg 4:4:4, restarts", "jpg", false},
+    {"jpeg 4:2:0, restarts", "jpg", true},
+    {"png", "png", false},
+  };
+
+  uint8_t *rgba = malloc((size_t)size * size * 4);
+  if (rgba == NULL) {
+    fprintf(stderr, "[ERROR]: Out of memory\n");
+    return false;
+  }
+  synthesize(rgba, NULL, size);
+
+  ImageWriter writer;
+  image_writer_init(&writer);
+
+  bool ok = true;
+  for (uint32_t k = 0; ok && k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+    char path[IMAGE_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/bench_image_large_%u.%s", dir, k, kinds[k].extension);
+
+    if (strcmp(kinds[k].extension, "png") == 0) {
+      ok = image_write_png(&writer, path, size, size, rgba, (size_t)size * 4, false);
+    } else {
+      ByteBuffer out = {0};
+      encode_jpeg(&out, rgba, size, size, IMAGE_JPEG_QUALITY, kinds[k].subsample, true);
+      ok = buffer_write_file(&out, path);
+      free(out.data);
+    }
+    if (!ok) break;
+
+    printf("  large %s: %s, %dx%d, flipped to RGBA\n", kinds[k].label, path, size, size);
+
+    // The first entry is single threaded, later ones must match it exactly
+    TextureImage baseline;
+    double baseline_seconds = 0.0;
+    ok = decode_large(&baseline, path, pools[0], &baseline_seconds);
+
+    for (uint32_t i = 0; ok && i < pool_count; i++) {
+      TextureImage image = baseline;
+      double seconds = baseline_seconds;
+      if (i > 0) {
+        ok = decode_large(&image, path, pools[i], &seconds);
+        if (ok && (image.size != baseline.size || memcmp(image.pixels, baseline.pixels, image.size) != 0)) {
+          fprintf(stderr, "[ERROR]: %u thread decode of %s does not match the single threaded one\n", pool_threads[i], path);
+          ok = false;
+        }
+        if (image.pixels != NULL) texture_image_free(&image);
+        if (!ok) break;
+      }
+
+      char label[64];
+      snprintf(label, sizeof(label), "%u thread(s), %u band(s)", pool_threads[i], image.bands);
+      printf(
+        "    - %-30s: %9.1f MB/s, %8.2f images/s, %5.2fx\n",
+        label, size * (double)size * 4.0 / seconds / (1024.0 * 1024.0), 1.0 / seconds, baseline_seconds / seconds
+      );
+    }
+    if (baseline.pixels != NULL) texture_image_free(&baseline);
+  }
+
+  image_writer_free(&writer);
+  free(rgba);
+  return ok;
+}
+
+static const char *format_from_path(const char *path)
+{
+  const char *dot = strrchr(path, '.');
+  return dot != NULL ? dot + 1 : "file";
+}
+
+int main(int argc, char **argv)
+{
+  int size = IMAGE_DEFAULT_SIZE;
+  uint32_t decodes = IMAGE_DEFAULT_DECODES;
+  int large = IMAGE_DEFAULT_LARGE;
+  const char *dir = ".";
+  const char *files[IMAGE_MAX_FILES];
+  uint32_t file_count = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      size = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--decodes") == 0 && i + 1 < argc) {
+      decodes = (uint32_t)strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--large") == 0 && i + 1 < argc) {
+      large = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+      dir = argv[++i];
+    } else if (file_count < IMAGE_MAX_FILES) {
+      files[file_count++] = argv[i];
+    }
+  }
+
+  if (size < IMAGE_MIN_SIZE || size > 16384 || decodes == 0 || (large != 0 && (large < 8 || large > 16384))) {
+    fprintf(stderr, "[ERROR]: --size must be in [%d, 16384], --large in [8, 16384] (0 skips) and decodes at least 1\n", IMAGE_MIN_SIZE);
+    return EXIT_FAILURE;
+  }
+
+  BenchImage images[IMAGE_MAX_FILES + 4];
+  uint32_t image_count = 0;
+  if (!synthesize_images(images, &image_count, dir, size)) return EXIT_FAILURE;
+
+  bool ok = true;
+  for (uint32_t i = 0; ok && i < file_count; i++) {
+    ok = bench_image_load(&images[image_count], files[i], format_from_path(files[i]));
+    if (ok) image_count++;
+  }
+
+  // 1, 2, 4... threads up to the processor count, which is always included
+  ThreadPool *pools[IMAGE_MAX_POOLS];
+  uint32_t pool_threads[IMAGE_MAX_POOLS];
+  uint32_t pool_count = 0;
+  uint32_t cpus = platform_cpu_count();
+  for (uint32_t threads = 1; ok && pool_count < IMAGE_MAX_POOLS; threads *= 2) {
+    if (threads > cpus) threads = cpus;
+    pools[pool_count] = threads > 1 ? thread_pool_create(threads - 1) : NULL;
+    pool_threads[pool_count] = threads > 1 ? thread_pool_size(pools[pool_count]) : 1;
+    if (threads > 1 && pools[pool_count] == NULL) {
+      fprintf(stderr, "[ERROR]: Could not create a %u thread pool\n", threads);
+      ok = false;
+      break;
+    }
+    pool_count++;
+    if (threads == cpus) break;
+  }
+
+  printf("[BENCH]: image decode, %dx%d synthetic + %u file(s), %u decodes per run\n",
+    size, size, file_count, decodes);
+
+  for (uint32_t i = 0; ok && i < image_count; i++) ok = bench_image(&images[i], pools, pool_threads, pool_count, decodes);
+
+  // Synthesized RGBA straight from memory, its alpha ramps from 0 to 255 so premultiply and the alpha lane see real values
+  if (ok) {
+    uint8_t *source = malloc((size_t)size * size * 4);
+    if (source != NULL) synthesize(source, NULL, size);
+    ok = source != NULL && bench_kernels(source, size);
+    free(source);
+  }
+
+  if (ok && large > 0) ok = bench_large(dir, large, pools, pool_threads, pool_count);
+
+  for (uint32_t i = 0; i < pool_count; i++)
+    if (pools[i] != NULL) thread_pool_destroy(pools[i]);
+  for (uint32_t i = 0; i < image_count; i++) free(images[i].file);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
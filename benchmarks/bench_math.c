@@ -0,0 +1,434 @@
+/*
+  Math benchmark: ns/op and throughput of the raymath functions the
+  engine leans on, and of the batched transform update built on them.
+  Every kernel runs over randomized arrays twice:
+    - hot: the first MATH_HOT_ELEMENTS elements, repeated, which stay in
+      L1/L2 so only the arithmetic is measured;
+    - cold: the whole arrays (well past the last level cache), streamed
+      once per pass so every line comes from memory.
+  The best of MATH_TRIALS passes is kept. Results are also written as JSON
+  (--json) so runs can be tracked over time and scalar, SIMD and batch
+  implementations compared; "implementation" tells them apart. The SIMD
+  rows come from raymath's RAYMATH_USE_SIMD_INTRINSICS build (see
+  bench_math_simd.c), which only covers MatrixMultiply.
+  Usage: bench_math [--json PATH] [element count, default 524288]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <raymath.h>
+#include <platform.h>
+#include <transform.h>
+
+#define MATH_HOT_ELEMENTS   512
+#define MATH_TRIALS         5
+#define MATH_MAX_RESULTS    32
+#define MATH_INVERT_EPSILON 1e-3f
+#define MATH_SIMD_EPSILON   1e-4f   // Relative, the SIMD multiply sums in the same order but may contract
+
+#if defined(__AVX__)
+#define MATH_TARGET_ISA "avx"
+#elif defined(__SSE__) || defined(_M_X64)
+#define MATH_TARGET_ISA "sse"
+#elif defined(__ARM_NEON)
+#define MATH_TARGET_ISA "neon"
+#else
+#define MATH_TARGET_ISA "none"
+#endif
+
+#if defined(__VERSION__)
+#define MATH_COMPILER __VERSION__
+#else
+#define MATH_COMPILER "unknown"
+#endif
+
+typedef struct {
+  uint32_t count;
+  Matrix *a;
+  Matrix *b;
+  Matrix *matrices;     // Outputs
+  Quaternion *qa;
+  Quaternion *qb;
+  Quaternion *quaternions;
+  Vector3 *translations;
+  Vector3 *scales;
+  Vector3 *vectors;
+  float *amounts;
+} MathData;
+
+typedef void (*MathKernel)(MathData *data, uint32_t begin, uint32_t end);
+
+// bench_math_simd.c
+bool bench_math_simd_enabled(void);
+void bench_math_simd_multiply(const Matrix *a, const Matrix *b, Matrix *out, uint32_t begin, uint32_t end);
+
+typedef struct {
+  const char *name;
+  const char *implementation;
+  const char *variant;
+  uint64_t operations;
+  double seconds;
+} MathResult;
+
+typedef struct {
+  MathResult results[MATH_MAX_RESULTS];
+  uint32_t count;
+} MathReport;
+
+static uint32_t rng_state = 0x2545f491u;
+
+static inline float random_float(float lo, float hi)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return lo + (hi - lo) * (float)(rng_state & 0xffffffu) / (float)0xffffff;
+}
+
+static inline Vector3 random_vector(float lo, float hi)
+{
+  return (Vector3){random_float(lo, hi), random_float(lo, hi), random_float(lo, hi)};
+}
+
+static inline Quaternion random_rotation(void)
+{
+  return QuaternionFromAxisAngle(Vector3Normalize(random_vector(-1.0f, 1.0f)), random_float(-PI, PI));
+}
+
+static bool math_data_init(MathData *data, uint32_t count)
+{
+  memset(data, 0, sizeof(*data));
+  data->count = count;
+  data->a = malloc(count * sizeof(Matrix));
+  data->b = malloc(count * sizeof(Matrix));
+  data->matrices = malloc(count * sizeof(Matrix));
+  data->qa = malloc(count * sizeof(Quaternion));
+  data->qb = malloc(count * sizeof(Quaternion));
+  data->quaternions = malloc(count * sizeof(Quaternion));
+  data->translations = malloc(count * sizeof(Vector3));
+  data->scales = malloc(count * sizeof(Vector3));
+  data->vectors = malloc(count * sizeof(Vector3));
+  data->amounts = malloc(count * sizeof(float));
+
+  if (data->a == NULL || data->b == NULL || data->matrices == NULL ||
+      data->qa == NULL || data->qb == NULL || data->quaternions == NULL ||
+      data->translations == NULL || data->scales == NULL || data->vectors == NULL || data->amounts == NULL) return false;
+
+  // Affine TRS matrices like the transform graph produces, always invertible
+  for (uint32_t i = 0; i < count; i++) {
+    data->qa[i] = random_rotation();
+    data->qb[i] = random_rotation();
+    data->translations[i] = random_vector(-100.0f, 100.0f);
+    data->scales[i] = random_vector(0.5f, 2.0f);
+    data->amounts[i] = random_float(0.0f, 1.0f);
+    data->a[i] = MatrixCompose(data->translations[i], data->qa[i], data->scales[i]);
+    data->b[i] = MatrixCompose(random_vector(-100.0f, 100.0f), data->qb[i], random_vector(0.5f, 2.0f));
+  }
+  return true;
+}
+
+static void math_data_free(MathData *data)
+{
+  free(data->a);
+  free(data->b);
+  free(data->matrices);
+  free(data->qa);
+  free(data->qb);
+  free(data->quaternions);
+  free(data->translations);
+  free(data->scales);
+  free(data->vectors);
+  free(data->amounts);
+}
+
+static void kernel_matrix_multiply(MathData *data, uint32_t begin, uint32_t end)
+{
+  for (uint32_t i = begin; i < end; i++) data->matrices[i] = MatrixMultiply(data->a[i], data->b[i]);
+}
+
+static void kernel_matrix_multiply_simd(MathData *data, uint32_t begin, uint32_t end)
+{
+  bench_math_simd_multiply(data->a, data->b, data->matrices, begin, end);
+}
+
+static void kernel_matrix_invert(MathData *data, uint32_t begin, uint32_t end)
+{
+  for (uint32_t i = begin; i < end; i++) data->matrices[i] = MatrixInvert(data->a[i]);
+}
+
+static void kernel_matrix_transpose(MathData *data, uint32_t begin, uint32_t end)
+{
+  for (uint32_t i = begin; i < end; i++) data->matrices[i] = MatrixTranspose(data->a[i]);
+}
+
+static void kernel_matrix_compose(MathData *data, uint32_t begin, uint32_t end)
+{
+  for (uint32_t i = begin; i < end; i++)
+    data->matrices[i] = MatrixCompose(data->translations[i], data->qa[i], data->scales[i]);
+}
+
+// a was composed from translations and scales, so decomposing it writes back the same values
+static void kernel_matrix_decompose(MathData *data, uint32_t begin, uint32_t end)
+{
+  for (uint32_t i = begin; i < end; i++)
+    MatrixDecompose(data->a[i], &data->translations[i], &data->quaternions[i], &data->scales[i]);
+}
+
+static void kernel_vector3_transform(MathData *data, uint32_t begin, uint32_t end)
+{
+  for (uint32_t i = begin; i < end; i++) data->vectors[i] = Vector3Transform(data->translations[i], data->a[i]);
+}
+
+static void kernel_vector3_rotate(MathData *data, uint32_t begin, uint32_t end)
+{
+  for (uint32_t i = begin; i < end; i++) data->vectors[i] = Vector3RotateByQuaternion(data->translations[i], data->qa[i]);
+}
+
+static void kernel_quaternion_multiply(MathData *data, uint32_t begin, uint32_t end)
+{
+  for (uint32_t i = begin; i < end; i++) data->quaternions[i] = QuaternionMultiply(data->qa[i], data->qb[i]);
+}
+
+static void kernel_quaternion_slerp(MathData *data, uint32_t begin, uint32_t end)
+{
+  for (uint32_t i = begin; i < end; i++)
+    data->quaternions[i] = QuaternionSlerp(data->qa[i], data->qb[i], data->amounts[i]);
+}
+
+static void kernel_quaternion_from_matrix(MathData *data, uint32_t begin, uint32_t end)
+{
+  for (uint32_t i = begin; i < end; i++) data->quaternions[i] = QuaternionFromMatrix(data->a[i]);
+}
+
+static void kernel_quaternion_to_matrix(MathData *data, uint32_t begin, uint32_t end)
+{
+  for (uint32_t i = begin; i < end; i++) data->matrices[i] = QuaternionToMatrix(data->qa[i]);
+}
+
+static const struct { const char *name; MathKernel kernel; } math_kernels[] = {
+  {"MatrixMultiply", kernel_matrix_multiply},
+  {"MatrixInvert", kernel_matrix_invert},
+  {"MatrixTranspose", kernel_matrix_transpose},
+  {"MatrixCompose", kernel_matrix_compose},
+  {"MatrixDecompose", kernel_matrix_decompose},
+  {"Vector3Transform", kernel_vector3_transform},
+  {"Vector3RotateByQuaternion", kernel_vector3_rotate},
+  {"QuaternionMultiply", kernel_quaternion_multiply},
+  {"QuaternionSlerp", kernel_quaternion_slerp},
+  {"QuaternionFromMatrix", kernel_quaternion_from_matrix},
+  {"QuaternionToMatrix", kernel_quaternion_to_matrix},
+};
+
+#define MATH_KERNELS (sizeof(math_kernels) / sizeof(math_kernels[0]))
+
+static void report(MathReport *report, const char *name, const char *implementation, const char *variant,
+                   uint64_t operations, double seconds)
+{
+  printf(
+    "  - %-26s %-6s %-4s: %8.2f ns/op, %9.2f Mops/s\n",
+    name, implementation, variant,
+    seconds * 1e9 / (double)operations, seconds > 0.0 ? operations / seconds / 1e6 : 0.0
+  );
+
+  if (report->count < MATH_MAX_RESULTS)
+    report->results[report->count++] = (MathResult){name, implementation, variant, operations, seconds};
+}
+
+// Hot passes repeat the small range until they do as many operations as a cold one
+static double time_kernel(MathKernel kernel, MathData *data, bool hot, uint64_t *operations)
+{
+  uint32_t repeats = hot ? data->count / MATH_HOT_ELEMENTS : 1;
+  uint32_t end = hot ? MATH_HOT_ELEMENTS : data->count;
+  double best = 0.0;
+
+  for (uint32_t trial = 0; trial < MATH_TRIALS; trial++) {
+    double start = platform_time();
+    for (uint32_t r = 0; r < repeats; r++) kernel(data, 0, end);
+    double seconds = platform_time() - start;
+    if (trial == 0 || seconds < best) best = seconds;
+  }
+
+  *operations = (uint64_t)repeats * end;
+  return best;
+}
+
+/*
+  Batch path: every node composed from its TRS and multiplied by its
+  parent's world matrix in one forward pass. Nodes form a 4-ary tree, so
+  dirtying the root dirties all of them.
+*/
+static bool bench_transform_update(MathReport *math_report, const MathData *data, uint32_t count, const char *variant)
+{
+  TransformGraph graph;
+  if (!transform_graph_init(&graph, count)) return false;
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t parent = i == 0 ? TRANSFORM_NONE : (i - 1) / 4;
+    transform_add(&graph, parent, data->translations[i], data->qa[i], data->scales[i]);
+  }
+
+  uint32_t repeats = data->count / count;
+  double best = 0.0;
+  for (uint32_t trial = 0; trial < MATH_TRIALS; trial++) {
+    double seconds = 0.0;
+    for (uint32_t r = 0; r < repeats; r++) {
+      transform_set_translation(&graph, 0, data->translations[r % count]);
+      double start = platform_time();
+      transform_graph_update(&graph);
+      seconds += platform_time() - start;
+    }
+    if (trial == 0 || seconds < best) best = seconds;
+  }
+
+  report(math_report, "transform_graph_update", "batch", variant, (uint64_t)repeats * count, best);
+  transform_graph_free(&graph);
+  return true;
+}
+
+// Inverse times original must give back the identity, or the inputs are degenerate
+static float verify_invert(const MathData *data)
+{
+  float max_error = 0.0f;
+  for (uint32_t i = 0; i < data->count; i++) {
+    float16 m = MatrixToFloatV(MatrixMultiply(data->a[i], MatrixInvert(data->a[i])));
+    for (uint32_t k = 0; k < 16; k++) {
+      float error = fabsf(m.v[k] - ((k % 5) == 0 ? 1.0f : 0.0f));
+      if (error > max_error) max_error = error;
+    }
+  }
+  return max_error;
+}
+
+// Largest difference between the scalar and SIMD MatrixMultiply, relative to the largest element
+static float verify_simd_multiply(MathData *data)
+{
+  float error = 0.0f;
+  for (uint32_t i = 0; i < MATH_HOT_ELEMENTS; i++) {
+    Matrix simd;
+    bench_math_simd_multiply(&data->a[i], &data->b[i], &simd, 0, 1);
+    float16 s = MatrixToFloatV(simd), r = MatrixToFloatV(MatrixMultiply(data->a[i], data->b[i]));
+    float largest = 1.0f;
+    for (uint32_t j = 0; j < 16; j++) largest = fmaxf(largest, fabsf(r.v[j]));
+    for (uint32_t j = 0; j < 16; j++) error = fmaxf(error, fabsf(s.v[j] - r.v[j]) / largest);
+  }
+  return error;
+}
+
+static void json_string(FILE *file, const char *string)
+{
+  fputc('"', file);
+  for (const char *c = string; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') fputc('\\', file);
+    if ((unsigned char)*c >= 0x20) fputc(*c, file);
+  }
+  fputc('"', file);
+}
+
+static bool write_json(const MathReport *math_report, const char *path, uint32_t count)
+{
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    fprintf(stderr, "[ERROR]: Could not open \"%s\" for writing\n", path);
+    return false;
+  }
+
+  fprintf(file, "{\n  \"benchmark\": \"math\",\n  \"timestamp\": %lld,\n  \"compiler\": ", (long long)time(NULL));
+  json_string(file, MATH_COMPILER);
+  fprintf(file,
+    ",\n  \"target_isa\": \"%s\",\n  \"hot_elements\": %u,\n  \"cold_elements\": %u,\n  \"trials\": %u,\n  \"results\": [\n",
+    MATH_TARGET_ISA, MATH_HOT_ELEMENTS, count, MATH_TRIALS);
+
+  for (uint32_t i = 0; i < math_report->count; i++) {
+    const MathResult *result = &math_report->results[i];
+    fprintf(file, "    {\"name\": ");
+    json_string(file, result->name);
+    fprintf(file,
+      ", \"implementation\": \"%s\", \"variant\": \"%s\", \"operations\": %llu, \"ns_per_op\": %.4f, \"mops_per_s\": %.4f}%s\n",
+      result->implementation, result->variant, (unsigned long long)result->operations,
+      result->seconds * 1e9 / (double)result->operations,
+      result->seconds > 0.0 ? result->operations / result->seconds / 1e6 : 0.0,
+      i + 1 < math_report->count ? "," : "");
+  }
+
+  fprintf(file, "  ]\n}\n");
+  bool ok = fclose(file) == 0;
+  if (ok) printf("[INFO]: Results written to %s\n", path);
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  const char *json_path = NULL;
+  uint32_t count = 524288;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+      json_path = argv[++i];
+    } else {
+      count = (uint32_t)strtoul(argv[i], NULL, 10);
+    }
+  }
+
+  if (count < MATH_HOT_ELEMENTS) {
+    fprintf(stderr, "[ERROR]: Element count must be at least %u\n", MATH_HOT_ELEMENTS);
+    return EXIT_FAILURE;
+  }
+
+  MathData data;
+  if (!math_data_init(&data, count)) {
+    fprintf(stderr, "[ERROR]: Out of memory\n");
+    math_data_free(&data);
+    return EXIT_FAILURE;
+  }
+
+  printf("[BENCH]: math, %u elements (%.1f MB of matrices), %u hot, best of %u\n",
+    count, 3.0 * count * sizeof(Matrix) / (1024.0 * 1024.0), MATH_HOT_ELEMENTS, MATH_TRIALS);
+
+  MathReport math_report = {0};
+  for (uint32_t k = 0; k < MATH_KERNELS; k++) {
+    uint64_t operations;
+    double seconds = time_kernel(math_kernels[k].kernel, &data, true, &operations);
+    report(&math_report, math_kernels[k].name, "scalar", "hot", operations, seconds);
+
+    seconds = time_kernel(math_kernels[k].kernel, &data, false, &operations);
+    report(&math_report, math_kernels[k].name, "scalar", "cold", operations, seconds);
+  }
+
+  bool ok = true;
+  if (bench_math_simd_enabled()) {
+    uint64_t operations;
+    double seconds = time_kernel(kernel_matrix_multiply_simd, &data, true, &operations);
+    report(&math_report, "MatrixMultiply", "simd", "hot", operations, seconds);
+    seconds = time_kernel(kernel_matrix_multiply_simd, &data, false, &operations);
+    report(&math_report, "MatrixMultiply", "simd", "cold", operations, seconds);
+
+    float simd_error = verify_simd_multiply(&data);
+    if (simd_error > MATH_SIMD_EPSILON) {
+      fprintf(stderr, "[ERROR]: SIMD MatrixMultiply differs from the scalar one by %g\n", simd_error);
+      ok = false;
+    }
+  } else {
+    printf("  - raymath has no SIMD path for this target, SIMD runs skipped\n");
+  }
+
+  if (!bench_transform_update(&math_report, &data, MATH_HOT_ELEMENTS, "hot") ||
+      !bench_transform_update(&math_report, &data, count, "cold")) {
+    fprintf(stderr, "[ERROR]: Transform graph creation failed\n");
+    ok = false;
+  }
+
+  float invert_error = verify_invert(&data);
+  if (invert_error > MATH_INVERT_EPSILON) {
+    fprintf(stderr, "[ERROR]: MatrixInvert error %g past %g\n", invert_error, MATH_INVERT_EPSILON);
+    ok = false;
+  }
+
+  if (ok && json_path != NULL) ok = write_json(&math_report, json_path, count);
+
+  math_data_free(&data);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,27 @@
+/*
+  raymath built a second time with RAYMATH_USE_SIMD_INTRINSICS, linked
+  into bench_math next to the scalar build in raymath.o. Static inline so
+  its functions don't clash with the scalar ones, only MatrixMultiply has
+  a SIMD path (SSE) upstream.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RAYMATH_STATIC_INLINE
+#define RAYMATH_USE_SIMD_INTRINSICS
+#include <raymath.h>
+
+bool bench_math_simd_enabled(void)
+{
+#if defined(RAYMATH_SSE_ENABLED)
+  return true;
+#else
+  return false;
+#endif
+}
+
+void bench_math_simd_multiply(const Matrix *a, const Matrix *b, Matrix *out, uint32_t begin, uint32_t end)
+{
+  for (uint32_t i = begin; i < end; i++) out[i] = MatrixMultiply(a[i], b[i]);
+}
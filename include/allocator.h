@@ -0,0 +1,77 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+  Memory helpers for the frame loop:
+    - Arena: linear bump allocator, everything is released at once by a reset.
+    - FrameArena: two arenas used on alternate frames, so data written for
+      frame N stays valid while frame N + 1 is being built (one frame in flight).
+    - mem_*: heap wrappers counting every allocation. Between
+      alloc_frame_begin/end the counts are checked per frame, and with
+      ALLOC_DEBUG_ENABLED (make ALLOC_DEBUG=enabled) any heap allocation
+      in a steady state frame aborts.
+*/
+
+#define ALLOC_DEFAULT_ALIGNMENT 16
+// Frames after startup (or alloc_steady_reset) allowed to allocate while caches warm up
+#define ALLOC_WARMUP_FRAMES 8
+
+typedef struct {
+  uint8_t *base;
+  size_t size;
+  size_t offset;
+  size_t peak;
+} Arena;
+
+bool arena_init(Arena *arena, size_t size);
+void arena_free(Arena *arena);
+
+// NULL when the arena is exhausted, align must be a power of two
+void *arena_alloc(Arena *arena, size_t size, size_t align);
+void arena_reset(Arena *arena);
+
+typedef struct {
+  Arena arenas[2];
+  uint32_t index;
+} FrameArena;
+
+bool frame_arena_init(FrameArena *frame, size_t size);
+void frame_arena_free(FrameArena *frame);
+
+// Switches to the other arena and resets it, call once at the start of a frame
+void frame_arena_begin(FrameArena *frame);
+void *frame_alloc(FrameArena *frame, size_t size);
+
+static inline Arena *frame_arena_current(FrameArena *frame)
+{
+  return &frame->arenas[frame->index];
+}
+
+typedef struct {
+  uint64_t allocations;       // mem_alloc/calloc/realloc calls since startup
+  uint64_t frees;
+  uint64_t bytes_live;
+  uint64_t bytes_peak;
+  uint64_t frame_allocations; // During the last frame closed by alloc_frame_end
+  uint64_t frames;
+} AllocStats;
+
+// Tracked heap allocations, memory must be released with mem_free
+void *mem_alloc(size_t size);
+void *mem_calloc(size_t count, size_t size);
+void *mem_realloc(void *ptr, size_t size);
+void mem_free(void *ptr);
+
+AllocStats alloc_stats(void);
+
+void alloc_frame_begin(void);
+// Returns the heap allocations made since alloc_frame_begin
+uint64_t alloc_frame_end(void);
+// Restarts the warmup, for scene or mode switches that legitimately allocate
+void alloc_steady_reset(void);
+
+#endif //!ALLOCATOR_H
@@ -0,0 +1,46 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  Frame benchmark harness: collects per frame times, draw counters, input
+  latency and heap allocations over a fixed number of frames and prints
+  a summary.
+  Frames are bracketed with alloc_frame_begin/end, so ALLOC_DEBUG builds
+  abort on steady state allocations.
+*/
+typedef struct {
+  const char *name;
+  uint32_t frame_count;
+  uint32_t frame;
+  double *frame_ms;
+  double frame_start;
+  uint64_t triangles;
+  uint64_t draws;
+  uint64_t frame_triangles;
+  uint64_t frame_draws;
+  uint64_t heap_allocations;  // Tracked allocations made inside measured frames
+  double latency_ms;          // Sum of input to present latencies
+  double latency_max_ms;
+  uint32_t latency_samples;
+} Bench;
+
+bool bench_begin(Bench *bench, const char *name, uint32_t frame_count);
+void bench_end(Bench *bench);
+
+void bench_frame_begin(Bench *bench);
+// Returns true once frame_count frames were recorded
+bool bench_frame_end(Bench *bench);
+
+void bench_count_draw(Bench *bench, uint32_t triangles);
+// For GPU driven draws whose counts are read back from the GPU
+void bench_count_draws(Bench *bench, uint32_t draws, uint64_t triangles);
+
+// Time from polling the input a frame reacts to until that frame was presented
+void bench_count_latency(Bench *bench, double latency_ms);
+
+void bench_report(const Bench *bench);
+
+#endif //!BENCH_H
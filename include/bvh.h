@@ -0,0 +1,74 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <raymath.h>
+#include <cull.h>
+#include <threading.h>
+
+/*
+  Bounding volume hierarchy over axis aligned boxes, built top down with
+  binned SAH. Nodes are flattened into one array, 32 bytes each, with
+  siblings stored next to each other so a pair fills a 64 byte line.
+  Children always come after their parent, which lets a full refit run
+  as a single reverse sweep.
+*/
+
+#define BVH_BINS     16
+#define BVH_MAX_LEAF 8
+#define BVH_STACK    128  // Traversal stack, build keeps the depth below it
+
+typedef struct {
+  Vector3 min;
+  Vector3 max;
+} BvhBounds;
+
+typedef struct {
+  Vector3 min;
+  uint32_t left_first;  // Interior: left child (right is left_first + 1), leaf: first entry in indices
+  Vector3 max;
+  uint32_t count;       // Primitives in a leaf, 0 for interior nodes
+} BvhNode;
+
+typedef struct {
+  BvhNode *nodes;       // Root at 0, node 1 unused so sibling pairs stay aligned
+  uint32_t node_count;
+  uint32_t *indices;    // Primitive indices referenced by leaves
+  uint32_t *parents;    // Per node, for incremental refits
+  uint32_t *leaf_of;    // Per primitive
+  BvhBounds *bounds;    // Per primitive, owned copy
+  uint32_t primitive_count;
+} Bvh;
+
+typedef struct {
+  uint32_t primitive;
+  float t;
+} BvhHit;
+
+/*
+  Exact primitive test for raycasts, returns true and the distance along
+  the ray on hit. NULL falls back to the primitive's box.
+*/
+typedef bool (*BvhRayFn)(void *user, uint32_t primitive, Vector3 origin, Vector3 direction, float *t);
+
+// pool may be NULL for a single threaded build
+bool bvh_build(Bvh *bvh, const BvhBounds *bounds, uint32_t count, ThreadPool *pool);
+void bvh_free(Bvh *bvh);
+
+// Moves one primitive and refits the path to the root, stopping once bounds stop changing
+void bvh_update(Bvh *bvh, uint32_t primitive, BvhBounds bounds);
+
+// Batch variant: set every moved primitive, then refit all nodes at once
+void bvh_set_bounds(Bvh *bvh, uint32_t primitive, BvhBounds bounds);
+void bvh_refit(Bvh *bvh);
+
+// Queries write at most capacity primitive indices and return how many were written
+uint32_t bvh_query_frustum(const Bvh *bvh, const Frustum *frustum, uint32_t *out, uint32_t capacity);
+uint32_t bvh_query_bounds(const Bvh *bvh, BvhBounds range, uint32_t *out, uint32_t capacity);
+
+// Nearest hit along direction within max_t, fn may be NULL
+bool bvh_raycast(const Bvh *bvh, Vector3 origin, Vector3 direction, float max_t, BvhRayFn fn, void *user, BvhHit *hit);
+
+#endif //!BVH_H
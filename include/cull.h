@@ -0,0 +1,49 @@
+#ifndef CULL_H
+#define CULL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <raymath.h>
+#include <threading.h>
+
+/*
+  CPU frustum culling of bounding spheres stored SoA, tested 8 (AVX) or
+  4 (SSE / NEON) at a time. Produces a compacted list of visible indices
+  in ascending order.
+*/
+
+#define CULL_GROUP_SIZE 8     // SoA arrays are padded to this
+#define CULL_CHUNK_SIZE 1024  // Objects per parallel job, multiple of CULL_GROUP_SIZE
+
+// Planes point inwards: visible when dot(xyz, p) + w >= -radius
+typedef struct {
+  Vector4 planes[6];  // Left, right, bottom, top, near, far
+} Frustum;
+
+typedef struct {
+  float *x;
+  float *y;
+  float *z;
+  float *radius;
+  uint32_t count;
+  uint32_t capacity;
+  uint32_t *chunk_visible;  // Per chunk scratch for the parallel pass
+} CullSpheres;
+
+// Extracts normalized planes from a view projection matrix (MatrixMultiply(view, projection))
+Frustum frustum_from_matrix(Matrix view_projection);
+
+bool cull_spheres_init(CullSpheres *spheres, uint32_t capacity);
+void cull_spheres_free(CullSpheres *spheres);
+
+// Grows count as needed, index must be below capacity
+void cull_spheres_set(CullSpheres *spheres, uint32_t index, Vector3 center, float radius);
+
+// Culls [begin, end), begin must be a multiple of CULL_GROUP_SIZE. Returns the visible count
+uint32_t cull_spheres(const Frustum *frustum, const CullSpheres *spheres, uint32_t begin, uint32_t end, uint32_t *visible);
+
+// Same over every sphere, spread over the pool in chunks. visible holds spheres->count entries
+uint32_t cull_spheres_parallel(ThreadPool *pool, const Frustum *frustum, CullSpheres *spheres, uint32_t *visible);
+
+#endif //!CULL_H
@@ -0,0 +1,60 @@
+#ifndef DAMAGE_H
+#define DAMAGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  Damage tracking for event driven rendering: a frame is only redrawn
+  when something invalidated it, optionally restricted to the damaged
+  rectangles (scissored redraw into a persistent target).
+  Rectangles are in framebuffer pixels, GL lower left origin.
+*/
+
+#define DAMAGE_MAX_RECTS 8
+
+typedef struct {
+  int32_t x;
+  int32_t y;
+  int32_t width;
+  int32_t height;
+} DamageRect;
+
+typedef struct {
+  DamageRect rects[DAMAGE_MAX_RECTS];
+  uint32_t rect_count;
+  bool full;
+  int32_t width;
+  int32_t height;
+
+  // Counters since damage_init, to compare idle cost across modes
+  uint64_t wakeups;         // Event loop iterations
+  uint64_t frames;          // Redrawn frames
+  uint64_t partial_frames;  // Frames restricted to damaged rects
+  uint64_t pixels;          // Pixels redrawn
+  uint64_t full_pixels;     // Pixels the same frames would cost redrawn fully
+} DamageTracker;
+
+// Starts fully damaged so the first frame is drawn
+void damage_init(DamageTracker *damage, int32_t width, int32_t height);
+
+// Resizing damages everything
+void damage_resize(DamageTracker *damage, int32_t width, int32_t height);
+void damage_invalidate(DamageTracker *damage);
+
+// Clipped to the framebuffer, overlapping rects merge, too many collapse into their bounds
+void damage_add(DamageTracker *damage, DamageRect rect);
+// Same for a normalized device coordinates box, padded by a pixel for rasterization
+void damage_add_ndc(DamageTracker *damage, float min_x, float min_y, float max_x, float max_y);
+
+static inline bool damage_pending(const DamageTracker *damage)
+{
+  return damage->full || damage->rect_count > 0;
+}
+
+// Call once the damage was redrawn, counts the frame
+void damage_clear(DamageTracker *damage);
+
+void damage_report(const DamageTracker *damage, double seconds);
+
+#endif //!DAMAGE_H
@@ -0,0 +1,123 @@
+#ifndef ECS_H
+#define ECS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <threading.h>
+
+/*
+  Entity component storage. Entities sharing the same component set live
+  in one archetype, split in fixed size chunks holding one tightly packed
+  array per component (SoA), so queries walk contiguous memory.
+  Every chunk of an archetype is full except the last one: destroying an
+  entity moves the archetype's last entity into the hole.
+*/
+
+#define ECS_MAX_COMPONENTS 32
+#define ECS_MAX_ARCHETYPES 256
+#define ECS_CHUNK_BYTES    (16 * 1024)
+#define ECS_COLUMN_ALIGN   64
+
+typedef uint32_t EcsMask;   // Bit i set when component i is present
+
+#define ECS_COMPONENT(id) ((EcsMask)1u << (id))
+
+// Handle, stale once the generation of its slot moved on
+typedef struct {
+  uint32_t index;
+  uint32_t generation;
+} Entity;
+
+typedef struct {
+  uint8_t *data;
+  uint32_t count;
+} EcsChunk;
+
+typedef struct {
+  EcsMask mask;
+  uint32_t capacity;                        // Entities per chunk
+  uint32_t offsets[ECS_MAX_COMPONENTS];     // Column byte offset inside a chunk, entity column at 0
+  EcsChunk *chunks;
+  uint32_t chunk_count;
+  uint32_t chunk_capacity;
+  uint32_t entity_count;
+} EcsArchetype;
+
+// One chunk's worth of a query
+typedef struct {
+  const EcsArchetype *archetype;
+  uint8_t *data;
+  uint32_t count;
+} EcsView;
+
+typedef struct {
+  uint32_t archetype;
+  uint32_t row;           // Across the archetype's chunks
+  uint32_t generation;
+  bool alive;
+} EcsSlot;
+
+typedef struct {
+  uint32_t component_sizes[ECS_MAX_COMPONENTS];
+  uint32_t component_count;
+
+  EcsArchetype archetypes[ECS_MAX_ARCHETYPES];
+  uint32_t archetype_count;
+
+  EcsSlot *slots;
+  uint32_t slot_count;
+  uint32_t slot_capacity;
+  uint32_t *free_slots;
+  uint32_t free_count;
+
+  // Scratch for ecs_query_parallel, grown only when the chunk count grows
+  EcsView *views;
+  uint32_t view_capacity;
+} EcsWorld;
+
+typedef struct {
+  EcsWorld *world;
+  EcsMask mask;
+  uint32_t archetype;
+  uint32_t chunk;
+} EcsQuery;
+
+typedef void (*EcsSystemFn)(void *user, const EcsView *view, uint32_t worker);
+
+void ecs_init(EcsWorld *world);
+void ecs_free(EcsWorld *world);
+
+// Returns the component id, ECS_MAX_COMPONENTS when full
+uint32_t ecs_register_component(EcsWorld *world, uint32_t size);
+
+// Components start zeroed. A zero handle {0, 0} is returned on failure
+Entity ecs_create(EcsWorld *world, EcsMask mask);
+void ecs_destroy(EcsWorld *world, Entity entity);
+bool ecs_alive(const EcsWorld *world, Entity entity);
+
+// Moves the entity to the archetype of mask, shared components are kept
+bool ecs_set_mask(EcsWorld *world, Entity entity, EcsMask mask);
+
+// NULL when dead or the component is missing
+void *ecs_get(const EcsWorld *world, Entity entity, uint32_t component);
+
+// Iterates every chunk whose archetype has all components of mask
+EcsQuery ecs_query(EcsWorld *world, EcsMask mask);
+bool ecs_query_next(EcsQuery *query, EcsView *view);
+
+// Runs fn over every matching chunk, chunks spread over the pool (may be NULL)
+void ecs_query_parallel(EcsWorld *world, EcsMask mask, ThreadPool *pool, EcsSystemFn fn, void *user);
+
+static inline void *ecs_view_column(const EcsView *view, uint32_t component)
+{
+  return view->data + view->archetype->offsets[component];
+}
+
+static inline const Entity *ecs_view_entities(const EcsView *view)
+{
+  return (const Entity *)view->data;
+}
+
+#endif //!ECS_H
@@ -0,0 +1,90 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <threading.h>
+#include <image_write.h>
+
+/*
+  Asynchronous frame capture to numbered image files:
+    - frame_capture_frame queues a glReadPixels of the back buffer into a
+      free slot's pixel pack buffer and fences it, it never waits;
+    - once the fence is found signaled (on a later frame) the slot goes
+      to the writer threads, which encode straight from the persistently
+      mapped buffer and free the slot;
+    - with every slot busy (writers behind) the frame is dropped rather
+      than stalling the render loop, drops are reported.
+  Call frame_capture_frame after drawing and before the swap, on the GL
+  thread. Files are named <prefix>NNNNNN.<ppm|png>.
+*/
+
+#define FRAME_CAPTURE_SLOTS       8
+#define FRAME_CAPTURE_MAX_WRITERS 4
+
+typedef enum {
+  FRAME_CAPTURE_PPM,
+  FRAME_CAPTURE_PNG,
+} FrameCaptureFormat;
+
+typedef enum {
+  FRAME_SLOT_FREE,
+  FRAME_SLOT_READING,   // Copy queued on the GPU, fence pending
+  FRAME_SLOT_QUEUED,    // Waiting for a writer
+  FRAME_SLOT_WRITING,
+} FrameSlotState;
+
+typedef struct {
+  uint32_t buffer;
+  uint8_t *pixels;      // Persistent map
+  size_t capacity;
+  void *fence;          // GLsync
+  int32_t width;
+  int32_t height;
+  uint64_t frame;
+  FrameSlotState state;
+} FrameCaptureSlot;
+
+typedef struct FrameCapture FrameCapture;
+
+typedef struct {
+  FrameCapture *capture;
+  Thread thread;
+  ImageWriter writer;
+} FrameCaptureWriter;
+
+struct FrameCapture {
+  const char *prefix;
+  FrameCaptureFormat format;
+
+  FrameCaptureSlot slots[FRAME_CAPTURE_SLOTS];
+  uint32_t queue[FRAME_CAPTURE_SLOTS];   // Slots handed to the writers, FIFO
+  uint32_t queue_head;
+  uint32_t queue_count;
+  uint64_t next_frame;
+
+  FrameCaptureWriter writers[FRAME_CAPTURE_MAX_WRITERS];
+  uint32_t writer_count;
+  Mutex mutex;
+  Cond cond;
+  bool quit;
+
+  uint64_t captured;
+  uint64_t written;
+  uint64_t dropped;
+  uint64_t failed;
+};
+
+bool frame_capture_start(FrameCapture *capture, const char *prefix, FrameCaptureFormat format, uint32_t writer_count);
+// Hands over every pending readback, waits for the writers to finish them and joins them
+void frame_capture_stop(FrameCapture *capture);
+
+void frame_capture_frame(FrameCapture *capture, int32_t width, int32_t height);
+
+void frame_capture_report(const FrameCapture *capture);
+
+const char *frame_capture_format_name(FrameCaptureFormat format);
+bool frame_capture_format_parse(const char *name, FrameCaptureFormat *format);
+
+#endif //!FRAME_CAPTURE_H
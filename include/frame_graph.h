@@ -0,0 +1,145 @@
+#ifndef FRAME_GRAPH_H
+#define FRAME_GRAPH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <render_target.h>
+
+/*
+  Declarative frame graph, rebuilt every frame:
+    1. frame_graph_reset, then declare resources (transient textures,
+       imported textures, the backbuffer) and passes with the resources
+       they read and write.
+    2. frame_graph_compile orders the passes by their dependencies, culls
+       the ones whose results nothing uses, and computes the lifetime of
+       every transient texture.
+    3. frame_graph_execute binds each pass' attachments, inserts the
+       glMemoryBarrier bits its reads need and calls it.
+
+  Transient textures are taken from a RenderTexturePool when their first
+  pass runs and given back after their last one, so transients with the
+  same format and size whose lifetimes don't overlap alias the same
+  texture. Like render targets they are allocated rounded up to
+  RENDER_TARGET_GRANULARITY and rendered to through the viewport, sizes
+  changing within a bucket (dynamic resolution) keep hitting the same pool
+  textures. Their contents are undefined on first use, the writer clears.
+  Passes writing an imported resource (or marked FRAME_GRAPH_SIDE_EFFECT)
+  are never culled. Everything is stored in fixed arrays, building a
+  frame doesn't allocate.
+*/
+
+#define FRAME_GRAPH_MAX_PASSES    32
+#define FRAME_GRAPH_MAX_RESOURCES 64
+#define FRAME_GRAPH_MAX_ACCESSES  8   // Reads + writes per pass
+
+#define FRAME_GRAPH_INVALID UINT32_MAX
+
+typedef enum {
+  FRAME_GRAPH_ATTACHMENT,   // Bound to the pass framebuffer
+  FRAME_GRAPH_SAMPLED,      // Texture fetches
+  FRAME_GRAPH_IMAGE,        // Image load/store, incoherent writes
+  FRAME_GRAPH_TRANSFER,     // Blit or copy
+} FrameGraphAccess;
+
+#define FRAME_GRAPH_SIDE_EFFECT (1u << 0)
+
+typedef struct FrameGraph FrameGraph;
+typedef void (*FrameGraphPassFn)(const FrameGraph *graph, uint32_t pass, void *user);
+
+typedef struct {
+  const char *name;
+  uint32_t format;
+  int32_t width;
+  int32_t height;
+  bool imported;
+  bool backbuffer;
+
+  int32_t alloc_width;    // Texture size, width and height are the rendered area
+  int32_t alloc_height;
+
+  uint32_t texture;       // Physical texture while alive, 0 for the backbuffer
+  uint32_t first;         // Execution order positions of the first and last use
+  uint32_t last;
+  FrameGraphAccess last_write;
+  bool written;
+} FrameGraphResource;
+
+typedef struct {
+  uint32_t resource;
+  FrameGraphAccess access;
+  bool write;
+} FrameGraphUse;
+
+typedef struct {
+  const char *name;
+  FrameGraphPassFn fn;
+  void *user;
+  uint32_t flags;
+
+  FrameGraphUse uses[FRAME_GRAPH_MAX_ACCESSES];
+  uint32_t use_count;
+  bool live;
+} FrameGraphPass;
+
+typedef struct {
+  uint32_t passes;
+  uint32_t culled;
+  uint32_t transients;    // Transient textures declared by live passes
+  uint32_t textures;      // Distinct physical textures they used
+  uint32_t barriers;
+} FrameGraphStats;
+
+struct FrameGraph {
+  FrameGraphPass passes[FRAME_GRAPH_MAX_PASSES];
+  uint32_t pass_count;
+  FrameGraphResource resources[FRAME_GRAPH_MAX_RESOURCES];
+  uint32_t resource_count;
+
+  uint32_t order[FRAME_GRAPH_MAX_PASSES];   // Live passes in execution order
+  uint32_t order_count;
+  bool compiled;
+  bool failed;                              // A declaration overflowed, compile fails
+
+  uint32_t fbos[FRAME_GRAPH_MAX_PASSES];    // Per execution slot, kept across frames
+  uint32_t read_fbo;                        // Color read by the running pass through FRAME_GRAPH_TRANSFER
+  FrameGraphStats stats;
+};
+
+void frame_graph_init(FrameGraph *graph);
+// Needs the GL context, releases the cached framebuffers
+void frame_graph_destroy(FrameGraph *graph);
+void frame_graph_reset(FrameGraph *graph);
+
+// Return FRAME_GRAPH_INVALID when full, which also fails the compile
+uint32_t frame_graph_create_texture(FrameGraph *graph, const char *name, uint32_t format, int32_t width, int32_t height);
+uint32_t frame_graph_import_texture(FrameGraph *graph, const char *name, uint32_t texture, uint32_t format, int32_t width, int32_t height);
+uint32_t frame_graph_import_backbuffer(FrameGraph *graph, int32_t width, int32_t height);
+
+uint32_t frame_graph_add_pass(FrameGraph *graph, const char *name, uint32_t flags, FrameGraphPassFn fn, void *user);
+void frame_graph_read(FrameGraph *graph, uint32_t pass, uint32_t resource, FrameGraphAccess access);
+void frame_graph_write(FrameGraph *graph, uint32_t pass, uint32_t resource, FrameGraphAccess access);
+
+// False on a dependency cycle, an invalid declaration or an attachment mix the pass can't bind
+bool frame_graph_compile(FrameGraph *graph);
+// Transient textures come from and go back to pool
+bool frame_graph_execute(FrameGraph *graph, RenderTexturePool *pool);
+
+// For pass functions, 0 for the backbuffer or a resource not alive in this pass
+static inline uint32_t frame_graph_texture(const FrameGraph *graph, uint32_t resource)
+{
+  return resource < graph->resource_count ? graph->resources[resource].texture : 0;
+}
+
+/*
+  For pass functions blitting a FRAME_GRAPH_TRANSFER read: a framebuffer
+  with that color texture attached, bound to GL_READ_FRAMEBUFFER.
+*/
+static inline uint32_t frame_graph_read_framebuffer(const FrameGraph *graph)
+{
+  return graph->read_fbo;
+}
+
+void frame_graph_report(const FrameGraph *graph);
+
+#endif //!FRAME_GRAPH_H
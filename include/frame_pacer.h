@@ -0,0 +1,92 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct GLFWwindow GLFWwindow;
+
+/*
+  Frame pacing for the window's swap chain:
+    - present mode: vsync, adaptive vsync (tears instead of halving the
+      rate when a frame misses the vblank) or uncapped;
+    - optional frame rate limiter sleeping most of the frame, then
+      spinning the last FRAME_PACER_SPIN_SECONDS for an exact deadline;
+    - frame latency limit: a fence per presented frame, the CPU waits
+      before starting a frame while max_frames_ahead frames are still
+      unfinished on the GPU.
+  Present intervals give the jitter, fences the CPU start to GPU done latency.
+
+    frame_pacer_begin(&pacer);    // Before polling input / simulating
+    ... frame ...
+    frame_pacer_present(&pacer);  // Instead of glfwSwapBuffers
+*/
+
+#define FRAME_PACER_MAX_FRAMES_AHEAD 4
+#define FRAME_PACER_SPIN_SECONDS     0.002
+
+typedef enum {
+  FRAME_PRESENT_VSYNC,
+  FRAME_PRESENT_ADAPTIVE,
+  FRAME_PRESENT_UNCAPPED,
+} FramePresentMode;
+
+typedef struct {
+  uint64_t frames;
+  double interval_avg_ms;   // Present to present
+  double interval_jitter_ms; // Standard deviation of the interval
+  double interval_max_ms;
+  double latency_avg_ms;    // Frame begin to its fence found signaled
+  double latency_max_ms;
+} FramePacerStats;
+
+typedef struct {
+  GLFWwindow *window;
+  FramePresentMode mode;
+  double frame_seconds;     // Limiter period, 0 when off
+  uint32_t max_frames_ahead;
+
+  double frame_start;
+  double deadline;
+  double last_present;
+
+  // Ring of in flight frames, oldest at fence_head
+  void *fences[FRAME_PACER_MAX_FRAMES_AHEAD];  // GLsync
+  double fence_start[FRAME_PACER_MAX_FRAMES_AHEAD];
+  uint32_t fence_head;
+  uint32_t fence_count;
+
+  uint64_t frames;
+  uint64_t intervals;
+  double interval_sum;
+  double interval_sq_sum;
+  double interval_max;
+  uint64_t latencies;
+  double latency_sum;
+  double latency_max;
+} FramePacer;
+
+/*
+  target_fps 0 disables the limiter. max_frames_ahead is clamped to
+  [1, FRAME_PACER_MAX_FRAMES_AHEAD]. The window's context must be current.
+*/
+void frame_pacer_init(FramePacer *pacer, GLFWwindow *window, FramePresentMode mode, double target_fps, uint32_t max_frames_ahead);
+void frame_pacer_destroy(FramePacer *pacer);
+
+// Applies the swap interval, false when adaptive vsync isn't supported and plain vsync is used
+bool frame_pacer_set_mode(FramePacer *pacer, FramePresentMode mode);
+
+void frame_pacer_begin(FramePacer *pacer);
+void frame_pacer_present(FramePacer *pacer);
+
+// Waits for every presented frame, before an event driven loop goes to sleep
+void frame_pacer_drain(FramePacer *pacer);
+
+FramePacerStats frame_pacer_stats(const FramePacer *pacer);
+void frame_pacer_report(const FramePacer *pacer);
+
+const char *frame_present_mode_name(FramePresentMode mode);
+// Parses "vsync", "adaptive" or "uncapped"
+bool frame_present_mode_parse(const char *name, FramePresentMode *mode);
+
+#endif //!FRAME_PACER_H
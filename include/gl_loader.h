@@ -0,0 +1,83 @@
+#ifndef GL_LOADER_H
+#define GL_LOADER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <threading.h>
+
+typedef struct GLFWwindow GLFWwindow;
+
+/*
+  Background GL resource creation. Each loader thread owns an invisible
+  window whose context shares objects with the main window, so buffers,
+  textures, shaders and programs created there are usable by the render
+  context. Container objects (VAOs, FBOs, program pipelines) are not
+  shared and must still be created on the rendering context.
+
+  After a job the loader inserts a fence and flushes. gl_load_poll (or
+  gl_load_wait), called on the rendering context, then makes that context
+  wait on the fence with glWaitSync before the objects are used, so the
+  frame loop never blocks on an upload.
+*/
+
+#define GL_LOADER_MAX_THREADS 4
+
+typedef enum {
+  GL_LOAD_IDLE,
+  GL_LOAD_QUEUED,
+  GL_LOAD_RUNNING,
+  GL_LOAD_DONE,       // Uploaded, fence not yet waited on by the render context
+  GL_LOAD_PUBLISHED,  // Safe to use on the render context
+} GlLoadState;
+
+// Runs on a loader thread with its shared context current
+typedef bool (*GlLoadFn)(void *user);
+
+// Owned by the caller, must stay alive until published or the loader is destroyed
+typedef struct GlLoadJob {
+  GlLoadFn fn;
+  void *user;
+  struct GlLoadJob *next;
+  void *fence;        // GLsync
+  GlLoadState state;
+  bool ok;            // fn's result, valid once published
+} GlLoadJob;
+
+typedef struct GlLoader GlLoader;
+
+typedef struct {
+  GlLoader *loader;
+  GLFWwindow *context;
+  Thread thread;
+} GlLoaderWorker;
+
+struct GlLoader {
+  GlLoaderWorker workers[GL_LOADER_MAX_THREADS];
+  uint32_t worker_count;
+
+  Mutex mutex;
+  Cond cond;
+  GlLoadJob *head;
+  GlLoadJob *tail;
+  bool quit;
+};
+
+/*
+  Creates thread_count (clamped to GL_LOADER_MAX_THREADS) shared contexts,
+  must be called from the main thread as it creates windows. share is the
+  window the render context belongs to.
+*/
+bool gl_loader_create(GlLoader *loader, GLFWwindow *share, uint32_t thread_count);
+
+// Finishes running jobs, drops queued ones. Main thread only
+void gl_loader_destroy(GlLoader *loader);
+
+void gl_loader_submit(GlLoader *loader, GlLoadJob *job, GlLoadFn fn, void *user);
+
+// Render context only. True once published, check job->ok for the result
+bool gl_load_poll(GlLoader *loader, GlLoadJob *job);
+// Blocking version of gl_load_poll, for loads the frame cannot go on without
+void gl_load_wait(GlLoader *loader, GlLoadJob *job);
+
+#endif //!GL_LOADER_H
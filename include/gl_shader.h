@@ -0,0 +1,11 @@
+#ifndef GL_SHADER_H
+#define GL_SHADER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Compiles and links a program, diagnostics are printed to stderr
+bool gl_shader_program(uint32_t *program, const char *vertex_src, const char *fragment_src);
+bool gl_shader_compute(uint32_t *program, const char *compute_src);
+
+#endif //!GL_SHADER_H
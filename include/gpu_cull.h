@@ -0,0 +1,88 @@
+#ifndef GPU_CULL_H
+#define GPU_CULL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <raymath.h>
+#include <mesh.h>
+#include <mesh_lod.h>
+
+/*
+  GPU driven culling: a compute pass tests every instance against the
+  frustum and a Hi-Z pyramid built from the previous frame's depth, picks
+  its LOD and appends a DrawElementsIndirectCommand through an atomic
+  counter. The counter feeds glMultiDrawElementsIndirectCount, so the CPU
+  never touches per instance data after upload.
+*/
+
+#define GPU_CULL_STATS_LATENCY 3  // Frames between a dispatch and reading its counters
+
+// std430 layout shared with the shaders
+typedef struct {
+  float center[3];
+  float radius;     // World space bounding sphere
+  float color[3];
+  float scale;      // Converts mesh LOD errors to world space
+} GpuCullInstance;
+
+typedef struct {
+  uint32_t count;
+  uint32_t instance_count;
+  uint32_t first_index;
+  int32_t base_vertex;
+  uint32_t base_instance;
+} DrawElementsIndirectCommand;
+
+typedef struct {
+  uint32_t draws;
+  uint32_t triangles;
+} GpuCullStats;
+
+typedef struct {
+  uint32_t cull_program;
+  uint32_t pyramid_program;
+
+  uint32_t instance_buffer;
+  uint32_t command_buffer;
+  uint32_t counter_buffer;  // {draw count, triangle count}
+  uint32_t instance_count;
+
+  // Hi-Z pyramid, max depth per texel
+  uint32_t pyramid;
+  int32_t pyramid_width;
+  int32_t pyramid_height;
+  int32_t pyramid_levels;
+  bool pyramid_valid;
+
+  // Counters copied to persistently mapped slots, read back a few frames late
+  uint32_t stats_buffer;
+  const GpuCullStats *stats_mapped;
+  void *stats_fences[GPU_CULL_STATS_LATENCY];
+  uint32_t stats_frame;
+  GpuCullStats stats;
+} GpuCull;
+
+bool gpu_cull_create(GpuCull *cull, const GpuCullInstance *instances, uint32_t instance_count);
+void gpu_cull_destroy(GpuCull *cull);
+
+// (Re)allocates the pyramid for a depth buffer of the given size
+bool gpu_cull_resize(GpuCull *cull, int32_t width, int32_t height);
+
+// Reduces depth_texture (GL_DEPTH_COMPONENT*) into the pyramid used by the next dispatch
+void gpu_cull_build_pyramid(GpuCull *cull, uint32_t depth_texture);
+
+// occlusion false only frustum culls
+void gpu_cull_dispatch(
+  GpuCull *cull, const Mesh *mesh,
+  Matrix view_projection, Vector3 camera,
+  const LodSelector *selector, bool occlusion
+);
+
+// Binds the instance buffer at SSBO binding 0 and issues the indirect draws
+void gpu_cull_draw(const GpuCull *cull, const Mesh *mesh);
+
+// Latest counters that reached the CPU, GPU_CULL_STATS_LATENCY frames old
+GpuCullStats gpu_cull_stats(const GpuCull *cull);
+
+#endif //!GPU_CULL_H
@@ -0,0 +1,46 @@
+#ifndef IMAGE_OPS_H
+#define IMAGE_OPS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+  Post-processing of decoded 8 bit images, run on the loader threads
+  before upload:
+    - vertical flip, rows swapped in place 16 / 32 bytes at a time;
+    - RGB to RGBA expansion, with the flip fused in (rows written bottom
+      up) so a 3 channel image is only walked once;
+    - red / blue swap (RGBA <-> BGRA), premultiplied alpha (rounded
+      exactly like c * a / 255), sRGB to linear float through a table,
+      gathered 8 lanes at a time with AVX2.
+  The vector path (AVX2, SSE2 with SSSE3 shuffles when enabled, NEON) is
+  picked at compile time like cull.c, build with -mavx2 or -mssse3 to get
+  the wider ones. The *_reference versions are the plain per byte loops,
+  kept as the baseline for the tests and the image benchmark.
+*/
+
+// Widest instruction set the kernels were built with
+const char *image_ops_isa(void);
+
+void image_flip_vertical(uint8_t *pixels, size_t stride, int32_t height);
+
+// dst and src must not overlap, dst rows hold width * 4 bytes
+void image_rgb_to_rgba(uint8_t *dst, size_t dst_stride, const uint8_t *src, size_t src_stride,
+                       int32_t width, int32_t height, bool flip);
+
+// In place, count pixels
+void image_swap_red_blue(uint8_t *rgba, size_t count);
+void image_premultiply_alpha(uint8_t *rgba, size_t count);
+
+// sRGB encoded RGBA8 to linear RGBA float, alpha is linear already and only rescaled
+void image_srgb_to_linear(float *dst, const uint8_t *rgba, size_t count);
+
+void image_flip_vertical_reference(uint8_t *pixels, size_t stride, int32_t height);
+void image_rgb_to_rgba_reference(uint8_t *dst, size_t dst_stride, const uint8_t *src, size_t src_stride,
+                                 int32_t width, int32_t height, bool flip);
+void image_swap_red_blue_reference(uint8_t *rgba, size_t count);
+void image_premultiply_alpha_reference(uint8_t *rgba, size_t count);
+void image_srgb_to_linear_reference(float *dst, const uint8_t *rgba, size_t count);
+
+#endif //!IMAGE_OPS_H
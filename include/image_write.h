@@ -0,0 +1,45 @@
+#ifndef IMAGE_WRITE_H
+#define IMAGE_WRITE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+  Minimal image file writers, in the spirit of stb_image_write:
+    - PPM: binary P6, no encoding cost, large files;
+    - PNG: 8 bit RGB, per row Sub/Up filter choice and a single probe
+      LZ77 over fixed Huffman codes. Compresses less than zlib, but fast
+      enough to keep up with frame capture.
+  Input is RGBA rows (alpha dropped), bottom_up flips them as read back
+  from GL. The writer keeps its scratch buffers between images so steady
+  state writes don't allocate, use one per thread.
+*/
+
+#define IMAGE_WRITE_HASH_BITS 15
+
+typedef struct {
+  uint8_t *rows;        // Current and previous row converted to RGB
+  size_t rows_capacity;
+  uint8_t *filtered;    // Whole filtered image, the deflate input
+  size_t filtered_capacity;
+  uint8_t *out;         // Compressed stream
+  size_t out_capacity;
+  int32_t *hash;        // Last position of every 3 byte prefix hash
+
+  // Fixed Huffman codes (bit reversed, ready to emit) and lookup tables
+  uint16_t literal_codes[288];
+  uint8_t literal_lengths[288];
+  uint8_t length_symbols[259];
+  uint8_t distance_symbols[512];
+  uint8_t distance_codes[30];
+  uint32_t crc_table[256];
+} ImageWriter;
+
+void image_writer_init(ImageWriter *writer);
+void image_writer_free(ImageWriter *writer);
+
+bool image_write_ppm(ImageWriter *writer, const char *path, int32_t width, int32_t height, const uint8_t *rgba, size_t stride, bool bottom_up);
+bool image_write_png(ImageWriter *writer, const char *path, int32_t width, int32_t height, const uint8_t *rgba, size_t stride, bool bottom_up);
+
+#endif //!IMAGE_WRITE_H
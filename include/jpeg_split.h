@@ -0,0 +1,77 @@
+#ifndef JPEG_SPLIT_H
+#define JPEG_SPLIT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+  Splits a baseline JPEG into horizontal bands that decode independently,
+  so one large image can be spread over a thread pool. Entropy coded data
+  can only be entered at a restart marker (DC predictors and the bit
+  reader reset there), so this needs a restart interval (DRI) and uses the
+  markers that fall on the start of an MCU row, as encoders emit them with
+  restart intervals of one or more rows.
+
+  A band becomes a standalone stream: the original headers with the frame
+  height patched, the band's entropy data up to (not including) the next
+  band's restart marker, then EOI. Restart markers inside a band are kept,
+  decoders accept them in any order. With vertically subsampled chroma the
+  upsampler reads one chroma row past each edge, so jpeg_split_band adds a
+  context MCU row on each side when one is available, and the decoded
+  band then matches the rows of a whole image decode exactly.
+
+  Progressive, multi scan and restart-less files are not splittable,
+  decode them whole.
+*/
+
+typedef struct {
+  const uint8_t *file;
+  size_t size;
+  size_t header_size;       // SOI up to the end of the SOS segment
+  size_t height_offset;     // Frame height field, patched per band
+  int32_t width;
+  int32_t height;
+  uint32_t components;
+  uint32_t mcu_height;      // Pixel rows per MCU row
+  uint32_t mcu_rows;
+  bool subsampled;          // Some component is vertically subsampled, bands need context rows
+  size_t *row_offsets;      // Entropy data start of each MCU row, 0 when the row starts mid interval
+  size_t entropy_end;       // Position of the marker ending the scan (EOI)
+} JpegSplit;
+
+// Bands that decode on their own, as emitted by jpeg_split_band
+typedef struct {
+  uint32_t first_row;       // Output pixel rows [first_row, first_row + row_count)
+  uint32_t row_count;
+  uint32_t skip_rows;       // Context rows decoded above first_row, to drop
+} JpegBand;
+
+/*
+  Parses the headers and indexes the restart markers. False (without an
+  error) when the file isn't a JPEG that can be split, file must stay
+  alive until jpeg_split_free.
+*/
+bool jpeg_split_parse(JpegSplit *split, const uint8_t *file, size_t size);
+void jpeg_split_free(JpegSplit *split);
+
+// MCU rows a band may start at, row 0 always can
+static inline bool jpeg_split_row_start(const JpegSplit *split, uint32_t row)
+{
+  return row == 0 || (row < split->mcu_rows && split->row_offsets[row] != 0);
+}
+
+/*
+  Picks up to max_bands band boundaries of roughly equal height, returns
+  the band count (at least 1) and writes bands + 1 MCU row boundaries.
+*/
+uint32_t jpeg_split_bands(const JpegSplit *split, uint32_t max_bands, uint32_t *boundaries);
+
+/*
+  Standalone stream for MCU rows [row_begin, row_end), both valid row
+  starts (or mcu_rows for the end), context rows included. Returns a
+  mem_alloc'ed stream of *size bytes, NULL when out of memory.
+*/
+uint8_t *jpeg_split_band(const JpegSplit *split, uint32_t row_begin, uint32_t row_end, JpegBand *band, size_t *size);
+
+#endif //!JPEG_SPLIT_H
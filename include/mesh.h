@@ -0,0 +1,79 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <vertex_layout.h>
+#include <mesh_optimizer.h>
+
+// Attribute locations shared by meshes and shaders
+#define MESH_ATTRIB_POSITION 0
+#define MESH_ATTRIB_COLOR    1
+#define MESH_ATTRIB_NORMAL   2
+#define MESH_ATTRIB_TEXCOORD 3
+
+/*
+  GPU mesh: one vertex buffer per layout binding plus an optional
+  index buffer. The VAO is shared through the vertex layout cache,
+  buffers are attached to it when the mesh is bound.
+*/
+typedef struct {
+  VertexLayout layout;
+  uint32_t vao;
+  bool owns_vao;          // Not cached (the layout cache was full), deleted with the mesh
+  uint32_t vbos[VERTEX_LAYOUT_MAX_BINDINGS];
+  uint32_t ebo;
+  uint32_t index_type;    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, 0 when not indexed
+  uint32_t index_count;
+  uint32_t vertex_count;
+  MeshLodRange lods[MESH_MAX_LODS];  // Ranges inside the index buffer, LOD 0 is full detail
+  uint32_t lod_count;
+  float bounds_min[3];
+  float bounds_max[3];
+} Mesh;
+
+// Smallest index type able to address vertex_count vertices
+uint32_t mesh_index_type(uint32_t vertex_count);
+uint32_t mesh_index_size(uint32_t index_type);
+
+/*
+  Uploads already packed vertex data (one pointer per layout binding)
+  and optional indices (NULL for non indexed drawing). Indices are
+  narrowed to 16 bits when the vertex count allows it.
+*/
+bool mesh_create(
+  Mesh *mesh, const VertexLayout *layout,
+  const void *const *vertices, uint32_t vertex_count,
+  const uint32_t *indices, uint32_t index_count
+);
+
+// Same as mesh_create, indices hold every LOD range back to back
+bool mesh_create_lods(
+  Mesh *mesh, const VertexLayout *layout,
+  const void *const *vertices, uint32_t vertex_count,
+  const uint32_t *indices, uint32_t index_count,
+  const MeshLodRange *lods, uint32_t lod_count
+);
+void mesh_destroy(Mesh *mesh);
+
+/*
+  Loads a .mesh container (see mesh_file.h). The file is memory mapped and
+  its blobs are handed straight to glNamedBufferStorage, no parse or copy.
+*/
+bool mesh_load(Mesh *mesh, const char *path);
+
+/*
+  mesh_load split for loader threads (see gl_loader.h): buffers are shared
+  between contexts but VAOs are not, so mesh_load_buffers runs on the
+  loader context and mesh_attach_vao on the rendering one once the upload
+  is published.
+*/
+bool mesh_load_buffers(Mesh *mesh, const char *path);
+void mesh_attach_vao(Mesh *mesh);
+
+void mesh_bind(const Mesh *mesh);
+void mesh_draw(const Mesh *mesh);
+void mesh_draw_lod(const Mesh *mesh, uint32_t lod);
+
+#endif //!MESH_H
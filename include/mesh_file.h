@@ -0,0 +1,87 @@
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <vertex_layout.h>
+#include <mesh_optimizer.h>
+
+/*
+  Binary mesh container (.mesh), little endian:
+    [MeshFileHeader][padding][vertex blob 0][padding]...[index blob]
+  The index blob holds every LOD back to back, ranges are in the header.
+  Every blob starts on a MESH_FILE_ALIGNMENT boundary and holds data
+  exactly as the GPU consumes it, so a mapped file can be handed to
+  glNamedBufferStorage as is.
+*/
+
+#define MESH_FILE_MAGIC     0x4853454du  // "MESH"
+#define MESH_FILE_VERSION   2u
+#define MESH_FILE_ALIGNMENT 4096u
+
+typedef struct {
+  uint32_t format;      // VertexFormat
+  uint32_t components;
+  uint32_t location;
+  uint32_t binding;
+  uint32_t offset;
+} MeshFileAttrib;
+
+typedef struct {
+  uint32_t stride;
+  uint32_t divisor;
+  uint64_t offset;      // Blob file offset
+  uint64_t size;        // Blob size in bytes
+} MeshFileBinding;
+
+typedef struct {
+  uint32_t index_offset;  // In indices, not bytes
+  uint32_t index_count;
+  float error;
+} MeshFileLod;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t header_size;
+  uint32_t vertex_count;
+  uint32_t index_count;
+  uint32_t index_size;  // 0 (not indexed), 2 or 4 bytes
+  uint32_t attrib_count;
+  uint32_t binding_count;
+  MeshFileAttrib attribs[VERTEX_LAYOUT_MAX_ATTRIBS];
+  MeshFileBinding bindings[VERTEX_LAYOUT_MAX_BINDINGS];
+  uint64_t index_offset;
+  uint64_t index_size_bytes;
+  uint32_t lod_count;
+  MeshFileLod lods[MESH_MAX_LODS];
+  float bounds_min[3];
+  float bounds_max[3];
+} MeshFileHeader;
+
+typedef struct {
+  const VertexLayout *layout;
+  const void *const *vertices;  // One packed blob per layout binding
+  uint32_t vertex_count;
+  const uint32_t *indices;      // May be NULL
+  uint32_t index_count;
+  const MeshLodRange *lods;     // NULL for a single LOD spanning all indices
+  uint32_t lod_count;
+  float bounds_min[3];
+  float bounds_max[3];
+} MeshFileData;
+
+// Writes the container, indices are narrowed to 16 bits when possible
+bool mesh_file_write(const char *path, const MeshFileData *data);
+
+/*
+  Checks magic, version, that every blob lies inside the file, that
+  attributes fit their binding's stride and that indices address existing
+  vertices (a pass over the index blob, once per load).
+*/
+const MeshFileHeader *mesh_file_header(const void *file, size_t size);
+void mesh_file_layout(const MeshFileHeader *header, VertexLayout *layout);
+
+#endif //!MESH_FILE_H
@@ -0,0 +1,26 @@
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <raymath.h>
+#include <mesh.h>
+
+/*
+  Per frame LOD selection: picks the coarsest LOD whose simplification
+  error, projected to the screen, stays under max_pixel_error.
+*/
+typedef struct {
+  float pixels_per_unit;  // Pixels covered by one world unit at distance one
+  float max_pixel_error;
+  bool enabled;           // When false LOD 0 is always selected
+} LodSelector;
+
+// projection as built by MatrixPerspective, m5 holds 1 / tan(fovy / 2)
+LodSelector lod_selector_create(Matrix projection, float viewport_height, float max_pixel_error);
+
+// scale converts the mesh's object space error to world space
+uint32_t lod_select(const LodSelector *selector, const Mesh *mesh, Vector3 camera, Vector3 center, float scale);
+
+#endif //!MESH_LOD_H
@@ -0,0 +1,99 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+  CPU side mesh optimization, no GL calls so it can run both at load
+  time and offline in tools.
+  Vertex data is given as one or more streams (one per vertex binding),
+  each holding vertex_count elements of size bytes, stride bytes apart.
+*/
+
+#define MESH_REMAP_UNUSED 0xffffffffu
+#define MESH_DEFAULT_CACHE_SIZE 16
+#define MESH_MAX_LODS 8
+
+typedef struct {
+  void *data;
+  size_t size;
+  size_t stride;
+} MeshStream;
+
+typedef struct {
+  uint32_t vertices_before;
+  uint32_t vertices_after;
+  float acmr_before;  // Average cache miss ratio (transformed vertices per triangle)
+  float acmr_after;
+} MeshOptimizeStats;
+
+// Range of a level of detail inside a concatenated index buffer
+typedef struct {
+  uint32_t index_offset;
+  uint32_t index_count;
+  float error;        // Object space distance error relative to LOD 0, an upper bound
+} MeshLodRange;
+
+/*
+  Builds a remap table where byte identical vertices (across all streams)
+  share the same new index. Returns the unique vertex count.
+*/
+uint32_t mesh_weld(uint32_t *remap, const MeshStream *streams, uint32_t stream_count, uint32_t vertex_count);
+
+// Compacts the vertices of a stream in place following remap (unused entries dropped)
+bool mesh_remap_stream(MeshStream *stream, uint32_t vertex_count, const uint32_t *remap);
+void mesh_remap_indices(uint32_t *indices, uint32_t index_count, const uint32_t *remap);
+
+// Tipsify triangle reordering for post-transform cache locality
+bool mesh_optimize_vertex_cache(
+  uint32_t *dst, const uint32_t *indices, uint32_t index_count,
+  uint32_t vertex_count, uint32_t cache_size
+);
+
+// Remap table ordering vertices by first use in the index buffer, returns used vertex count
+uint32_t mesh_optimize_vertex_fetch(uint32_t *remap, const uint32_t *indices, uint32_t index_count, uint32_t vertex_count);
+
+// FIFO cache simulation, vertices transformed per triangle (0.5 best case, 3 worst)
+float mesh_acmr(const uint32_t *indices, uint32_t index_count, uint32_t vertex_count, uint32_t cache_size);
+
+/*
+  Full pipeline: weld, triangle reorder and vertex fetch reorder.
+  Streams and indices are rewritten in place, returns the new vertex count
+  (0 on allocation failure). stats may be NULL.
+*/
+uint32_t mesh_optimize(
+  MeshStream *streams, uint32_t stream_count, uint32_t vertex_count,
+  uint32_t *indices, uint32_t index_count,
+  MeshOptimizeStats *stats
+);
+
+/*
+  Quadric error metric edge collapse, writes at most index_count indices to dst
+  (may alias indices) sharing the original vertex buffer. Stops at
+  target_index_count or when the next collapse would exceed max_error
+  (object space distance). Returns the new index count, 0 on failure.
+  positions are float xyz, stride bytes apart.
+*/
+uint32_t mesh_simplify(
+  uint32_t *dst, const uint32_t *indices, uint32_t index_count,
+  const float *positions, size_t stride, uint32_t vertex_count,
+  uint32_t target_index_count, float max_error, float *result_error
+);
+
+/*
+  Builds a LOD chain into lod_indices (LOD 0 is a copy of indices), each level
+  keeping about reduction of the previous one's triangles. Levels are simplified
+  from the previous one, with max_error bounding each step, their errors
+  accumulate. Returns the LOD count.
+*/
+uint32_t mesh_build_lods(
+  uint32_t *lod_indices, uint32_t lod_index_capacity,
+  MeshLodRange *lods, uint32_t max_lods,
+  const uint32_t *indices, uint32_t index_count,
+  const float *positions, size_t stride, uint32_t vertex_count,
+  float reduction, float max_error
+);
+
+#endif //!MESH_OPTIMIZER_H
@@ -0,0 +1,37 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+  Thin OS layer for what GLFW doesn't cover.
+  Win32 and POSIX implementations live side by side in platform.c
+*/
+
+typedef struct {
+  const void *data;
+  size_t size;
+} PlatformFileMap;
+
+// Maps a whole file read only, the mapping stays valid until unmapped
+bool platform_map_file(PlatformFileMap *map, const char *path);
+void platform_unmap_file(PlatformFileMap *map);
+
+size_t platform_page_size(void);
+
+// Logical processors available to the process, at least 1
+uint32_t platform_cpu_count(void);
+
+// Monotonic clock in seconds, for code running without a GLFW context
+double platform_time(void);
+
+/*
+  Sleeps at least seconds, with the OS timer granularity (about 1 ms with
+  high resolution timers, up to 15.6 ms without). Callers needing exact
+  deadlines sleep short and spin on platform_time for the rest.
+*/
+void platform_sleep(double seconds);
+
+#endif //!PLATFORM_H
@@ -0,0 +1,106 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <raymath.h>
+#include <mesh.h>
+
+/*
+  Deferred draw submission. Commands are recorded with a 64 bit sort key
+  into per thread buffers (no locking, one buffer per pool worker), then
+  merged, radix sorted by key and executed, skipping program and mesh
+  binds that would not change any state.
+
+  Key layout, most significant first:
+    [63:60] layer     pass / blend mode, opaque before transparent
+    [59:48] program
+    [47:24] material  anything else worth grouping (mesh, LOD, textures)
+    [23:0]  depth     quantized [0, 1], front to back
+*/
+
+#define RENDER_KEY_LAYER_BITS    4
+#define RENDER_KEY_PROGRAM_BITS  12
+#define RENDER_KEY_MATERIAL_BITS 24
+#define RENDER_KEY_DEPTH_BITS    24
+
+typedef struct {
+  const Mesh *mesh;
+  uint32_t program;
+  uint32_t lod;
+  int32_t u_mvp;      // -1 when the program has no such uniform
+  int32_t u_color;
+  Matrix mvp;
+  Vector3 color;
+} RenderCommand;
+
+// Padded so workers pushing into neighbouring buffers never share a cache line
+#define RENDER_BUFFER_PADDING (128 - 2 * sizeof(void *) - 2 * sizeof(uint32_t))
+
+typedef struct {
+  RenderCommand *commands;
+  uint64_t *keys;
+  uint32_t count;
+  uint32_t capacity;
+  uint8_t padding[RENDER_BUFFER_PADDING];
+} RenderBuffer;
+
+typedef struct {
+  uint64_t key;
+  const RenderCommand *command;
+} RenderSortItem;
+
+typedef struct {
+  RenderBuffer *buffers;
+  uint32_t buffer_count;
+
+  // Merged and sorted commands, valid until the next reset
+  RenderSortItem *items;
+  RenderSortItem *scratch;
+  uint32_t item_count;
+  uint32_t item_capacity;
+} RenderQueue;
+
+typedef struct {
+  uint32_t draws;
+  uint64_t triangles;
+  uint32_t program_binds;
+  uint32_t mesh_binds;
+} RenderQueueStats;
+
+// depth is clamped to [0, 1], pass 1 - depth for back to front layers
+static inline uint64_t render_key(uint32_t layer, uint32_t program, uint32_t material, float depth)
+{
+  const uint32_t depth_max = (1u << RENDER_KEY_DEPTH_BITS) - 1;
+  depth = depth < 0.0f ? 0.0f : depth > 1.0f ? 1.0f : depth;
+
+  uint64_t key = layer & ((1u << RENDER_KEY_LAYER_BITS) - 1);
+  key = (key << RENDER_KEY_PROGRAM_BITS) | (program & ((1u << RENDER_KEY_PROGRAM_BITS) - 1));
+  key = (key << RENDER_KEY_MATERIAL_BITS) | (material & ((1u << RENDER_KEY_MATERIAL_BITS) - 1));
+  key = (key << RENDER_KEY_DEPTH_BITS) | (uint32_t)(depth * depth_max);
+  return key;
+}
+
+// buffer_count is usually thread_pool_size(pool)
+bool render_queue_init(RenderQueue *queue, uint32_t buffer_count);
+void render_queue_free(RenderQueue *queue);
+
+// Drops every recorded command, capacity is kept so steady state frames don't allocate
+void render_queue_reset(RenderQueue *queue);
+
+static inline RenderBuffer *render_queue_buffer(RenderQueue *queue, uint32_t worker)
+{
+  return &queue->buffers[worker];
+}
+
+// Only the owning thread may push into a buffer, false on allocation failure
+bool render_buffer_push(RenderBuffer *buffer, uint64_t key, const RenderCommand *command);
+
+// Merges every buffer and sorts by key, equal keys keep buffer then recording order
+bool render_queue_sort(RenderQueue *queue);
+
+// Issues the sorted commands on the calling (GL) thread
+RenderQueueStats render_queue_execute(const RenderQueue *queue);
+
+#endif //!RENDER_QUEUE_H
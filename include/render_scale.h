@@ -0,0 +1,84 @@
+#ifndef RENDER_SCALE_H
+#define RENDER_SCALE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <render_target.h>
+
+/*
+  Dynamic resolution: the scene renders into its offscreen target at
+  scale * output size, then is upscaled to the default framebuffer.
+  The GPU time of every frame is measured with a ring of
+  GL_TIME_ELAPSED queries read back without stalling (a few frames
+  late). The smoothed time drives the scale towards RENDER_SCALE_HEADROOM
+  of the budget, assuming GPU time follows the pixel count.
+
+    render_scale_size(&rs, width, height, &w, &h);  // Size to render at
+    render_scale_begin(&rs);
+    ... render at w x h ...
+    render_scale_upscale(&rs, &target, width, height);
+    render_scale_end(&rs);
+*/
+
+#define RENDER_SCALE_QUERIES    4
+#define RENDER_SCALE_MIN        0.5f
+#define RENDER_SCALE_STEP       0.05f   // Scales are multiples of this, small changes aren't worth a resize
+#define RENDER_SCALE_HEADROOM   0.9     // Fraction of the budget aimed for
+#define RENDER_SCALE_SMOOTHING  0.2     // Weight of the newest sample
+#define RENDER_SCALE_COOLDOWN   8       // Samples ignored after a change, covers the query latency
+#define RENDER_SCALE_SHARPNESS  0.5f
+
+typedef enum {
+  RENDER_UPSCALE_BILINEAR,  // Filtered blit
+  RENDER_UPSCALE_SHARPEN,   // Bilinear plus an unsharp mask to recover some edge contrast
+} RenderUpscale;
+
+typedef struct {
+  RenderUpscale upscale;
+  double budget_ms;
+  float scale;
+  float min_scale;
+  float max_scale;
+
+  uint32_t queries[RENDER_SCALE_QUERIES];
+  uint32_t query_head;
+  uint32_t query_count;
+  bool timing;              // A query is open for the current frame
+  double gpu_ms;            // Smoothed
+  uint32_t cooldown;
+
+  // Sharpen pass
+  uint32_t program;
+  int32_t u_uv_max;
+  int32_t u_sharpness;
+  uint32_t sampler;
+  uint32_t vao;
+
+  uint64_t frames;
+  uint64_t samples;
+  uint64_t changes;
+  double scale_sum;
+  double gpu_ms_sum;
+  float scale_low;
+} RenderScale;
+
+// A budget of 0 keeps the scale at 1, upscale then only matters when set by hand
+bool render_scale_init(RenderScale *rs, double budget_ms, RenderUpscale upscale);
+void render_scale_destroy(RenderScale *rs);
+
+void render_scale_size(const RenderScale *rs, int32_t width, int32_t height, int32_t *scaled_width, int32_t *scaled_height);
+
+// Brackets the timed GPU work of a frame, begin also reads back finished queries
+void render_scale_begin(RenderScale *rs);
+void render_scale_end(RenderScale *rs);
+
+// Draws the rendered part of source's color over the whole default framebuffer
+void render_scale_upscale(const RenderScale *rs, const RenderTarget *source, int32_t width, int32_t height);
+
+void render_scale_report(const RenderScale *rs);
+
+const char *render_upscale_name(RenderUpscale upscale);
+bool render_upscale_parse(const char *name, RenderUpscale *upscale);
+
+#endif //!RENDER_SCALE_H
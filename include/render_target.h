@@ -0,0 +1,110 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  Offscreen render target management:
+    - RenderTexturePool: immutable (glTextureStorage2D) attachments pooled
+      by format and size. Released textures are reused by later requests
+      and only deleted after RENDER_POOL_MAX_AGE frames unused.
+    - RenderTarget: an FBO with optional color and depth attachments from
+      a pool. Attachments are allocated rounded up to
+      RENDER_TARGET_GRANULARITY and rendered to through a viewport, so a
+      drag resize only reallocates when it leaves the current bucket.
+    - RenderResize: coalesces window resize events, the new size is
+      applied at most once per frame.
+  All but RenderResize need the GL context current.
+*/
+
+#define RENDER_POOL_MAX_TEXTURES  32
+#define RENDER_POOL_MAX_AGE       120
+#define RENDER_TARGET_GRANULARITY 128
+
+typedef struct {
+  uint32_t texture;
+  uint32_t format;
+  int32_t width;
+  int32_t height;
+  bool in_use;
+  uint64_t last_used;   // Pool frame of the last release
+} RenderPoolTexture;
+
+typedef struct {
+  RenderPoolTexture textures[RENDER_POOL_MAX_TEXTURES];
+  uint32_t texture_count;
+  uint64_t frame;
+
+  uint64_t allocations;
+  uint64_t reuses;
+  uint64_t evictions;
+} RenderTexturePool;
+
+void render_texture_pool_init(RenderTexturePool *pool);
+void render_texture_pool_destroy(RenderTexturePool *pool);
+
+// Single level texture, 0 on failure
+uint32_t render_texture_acquire(RenderTexturePool *pool, uint32_t format, int32_t width, int32_t height);
+void render_texture_release(RenderTexturePool *pool, uint32_t texture);
+
+// Advances the pool clock and deletes textures unused for RENDER_POOL_MAX_AGE frames
+void render_texture_pool_frame(RenderTexturePool *pool);
+
+typedef struct {
+  uint32_t fbo;
+  uint32_t color_format;  // 0 for none
+  uint32_t depth_format;  // 0 for none
+  uint32_t color;
+  uint32_t depth;
+  int32_t width;          // Size rendered to
+  int32_t height;
+  int32_t alloc_width;    // Attachment size
+  int32_t alloc_height;
+} RenderTarget;
+
+// Attachment size for a rendered size, shared by render targets and frame graph transients
+static inline int32_t render_target_round(int32_t size)
+{
+  return (size + RENDER_TARGET_GRANULARITY - 1) / RENDER_TARGET_GRANULARITY * RENDER_TARGET_GRANULARITY;
+}
+
+void render_target_init(RenderTarget *target, uint32_t color_format, uint32_t depth_format);
+void render_target_destroy(RenderTarget *target, RenderTexturePool *pool);
+
+/*
+  Reallocates the attachments only when the size outgrows them or they
+  are over four times the needed area. Returns true when the contents
+  were lost (new attachments), false when they were kept or on failure.
+*/
+bool render_target_resize(RenderTarget *target, RenderTexturePool *pool, int32_t width, int32_t height);
+
+static inline bool render_target_valid(const RenderTarget *target)
+{
+  return target->fbo != 0 && target->width > 0 && target->height > 0;
+}
+
+// Binds the FBO and sets the viewport to the rendered size
+void render_target_bind(const RenderTarget *target);
+// Copies the rendered size of the color attachment to the default framebuffer
+void render_target_blit(const RenderTarget *target);
+
+typedef struct {
+  int32_t width;            // Applied size
+  int32_t height;
+  int32_t pending_width;    // Latest size reported
+  int32_t pending_height;
+  bool pending;
+  uint64_t events;          // Size callbacks received
+  uint64_t applied;         // Sizes actually applied
+} RenderResize;
+
+void render_resize_init(RenderResize *resize, int32_t width, int32_t height);
+// Safe to call from a GLFW callback, only records the latest size
+void render_resize_request(RenderResize *resize, int32_t width, int32_t height);
+// Once per frame, true with the final size when a burst of events ended in a change
+bool render_resize_apply(RenderResize *resize, int32_t *width, int32_t *height);
+
+void render_targets_report(const RenderTexturePool *pool, const RenderResize *resize);
+
+#endif //!RENDER_TARGET_H
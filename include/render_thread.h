@@ -0,0 +1,81 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <threading.h>
+#include <render_queue.h>
+
+typedef struct GLFWwindow GLFWwindow;
+
+/*
+  Render thread owning the window's GL context. The main thread keeps
+  polling events and simulating: it fills frame N + 1 while the render
+  thread submits and presents frame N. Frames are handed over through
+  two RenderFrame slots, so the main thread runs at most one frame ahead.
+
+    RenderFrame *frame = render_thread_acquire(&rt);  // Blocks while both slots are in flight
+    ... record into frame->queue, set size and input_time ...
+    render_thread_submit(&rt, frame);
+*/
+
+#define RENDER_THREAD_FRAMES 2
+
+typedef struct {
+  RenderQueue queue;
+  int32_t width;
+  int32_t height;
+  double input_time;        // glfwGetTime() when the input this frame reacts to was polled
+  uint64_t index;
+
+  // Written by the render thread once presented, read back on the next acquire
+  bool presented;
+  double latency_ms;        // input_time to the end of glfwSwapBuffers
+  RenderQueueStats stats;
+} RenderFrame;
+
+// Runs on the render thread with the context current, swap follows
+typedef RenderQueueStats (*RenderSubmitFn)(void *user, const RenderFrame *frame);
+
+typedef enum {
+  RENDER_FRAME_FREE,
+  RENDER_FRAME_RECORDING,
+  RENDER_FRAME_READY,
+} RenderFrameState;
+
+typedef struct {
+  Thread thread;
+  Mutex mutex;
+  Cond cond;
+  GLFWwindow *window;
+  RenderSubmitFn submit;
+  void *user;
+
+  RenderFrame frames[RENDER_THREAD_FRAMES];
+  RenderFrameState states[RENDER_THREAD_FRAMES];
+  uint64_t acquired;        // Frames handed to the main thread
+  uint64_t rendered;        // Frames the render thread picked up
+  bool quit;
+} RenderThread;
+
+/*
+  Releases the context from the calling thread and makes it current on
+  a new render thread. buffer_count is the per frame queue buffer count.
+*/
+bool render_thread_start(
+  RenderThread *rt, GLFWwindow *window, uint32_t buffer_count,
+  RenderSubmitFn submit, void *user
+);
+
+// Presents every submitted frame, joins and makes the context current on the caller again
+void render_thread_stop(RenderThread *rt);
+
+/*
+  Next slot to record into. The slot still holds the results of the frame
+  that used it RENDER_THREAD_FRAMES frames ago (check presented).
+*/
+RenderFrame *render_thread_acquire(RenderThread *rt);
+void render_thread_submit(RenderThread *rt, RenderFrame *frame);
+
+#endif //!RENDER_THREAD_H
@@ -0,0 +1,107 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <raymath.h>
+#include <mesh.h>
+#include <mesh_lod.h>
+#include <bench.h>
+#include <cull.h>
+#include <threading.h>
+#include <gpu_cull.h>
+#include <bvh.h>
+#include <transform.h>
+#include <allocator.h>
+#include <render_queue.h>
+#include <render_target.h>
+#include <render_scale.h>
+#include <frame_graph.h>
+
+/*
+  Benchmark scene: a grid of instances of a procedurally generated,
+  LOD'ed sphere seen from an orbiting camera.
+*/
+typedef struct {
+  Vector3 position;
+  float scale;
+  Vector3 color;
+} SceneObject;
+
+typedef struct {
+  Mesh mesh;
+  float mesh_radius;
+  uint32_t program;
+  int32_t u_mvp;
+  int32_t u_color;
+
+  SceneObject *objects;
+  uint32_t object_count;
+  TransformGraph transforms;  // Node i is object i
+
+  // World space bounds, SoA for culling, and the compacted visible list
+  CullSpheres bounds;
+  Bvh bvh;
+  FrameArena frame;           // Per frame data, the visible list lives here
+  uint32_t *visible;
+  uint32_t visible_count;
+  ThreadPool *pool;
+
+  // CPU path draws are recorded by the pool workers, sorted then submitted
+  RenderQueue queue;
+
+  // GPU driven path
+  GpuCull gpu;
+  uint32_t gpu_program;
+  int32_t u_view_projection;
+
+  /*
+    Frames go through a frame graph: the scene pass renders into transient
+    color and depth textures, the GPU driven path builds the Hi-Z pyramid
+    from that depth, and a last pass upscales or blits the color into the
+    backbuffer. Transients come from textures and go back every frame.
+  */
+  FrameGraph graph;
+  RenderTexturePool *textures;
+  int32_t render_width;       // Size rendered at last frame, the pyramid follows it
+  int32_t render_height;
+  RenderScale *scale;         // Dynamic resolution, NULL renders at the output size
+
+  Vector3 camera;
+  Matrix view;
+  Matrix projection;
+  float far_plane;
+  float viewport_height;
+  int32_t frame_width;        // Framebuffer size given to the last scene_update
+  int32_t frame_height;
+} Scene;
+
+#define SCENE_DRAW_LOD  (1u << 0)
+#define SCENE_DRAW_CULL (1u << 1)
+#define SCENE_DRAW_GPU  (1u << 2)  // Frustum + Hi-Z culling and LOD selection in a compute pass
+#define SCENE_DRAW_BVH  (1u << 3)  // With SCENE_DRAW_CULL, query the BVH instead of testing every object
+
+// pool may be NULL, culling then runs on the calling thread. textures must outlive the scene
+bool scene_create(Scene *scene, uint32_t grid_size, ThreadPool *pool, RenderTexturePool *textures);
+void scene_destroy(Scene *scene);
+
+// Moves the camera along its orbit, time in seconds. No GL calls
+void scene_update(Scene *scene, float time, int width, int height);
+
+// flags is a SCENE_DRAW_* mask, bench may be NULL
+void scene_draw(Scene *scene, uint32_t flags, Bench *bench);
+
+/*
+  Split version of the CPU path for a render thread: scene_record culls
+  and records the frame into queue without touching GL (the queue needs
+  thread_pool_size(pool) buffers), scene_submit runs it through the
+  frame graph on the GL thread. SCENE_DRAW_GPU is not supported.
+*/
+bool scene_record(Scene *scene, uint32_t flags, RenderQueue *queue);
+RenderQueueStats scene_submit(Scene *scene, const RenderQueue *queue, int width, int height);
+
+// Nearest object hit by the ray, false when nothing is hit
+bool scene_pick(const Scene *scene, Vector3 origin, Vector3 direction, uint32_t *object);
+
+#endif //!SCENE_H
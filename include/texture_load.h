@@ -0,0 +1,71 @@
+#ifndef TEXTURE_LOAD_H
+#define TEXTURE_LOAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <threading.h>
+
+/*
+  Image file to GL texture, split for loader threads (see gl_loader.h).
+  stb_image decodes without its own flip or channel expansion, both are
+  done afterwards by the image_ops.h kernels: 3 channel images are
+  expanded to RGBA with the flip fused in, others are decoded as RGBA and
+  flipped in place. Premultiplication, BGRA ordering and sRGB to linear
+  conversion follow, so the upload is a straight copy.
+
+  Given a thread pool, conversions are split over row ranges, and large
+  JPEGs with restart markers are decoded as independent bands (see
+  jpeg_split.h), each converted into the final image by the thread that
+  decoded it. Other formats can't be entered mid stream (PNG inflates and
+  unfilters every row from the previous one), they decode on one thread.
+*/
+
+#define TEXTURE_LOAD_FLIP        (1u << 0)  // Bottom row first, as GL expects
+#define TEXTURE_LOAD_SRGB        (1u << 1)  // GL_SRGB8_ALPHA8 storage, the GPU linearizes on sampling
+#define TEXTURE_LOAD_LINEAR      (1u << 2)  // Linearized on the CPU into GL_RGBA16F storage
+#define TEXTURE_LOAD_PREMULTIPLY (1u << 3)  // Color multiplied by alpha, in the encoded space
+#define TEXTURE_LOAD_BGRA        (1u << 4)  // Uploaded as GL_BGRA, the native order of most drivers
+#define TEXTURE_LOAD_MIPMAPS     (1u << 5)
+
+// Below this, one decode costs less than splitting it
+#define TEXTURE_SPLIT_MIN_PIXELS (2048 * 2048)
+#define TEXTURE_MAX_BANDS        128
+
+typedef struct {
+  int32_t width;
+  int32_t height;
+  uint32_t flags;
+  void *pixels;       // RGBA8 (BGRA8 with TEXTURE_LOAD_BGRA) or RGBA32F with TEXTURE_LOAD_LINEAR
+  size_t size;
+  bool from_stb;      // pixels still owned by stb_image (decoded as RGBA8 and converted in place)
+  uint32_t bands;     // Independently decoded bands, 1 for a whole image decode
+  double decode_ms;   // Banded decodes include their conversion
+  double convert_ms;  // Flip, expansion and the other image_ops passes
+} TextureImage;
+
+// Any thread, pool may be NULL to decode and convert on the calling thread
+bool texture_decode(TextureImage *image, const char *path, uint32_t flags, ThreadPool *pool);
+void texture_image_free(TextureImage *image);
+
+// Needs a current context, 0 on failure
+uint32_t texture_upload(const TextureImage *image);
+
+typedef struct {
+  const char *path;
+  uint32_t flags;
+  ThreadPool *pool;   // Optional, only used by this load while it runs
+  uint32_t texture;
+  int32_t width;
+  int32_t height;
+  uint32_t bands;
+  double decode_ms;
+  double convert_ms;
+  double upload_ms;
+} TextureLoad;
+
+// GlLoadFn: decode, convert and upload load->path on the loader thread
+bool texture_load_job(void *user);
+
+#endif //!TEXTURE_LOAD_H
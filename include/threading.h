@@ -0,0 +1,65 @@
+#ifndef THREADING_H
+#define THREADING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  Minimal threading layer: threads, mutexes and condition variables on
+  top of Win32 or pthreads, plus a persistent worker pool for data
+  parallel loops.
+*/
+
+#if defined(_WIN32)
+// Storage for HANDLE, SRWLOCK and CONDITION_VARIABLE (all pointer sized)
+typedef struct { void *handle; } Thread;
+typedef struct { void *handle; } Mutex;
+typedef struct { void *handle; } Cond;
+#else
+#include <pthread.h>
+typedef struct { pthread_t handle; } Thread;
+typedef struct { pthread_mutex_t handle; } Mutex;
+typedef struct { pthread_cond_t handle; } Cond;
+#endif
+
+typedef void (*ThreadFn)(void *user);
+
+bool thread_create(Thread *thread, ThreadFn fn, void *user);
+void thread_join(Thread *thread);
+
+void mutex_init(Mutex *mutex);
+void mutex_destroy(Mutex *mutex);
+void mutex_lock(Mutex *mutex);
+void mutex_unlock(Mutex *mutex);
+
+void cond_init(Cond *cond);
+void cond_destroy(Cond *cond);
+void cond_wait(Cond *cond, Mutex *mutex);
+void cond_signal(Cond *cond);
+void cond_broadcast(Cond *cond);
+
+#define THREAD_POOL_MAX_WORKERS 64
+
+/*
+  Processes [begin, end) of a parallel loop, worker is 0 for the calling
+  thread and 1..worker_count for pool threads (indexes per worker scratch).
+*/
+typedef void (*ThreadPoolFn)(void *user, uint32_t begin, uint32_t end, uint32_t worker);
+
+typedef struct ThreadPool ThreadPool;
+
+// thread_count 0 picks one thread per logical processor minus the caller
+ThreadPool *thread_pool_create(uint32_t thread_count);
+void thread_pool_destroy(ThreadPool *pool);
+
+// Threads that may run a job, the caller included
+uint32_t thread_pool_size(const ThreadPool *pool);
+
+/*
+  Splits [0, count) in chunk sized ranges handed out dynamically, the
+  caller participates and returns once every range is done.
+  pool may be NULL to run serially.
+*/
+void thread_pool_parallel_for(ThreadPool *pool, uint32_t count, uint32_t chunk, ThreadPoolFn fn, void *user);
+
+#endif //!THREADING_H
@@ -0,0 +1,58 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <raymath.h>
+
+/*
+  Transform hierarchy stored as flat arrays with parents before children,
+  so world matrices resolve in one forward pass. Only nodes whose local
+  transform changed, and their descendants, are recomputed; a graph
+  without changes returns immediately. World matrices are contiguous and
+  can be uploaded as an instance buffer as is.
+*/
+
+#define TRANSFORM_NONE 0xffffffffu
+
+typedef struct {
+  uint32_t count;
+  uint32_t capacity;
+
+  uint32_t *parents;          // TRANSFORM_NONE for roots, always lower than the child's index
+  Vector3 *translations;      // Local TRS
+  Quaternion *rotations;
+  Vector3 *scales;
+  Matrix *world;
+
+  uint8_t *dirty;
+  uint32_t first_dirty;       // count when nothing changed
+
+  // World matrices rewritten by the last update, [begin, end), empty when begin == end
+  uint32_t changed_begin;
+  uint32_t changed_end;
+} TransformGraph;
+
+bool transform_graph_init(TransformGraph *graph, uint32_t capacity);
+void transform_graph_free(TransformGraph *graph);
+
+// Appends a node, parent must already exist. Returns its index, TRANSFORM_NONE on failure
+uint32_t transform_add(TransformGraph *graph, uint32_t parent, Vector3 translation, Quaternion rotation, Vector3 scale);
+
+void transform_set_local(TransformGraph *graph, uint32_t node, Vector3 translation, Quaternion rotation, Vector3 scale);
+void transform_set_translation(TransformGraph *graph, uint32_t node, Vector3 translation);
+void transform_set_rotation(TransformGraph *graph, uint32_t node, Quaternion rotation);
+void transform_set_scale(TransformGraph *graph, uint32_t node, Vector3 scale);
+
+// Recomputes world matrices of dirty subtrees
+void transform_graph_update(TransformGraph *graph);
+
+/*
+  Reorders nodes by depth (stable within a level), so each level is
+  contiguous. remap, when not NULL, receives the new index of every old
+  node. Marks everything dirty.
+*/
+bool transform_graph_sort(TransformGraph *graph, uint32_t *remap);
+
+#endif //!TRANSFORM_H
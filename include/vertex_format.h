@@ -0,0 +1,62 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+  Compact vertex storage formats.
+  Source geometry is authored as plain floats, then packed into the
+  smallest format each attribute tolerates before being uploaded.
+*/
+typedef enum {
+  VERTEX_FORMAT_FLOAT32 = 0,      // GL_FLOAT
+  VERTEX_FORMAT_HALF16,           // GL_HALF_FLOAT
+  VERTEX_FORMAT_UNORM8,           // GL_UNSIGNED_BYTE, normalized [0, 1]
+  VERTEX_FORMAT_SNORM8,           // GL_BYTE, normalized [-1, 1]
+  VERTEX_FORMAT_SNORM10_10_10_2,  // GL_INT_2_10_10_10_REV, normalized, xyz only
+  VERTEX_FORMAT_COUNT
+} VertexFormat;
+
+typedef struct {
+  const char *name;
+  uint32_t gl_type;
+  uint32_t component_size; // Bytes per component (0 for packed formats)
+  uint32_t packed_size;    // Bytes per element for packed formats
+  bool normalized;
+} VertexFormatInfo;
+
+typedef struct {
+  VertexFormat format;
+  uint32_t components;
+} VertexAttribFormat;
+
+const VertexFormatInfo *vertex_format_info(VertexFormat format);
+
+// Bytes taken by one attribute, padded up to 4 bytes as GL prefers
+uint32_t vertex_attrib_size(VertexAttribFormat attrib);
+
+// Component count passed to GL (packed formats are always fetched as 4)
+uint32_t vertex_attrib_gl_size(VertexAttribFormat attrib);
+
+/*
+  Converts count float elements from src into the attribute format at dst.
+  Strides are in bytes, src elements hold attrib.components floats.
+  Returns false on an unsupported format/component combination.
+*/
+bool vertex_attrib_pack(
+  VertexAttribFormat attrib,
+  void *dst, size_t dst_stride,
+  const float *src, size_t src_stride,
+  size_t count
+);
+
+// Contiguous conversion kernels (SIMD when available)
+void vertex_convert_f32_to_f16(uint16_t *dst, const float *src, size_t count);
+void vertex_convert_f16_to_f32(float *dst, const uint16_t *src, size_t count);
+void vertex_convert_f32_to_unorm8(uint8_t *dst, const float *src, size_t count);
+void vertex_convert_f32_to_snorm8(int8_t *dst, const float *src, size_t count);
+void vertex_convert_f32_to_snorm10(uint32_t *dst, const float *xyz, size_t count);
+
+#endif //!VERTEX_FORMAT_H
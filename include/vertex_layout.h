@@ -0,0 +1,77 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <vertex_format.h>
+
+#define VERTEX_LAYOUT_MAX_ATTRIBS  16
+#define VERTEX_LAYOUT_MAX_BINDINGS 8
+
+/*
+  Data driven vertex input description, maps 1:1 onto the
+  separate attribute format API (glVertexArrayAttribFormat & co).
+  Type, component count and normalization come from the VertexAttribFormat.
+*/
+typedef struct {
+  VertexAttribFormat format;
+  uint32_t location;
+  uint32_t binding;
+  uint32_t offset;   // Relative to the start of a vertex in its binding
+} VertexLayoutAttrib;
+
+typedef struct {
+  uint32_t stride;
+  uint32_t divisor;  // 0 = per vertex, N = advance every N instances
+} VertexLayoutBinding;
+
+typedef struct {
+  VertexLayoutAttrib attribs[VERTEX_LAYOUT_MAX_ATTRIBS];
+  VertexLayoutBinding bindings[VERTEX_LAYOUT_MAX_BINDINGS];
+  uint32_t attrib_count;
+  uint32_t binding_count;
+} VertexLayout;
+
+void vertex_layout_init(VertexLayout *layout);
+
+/*
+  Appends an attribute at the end of a binding, its offset is the
+  binding's current stride. Returns false when limits are exceeded.
+*/
+bool vertex_layout_add(VertexLayout *layout, uint32_t location, VertexAttribFormat format, uint32_t binding);
+bool vertex_layout_set_divisor(VertexLayout *layout, uint32_t binding, uint32_t divisor);
+
+// All attributes in binding 0, one after the other (locations 0..count-1)
+bool vertex_layout_interleaved(VertexLayout *layout, const VertexAttribFormat *formats, uint32_t count);
+// One binding (stream) per attribute (locations 0..count-1)
+bool vertex_layout_deinterleaved(VertexLayout *layout, const VertexAttribFormat *formats, uint32_t count);
+
+uint64_t vertex_layout_hash(const VertexLayout *layout);
+bool vertex_layout_equal(const VertexLayout *a, const VertexLayout *b);
+
+/*
+  Packs float source streams (one per attribute, in attribute order) into
+  the per binding destination buffers. src_strides are in bytes, 0 = tight.
+*/
+bool vertex_layout_pack(
+  const VertexLayout *layout,
+  void *const *binding_dst,
+  const float *const *attrib_src,
+  const size_t *src_strides,
+  size_t vertex_count
+);
+
+/*
+  Returns a VAO with the layout's attribute formats set up.
+  VAOs are cached by layout, identical layouts share the same VAO,
+  buffers are attached per draw with vertex_layout_bind_buffer.
+  Once the cache is full new layouts get an uncached VAO, *owned is set
+  and the caller deletes it, cached ones are deleted by the cache.
+*/
+uint32_t vertex_layout_vao(const VertexLayout *layout, bool *owned);
+void vertex_layout_bind_buffer(uint32_t vao, const VertexLayout *layout, uint32_t binding, uint32_t buffer, size_t offset);
+void vertex_layout_cache_clear(void);
+
+#endif //!VERTEX_LAYOUT_H
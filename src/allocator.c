@@ -0,0 +1,203 @@
+#include <allocator.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+static inline size_t align_up(size_t value, size_t alignment)
+{
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Arena
+
+bool arena_init(Arena *arena, size_t size)
+{
+  memset(arena, 0, sizeof(*arena));
+  arena->base = mem_alloc(size);
+  if (arena->base == NULL) return false;
+  arena->size = size;
+  return true;
+}
+
+void arena_free(Arena *arena)
+{
+  mem_free(arena->base);
+  memset(arena, 0, sizeof(*arena));
+}
+
+void *arena_alloc(Arena *arena, size_t size, size_t align)
+{
+  // Align the address, not the offset, mem_alloc only guarantees 16 bytes
+  uintptr_t base = (uintptr_t)arena->base;
+  size_t offset = align_up(base + arena->offset, align) - base;
+  if (offset > arena->size || size > arena->size - offset) return NULL;
+
+  arena->offset = offset + size;
+  if (arena->offset > arena->peak) arena->peak = arena->offset;
+  return arena->base + offset;
+}
+
+void arena_reset(Arena *arena)
+{
+  arena->offset = 0;
+}
+
+// Frame arena
+
+bool frame_arena_init(FrameArena *frame, size_t size)
+{
+  frame->index = 0;
+  if (!arena_init(&frame->arenas[0], size)) return false;
+  if (!arena_init(&frame->arenas[1], size)) {
+    arena_free(&frame->arenas[0]);
+    return false;
+  }
+  return true;
+}
+
+void frame_arena_free(FrameArena *frame)
+{
+  arena_free(&frame->arenas[0]);
+  arena_free(&frame->arenas[1]);
+}
+
+void frame_arena_begin(FrameArena *frame)
+{
+  frame->index ^= 1;
+  arena_reset(&frame->arenas[frame->index]);
+}
+
+void *frame_alloc(FrameArena *frame, size_t size)
+{
+  void *ptr = arena_alloc(frame_arena_current(frame), size, ALLOC_DEFAULT_ALIGNMENT);
+  if (ptr == NULL)
+    fprintf(stderr, "[ERROR]: Frame arena exhausted (%zu byte request)\n", size);
+  return ptr;
+}
+
+// Tracked heap
+
+/*
+  Every block is prefixed by its size so frees can update the live byte
+  count, the header keeps the 16 byte alignment malloc gives.
+*/
+#define MEM_HEADER_SIZE 16
+
+static struct {
+  atomic_uint_least64_t allocations;
+  atomic_uint_least64_t frees;
+  atomic_uint_least64_t bytes_live;
+  atomic_uint_least64_t bytes_peak;
+  uint64_t frame_start;
+  uint64_t frame_allocations;
+  uint64_t frames;
+  uint64_t steady_frames;
+} mem_stats;
+
+static inline void mem_track_alloc(size_t size)
+{
+  atomic_fetch_add_explicit(&mem_stats.allocations, 1, memory_order_relaxed);
+  uint64_t live = atomic_fetch_add_explicit(&mem_stats.bytes_live, size, memory_order_relaxed) + size;
+
+  uint64_t peak = atomic_load_explicit(&mem_stats.bytes_peak, memory_order_relaxed);
+  while (live > peak &&
+         !atomic_compare_exchange_weak_explicit(&mem_stats.bytes_peak, &peak, live,
+                                                memory_order_relaxed, memory_order_relaxed));
+}
+
+static inline void mem_track_free(size_t size)
+{
+  atomic_fetch_add_explicit(&mem_stats.frees, 1, memory_order_relaxed);
+  atomic_fetch_sub_explicit(&mem_stats.bytes_live, size, memory_order_relaxed);
+}
+
+void *mem_alloc(size_t size)
+{
+  if (size > SIZE_MAX - MEM_HEADER_SIZE) return NULL;
+
+  uint8_t *block = malloc(size + MEM_HEADER_SIZE);
+  if (block == NULL) return NULL;
+
+  *(size_t *)block = size;
+  mem_track_alloc(size);
+  return block + MEM_HEADER_SIZE;
+}
+
+void *mem_calloc(size_t count, size_t size)
+{
+  if (size != 0 && count > (SIZE_MAX - MEM_HEADER_SIZE) / size) return NULL;
+
+  void *ptr = mem_alloc(count * size);
+  if (ptr != NULL) memset(ptr, 0, count * size);
+  return ptr;
+}
+
+void *mem_realloc(void *ptr, size_t size)
+{
+  if (ptr == NULL) return mem_alloc(size);
+  if (size > SIZE_MAX - MEM_HEADER_SIZE) return NULL;
+
+  uint8_t *old_block = (uint8_t *)ptr - MEM_HEADER_SIZE;
+  size_t old_size = *(size_t *)old_block;
+
+  uint8_t *block = realloc(old_block, size + MEM_HEADER_SIZE);
+  if (block == NULL) return NULL;
+
+  *(size_t *)block = size;
+  mem_track_free(old_size);
+  mem_track_alloc(size);
+  return block + MEM_HEADER_SIZE;
+}
+
+void mem_free(void *ptr)
+{
+  if (ptr == NULL) return;
+
+  uint8_t *block = (uint8_t *)ptr - MEM_HEADER_SIZE;
+  mem_track_free(*(size_t *)block);
+  free(block);
+}
+
+AllocStats alloc_stats(void)
+{
+  return (AllocStats) {
+    atomic_load_explicit(&mem_stats.allocations, memory_order_relaxed),
+    atomic_load_explicit(&mem_stats.frees, memory_order_relaxed),
+    atomic_load_explicit(&mem_stats.bytes_live, memory_order_relaxed),
+    atomic_load_explicit(&mem_stats.bytes_peak, memory_order_relaxed),
+    mem_stats.frame_allocations,
+    mem_stats.frames
+  };
+}
+
+void alloc_frame_begin(void)
+{
+  mem_stats.frame_start = atomic_load_explicit(&mem_stats.allocations, memory_order_relaxed);
+}
+
+uint64_t alloc_frame_end(void)
+{
+  uint64_t count = atomic_load_explicit(&mem_stats.allocations, memory_order_relaxed) - mem_stats.frame_start;
+  mem_stats.frame_allocations = count;
+  mem_stats.frames++;
+
+#if defined(ALLOC_DEBUG_ENABLED)
+  if (mem_stats.steady_frames >= ALLOC_WARMUP_FRAMES && count > 0) {
+    fprintf(stderr,
+      "[ERROR]: %llu heap allocation(s) in steady state frame %llu\n",
+      (unsigned long long)count, (unsigned long long)mem_stats.frames
+    );
+    abort();
+  }
+#endif // !ALLOC_DEBUG_ENABLED
+
+  mem_stats.steady_frames++;
+  return count;
+}
+
+void alloc_steady_reset(void)
+{
+  mem_stats.steady_frames = 0;
+}
@@ -0,0 +1,118 @@
+#include <bench.h>
+#include <allocator.h>
+#include <GLFW/glfw3.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+bool bench_begin(Bench *bench, const char *name, uint32_t frame_count)
+{
+  memset(bench, 0, sizeof(*bench));
+  bench->name = name;
+  bench->frame_count = frame_count;
+  bench->frame_ms = calloc(frame_count, sizeof(double));
+
+  // Each run may warm its own caches
+  alloc_steady_reset();
+  return bench->frame_ms != NULL;
+}
+
+void bench_end(Bench *bench)
+{
+  free(bench->frame_ms);
+  bench->frame_ms = NULL;
+}
+
+void bench_frame_begin(Bench *bench)
+{
+  bench->frame_start = glfwGetTime();
+  bench->frame_triangles = 0;
+  bench->frame_draws = 0;
+  alloc_frame_begin();
+}
+
+bool bench_frame_end(Bench *bench)
+{
+  uint64_t allocations = alloc_frame_end();
+  if (bench->frame >= bench->frame_count) return true;
+
+  bench->heap_allocations += allocations;
+  bench->frame_ms[bench->frame++] = (glfwGetTime() - bench->frame_start) * 1000.0;
+  bench->triangles += bench->frame_triangles;
+  bench->draws += bench->frame_draws;
+
+  return bench->frame >= bench->frame_count;
+}
+
+void bench_count_draw(Bench *bench, uint32_t triangles)
+{
+  bench->frame_triangles += triangles;
+  bench->frame_draws++;
+}
+
+void bench_count_draws(Bench *bench, uint32_t draws, uint64_t triangles)
+{
+  bench->frame_triangles += triangles;
+  bench->frame_draws += draws;
+}
+
+void bench_count_latency(Bench *bench, double latency_ms)
+{
+  bench->latency_ms += latency_ms;
+  if (latency_ms > bench->latency_max_ms) bench->latency_max_ms = latency_ms;
+  bench->latency_samples++;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+void bench_report(const Bench *bench)
+{
+  uint32_t frames = bench->frame;
+  if (frames == 0) return;
+
+  double *sorted = malloc(frames * sizeof(double));
+  if (sorted == NULL) return;
+  memcpy(sorted, bench->frame_ms, frames * sizeof(double));
+  qsort(sorted, frames, sizeof(double), compare_double);
+
+  double total = 0.0;
+  for (uint32_t i = 0; i < frames; i++) total += sorted[i];
+  double average = total / frames;
+
+  double variance = 0.0;
+  for (uint32_t i = 0; i < frames; i++) variance += (sorted[i] - average) * (sorted[i] - average);
+  double jitter = sqrt(variance / frames);
+
+  printf(
+    "[BENCH]: %s\n"
+    "  - Frames        : %u\n"
+    "  - Frame time    : avg %.3f ms, jitter %.3f, min %.3f, p50 %.3f, p99 %.3f, max %.3f\n"
+    "  - Throughput    : %.1f fps\n"
+    "  - Triangles     : %llu per frame\n"
+    "  - Draw calls    : %llu per frame\n"
+    "  - Heap allocs   : %llu over the run\n",
+    bench->name,
+    frames,
+    average, jitter, sorted[0], sorted[frames / 2], sorted[(frames * 99) / 100], sorted[frames - 1],
+    average > 0.0 ? 1000.0 / average : 0.0,
+    (unsigned long long)(bench->triangles / frames),
+    (unsigned long long)(bench->draws / frames),
+    (unsigned long long)bench->heap_allocations
+  );
+
+  if (bench->latency_samples > 0) {
+    printf(
+      "  - Input latency : avg %.3f ms, max %.3f\n",
+      bench->latency_ms / bench->latency_samples, bench->latency_max_ms
+    );
+  }
+
+  free(sorted);
+}
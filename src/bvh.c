@@ -0,0 +1,556 @@
+#include <bvh.h>
+#include <allocator.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <stdatomic.h>
+
+// Subtrees below this many primitives are built as one parallel job
+#define BVH_JOB_MIN_PRIMITIVES 4096
+#define BVH_MAX_JOBS 1024
+
+// Past this depth splits go to the median, bounding the depth well under BVH_STACK
+#define BVH_MAX_SAH_DEPTH 48
+
+typedef struct {
+  uint32_t node;
+  uint32_t begin;
+  uint32_t end;
+  uint32_t depth;
+} BvhJob;
+
+// Build time copy of a primitive, partitioned in place so passes stay sequential
+typedef struct {
+  BvhBounds bounds;
+  Vector3 centroid;
+  uint32_t primitive;
+} BvhRef;
+
+typedef struct {
+  Bvh *bvh;
+  BvhRef *refs;
+  atomic_uint node_count;
+
+  // Serial top levels queue subtrees here, then the pool drains them
+  BvhJob jobs[BVH_MAX_JOBS];
+  uint32_t job_count;
+  uint32_t job_threshold;
+} BvhBuilder;
+
+typedef struct {
+  BvhBounds bounds;
+  uint32_t count;
+} BvhBin;
+
+static inline BvhBounds bounds_empty(void)
+{
+  return (BvhBounds){{FLT_MAX, FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX, -FLT_MAX}};
+}
+
+/*
+  Same as raymath's Vector3Min / Vector3Max, but those go through fminf /
+  fmaxf which stay libm calls without -ffast-math, several per primitive
+  per level in the build loops. Plain compares compile to minss / maxss.
+*/
+static inline float min_f(float a, float b) { return a < b ? a : b; }
+static inline float max_f(float a, float b) { return a > b ? a : b; }
+
+static inline Vector3 vector3_min(Vector3 a, Vector3 b)
+{
+  return (Vector3){min_f(a.x, b.x), min_f(a.y, b.y), min_f(a.z, b.z)};
+}
+
+static inline Vector3 vector3_max(Vector3 a, Vector3 b)
+{
+  return (Vector3){max_f(a.x, b.x), max_f(a.y, b.y), max_f(a.z, b.z)};
+}
+
+static inline BvhBounds bounds_union(BvhBounds a, BvhBounds b)
+{
+  return (BvhBounds){vector3_min(a.min, b.min), vector3_max(a.max, b.max)};
+}
+
+static inline BvhBounds bounds_grow(BvhBounds a, Vector3 p)
+{
+  return (BvhBounds){vector3_min(a.min, p), vector3_max(a.max, p)};
+}
+
+// Half surface area, constant factors cancel out in SAH ratios
+static inline float bounds_area(BvhBounds b)
+{
+  Vector3 d = Vector3Subtract(b.max, b.min);
+  if (d.x < 0.0f || d.y < 0.0f || d.z < 0.0f) return 0.0f;
+  return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+static inline float vector3_axis(Vector3 v, int axis)
+{
+  return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+static inline void node_set_bounds(BvhNode *node, BvhBounds b)
+{
+  node->min = b.min;
+  node->max = b.max;
+}
+
+static inline BvhBounds node_bounds(const BvhNode *node)
+{
+  return (BvhBounds){node->min, node->max};
+}
+
+static inline int bvh_bin(float value, float lo, float scale)
+{
+  int b = (int)((value - lo) * scale);
+  return b < BVH_BINS ? b : BVH_BINS - 1;
+}
+
+static void bvh_make_leaf(BvhBuilder *builder, uint32_t node_index, uint32_t begin, uint32_t end)
+{
+  Bvh *bvh = builder->bvh;
+  BvhNode *node = &bvh->nodes[node_index];
+  node->left_first = begin;
+  node->count = end - begin;
+
+  for (uint32_t i = begin; i < end; i++) {
+    uint32_t primitive = builder->refs[i].primitive;
+    bvh->indices[i] = primitive;
+    bvh->leaf_of[primitive] = node_index;
+  }
+}
+
+/*
+  Finds the cheapest binned SAH split of [begin, end), binning the three
+  axes in a single pass. Returns false when keeping a leaf is cheaper (or
+  every centroid coincides).
+*/
+static bool bvh_find_split(
+  const BvhBuilder *builder, uint32_t begin, uint32_t end, BvhBounds node_bounds,
+  BvhBounds centroid_bounds, int *best_axis, uint32_t *best_split)
+{
+  const uint32_t count = end - begin;
+  float best_cost = (float)count;  // Leaf cost with unit intersection cost
+  bool found = false;
+  float parent_area = bounds_area(node_bounds);
+  if (parent_area <= 0.0f) parent_area = 1.0f;
+
+  float lo[3], scale[3];
+  for (int axis = 0; axis < 3; axis++) {
+    lo[axis] = vector3_axis(centroid_bounds.min, axis);
+    float extent = vector3_axis(centroid_bounds.max, axis) - lo[axis];
+    scale[axis] = extent > 0.0f ? (float)BVH_BINS / extent : 0.0f;
+  }
+
+  BvhBin bins[3][BVH_BINS];
+  for (int axis = 0; axis < 3; axis++)
+    for (int b = 0; b < BVH_BINS; b++) bins[axis][b] = (BvhBin){bounds_empty(), 0};
+
+  for (uint32_t i = begin; i < end; i++) {
+    const BvhRef *ref = &builder->refs[i];
+    for (int axis = 0; axis < 3; axis++) {
+      BvhBin *bin = &bins[axis][bvh_bin(vector3_axis(ref->centroid, axis), lo[axis], scale[axis])];
+      bin->count++;
+      bin->bounds = bounds_union(bin->bounds, ref->bounds);
+    }
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    if (scale[axis] == 0.0f) continue;
+
+    // Sweep from the right, then evaluate splits from the left
+    float right_area[BVH_BINS];
+    uint32_t right_count[BVH_BINS];
+    BvhBounds acc = bounds_empty();
+    uint32_t n = 0;
+    for (int b = BVH_BINS - 1; b > 0; b--) {
+      acc = bounds_union(acc, bins[axis][b].bounds);
+      n += bins[axis][b].count;
+      right_area[b] = bounds_area(acc);
+      right_count[b] = n;
+    }
+
+    acc = bounds_empty();
+    n = 0;
+    for (int b = 1; b < BVH_BINS; b++) {
+      acc = bounds_union(acc, bins[axis][b - 1].bounds);
+      n += bins[axis][b - 1].count;
+      if (n == 0 || right_count[b] == 0) continue;
+
+      float cost = 1.0f + (bounds_area(acc) * n + right_area[b] * right_count[b]) / parent_area;
+      if (cost < best_cost) {
+        best_cost = cost;
+        *best_axis = axis;
+        *best_split = (uint32_t)b;
+        found = true;
+      }
+    }
+  }
+
+  return found;
+}
+
+static uint32_t bvh_partition(BvhBuilder *builder, uint32_t begin, uint32_t end, BvhBounds centroid_bounds, int axis, uint32_t split)
+{
+  BvhRef *refs = builder->refs;
+  float lo = vector3_axis(centroid_bounds.min, axis);
+  float scale = (float)BVH_BINS / (vector3_axis(centroid_bounds.max, axis) - lo);
+
+  uint32_t i = begin, j = end;
+  while (i < j) {
+    if ((uint32_t)bvh_bin(vector3_axis(refs[i].centroid, axis), lo, scale) < split) {
+      i++;
+    } else {
+      BvhRef tmp = refs[i];
+      refs[i] = refs[--j];
+      refs[j] = tmp;
+    }
+  }
+  return i;
+}
+
+// Builds the subtree rooted at node_index, queueing large subtrees when queue is set
+static void bvh_subdivide(BvhBuilder *builder, uint32_t node_index, uint32_t begin, uint32_t end, uint32_t depth, bool queue)
+{
+  Bvh *bvh = builder->bvh;
+
+  if (queue && end - begin <= builder->job_threshold && builder->job_count < BVH_MAX_JOBS) {
+    builder->jobs[builder->job_count++] = (BvhJob){node_index, begin, end, depth};
+    return;
+  }
+
+  BvhBounds bounds = bounds_empty();
+  BvhBounds centroid_bounds = bounds_empty();
+  for (uint32_t i = begin; i < end; i++) {
+    bounds = bounds_union(bounds, builder->refs[i].bounds);
+    centroid_bounds = bounds_grow(centroid_bounds, builder->refs[i].centroid);
+  }
+  node_set_bounds(&bvh->nodes[node_index], bounds);
+
+  const uint32_t count = end - begin;
+  if (count <= 1) {
+    bvh_make_leaf(builder, node_index, begin, end);
+    return;
+  }
+
+  int axis = 0;
+  uint32_t split = 0;
+  uint32_t middle;
+
+  if (depth < BVH_MAX_SAH_DEPTH && bvh_find_split(builder, begin, end, bounds, centroid_bounds, &axis, &split)) {
+    middle = bvh_partition(builder, begin, end, centroid_bounds, axis, split);
+  } else if (count <= BVH_MAX_LEAF) {
+    bvh_make_leaf(builder, node_index, begin, end);
+    return;
+  } else {
+    // Coincident centroids, too deep, or no split beats the leaf but the leaf is too big
+    middle = begin + count / 2;
+  }
+
+  uint32_t left = atomic_fetch_add_explicit(&builder->node_count, 2, memory_order_relaxed);
+  BvhNode *node = &bvh->nodes[node_index];
+  node->left_first = left;
+  node->count = 0;
+  bvh->parents[left] = node_index;
+  bvh->parents[left + 1] = node_index;
+
+  bvh_subdivide(builder, left, begin, middle, depth + 1, queue);
+  bvh_subdivide(builder, left + 1, middle, end, depth + 1, queue);
+}
+
+static void bvh_build_jobs(void *user, uint32_t begin, uint32_t end, uint32_t worker)
+{
+  BvhBuilder *builder = user;
+  for (uint32_t i = begin; i < end; i++) {
+    const BvhJob *job = &builder->jobs[i];
+    bvh_subdivide(builder, job->node, job->begin, job->end, job->depth, false);
+  }
+}
+
+bool bvh_build(Bvh *bvh, const BvhBounds *bounds, uint32_t count, ThreadPool *pool)
+{
+  memset(bvh, 0, sizeof(*bvh));
+  if (count == 0) return false;
+
+  const uint32_t node_capacity = count * 2;
+  bvh->nodes = mem_alloc(node_capacity * sizeof(BvhNode));
+  bvh->parents = mem_alloc(node_capacity * sizeof(uint32_t));
+  bvh->indices = mem_alloc(count * sizeof(uint32_t));
+  bvh->leaf_of = mem_alloc(count * sizeof(uint32_t));
+  bvh->bounds = mem_alloc(count * sizeof(BvhBounds));
+
+  BvhBuilder *builder = mem_alloc(sizeof(BvhBuilder));
+  BvhRef *refs = mem_alloc(count * sizeof(BvhRef));
+
+  if (bvh->nodes == NULL || bvh->parents == NULL || bvh->indices == NULL ||
+      bvh->leaf_of == NULL || bvh->bounds == NULL || builder == NULL || refs == NULL) {
+    mem_free(builder);
+    mem_free(refs);
+    bvh_free(bvh);
+    return false;
+  }
+
+  memcpy(bvh->bounds, bounds, count * sizeof(BvhBounds));
+  bvh->primitive_count = count;
+
+  for (uint32_t i = 0; i < count; i++) {
+    refs[i].bounds = bounds[i];
+    refs[i].centroid = Vector3Scale(Vector3Add(bounds[i].min, bounds[i].max), 0.5f);
+    refs[i].primitive = i;
+  }
+
+  builder->bvh = bvh;
+  builder->refs = refs;
+  builder->job_count = 0;
+  atomic_init(&builder->node_count, 2);
+
+  // Enough jobs for dynamic balancing across the pool
+  uint32_t threads = thread_pool_size(pool);
+  builder->job_threshold = count / (threads * 8);
+  if (builder->job_threshold < BVH_JOB_MIN_PRIMITIVES) builder->job_threshold = BVH_JOB_MIN_PRIMITIVES;
+
+  bvh->parents[0] = 0;
+  bvh->nodes[1] = (BvhNode){0};
+  bvh_subdivide(builder, 0, 0, count, 0, threads > 1);
+  thread_pool_parallel_for(pool, builder->job_count, 1, bvh_build_jobs, builder);
+
+  bvh->node_count = atomic_load(&builder->node_count);
+
+  mem_free(refs);
+  mem_free(builder);
+  return true;
+}
+
+void bvh_free(Bvh *bvh)
+{
+  mem_free(bvh->nodes);
+  mem_free(bvh->parents);
+  mem_free(bvh->indices);
+  mem_free(bvh->leaf_of);
+  mem_free(bvh->bounds);
+  memset(bvh, 0, sizeof(*bvh));
+}
+
+static BvhBounds bvh_leaf_bounds(const Bvh *bvh, const BvhNode *node)
+{
+  BvhBounds b = bounds_empty();
+  for (uint32_t i = 0; i < node->count; i++)
+    b = bounds_union(b, bvh->bounds[bvh->indices[node->left_first + i]]);
+  return b;
+}
+
+static inline bool bounds_equal(BvhBounds a, BvhBounds b)
+{
+  return a.min.x == b.min.x && a.min.y == b.min.y && a.min.z == b.min.z &&
+         a.max.x == b.max.x && a.max.y == b.max.y && a.max.z == b.max.z;
+}
+
+void bvh_update(Bvh *bvh, uint32_t primitive, BvhBounds bounds)
+{
+  bvh->bounds[primitive] = bounds;
+
+  uint32_t node_index = bvh->leaf_of[primitive];
+  BvhBounds refit = bvh_leaf_bounds(bvh, &bvh->nodes[node_index]);
+
+  for (;;) {
+    BvhNode *node = &bvh->nodes[node_index];
+    if (bounds_equal(node_bounds(node), refit)) break;
+    node_set_bounds(node, refit);
+    if (node_index == 0) break;
+
+    node_index = bvh->parents[node_index];
+    const BvhNode *parent = &bvh->nodes[node_index];
+    refit = bounds_union(node_bounds(&bvh->nodes[parent->left_first]), node_bounds(&bvh->nodes[parent->left_first + 1]));
+  }
+}
+
+void bvh_set_bounds(Bvh *bvh, uint32_t primitive, BvhBounds bounds)
+{
+  bvh->bounds[primitive] = bounds;
+}
+
+void bvh_refit(Bvh *bvh)
+{
+  for (uint32_t i = bvh->node_count; i-- > 0;) {
+    if (i == 1) continue;
+    BvhNode *node = &bvh->nodes[i];
+    if (node->count > 0)
+      node_set_bounds(node, bvh_leaf_bounds(bvh, node));
+    else
+      node_set_bounds(node, bounds_union(node_bounds(&bvh->nodes[node->left_first]), node_bounds(&bvh->nodes[node->left_first + 1])));
+  }
+}
+
+// Frustum
+
+typedef enum {
+  BVH_OUTSIDE,
+  BVH_INTERSECTS,
+  BVH_INSIDE,
+} BvhClass;
+
+static inline BvhClass frustum_classify(const Frustum *frustum, Vector3 min, Vector3 max)
+{
+  BvhClass result = BVH_INSIDE;
+  for (int k = 0; k < 6; k++) {
+    const Vector4 p = frustum->planes[k];
+    // Corner furthest along the plane normal, then the nearest one
+    float far = p.x * (p.x > 0.0f ? max.x : min.x) + p.y * (p.y > 0.0f ? max.y : min.y) + p.z * (p.z > 0.0f ? max.z : min.z) + p.w;
+    if (far < 0.0f) return BVH_OUTSIDE;
+    float near = p.x * (p.x > 0.0f ? min.x : max.x) + p.y * (p.y > 0.0f ? min.y : max.y) + p.z * (p.z > 0.0f ? min.z : max.z) + p.w;
+    if (near < 0.0f) result = BVH_INTERSECTS;
+  }
+  return result;
+}
+
+// Emits every primitive below node without further tests
+static uint32_t bvh_emit_subtree(const Bvh *bvh, uint32_t root, uint32_t *out, uint32_t count, uint32_t capacity)
+{
+  uint32_t stack[BVH_STACK];
+  uint32_t top = 0;
+  stack[top++] = root;
+
+  while (top > 0 && count < capacity) {
+    const BvhNode *node = &bvh->nodes[stack[--top]];
+    if (node->count > 0) {
+      for (uint32_t i = 0; i < node->count && count < capacity; i++)
+        out[count++] = bvh->indices[node->left_first + i];
+    } else {
+      stack[top++] = node->left_first + 1;
+      stack[top++] = node->left_first;
+    }
+  }
+  return count;
+}
+
+uint32_t bvh_query_frustum(const Bvh *bvh, const Frustum *frustum, uint32_t *out, uint32_t capacity)
+{
+  if (bvh->node_count == 0) return 0;
+
+  uint32_t stack[BVH_STACK];
+  uint32_t top = 0;
+  uint32_t count = 0;
+  stack[top++] = 0;
+
+  while (top > 0 && count < capacity) {
+    uint32_t node_index = stack[--top];
+    const BvhNode *node = &bvh->nodes[node_index];
+
+    BvhClass c = frustum_classify(frustum, node->min, node->max);
+    if (c == BVH_OUTSIDE) continue;
+    if (c == BVH_INSIDE) {
+      count = bvh_emit_subtree(bvh, node_index, out, count, capacity);
+      continue;
+    }
+
+    if (node->count > 0) {
+      for (uint32_t i = 0; i < node->count && count < capacity; i++) {
+        uint32_t primitive = bvh->indices[node->left_first + i];
+        const BvhBounds *b = &bvh->bounds[primitive];
+        if (frustum_classify(frustum, b->min, b->max) != BVH_OUTSIDE) out[count++] = primitive;
+      }
+    } else {
+      stack[top++] = node->left_first + 1;
+      stack[top++] = node->left_first;
+    }
+  }
+
+  return count;
+}
+
+static inline bool bounds_overlap(Vector3 amin, Vector3 amax, BvhBounds b)
+{
+  return amin.x <= b.max.x && amax.x >= b.min.x &&
+         amin.y <= b.max.y && amax.y >= b.min.y &&
+         amin.z <= b.max.z && amax.z >= b.min.z;
+}
+
+uint32_t bvh_query_bounds(const Bvh *bvh, BvhBounds range, uint32_t *out, uint32_t capacity)
+{
+  if (bvh->node_count == 0) return 0;
+
+  uint32_t stack[BVH_STACK];
+  uint32_t top = 0;
+  uint32_t count = 0;
+  stack[top++] = 0;
+
+  while (top > 0 && count < capacity) {
+    const BvhNode *node = &bvh->nodes[stack[--top]];
+    if (!bounds_overlap(node->min, node->max, range)) continue;
+
+    if (node->count > 0) {
+      for (uint32_t i = 0; i < node->count && count < capacity; i++) {
+        uint32_t primitive = bvh->indices[node->left_first + i];
+        if (bounds_overlap(bvh->bounds[primitive].min, bvh->bounds[primitive].max, range)) out[count++] = primitive;
+      }
+    } else {
+      stack[top++] = node->left_first + 1;
+      stack[top++] = node->left_first;
+    }
+  }
+
+  return count;
+}
+
+// Slab test, returns the entry distance or FLT_MAX on miss
+static inline float ray_box(Vector3 origin, Vector3 inv_dir, Vector3 min, Vector3 max, float max_t)
+{
+  float tx1 = (min.x - origin.x) * inv_dir.x, tx2 = (max.x - origin.x) * inv_dir.x;
+  float ty1 = (min.y - origin.y) * inv_dir.y, ty2 = (max.y - origin.y) * inv_dir.y;
+  float tz1 = (min.z - origin.z) * inv_dir.z, tz2 = (max.z - origin.z) * inv_dir.z;
+
+  float tmin = max_f(max_f(min_f(tx1, tx2), min_f(ty1, ty2)), min_f(tz1, tz2));
+  float tmax = min_f(min_f(max_f(tx1, tx2), max_f(ty1, ty2)), max_f(tz1, tz2));
+
+  if (tmax < 0.0f || tmin > tmax || tmin > max_t) return FLT_MAX;
+  return tmin > 0.0f ? tmin : 0.0f;
+}
+
+bool bvh_raycast(const Bvh *bvh, Vector3 origin, Vector3 direction, float max_t, BvhRayFn fn, void *user, BvhHit *hit)
+{
+  if (bvh->node_count == 0) return false;
+
+  Vector3 inv_dir = {1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z};
+  float best = max_t;
+  bool found = false;
+
+  uint32_t stack[BVH_STACK];
+  uint32_t top = 0;
+  if (ray_box(origin, inv_dir, bvh->nodes[0].min, bvh->nodes[0].max, best) == FLT_MAX) return false;
+  stack[top++] = 0;
+
+  while (top > 0) {
+    const BvhNode *node = &bvh->nodes[stack[--top]];
+
+    if (node->count > 0) {
+      for (uint32_t i = 0; i < node->count; i++) {
+        uint32_t primitive = bvh->indices[node->left_first + i];
+        const BvhBounds *b = &bvh->bounds[primitive];
+        float t = ray_box(origin, inv_dir, b->min, b->max, best);
+        if (t == FLT_MAX) continue;
+        if (fn != NULL && !fn(user, primitive, origin, direction, &t)) continue;
+        if (t <= best) {
+          best = t;
+          hit->primitive = primitive;
+          hit->t = t;
+          found = true;
+        }
+      }
+      continue;
+    }
+
+    // Visit the nearer child first, pushed last
+    uint32_t left = node->left_first, right = left + 1;
+    float tl = ray_box(origin, inv_dir, bvh->nodes[left].min, bvh->nodes[left].max, best);
+    float tr = ray_box(origin, inv_dir, bvh->nodes[right].min, bvh->nodes[right].max, best);
+    if (tl > tr) {
+      uint32_t swap = left; left = right; right = swap;
+      float t = tl; tl = tr; tr = t;
+    }
+    if (tr != FLT_MAX) stack[top++] = right;
+    if (tl != FLT_MAX) stack[top++] = left;
+  }
+
+  return found;
+}
@@ -0,0 +1,219 @@
+#include <cull.h>
+#include <allocator.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CULL_AVX
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define CULL_SSE
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define CULL_NEON
+#endif
+
+static inline Vector4 plane_normalize(float x, float y, float z, float w)
+{
+  float length = sqrtf(x * x + y * y + z * z);
+  float inv = length > 0.0f ? 1.0f / length : 0.0f;
+  return (Vector4){x * inv, y * inv, z * inv, w * inv};
+}
+
+/*
+  Gribb / Hartmann: with raymath's layout clip = (row0..row3) * v where
+  row i is (m[i], m[i + 4], m[i + 8], m[i + 12]) in MatrixToFloat order.
+*/
+Frustum frustum_from_matrix(Matrix m)
+{
+  Frustum frustum;
+  frustum.planes[0] = plane_normalize(m.m3 + m.m0, m.m7 + m.m4, m.m11 + m.m8,  m.m15 + m.m12);
+  frustum.planes[1] = plane_normalize(m.m3 - m.m0, m.m7 - m.m4, m.m11 - m.m8,  m.m15 - m.m12);
+  frustum.planes[2] = plane_normalize(m.m3 + m.m1, m.m7 + m.m5, m.m11 + m.m9,  m.m15 + m.m13);
+  frustum.planes[3] = plane_normalize(m.m3 - m.m1, m.m7 - m.m5, m.m11 - m.m9,  m.m15 - m.m13);
+  frustum.planes[4] = plane_normalize(m.m3 + m.m2, m.m7 + m.m6, m.m11 + m.m10, m.m15 + m.m14);
+  frustum.planes[5] = plane_normalize(m.m3 - m.m2, m.m7 - m.m6, m.m11 - m.m10, m.m15 - m.m14);
+  return frustum;
+}
+
+bool cull_spheres_init(CullSpheres *spheres, uint32_t capacity)
+{
+  memset(spheres, 0, sizeof(*spheres));
+
+  capacity = (capacity + CULL_GROUP_SIZE - 1) & ~(uint32_t)(CULL_GROUP_SIZE - 1);
+  if (capacity == 0) capacity = CULL_GROUP_SIZE;
+
+  // One block for the four streams, padding lanes stay zeroed
+  float *block = mem_calloc((size_t)capacity * 4, sizeof(float));
+  uint32_t *chunks = mem_calloc(capacity / CULL_CHUNK_SIZE + 1, sizeof(uint32_t));
+  if (block == NULL || chunks == NULL) {
+    mem_free(block);
+    mem_free(chunks);
+    return false;
+  }
+
+  spheres->x = block;
+  spheres->y = block + capacity;
+  spheres->z = block + capacity * 2;
+  spheres->radius = block + capacity * 3;
+  spheres->capacity = capacity;
+  spheres->chunk_visible = chunks;
+  return true;
+}
+
+void cull_spheres_free(CullSpheres *spheres)
+{
+  mem_free(spheres->x);
+  mem_free(spheres->chunk_visible);
+  memset(spheres, 0, sizeof(*spheres));
+}
+
+void cull_spheres_set(CullSpheres *spheres, uint32_t index, Vector3 center, float radius)
+{
+  spheres->x[index] = center.x;
+  spheres->y[index] = center.y;
+  spheres->z[index] = center.z;
+  spheres->radius[index] = radius;
+  if (index >= spheres->count) spheres->count = index + 1;
+}
+
+// Appends begin + lane for every set bit of mask
+static inline uint32_t cull_emit(uint32_t *visible, uint32_t count, uint32_t mask, uint32_t begin)
+{
+  while (mask != 0) {
+    visible[count++] = begin + (uint32_t)__builtin_ctz(mask);
+    mask &= mask - 1;
+  }
+  return count;
+}
+
+static inline uint32_t cull_lane_mask(uint32_t i, uint32_t end, uint32_t width)
+{
+  return end - i >= width ? (1u << width) - 1 : (1u << (end - i)) - 1;
+}
+
+uint32_t cull_spheres(const Frustum *frustum, const CullSpheres *spheres, uint32_t begin, uint32_t end, uint32_t *visible)
+{
+  const Vector4 *p = frustum->planes;
+  uint32_t count = 0;
+
+#if defined(CULL_AVX)
+  __m256 px[6], py[6], pz[6], pw[6];
+  for (int k = 0; k < 6; k++) {
+    px[k] = _mm256_set1_ps(p[k].x); py[k] = _mm256_set1_ps(p[k].y);
+    pz[k] = _mm256_set1_ps(p[k].z); pw[k] = _mm256_set1_ps(p[k].w);
+  }
+
+  for (uint32_t i = begin; i < end; i += 8) {
+    __m256 x = _mm256_loadu_ps(spheres->x + i);
+    __m256 y = _mm256_loadu_ps(spheres->y + i);
+    __m256 z = _mm256_loadu_ps(spheres->z + i);
+    __m256 neg_r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(spheres->radius + i));
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+    for (int k = 0; k < 6; k++) {
+      __m256 d = _mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(x, px[k]), _mm256_mul_ps(y, py[k])),
+        _mm256_add_ps(_mm256_mul_ps(z, pz[k]), pw[k])
+      );
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, neg_r, _CMP_GE_OQ));
+    }
+
+    uint32_t mask = (uint32_t)_mm256_movemask_ps(inside) & cull_lane_mask(i, end, 8);
+    count = cull_emit(visible, count, mask, i);
+  }
+#elif defined(CULL_SSE)
+  __m128 px[6], py[6], pz[6], pw[6];
+  for (int k = 0; k < 6; k++) {
+    px[k] = _mm_set1_ps(p[k].x); py[k] = _mm_set1_ps(p[k].y);
+    pz[k] = _mm_set1_ps(p[k].z); pw[k] = _mm_set1_ps(p[k].w);
+  }
+
+  for (uint32_t i = begin; i < end; i += 4) {
+    __m128 x = _mm_loadu_ps(spheres->x + i);
+    __m128 y = _mm_loadu_ps(spheres->y + i);
+    __m128 z = _mm_loadu_ps(spheres->z + i);
+    __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres->radius + i));
+    __m128 inside = _mm_cmpeq_ps(x, x);
+
+    for (int k = 0; k < 6; k++) {
+      __m128 d = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(x, px[k]), _mm_mul_ps(y, py[k])),
+        _mm_add_ps(_mm_mul_ps(z, pz[k]), pw[k])
+      );
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(d, neg_r));
+    }
+
+    uint32_t mask = (uint32_t)_mm_movemask_ps(inside) & cull_lane_mask(i, end, 4);
+    count = cull_emit(visible, count, mask, i);
+  }
+#elif defined(CULL_NEON)
+  static const uint32_t lane_bits[4] = {1, 2, 4, 8};
+  const uint32x4_t bits = vld1q_u32(lane_bits);
+
+  for (uint32_t i = begin; i < end; i += 4) {
+    float32x4_t x = vld1q_f32(spheres->x + i);
+    float32x4_t y = vld1q_f32(spheres->y + i);
+    float32x4_t z = vld1q_f32(spheres->z + i);
+    float32x4_t neg_r = vnegq_f32(vld1q_f32(spheres->radius + i));
+    uint32x4_t inside = vdupq_n_u32(0xffffffffu);
+
+    for (int k = 0; k < 6; k++) {
+      float32x4_t d = vdupq_n_f32(p[k].w);
+      d = vfmaq_n_f32(d, x, p[k].x);
+      d = vfmaq_n_f32(d, y, p[k].y);
+      d = vfmaq_n_f32(d, z, p[k].z);
+      inside = vandq_u32(inside, vcgeq_f32(d, neg_r));
+    }
+
+    uint32_t mask = vaddvq_u32(vandq_u32(inside, bits)) & cull_lane_mask(i, end, 4);
+    count = cull_emit(visible, count, mask, i);
+  }
+#else
+  for (uint32_t i = begin; i < end; i++) {
+    bool inside = true;
+    for (int k = 0; k < 6 && inside; k++) {
+      float d = spheres->x[i] * p[k].x + spheres->y[i] * p[k].y + spheres->z[i] * p[k].z + p[k].w;
+      inside = d >= -spheres->radius[i];
+    }
+    if (inside) visible[count++] = i;
+  }
+#endif
+
+  return count;
+}
+
+typedef struct {
+  const Frustum *frustum;
+  CullSpheres *spheres;
+  uint32_t *visible;
+} CullJob;
+
+// Each chunk compacts into its own slice of visible, merged afterwards
+static void cull_chunk(void *user, uint32_t begin, uint32_t end, uint32_t worker)
+{
+  CullJob *job = user;
+  job->spheres->chunk_visible[begin / CULL_CHUNK_SIZE] =
+    cull_spheres(job->frustum, job->spheres, begin, end, job->visible + begin);
+}
+
+uint32_t cull_spheres_parallel(ThreadPool *pool, const Frustum *frustum, CullSpheres *spheres, uint32_t *visible)
+{
+  CullJob job = {frustum, spheres, visible};
+  thread_pool_parallel_for(pool, spheres->count, CULL_CHUNK_SIZE, cull_chunk, &job);
+
+  // Chunk slices start at their first object, so compaction only moves left
+  uint32_t count = 0;
+  uint32_t chunks = (spheres->count + CULL_CHUNK_SIZE - 1) / CULL_CHUNK_SIZE;
+  for (uint32_t c = 0; c < chunks; c++) {
+    uint32_t chunk_count = spheres->chunk_visible[c];
+    uint32_t *src = visible + c * CULL_CHUNK_SIZE;
+    if (src != visible + count) memmove(visible + count, src, chunk_count * sizeof(uint32_t));
+    count += chunk_count;
+  }
+
+  return count;
+}
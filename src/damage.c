@@ -0,0 +1,124 @@
+#include <damage.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+static inline int32_t min_i32(int32_t a, int32_t b) { return a < b ? a : b; }
+static inline int32_t max_i32(int32_t a, int32_t b) { return a > b ? a : b; }
+
+static inline bool damage_overlap(DamageRect a, DamageRect b)
+{
+  return a.x <= b.x + b.width && b.x <= a.x + a.width &&
+         a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+static inline DamageRect damage_union(DamageRect a, DamageRect b)
+{
+  int32_t x0 = min_i32(a.x, b.x);
+  int32_t y0 = min_i32(a.y, b.y);
+  int32_t x1 = max_i32(a.x + a.width, b.x + b.width);
+  int32_t y1 = max_i32(a.y + a.height, b.y + b.height);
+  return (DamageRect){x0, y0, x1 - x0, y1 - y0};
+}
+
+void damage_init(DamageTracker *damage, int32_t width, int32_t height)
+{
+  memset(damage, 0, sizeof(*damage));
+  damage->width = width;
+  damage->height = height;
+  damage->full = true;
+}
+
+void damage_resize(DamageTracker *damage, int32_t width, int32_t height)
+{
+  damage->width = width;
+  damage->height = height;
+  damage_invalidate(damage);
+}
+
+void damage_invalidate(DamageTracker *damage)
+{
+  damage->full = true;
+  damage->rect_count = 0;
+}
+
+void damage_add(DamageTracker *damage, DamageRect rect)
+{
+  if (damage->full) return;
+
+  // Clip to the framebuffer
+  int32_t x0 = max_i32(rect.x, 0);
+  int32_t y0 = max_i32(rect.y, 0);
+  int32_t x1 = min_i32(rect.x + rect.width, damage->width);
+  int32_t y1 = min_i32(rect.y + rect.height, damage->height);
+  if (x1 <= x0 || y1 <= y0) return;
+  rect = (DamageRect){x0, y0, x1 - x0, y1 - y0};
+
+  // Merging may make the result overlap earlier rects, so restart after each merge
+  for (uint32_t i = 0; i < damage->rect_count;) {
+    if (damage_overlap(damage->rects[i], rect)) {
+      rect = damage_union(damage->rects[i], rect);
+      damage->rects[i] = damage->rects[--damage->rect_count];
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+
+  if (damage->rect_count == DAMAGE_MAX_RECTS) {
+    for (uint32_t i = 0; i < damage->rect_count; i++) rect = damage_union(rect, damage->rects[i]);
+    damage->rect_count = 0;
+  }
+
+  damage->rects[damage->rect_count++] = rect;
+}
+
+void damage_add_ndc(DamageTracker *damage, float min_x, float min_y, float max_x, float max_y)
+{
+  float half_width = damage->width * 0.5f;
+  float half_height = damage->height * 0.5f;
+
+  int32_t x0 = (int32_t)floorf((min_x + 1.0f) * half_width) - 1;
+  int32_t y0 = (int32_t)floorf((min_y + 1.0f) * half_height) - 1;
+  int32_t x1 = (int32_t)ceilf((max_x + 1.0f) * half_width) + 1;
+  int32_t y1 = (int32_t)ceilf((max_y + 1.0f) * half_height) + 1;
+  damage_add(damage, (DamageRect){x0, y0, x1 - x0, y1 - y0});
+}
+
+void damage_clear(DamageTracker *damage)
+{
+  uint64_t full_pixels = (uint64_t)damage->width * (uint64_t)damage->height;
+
+  if (damage->full) {
+    damage->pixels += full_pixels;
+  } else if (damage->rect_count > 0) {
+    for (uint32_t i = 0; i < damage->rect_count; i++)
+      damage->pixels += (uint64_t)damage->rects[i].width * (uint64_t)damage->rects[i].height;
+    damage->partial_frames++;
+  } else {
+    return;
+  }
+
+  damage->full_pixels += full_pixels;
+  damage->frames++;
+  damage->full = false;
+  damage->rect_count = 0;
+}
+
+void damage_report(const DamageTracker *damage, double seconds)
+{
+  if (seconds <= 0.0) seconds = 1.0;
+
+  printf(
+    "[INFO]: Damage tracking over %.1f s\n"
+    "  - Wakeups       : %llu (%.2f per second)\n"
+    "  - Frames drawn  : %llu (%.2f per second), %llu partial\n"
+    "  - Pixels drawn  : %.1f%% of full redraws\n",
+    seconds,
+    (unsigned long long)damage->wakeups, damage->wakeups / seconds,
+    (unsigned long long)damage->frames, damage->frames / seconds,
+    (unsigned long long)damage->partial_frames,
+    damage->full_pixels > 0 ? 100.0 * (double)damage->pixels / (double)damage->full_pixels : 0.0
+  );
+}
@@ -0,0 +1,322 @@
+#include <ecs.h>
+#include <allocator.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline uint32_t align_up_u32(uint32_t value, uint32_t alignment)
+{
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Lays out columns for capacity rows, returns the bytes needed
+static uint32_t ecs_layout(const EcsWorld *world, EcsMask mask, uint32_t capacity, uint32_t *offsets)
+{
+  uint32_t offset = align_up_u32(capacity * sizeof(Entity), ECS_COLUMN_ALIGN);
+
+  for (uint32_t c = 0; c < world->component_count; c++) {
+    if (!(mask & ECS_COMPONENT(c))) continue;
+    offsets[c] = offset;
+    offset = align_up_u32(offset + capacity * world->component_sizes[c], ECS_COLUMN_ALIGN);
+  }
+  return offset;
+}
+
+static uint32_t ecs_archetype_find(EcsWorld *world, EcsMask mask)
+{
+  for (uint32_t i = 0; i < world->archetype_count; i++)
+    if (world->archetypes[i].mask == mask) return i;
+
+  if (world->archetype_count == ECS_MAX_ARCHETYPES) {
+    fprintf(stderr, "[ERROR]: Too many ECS archetypes\n");
+    return ECS_MAX_ARCHETYPES;
+  }
+
+  EcsArchetype *archetype = &world->archetypes[world->archetype_count];
+  memset(archetype, 0, sizeof(*archetype));
+  archetype->mask = mask;
+
+  uint32_t row_size = sizeof(Entity);
+  for (uint32_t c = 0; c < world->component_count; c++)
+    if (mask & ECS_COMPONENT(c)) row_size += world->component_sizes[c];
+
+  // Largest row count whose aligned columns still fit the chunk
+  uint32_t capacity = ECS_CHUNK_BYTES / row_size;
+  while (capacity > 1 && ecs_layout(world, mask, capacity, archetype->offsets) > ECS_CHUNK_BYTES) capacity--;
+  if (capacity == 0) capacity = 1;
+  ecs_layout(world, mask, capacity, archetype->offsets);
+  archetype->capacity = capacity;
+
+  return world->archetype_count++;
+}
+
+static inline uint8_t *ecs_row_column(const EcsWorld *world, const EcsArchetype *archetype, uint32_t row, uint32_t component)
+{
+  const EcsChunk *chunk = &archetype->chunks[row / archetype->capacity];
+  return chunk->data + archetype->offsets[component] + (row % archetype->capacity) * world->component_sizes[component];
+}
+
+static inline Entity *ecs_row_entity(const EcsArchetype *archetype, uint32_t row)
+{
+  return (Entity *)archetype->chunks[row / archetype->capacity].data + row % archetype->capacity;
+}
+
+// Appends a zeroed row, returns its index or UINT32_MAX
+static uint32_t ecs_archetype_push(EcsWorld *world, EcsArchetype *archetype, Entity entity)
+{
+  uint32_t row = archetype->entity_count;
+  uint32_t chunk_index = row / archetype->capacity;
+
+  if (chunk_index == archetype->chunk_count) {
+    if (archetype->chunk_count == archetype->chunk_capacity) {
+      uint32_t capacity = archetype->chunk_capacity ? archetype->chunk_capacity * 2 : 16;
+      EcsChunk *chunks = mem_realloc(archetype->chunks, capacity * sizeof(EcsChunk));
+      if (chunks == NULL) return UINT32_MAX;
+      archetype->chunks = chunks;
+      archetype->chunk_capacity = capacity;
+    }
+
+    uint8_t *data = mem_alloc(ECS_CHUNK_BYTES);
+    if (data == NULL) return UINT32_MAX;
+    archetype->chunks[archetype->chunk_count++] = (EcsChunk){data, 0};
+  }
+
+  EcsChunk *chunk = &archetype->chunks[chunk_index];
+  uint32_t local = chunk->count++;
+  ((Entity *)chunk->data)[local] = entity;
+
+  for (uint32_t c = 0; c < world->component_count; c++) {
+    if (!(archetype->mask & ECS_COMPONENT(c))) continue;
+    memset(chunk->data + archetype->offsets[c] + local * world->component_sizes[c], 0, world->component_sizes[c]);
+  }
+
+  archetype->entity_count++;
+  return row;
+}
+
+// Fills row with the archetype's last entity, keeping chunks dense
+static void ecs_archetype_remove(EcsWorld *world, EcsArchetype *archetype, uint32_t row)
+{
+  uint32_t last = archetype->entity_count - 1;
+
+  if (row != last) {
+    Entity moved = *ecs_row_entity(archetype, last);
+    *ecs_row_entity(archetype, row) = moved;
+
+    for (uint32_t c = 0; c < world->component_count; c++) {
+      if (!(archetype->mask & ECS_COMPONENT(c))) continue;
+      memcpy(ecs_row_column(world, archetype, row, c), ecs_row_column(world, archetype, last, c), world->component_sizes[c]);
+    }
+    world->slots[moved.index].row = row;
+  }
+
+  archetype->chunks[last / archetype->capacity].count--;
+  archetype->entity_count--;
+
+  // Keep one spare chunk around to avoid thrashing on the boundary
+  while (archetype->chunk_count > 1 &&
+         archetype->chunks[archetype->chunk_count - 1].count == 0 &&
+         archetype->chunks[archetype->chunk_count - 2].count == 0) {
+    mem_free(archetype->chunks[--archetype->chunk_count].data);
+  }
+}
+
+void ecs_init(EcsWorld *world)
+{
+  memset(world, 0, sizeof(*world));
+}
+
+void ecs_free(EcsWorld *world)
+{
+  for (uint32_t i = 0; i < world->archetype_count; i++) {
+    EcsArchetype *archetype = &world->archetypes[i];
+    for (uint32_t c = 0; c < archetype->chunk_count; c++) mem_free(archetype->chunks[c].data);
+    mem_free(archetype->chunks);
+  }
+  mem_free(world->slots);
+  mem_free(world->free_slots);
+  mem_free(world->views);
+  memset(world, 0, sizeof(*world));
+}
+
+uint32_t ecs_register_component(EcsWorld *world, uint32_t size)
+{
+  // Archetypes are laid out with the components known at the time
+  if (world->component_count == ECS_MAX_COMPONENTS || world->archetype_count > 0 || size == 0) {
+    fprintf(stderr, "[ERROR]: Cannot register ECS component\n");
+    return ECS_MAX_COMPONENTS;
+  }
+
+  world->component_sizes[world->component_count] = size;
+  return world->component_count++;
+}
+
+static bool ecs_slot_alloc(EcsWorld *world, uint32_t *index)
+{
+  if (world->free_count > 0) {
+    *index = world->free_slots[--world->free_count];
+    return true;
+  }
+
+  if (world->slot_count == world->slot_capacity) {
+    uint32_t capacity = world->slot_capacity ? world->slot_capacity * 2 : 1024;
+    EcsSlot *slots = mem_realloc(world->slots, capacity * sizeof(EcsSlot));
+    if (slots == NULL) return false;
+    world->slots = slots;
+
+    uint32_t *free_slots = mem_realloc(world->free_slots, capacity * sizeof(uint32_t));
+    if (free_slots == NULL) return false;
+    world->free_slots = free_slots;
+    world->slot_capacity = capacity;
+  }
+
+  *index = world->slot_count;
+  world->slots[world->slot_count++] = (EcsSlot){0, 0, 0, false};
+  return true;
+}
+
+Entity ecs_create(EcsWorld *world, EcsMask mask)
+{
+  Entity none = {0, 0};
+
+  uint32_t archetype_index = ecs_archetype_find(world, mask);
+  if (archetype_index == ECS_MAX_ARCHETYPES) return none;
+
+  uint32_t index;
+  if (!ecs_slot_alloc(world, &index)) return none;
+
+  EcsSlot *slot = &world->slots[index];
+  // Generation 0 is never handed out so {0, 0} stays invalid
+  Entity entity = {index, slot->generation + 1};
+
+  uint32_t row = ecs_archetype_push(world, &world->archetypes[archetype_index], entity);
+  if (row == UINT32_MAX) {
+    world->free_slots[world->free_count++] = index;
+    return none;
+  }
+
+  *slot = (EcsSlot){archetype_index, row, entity.generation, true};
+  return entity;
+}
+
+bool ecs_alive(const EcsWorld *world, Entity entity)
+{
+  return entity.index < world->slot_count &&
+         world->slots[entity.index].alive &&
+         world->slots[entity.index].generation == entity.generation;
+}
+
+void ecs_destroy(EcsWorld *world, Entity entity)
+{
+  if (!ecs_alive(world, entity)) return;
+
+  EcsSlot *slot = &world->slots[entity.index];
+  ecs_archetype_remove(world, &world->archetypes[slot->archetype], slot->row);
+
+  slot->alive = false;
+  world->free_slots[world->free_count++] = entity.index;
+}
+
+bool ecs_set_mask(EcsWorld *world, Entity entity, EcsMask mask)
+{
+  if (!ecs_alive(world, entity)) return false;
+
+  EcsSlot *slot = &world->slots[entity.index];
+  if (world->archetypes[slot->archetype].mask == mask) return true;
+
+  uint32_t target_index = ecs_archetype_find(world, mask);
+  if (target_index == ECS_MAX_ARCHETYPES) return false;
+
+  EcsArchetype *source = &world->archetypes[slot->archetype];
+  EcsArchetype *target = &world->archetypes[target_index];
+
+  uint32_t row = ecs_archetype_push(world, target, entity);
+  if (row == UINT32_MAX) return false;
+
+  EcsMask shared = source->mask & target->mask;
+  for (uint32_t c = 0; c < world->component_count; c++) {
+    if (!(shared & ECS_COMPONENT(c))) continue;
+    memcpy(ecs_row_column(world, target, row, c), ecs_row_column(world, source, slot->row, c), world->component_sizes[c]);
+  }
+
+  ecs_archetype_remove(world, source, slot->row);
+  slot->archetype = target_index;
+  slot->row = row;
+  return true;
+}
+
+void *ecs_get(const EcsWorld *world, Entity entity, uint32_t component)
+{
+  if (!ecs_alive(world, entity) || component >= world->component_count) return NULL;
+
+  const EcsSlot *slot = &world->slots[entity.index];
+  const EcsArchetype *archetype = &world->archetypes[slot->archetype];
+  if (!(archetype->mask & ECS_COMPONENT(component))) return NULL;
+
+  return ecs_row_column(world, archetype, slot->row, component);
+}
+
+EcsQuery ecs_query(EcsWorld *world, EcsMask mask)
+{
+  return (EcsQuery){world, mask, 0, 0};
+}
+
+bool ecs_query_next(EcsQuery *query, EcsView *view)
+{
+  EcsWorld *world = query->world;
+
+  for (; query->archetype < world->archetype_count; query->archetype++, query->chunk = 0) {
+    const EcsArchetype *archetype = &world->archetypes[query->archetype];
+    if ((archetype->mask & query->mask) != query->mask) continue;
+
+    while (query->chunk < archetype->chunk_count) {
+      const EcsChunk *chunk = &archetype->chunks[query->chunk++];
+      if (chunk->count == 0) continue;
+
+      *view = (EcsView){archetype, chunk->data, chunk->count};
+      return true;
+    }
+  }
+  return false;
+}
+
+typedef struct {
+  EcsView *views;
+  EcsSystemFn fn;
+  void *user;
+} EcsParallelJob;
+
+static void ecs_parallel_chunk(void *user, uint32_t begin, uint32_t end, uint32_t worker)
+{
+  EcsParallelJob *job = user;
+  for (uint32_t i = begin; i < end; i++) job->fn(job->user, &job->views[i], worker);
+}
+
+void ecs_query_parallel(EcsWorld *world, EcsMask mask, ThreadPool *pool, EcsSystemFn fn, void *user)
+{
+  uint32_t chunk_count = 0;
+  for (uint32_t i = 0; i < world->archetype_count; i++)
+    if ((world->archetypes[i].mask & mask) == mask) chunk_count += world->archetypes[i].chunk_count;
+  if (chunk_count == 0) return;
+
+  if (chunk_count > world->view_capacity) {
+    EcsView *views = mem_realloc(world->views, chunk_count * sizeof(EcsView));
+    if (views == NULL) {
+      // Still correct, just serial
+      EcsQuery query = ecs_query(world, mask);
+      EcsView view;
+      while (ecs_query_next(&query, &view)) fn(user, &view, 0);
+      return;
+    }
+    world->views = views;
+    world->view_capacity = chunk_count;
+  }
+
+  uint32_t view_count = 0;
+  EcsQuery query = ecs_query(world, mask);
+  while (ecs_query_next(&query, &world->views[view_count])) view_count++;
+
+  EcsParallelJob job = {world->views, fn, user};
+  thread_pool_parallel_for(pool, view_count, 4, ecs_parallel_chunk, &job);
+}
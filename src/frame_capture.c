@@ -0,0 +1,258 @@
+#include <frame_capture.h>
+#include <glad/glad.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define FRAME_CAPTURE_PATH_MAX        1024
+#define FRAME_CAPTURE_FENCE_TIMEOUT_NS 1000000000ull
+
+static void frame_capture_writer(void *user)
+{
+  FrameCaptureWriter *worker = user;
+  FrameCapture *capture = worker->capture;
+  char path[FRAME_CAPTURE_PATH_MAX];
+
+  mutex_lock(&capture->mutex);
+  for (;;) {
+    while (capture->queue_count == 0 && !capture->quit) cond_wait(&capture->cond, &capture->mutex);
+    if (capture->queue_count == 0) break;
+
+    FrameCaptureSlot *slot = &capture->slots[capture->queue[capture->queue_head]];
+    capture->queue_head = (capture->queue_head + 1) % FRAME_CAPTURE_SLOTS;
+    capture->queue_count--;
+    slot->state = FRAME_SLOT_WRITING;
+    mutex_unlock(&capture->mutex);
+
+    // The slot is ours until set free, the GL thread doesn't touch its buffer meanwhile
+    bool ok = false;
+    int length = snprintf(path, sizeof(path), "%s%06llu.%s",
+      capture->prefix, (unsigned long long)slot->frame, frame_capture_format_name(capture->format));
+
+    if (length < 0 || length >= (int)sizeof(path)) {
+      fprintf(stderr, "[ERROR]: Capture path too long\n");
+    } else if (capture->format == FRAME_CAPTURE_PNG) {
+      ok = image_write_png(&worker->writer, path, slot->width, slot->height, slot->pixels, (size_t)slot->width * 4, true);
+    } else {
+      ok = image_write_ppm(&worker->writer, path, slot->width, slot->height, slot->pixels, (size_t)slot->width * 4, true);
+    }
+
+    mutex_lock(&capture->mutex);
+    if (ok) capture->written++;
+    else capture->failed++;
+    slot->state = FRAME_SLOT_FREE;
+  }
+  mutex_unlock(&capture->mutex);
+}
+
+bool frame_capture_start(FrameCapture *capture, const char *prefix, FrameCaptureFormat format, uint32_t writer_count)
+{
+  memset(capture, 0, sizeof(*capture));
+  capture->prefix = prefix;
+  capture->format = format;
+
+  if (writer_count == 0) writer_count = 1;
+  if (writer_count > FRAME_CAPTURE_MAX_WRITERS) writer_count = FRAME_CAPTURE_MAX_WRITERS;
+
+  mutex_init(&capture->mutex);
+  cond_init(&capture->cond);
+
+  for (uint32_t i = 0; i < writer_count; i++) {
+    FrameCaptureWriter *worker = &capture->writers[i];
+    worker->capture = capture;
+    image_writer_init(&worker->writer);
+
+    if (!thread_create(&worker->thread, frame_capture_writer, worker)) {
+      image_writer_free(&worker->writer);
+      break;
+    }
+    capture->writer_count++;
+  }
+
+  if (capture->writer_count == 0) {
+    fprintf(stderr, "[ERROR]: Could not create any capture writer thread\n");
+    cond_destroy(&capture->cond);
+    mutex_destroy(&capture->mutex);
+    return false;
+  }
+  return true;
+}
+
+static void frame_capture_hand_over(FrameCapture *capture, FrameCaptureSlot *slot)
+{
+  glDeleteSync((GLsync)slot->fence);
+  slot->fence = NULL;
+
+  mutex_lock(&capture->mutex);
+  slot->state = FRAME_SLOT_QUEUED;
+  capture->queue[(capture->queue_head + capture->queue_count) % FRAME_CAPTURE_SLOTS] = (uint32_t)(slot - capture->slots);
+  capture->queue_count++;
+  cond_signal(&capture->cond);
+  mutex_unlock(&capture->mutex);
+}
+
+// Readbacks the GPU finished go to the writers, oldest first
+static void frame_capture_poll(FrameCapture *capture, bool wait)
+{
+  for (;;) {
+    FrameCaptureSlot *oldest = NULL;
+    mutex_lock(&capture->mutex);
+    for (uint32_t i = 0; i < FRAME_CAPTURE_SLOTS; i++) {
+      FrameCaptureSlot *slot = &capture->slots[i];
+      if (slot->state == FRAME_SLOT_READING && (oldest == NULL || slot->frame < oldest->frame)) oldest = slot;
+    }
+    mutex_unlock(&capture->mutex);
+    if (oldest == NULL) return;
+
+    GLenum status = wait
+      ? glClientWaitSync((GLsync)oldest->fence, GL_SYNC_FLUSH_COMMANDS_BIT, FRAME_CAPTURE_FENCE_TIMEOUT_NS)
+      : glClientWaitSync((GLsync)oldest->fence, 0, 0);
+
+    if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+      frame_capture_hand_over(capture, oldest);
+    } else if (status == GL_WAIT_FAILED || wait) {
+      fprintf(stderr, "[WARNING]: Capture fence wait failed, dropping frame %llu\n", (unsigned long long)oldest->frame);
+      glDeleteSync((GLsync)oldest->fence);
+      oldest->fence = NULL;
+
+      mutex_lock(&capture->mutex);
+      oldest->state = FRAME_SLOT_FREE;
+      capture->failed++;
+      mutex_unlock(&capture->mutex);
+    } else {
+      return;
+    }
+  }
+}
+
+static bool frame_capture_reserve(FrameCaptureSlot *slot, size_t size)
+{
+  if (size <= slot->capacity) return true;
+
+  if (slot->buffer != 0) {
+    glUnmapNamedBuffer(slot->buffer);
+    glDeleteBuffers(1, &slot->buffer);
+  }
+  slot->buffer = 0;
+  slot->pixels = NULL;
+  slot->capacity = 0;
+
+  // Persistent + coherent: writers read the mapping directly, no copy out and no remap per frame
+  GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glCreateBuffers(1, &slot->buffer);
+  glNamedBufferStorage(slot->buffer, (GLsizeiptr)size, NULL, flags | GL_CLIENT_STORAGE_BIT);
+  slot->pixels = glMapNamedBufferRange(slot->buffer, 0, (GLsizeiptr)size, flags);
+
+  if (slot->pixels == NULL) {
+    fprintf(stderr, "[ERROR]: Could not map a %zu byte capture buffer\n", size);
+    glDeleteBuffers(1, &slot->buffer);
+    slot->buffer = 0;
+    return false;
+  }
+  slot->capacity = size;
+  return true;
+}
+
+void frame_capture_frame(FrameCapture *capture, int32_t width, int32_t height)
+{
+  frame_capture_poll(capture, false);
+  if (width <= 0 || height <= 0) return;
+
+  FrameCaptureSlot *slot = NULL;
+  mutex_lock(&capture->mutex);
+  for (uint32_t i = 0; i < FRAME_CAPTURE_SLOTS && slot == NULL; i++)
+    if (capture->slots[i].state == FRAME_SLOT_FREE) slot = &capture->slots[i];
+  mutex_unlock(&capture->mutex);
+
+  uint64_t frame = capture->next_frame++;
+  if (slot == NULL) {
+    capture->dropped++;
+    return;
+  }
+
+  if (!frame_capture_reserve(slot, (size_t)width * (size_t)height * 4)) {
+    mutex_lock(&capture->mutex);
+    capture->failed++;
+    mutex_unlock(&capture->mutex);
+    return;
+  }
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+  slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot->width = width;
+  slot->height = height;
+  slot->frame = frame;
+  capture->captured++;
+
+  mutex_lock(&capture->mutex);
+  slot->state = FRAME_SLOT_READING;
+  mutex_unlock(&capture->mutex);
+}
+
+void frame_capture_stop(FrameCapture *capture)
+{
+  frame_capture_poll(capture, true);
+
+  mutex_lock(&capture->mutex);
+  capture->quit = true;
+  cond_broadcast(&capture->cond);
+  mutex_unlock(&capture->mutex);
+
+  for (uint32_t i = 0; i < capture->writer_count; i++) {
+    thread_join(&capture->writers[i].thread);
+    image_writer_free(&capture->writers[i].writer);
+  }
+  capture->writer_count = 0;
+
+  for (uint32_t i = 0; i < FRAME_CAPTURE_SLOTS; i++) {
+    FrameCaptureSlot *slot = &capture->slots[i];
+    if (slot->buffer == 0) continue;
+    glUnmapNamedBuffer(slot->buffer);
+    glDeleteBuffers(1, &slot->buffer);
+    slot->buffer = 0;
+    slot->pixels = NULL;
+    slot->capacity = 0;
+  }
+
+  cond_destroy(&capture->cond);
+  mutex_destroy(&capture->mutex);
+}
+
+void frame_capture_report(const FrameCapture *capture)
+{
+  printf(
+    "[INFO]: Frame capture (%s, \"%s\")\n"
+    "  - Frames        : %llu captured, %llu written, %llu dropped, %llu failed\n",
+    frame_capture_format_name(capture->format), capture->prefix,
+    (unsigned long long)capture->captured, (unsigned long long)capture->written,
+    (unsigned long long)capture->dropped, (unsigned long long)capture->failed
+  );
+}
+
+const char *frame_capture_format_name(FrameCaptureFormat format)
+{
+  switch (format) {
+    case FRAME_CAPTURE_PPM: return "ppm";
+    case FRAME_CAPTURE_PNG: return "png";
+  }
+  return "unknown";
+}
+
+bool frame_capture_format_parse(const char *name, FrameCaptureFormat *format)
+{
+  static const FrameCaptureFormat formats[] = {FRAME_CAPTURE_PPM, FRAME_CAPTURE_PNG};
+
+  for (uint32_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+    if (strcmp(name, frame_capture_format_name(formats[i])) == 0) {
+      *format = formats[i];
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,436 @@
+#include <frame_graph.h>
+#include <glad/glad.h>
+
+#include <stdio.h>
+#include <string.h>
+
+void frame_graph_init(FrameGraph *graph)
+{
+  memset(graph, 0, sizeof(*graph));
+}
+
+void frame_graph_destroy(FrameGraph *graph)
+{
+  for (uint32_t i = 0; i < FRAME_GRAPH_MAX_PASSES; i++)
+    if (graph->fbos[i] != 0) glDeleteFramebuffers(1, &graph->fbos[i]);
+  if (graph->read_fbo != 0) glDeleteFramebuffers(1, &graph->read_fbo);
+  memset(graph, 0, sizeof(*graph));
+}
+
+void frame_graph_reset(FrameGraph *graph)
+{
+  graph->pass_count = 0;
+  graph->resource_count = 0;
+  graph->order_count = 0;
+  graph->compiled = false;
+  graph->failed = false;
+}
+
+static uint32_t frame_graph_add_resource(FrameGraph *graph, FrameGraphResource resource)
+{
+  if (graph->resource_count == FRAME_GRAPH_MAX_RESOURCES) {
+    fprintf(stderr, "[ERROR]: Frame graph resource limit (%u) reached by \"%s\"\n", FRAME_GRAPH_MAX_RESOURCES, resource.name);
+    graph->failed = true;
+    return FRAME_GRAPH_INVALID;
+  }
+
+  resource.first = FRAME_GRAPH_INVALID;
+  resource.last = FRAME_GRAPH_INVALID;
+  graph->resources[graph->resource_count] = resource;
+  return graph->resource_count++;
+}
+
+uint32_t frame_graph_create_texture(FrameGraph *graph, const char *name, uint32_t format, int32_t width, int32_t height)
+{
+  return frame_graph_add_resource(graph, (FrameGraphResource){
+    .name = name, .format = format, .width = width, .height = height,
+    .alloc_width = render_target_round(width), .alloc_height = render_target_round(height)
+  });
+}
+
+uint32_t frame_graph_import_texture(FrameGraph *graph, const char *name, uint32_t texture, uint32_t format, int32_t width, int32_t height)
+{
+  return frame_graph_add_resource(graph, (FrameGraphResource){
+    .name = name, .format = format, .width = width, .height = height,
+    .alloc_width = width, .alloc_height = height, .imported = true, .texture = texture
+  });
+}
+
+uint32_t frame_graph_import_backbuffer(FrameGraph *graph, int32_t width, int32_t height)
+{
+  return frame_graph_add_resource(graph, (FrameGraphResource){
+    .name = "backbuffer", .width = width, .height = height,
+    .alloc_width = width, .alloc_height = height, .imported = true, .backbuffer = true
+  });
+}
+
+uint32_t frame_graph_add_pass(FrameGraph *graph, const char *name, uint32_t flags, FrameGraphPassFn fn, void *user)
+{
+  if (graph->pass_count == FRAME_GRAPH_MAX_PASSES) {
+    fprintf(stderr, "[ERROR]: Frame graph pass limit (%u) reached by \"%s\"\n", FRAME_GRAPH_MAX_PASSES, name);
+    graph->failed = true;
+    return FRAME_GRAPH_INVALID;
+  }
+
+  graph->passes[graph->pass_count] = (FrameGraphPass){.name = name, .fn = fn, .user = user, .flags = flags};
+  return graph->pass_count++;
+}
+
+static void frame_graph_use(FrameGraph *graph, uint32_t pass, uint32_t resource, FrameGraphAccess access, bool write)
+{
+  if (pass >= graph->pass_count || resource >= graph->resource_count) {
+    graph->failed = true;
+    return;
+  }
+
+  FrameGraphPass *p = &graph->passes[pass];
+  if (p->use_count == FRAME_GRAPH_MAX_ACCESSES) {
+    fprintf(stderr, "[ERROR]: Pass \"%s\" uses more than %u resources\n", p->name, FRAME_GRAPH_MAX_ACCESSES);
+    graph->failed = true;
+    return;
+  }
+  p->uses[p->use_count++] = (FrameGraphUse){resource, access, write};
+}
+
+void frame_graph_read(FrameGraph *graph, uint32_t pass, uint32_t resource, FrameGraphAccess access)
+{
+  frame_graph_use(graph, pass, resource, access, false);
+}
+
+void frame_graph_write(FrameGraph *graph, uint32_t pass, uint32_t resource, FrameGraphAccess access)
+{
+  frame_graph_use(graph, pass, resource, access, true);
+}
+
+static inline bool frame_graph_writes(const FrameGraphPass *pass, uint32_t resource)
+{
+  for (uint32_t i = 0; i < pass->use_count; i++)
+    if (pass->uses[i].write && pass->uses[i].resource == resource) return true;
+  return false;
+}
+
+/*
+  Readers run after every writer of a resource. A pass that also writes
+  what it reads (loading an attachment) only waits for the writers
+  declared before it, so passes can accumulate into the same target.
+*/
+static bool frame_graph_depends(const FrameGraph *graph, uint32_t before, uint32_t after)
+{
+  const FrameGraphPass *p = &graph->passes[after];
+  const FrameGraphPass *q = &graph->passes[before];
+
+  for (uint32_t i = 0; i < p->use_count; i++) {
+    uint32_t resource = p->uses[i].resource;
+    if (!frame_graph_writes(q, resource)) continue;
+    if (!frame_graph_writes(p, resource) || before < after) return true;
+  }
+  return false;
+}
+
+static inline bool frame_graph_is_depth(uint32_t format)
+{
+  switch (format) {
+    case GL_DEPTH_COMPONENT16:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_COMPONENT32:
+    case GL_DEPTH_COMPONENT32F:
+    case GL_DEPTH24_STENCIL8:
+    case GL_DEPTH32F_STENCIL8:
+      return true;
+  }
+  return false;
+}
+
+static inline bool frame_graph_has_stencil(uint32_t format)
+{
+  return format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+}
+
+static bool frame_graph_check_attachments(const FrameGraph *graph, const FrameGraphPass *pass)
+{
+  uint32_t colors = 0, depths = 0;
+  bool backbuffer = false;
+  int32_t width = 0, height = 0;
+
+  for (uint32_t i = 0; i < pass->use_count; i++) {
+    if (pass->uses[i].access != FRAME_GRAPH_ATTACHMENT) continue;
+    const FrameGraphResource *resource = &graph->resources[pass->uses[i].resource];
+
+    if (resource->backbuffer) backbuffer = true;
+    else if (frame_graph_is_depth(resource->format)) depths++;
+    else colors++;
+
+    if (width != 0 && (resource->width != width || resource->height != height)) {
+      fprintf(stderr, "[ERROR]: Pass \"%s\" attachments differ in size\n", pass->name);
+      return false;
+    }
+    width = resource->width;
+    height = resource->height;
+  }
+
+  if (backbuffer && (colors > 0 || depths > 0)) {
+    fprintf(stderr, "[ERROR]: Pass \"%s\" mixes the backbuffer with other attachments\n", pass->name);
+    return false;
+  }
+  if (depths > 1) {
+    fprintf(stderr, "[ERROR]: Pass \"%s\" has more than one depth attachment\n", pass->name);
+    return false;
+  }
+  return true;
+}
+
+bool frame_graph_compile(FrameGraph *graph)
+{
+  graph->compiled = false;
+  graph->order_count = 0;
+  memset(&graph->stats, 0, sizeof(graph->stats));
+  if (graph->failed) return false;
+
+  // Culling: keep side effects and writers of imported resources, then everything they read from
+  for (uint32_t p = 0; p < graph->pass_count; p++) {
+    FrameGraphPass *pass = &graph->passes[p];
+    pass->live = (pass->flags & FRAME_GRAPH_SIDE_EFFECT) != 0;
+    for (uint32_t i = 0; i < pass->use_count; i++)
+      if (pass->uses[i].write && graph->resources[pass->uses[i].resource].imported) pass->live = true;
+  }
+
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (uint32_t p = 0; p < graph->pass_count; p++) {
+      if (!graph->passes[p].live) continue;
+      for (uint32_t q = 0; q < graph->pass_count; q++) {
+        if (graph->passes[q].live || !frame_graph_depends(graph, q, p)) continue;
+        graph->passes[q].live = true;
+        changed = true;
+      }
+    }
+  }
+
+  // Topological order of the live passes, ties keep the declaration order
+  bool placed[FRAME_GRAPH_MAX_PASSES] = {0};
+  uint32_t live_count = 0;
+  for (uint32_t p = 0; p < graph->pass_count; p++) live_count += graph->passes[p].live;
+
+  while (graph->order_count < live_count) {
+    uint32_t next = FRAME_GRAPH_INVALID;
+    for (uint32_t p = 0; p < graph->pass_count && next == FRAME_GRAPH_INVALID; p++) {
+      if (!graph->passes[p].live || placed[p]) continue;
+
+      bool ready = true;
+      for (uint32_t q = 0; q < graph->pass_count && ready; q++)
+        if (q != p && graph->passes[q].live && !placed[q] && frame_graph_depends(graph, q, p)) ready = false;
+      if (ready) next = p;
+    }
+
+    if (next == FRAME_GRAPH_INVALID) {
+      fprintf(stderr, "[ERROR]: Frame graph has a dependency cycle\n");
+      return false;
+    }
+    placed[next] = true;
+    graph->order[graph->order_count++] = next;
+  }
+
+  // Lifetimes, as positions in the execution order
+  for (uint32_t r = 0; r < graph->resource_count; r++) {
+    graph->resources[r].first = FRAME_GRAPH_INVALID;
+    graph->resources[r].last = FRAME_GRAPH_INVALID;
+    graph->resources[r].written = false;
+    if (!graph->resources[r].imported) graph->resources[r].texture = 0;
+  }
+
+  for (uint32_t i = 0; i < graph->order_count; i++) {
+    const FrameGraphPass *pass = &graph->passes[graph->order[i]];
+    if (!frame_graph_check_attachments(graph, pass)) return false;
+
+    for (uint32_t u = 0; u < pass->use_count; u++) {
+      FrameGraphResource *resource = &graph->resources[pass->uses[u].resource];
+      if (resource->first == FRAME_GRAPH_INVALID) {
+        resource->first = i;
+        if (!resource->imported) graph->stats.transients++;
+      }
+      resource->last = i;
+    }
+  }
+
+  graph->stats.passes = graph->order_count;
+  graph->stats.culled = graph->pass_count - graph->order_count;
+  graph->compiled = true;
+  return true;
+}
+
+// Only image stores are incoherent, framebuffer and copy writes are ordered by GL itself
+static inline uint32_t frame_graph_barrier_bits(FrameGraphAccess access)
+{
+  switch (access) {
+    case FRAME_GRAPH_ATTACHMENT: return GL_FRAMEBUFFER_BARRIER_BIT;
+    case FRAME_GRAPH_SAMPLED:    return GL_TEXTURE_FETCH_BARRIER_BIT;
+    case FRAME_GRAPH_IMAGE:      return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+    case FRAME_GRAPH_TRANSFER:   return GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT;
+  }
+  return GL_ALL_BARRIER_BITS;
+}
+
+// Blits name their source framebuffer, the first color read through FRAME_GRAPH_TRANSFER gets one
+static void frame_graph_bind_read(FrameGraph *graph, const FrameGraphPass *pass)
+{
+  for (uint32_t i = 0; i < pass->use_count; i++) {
+    const FrameGraphResource *resource = &graph->resources[pass->uses[i].resource];
+    if (pass->uses[i].write || pass->uses[i].access != FRAME_GRAPH_TRANSFER) continue;
+    if (resource->backbuffer || frame_graph_is_depth(resource->format)) continue;
+
+    if (graph->read_fbo == 0) glCreateFramebuffers(1, &graph->read_fbo);
+    glNamedFramebufferTexture(graph->read_fbo, GL_COLOR_ATTACHMENT0, resource->texture, 0);
+    glNamedFramebufferReadBuffer(graph->read_fbo, GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, graph->read_fbo);
+    return;
+  }
+}
+
+static bool frame_graph_bind_draw(FrameGraph *graph, uint32_t slot, const FrameGraphPass *pass)
+{
+  uint32_t colors[FRAME_GRAPH_MAX_ACCESSES];
+  uint32_t color_count = 0;
+  const FrameGraphResource *depth = NULL;
+  const FrameGraphResource *any = NULL;
+
+  for (uint32_t i = 0; i < pass->use_count; i++) {
+    if (pass->uses[i].access != FRAME_GRAPH_ATTACHMENT) continue;
+    const FrameGraphResource *resource = &graph->resources[pass->uses[i].resource];
+    any = resource;
+
+    if (resource->backbuffer) {
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      glViewport(0, 0, resource->width, resource->height);
+      return true;
+    }
+
+    if (frame_graph_is_depth(resource->format)) {
+      depth = resource;
+      continue;
+    }
+
+    // A read + write of the same attachment binds it once
+    bool bound = false;
+    for (uint32_t c = 0; c < color_count; c++) bound |= colors[c] == resource->texture;
+    if (!bound) colors[color_count++] = resource->texture;
+  }
+
+  // Compute and copy passes bind what they need themselves
+  if (any == NULL) return true;
+
+  if (graph->fbos[slot] == 0) glCreateFramebuffers(1, &graph->fbos[slot]);
+  uint32_t fbo = graph->fbos[slot];
+
+  GLenum draw_buffers[FRAME_GRAPH_MAX_ACCESSES];
+  for (uint32_t c = 0; c < FRAME_GRAPH_MAX_ACCESSES; c++) {
+    glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0 + c, c < color_count ? colors[c] : 0, 0);
+    draw_buffers[c] = c < color_count ? GL_COLOR_ATTACHMENT0 + c : GL_NONE;
+  }
+  glNamedFramebufferDrawBuffers(fbo, FRAME_GRAPH_MAX_ACCESSES, draw_buffers);
+
+  // The depth stencil point covers the depth one too, it is set first so it doesn't detach depth only textures
+  bool stencil = depth != NULL && frame_graph_has_stencil(depth->format);
+  glNamedFramebufferTexture(fbo, GL_DEPTH_STENCIL_ATTACHMENT, stencil ? depth->texture : 0, 0);
+  if (!stencil) glNamedFramebufferTexture(fbo, GL_DEPTH_ATTACHMENT, depth != NULL ? depth->texture : 0, 0);
+
+  if (glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    fprintf(stderr, "[ERROR]: Framebuffer of pass \"%s\" incomplete\n", pass->name);
+    return false;
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glViewport(0, 0, any->width, any->height);
+  return true;
+}
+
+static bool frame_graph_bind(FrameGraph *graph, uint32_t slot, const FrameGraphPass *pass)
+{
+  if (!frame_graph_bind_draw(graph, slot, pass)) return false;
+  frame_graph_bind_read(graph, pass);
+  return true;
+}
+
+static void frame_graph_release(FrameGraph *graph, RenderTexturePool *pool, uint32_t position, bool all)
+{
+  for (uint32_t r = 0; r < graph->resource_count; r++) {
+    FrameGraphResource *resource = &graph->resources[r];
+    if (resource->imported || resource->texture == 0) continue;
+    if (!all && resource->last != position) continue;
+
+    render_texture_release(pool, resource->texture);
+    resource->texture = 0;
+  }
+}
+
+bool frame_graph_execute(FrameGraph *graph, RenderTexturePool *pool)
+{
+  if (!graph->compiled) return false;
+
+  uint32_t textures[FRAME_GRAPH_MAX_RESOURCES];
+  uint32_t texture_count = 0;
+
+  for (uint32_t i = 0; i < graph->order_count; i++) {
+    FrameGraphPass *pass = &graph->passes[graph->order[i]];
+
+    // Transients born here reuse whatever textures died in earlier passes
+    for (uint32_t r = 0; r < graph->resource_count; r++) {
+      FrameGraphResource *resource = &graph->resources[r];
+      if (resource->imported || resource->first != i) continue;
+
+      resource->texture = render_texture_acquire(pool, resource->format, resource->alloc_width, resource->alloc_height);
+      if (resource->texture == 0) {
+        fprintf(stderr, "[ERROR]: Could not allocate transient \"%s\"\n", resource->name);
+        frame_graph_release(graph, pool, i, true);
+        return false;
+      }
+
+      bool seen = false;
+      for (uint32_t t = 0; t < texture_count; t++) seen |= textures[t] == resource->texture;
+      if (!seen) textures[texture_count++] = resource->texture;
+    }
+
+    uint32_t barriers = 0;
+    for (uint32_t u = 0; u < pass->use_count; u++) {
+      const FrameGraphResource *resource = &graph->resources[pass->uses[u].resource];
+      if (resource->written && resource->last_write == FRAME_GRAPH_IMAGE)
+        barriers |= frame_graph_barrier_bits(pass->uses[u].access);
+    }
+    if (barriers != 0) {
+      glMemoryBarrier(barriers);
+      graph->stats.barriers++;
+    }
+
+    if (!frame_graph_bind(graph, i, pass)) {
+      frame_graph_release(graph, pool, i, true);
+      return false;
+    }
+
+    pass->fn(graph, graph->order[i], pass->user);
+
+    for (uint32_t u = 0; u < pass->use_count; u++) {
+      if (!pass->uses[u].write) continue;
+      FrameGraphResource *resource = &graph->resources[pass->uses[u].resource];
+      resource->written = true;
+      resource->last_write = pass->uses[u].access;
+    }
+
+    frame_graph_release(graph, pool, i, false);
+  }
+
+  graph->stats.textures = texture_count;
+  return true;
+}
+
+void frame_graph_report(const FrameGraph *graph)
+{
+  const FrameGraphStats *stats = &graph->stats;
+  printf(
+    "[INFO]: Frame graph (last frame)\n"
+    "  - Passes        : %u run, %u culled\n"
+    "  - Transients    : %u on %u texture(s)\n"
+    "  - Barriers      : %u\n",
+    stats->passes, stats->culled,
+    stats->transients, stats->textures,
+    stats->barriers
+  );
+}
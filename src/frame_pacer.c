@@ -0,0 +1,199 @@
+#include <frame_pacer.h>
+#include <platform.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#define FRAME_PACER_FENCE_TIMEOUT_NS 1000000000ull
+
+void frame_pacer_init(FramePacer *pacer, GLFWwindow *window, FramePresentMode mode, double target_fps, uint32_t max_frames_ahead)
+{
+  memset(pacer, 0, sizeof(*pacer));
+  pacer->window = window;
+  pacer->frame_seconds = target_fps > 0.0 ? 1.0 / target_fps : 0.0;
+
+  if (max_frames_ahead < 1) max_frames_ahead = 1;
+  if (max_frames_ahead > FRAME_PACER_MAX_FRAMES_AHEAD) max_frames_ahead = FRAME_PACER_MAX_FRAMES_AHEAD;
+  pacer->max_frames_ahead = max_frames_ahead;
+
+  frame_pacer_set_mode(pacer, mode);
+}
+
+void frame_pacer_destroy(FramePacer *pacer)
+{
+  for (uint32_t i = 0; i < pacer->fence_count; i++)
+    glDeleteSync((GLsync)pacer->fences[(pacer->fence_head + i) % FRAME_PACER_MAX_FRAMES_AHEAD]);
+  pacer->fence_count = 0;
+}
+
+bool frame_pacer_set_mode(FramePacer *pacer, FramePresentMode mode)
+{
+  bool supported = true;
+
+  if (mode == FRAME_PRESENT_ADAPTIVE &&
+      !glfwExtensionSupported("WGL_EXT_swap_control_tear") &&
+      !glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+    fprintf(stderr, "[WARNING]: Adaptive vsync not supported, using vsync\n");
+    mode = FRAME_PRESENT_VSYNC;
+    supported = false;
+  }
+
+  switch (mode) {
+    case FRAME_PRESENT_VSYNC:    glfwSwapInterval(1);  break;
+    case FRAME_PRESENT_ADAPTIVE: glfwSwapInterval(-1); break;
+    case FRAME_PRESENT_UNCAPPED: glfwSwapInterval(0);  break;
+  }
+
+  pacer->mode = mode;
+  return supported;
+}
+
+static void frame_pacer_retire(FramePacer *pacer, double now)
+{
+  GLsync fence = (GLsync)pacer->fences[pacer->fence_head];
+  double latency = now - pacer->fence_start[pacer->fence_head];
+
+  glDeleteSync(fence);
+  pacer->fence_head = (pacer->fence_head + 1) % FRAME_PACER_MAX_FRAMES_AHEAD;
+  pacer->fence_count--;
+
+  pacer->latency_sum += latency;
+  if (latency > pacer->latency_max) pacer->latency_max = latency;
+  pacer->latencies++;
+}
+
+// Retires finished frames, blocking while more than max_in_flight are queued
+static void frame_pacer_wait(FramePacer *pacer, uint32_t max_in_flight)
+{
+  while (pacer->fence_count > 0) {
+    GLsync fence = (GLsync)pacer->fences[pacer->fence_head];
+    bool must_wait = pacer->fence_count > max_in_flight;
+
+    GLenum status = must_wait
+      ? glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FRAME_PACER_FENCE_TIMEOUT_NS)
+      : glClientWaitSync(fence, 0, 0);
+
+    if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+      frame_pacer_retire(pacer, platform_time());
+    } else if (status == GL_WAIT_FAILED || (must_wait && status == GL_TIMEOUT_EXPIRED)) {
+      // Lost or hung fence, don't let it stall every following frame
+      fprintf(stderr, "[WARNING]: Frame fence wait failed, dropping it\n");
+      frame_pacer_retire(pacer, platform_time());
+    } else {
+      break;
+    }
+  }
+}
+
+void frame_pacer_begin(FramePacer *pacer)
+{
+  frame_pacer_wait(pacer, pacer->max_frames_ahead - 1);
+  pacer->frame_start = platform_time();
+}
+
+void frame_pacer_drain(FramePacer *pacer)
+{
+  frame_pacer_wait(pacer, 0);
+}
+
+void frame_pacer_present(FramePacer *pacer)
+{
+  if (pacer->frame_seconds > 0.0) {
+    if (pacer->deadline == 0.0) pacer->deadline = pacer->frame_start + pacer->frame_seconds;
+
+    // Sleep is only accurate to the OS timer, spin the last stretch
+    double now = platform_time();
+    if (pacer->deadline - now > FRAME_PACER_SPIN_SECONDS)
+      platform_sleep(pacer->deadline - now - FRAME_PACER_SPIN_SECONDS);
+    while (platform_time() < pacer->deadline) {}
+
+    // Keep a fixed cadence, but don't try to catch up after a long frame
+    pacer->deadline += pacer->frame_seconds;
+    now = platform_time();
+    if (now > pacer->deadline) pacer->deadline = now + pacer->frame_seconds;
+  }
+
+  glfwSwapBuffers(pacer->window);
+
+  uint32_t slot = (pacer->fence_head + pacer->fence_count) % FRAME_PACER_MAX_FRAMES_AHEAD;
+  pacer->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  pacer->fence_start[slot] = pacer->frame_start;
+  pacer->fence_count++;
+
+  double now = platform_time();
+  if (pacer->frames > 0) {
+    double interval = now - pacer->last_present;
+    pacer->interval_sum += interval;
+    pacer->interval_sq_sum += interval * interval;
+    if (interval > pacer->interval_max) pacer->interval_max = interval;
+    pacer->intervals++;
+  }
+  pacer->last_present = now;
+  pacer->frames++;
+}
+
+FramePacerStats frame_pacer_stats(const FramePacer *pacer)
+{
+  FramePacerStats stats = {0};
+  stats.frames = pacer->frames;
+
+  if (pacer->intervals > 0) {
+    double mean = pacer->interval_sum / pacer->intervals;
+    double variance = pacer->interval_sq_sum / pacer->intervals - mean * mean;
+    stats.interval_avg_ms = mean * 1000.0;
+    stats.interval_jitter_ms = variance > 0.0 ? sqrt(variance) * 1000.0 : 0.0;
+    stats.interval_max_ms = pacer->interval_max * 1000.0;
+  }
+
+  if (pacer->latencies > 0) {
+    stats.latency_avg_ms = pacer->latency_sum / pacer->latencies * 1000.0;
+    stats.latency_max_ms = pacer->latency_max * 1000.0;
+  }
+
+  return stats;
+}
+
+void frame_pacer_report(const FramePacer *pacer)
+{
+  FramePacerStats stats = frame_pacer_stats(pacer);
+  printf(
+    "[INFO]: Frame pacing (%s, %s, %u frame(s) ahead)\n"
+    "  - Frames        : %llu\n"
+    "  - Interval      : avg %.3f ms, jitter %.3f, max %.3f\n"
+    "  - Latency       : avg %.3f ms, max %.3f\n",
+    frame_present_mode_name(pacer->mode),
+    pacer->frame_seconds > 0.0 ? "limited" : "unlimited",
+    pacer->max_frames_ahead,
+    (unsigned long long)stats.frames,
+    stats.interval_avg_ms, stats.interval_jitter_ms, stats.interval_max_ms,
+    stats.latency_avg_ms, stats.latency_max_ms
+  );
+}
+
+const char *frame_present_mode_name(FramePresentMode mode)
+{
+  switch (mode) {
+    case FRAME_PRESENT_VSYNC:    return "vsync";
+    case FRAME_PRESENT_ADAPTIVE: return "adaptive";
+    case FRAME_PRESENT_UNCAPPED: return "uncapped";
+  }
+  return "unknown";
+}
+
+bool frame_present_mode_parse(const char *name, FramePresentMode *mode)
+{
+  static const FramePresentMode modes[] = {
+    FRAME_PRESENT_VSYNC, FRAME_PRESENT_ADAPTIVE, FRAME_PRESENT_UNCAPPED
+  };
+
+  for (uint32_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+    if (strcmp(name, frame_present_mode_name(modes[i])) == 0) {
+      *mode = modes[i];
+      return true;
+    }
+  }
+  return false;
+}
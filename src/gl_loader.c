@@ -0,0 +1,148 @@
+#include <gl_loader.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static void gl_loader_worker(void *user)
+{
+  GlLoaderWorker *worker = user;
+  GlLoader *loader = worker->loader;
+  glfwMakeContextCurrent(worker->context);
+
+  for (;;) {
+    mutex_lock(&loader->mutex);
+    while (loader->head == NULL && !loader->quit) cond_wait(&loader->cond, &loader->mutex);
+    if (loader->quit) {
+      mutex_unlock(&loader->mutex);
+      break;
+    }
+
+    GlLoadJob *job = loader->head;
+    loader->head = job->next;
+    if (loader->head == NULL) loader->tail = NULL;
+    job->state = GL_LOAD_RUNNING;
+    mutex_unlock(&loader->mutex);
+
+    bool ok = job->fn(job->user);
+
+    // The flush makes sure the fence reaches the server before another context waits on it
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    mutex_lock(&loader->mutex);
+    job->ok = ok;
+    job->fence = fence;
+    job->state = GL_LOAD_DONE;
+    cond_broadcast(&loader->cond);
+    mutex_unlock(&loader->mutex);
+
+    // Wakes an event driven main loop sleeping in glfwWaitEvents
+    glfwPostEmptyEvent();
+  }
+
+  glfwMakeContextCurrent(NULL);
+}
+
+bool gl_loader_create(GlLoader *loader, GLFWwindow *share, uint32_t thread_count)
+{
+  memset(loader, 0, sizeof(*loader));
+  if (thread_count == 0) thread_count = 1;
+  if (thread_count > GL_LOADER_MAX_THREADS) thread_count = GL_LOADER_MAX_THREADS;
+
+  mutex_init(&loader->mutex);
+  cond_init(&loader->cond);
+
+  // Context hints set for the main window still apply, only hide these ones
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  for (uint32_t i = 0; i < thread_count; i++) {
+    GlLoaderWorker *worker = &loader->workers[i];
+    worker->loader = loader;
+    worker->context = glfwCreateWindow(1, 1, "loader", NULL, share);
+    if (worker->context == NULL) break;
+
+    if (!thread_create(&worker->thread, gl_loader_worker, worker)) {
+      glfwDestroyWindow(worker->context);
+      break;
+    }
+    loader->worker_count++;
+  }
+  glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+  if (loader->worker_count == 0) {
+    fprintf(stderr, "[ERROR]: Could not create any shared loader context\n");
+    gl_loader_destroy(loader);
+    return false;
+  }
+
+  if (loader->worker_count < thread_count)
+    fprintf(stderr, "[WARNING]: Only %u of %u loader threads created\n", loader->worker_count, thread_count);
+  return true;
+}
+
+void gl_loader_destroy(GlLoader *loader)
+{
+  mutex_lock(&loader->mutex);
+  loader->quit = true;
+  cond_broadcast(&loader->cond);
+  mutex_unlock(&loader->mutex);
+
+  for (uint32_t i = 0; i < loader->worker_count; i++) {
+    thread_join(&loader->workers[i].thread);
+    glfwDestroyWindow(loader->workers[i].context);
+  }
+
+  cond_destroy(&loader->cond);
+  mutex_destroy(&loader->mutex);
+  memset(loader, 0, sizeof(*loader));
+}
+
+void gl_loader_submit(GlLoader *loader, GlLoadJob *job, GlLoadFn fn, void *user)
+{
+  job->fn = fn;
+  job->user = user;
+  job->next = NULL;
+  job->fence = NULL;
+  job->ok = false;
+
+  mutex_lock(&loader->mutex);
+  job->state = GL_LOAD_QUEUED;
+  if (loader->tail != NULL) loader->tail->next = job;
+  else loader->head = job;
+  loader->tail = job;
+  cond_broadcast(&loader->cond);
+  mutex_unlock(&loader->mutex);
+}
+
+static void gl_load_publish(GlLoadJob *job)
+{
+  if (job->fence != NULL) {
+    // Server side wait, the render context queues behind the upload without stalling the CPU
+    glWaitSync((GLsync)job->fence, 0, GL_TIMEOUT_IGNORED);
+    glDeleteSync((GLsync)job->fence);
+    job->fence = NULL;
+  }
+  job->state = GL_LOAD_PUBLISHED;
+}
+
+bool gl_load_poll(GlLoader *loader, GlLoadJob *job)
+{
+  mutex_lock(&loader->mutex);
+  GlLoadState state = job->state;
+  mutex_unlock(&loader->mutex);
+
+  if (state == GL_LOAD_DONE) gl_load_publish(job);
+  return state >= GL_LOAD_DONE;
+}
+
+void gl_load_wait(GlLoader *loader, GlLoadJob *job)
+{
+  mutex_lock(&loader->mutex);
+  while (job->state == GL_LOAD_QUEUED || job->state == GL_LOAD_RUNNING)
+    cond_wait(&loader->cond, &loader->mutex);
+  GlLoadState state = job->state;
+  mutex_unlock(&loader->mutex);
+
+  if (state == GL_LOAD_DONE) gl_load_publish(job);
+}
@@ -0,0 +1,73 @@
+#include <gl_shader.h>
+#include <glad/glad.h>
+
+#include <stdio.h>
+
+static bool shader_ok(uint32_t shader)
+{
+  int32_t status = 0;
+  char diagnostic[512] = {0};
+
+  if (glIsProgram(shader)) {
+    glGetProgramiv(shader, GL_LINK_STATUS, &status);
+    glGetProgramInfoLog(shader, 512, NULL, diagnostic);
+  } else {
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    glGetShaderInfoLog(shader, 512, NULL, diagnostic);
+  }
+
+  if (status == 0) {
+    fprintf(
+      stderr, "[ERROR]: %s =>\n\t%s\n",
+      glIsProgram(shader) ? 
+        "Program linking failed" :
+        "Shader compilation failed",
+      diagnostic
+    );
+
+    return false;
+  }
+
+  return true;
+}
+
+bool gl_shader_program(uint32_t *program, const char *vertex_src, const char *fragment_src)
+{
+  uint32_t vert = glCreateShader(GL_VERTEX_SHADER);
+  glShaderSource(vert, 1, &vertex_src, NULL);
+  glCompileShader(vert);
+  if (!shader_ok(vert)) return false;
+
+  uint32_t frag = glCreateShader(GL_FRAGMENT_SHADER);
+  glShaderSource(frag, 1, &fragment_src, NULL);
+  glCompileShader(frag);
+  if (!shader_ok(frag)) return false;
+
+  *program = glCreateProgram();
+  glAttachShader(*program, vert);
+  glAttachShader(*program, frag);
+  glLinkProgram(*program);
+  if (!shader_ok(*program)) return false;
+
+  glDeleteShader(vert);
+  glDeleteShader(frag);
+
+  return true;
+}
+
+bool gl_shader_compute(uint32_t *program, const char *compute_src)
+{
+  uint32_t comp = glCreateShader(GL_COMPUTE_SHADER);
+  glShaderSource(comp, 1, &compute_src, NULL);
+  glCompileShader(comp);
+  if (!shader_ok(comp)) return false;
+
+  *program = glCreateProgram();
+  glAttachShader(*program, comp);
+  glLinkProgram(*program);
+  if (!shader_ok(*program)) return false;
+
+  glDeleteShader(comp);
+
+  return true;
+}
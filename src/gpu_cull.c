@@ -0,0 +1,323 @@
+#include <gpu_cull.h>
+#include <gl_shader.h>
+#include <cull.h>
+#include <glad/glad.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define GPU_CULL_GROUP_SIZE    64
+#define GPU_PYRAMID_GROUP_SIZE 8
+
+// Uniform locations, fixed in the shaders below
+#define CULL_U_INSTANCE_COUNT   0
+#define CULL_U_VIEW_PROJECTION  1
+#define CULL_U_CAMERA           2
+#define CULL_U_PIXELS_PER_UNIT  3
+#define CULL_U_MAX_PIXEL_ERROR  4
+#define CULL_U_OCCLUSION        5
+#define CULL_U_PYRAMID_SIZE     6
+#define CULL_U_PYRAMID_LEVELS   7
+#define CULL_U_LOD_COUNT        8
+#define CULL_U_PLANES           16  // 6 locations
+#define CULL_U_LOD_FIRST        24  // MESH_MAX_LODS locations each
+#define CULL_U_LOD_INDICES      32
+#define CULL_U_LOD_ERROR        40
+
+#define PYRAMID_U_COPY          0
+#define PYRAMID_U_SRC_LEVEL     1
+
+static const char *cull_compute_src =
+  "#version 460 core\n"
+  "layout (local_size_x = 64) in;\n"
+  "struct Instance { vec4 sphere; vec4 color_scale; };\n"
+  "struct Command { uint count; uint instance_count; uint first_index; int base_vertex; uint base_instance; };\n"
+  "layout (std430, binding = 0) readonly buffer Instances { Instance instances[]; };\n"
+  "layout (std430, binding = 1) writeonly buffer Commands { Command commands[]; };\n"
+  "layout (binding = 0, offset = 0) uniform atomic_uint draw_count;\n"
+  "layout (binding = 0, offset = 4) uniform atomic_uint triangle_count;\n"
+  "layout (binding = 0) uniform sampler2D uPyramid;\n"
+  "layout (location = 0) uniform uint uInstanceCount;\n"
+  "layout (location = 1) uniform mat4 uViewProjection;\n"
+  "layout (location = 2) uniform vec3 uCamera;\n"
+  "layout (location = 3) uniform float uPixelsPerUnit;\n"
+  "layout (location = 4) uniform float uMaxPixelError;\n"
+  "layout (location = 5) uniform bool uOcclusion;\n"
+  "layout (location = 6) uniform ivec2 uPyramidSize;\n"
+  "layout (location = 7) uniform int uPyramidLevels;\n"
+  "layout (location = 8) uniform uint uLodCount;\n"
+  "layout (location = 16) uniform vec4 uPlanes[6];\n"
+  "layout (location = 24) uniform uint uLodFirst[8];\n"
+  "layout (location = 32) uniform uint uLodIndices[8];\n"
+  "layout (location = 40) uniform float uLodError[8];\n"
+  "\n"
+  "bool occluded(vec3 center, float radius) {\n"
+  "  vec2 lo = vec2(1.0f), hi = vec2(0.0f);\n"
+  "  float nearest = 1.0f;\n"
+  "  for (int i = 0; i < 8; i++) {\n"
+  "    vec3 corner = center + radius * vec3((i & 1) != 0 ? 1.0f : -1.0f, (i & 2) != 0 ? 1.0f : -1.0f, (i & 4) != 0 ? 1.0f : -1.0f);\n"
+  "    vec4 clip = uViewProjection * vec4(corner, 1.0f);\n"
+  "    if (clip.w <= 0.0f) return false;\n"  // Crosses the camera plane
+  "    vec3 ndc = clip.xyz / clip.w;\n"
+  "    lo = min(lo, ndc.xy * 0.5f + 0.5f);\n"
+  "    hi = max(hi, ndc.xy * 0.5f + 0.5f);\n"
+  "    nearest = min(nearest, ndc.z * 0.5f + 0.5f);\n"
+  "  }\n"
+  "  vec2 p0 = clamp(lo, 0.0f, 1.0f) * vec2(uPyramidSize);\n"
+  "  vec2 p1 = clamp(hi, 0.0f, 1.0f) * vec2(uPyramidSize);\n"
+  "  float extent = max(max(p1.x - p0.x, p1.y - p0.y), 1.0f);\n"
+  "  int level = min(int(ceil(log2(extent))), uPyramidLevels - 1);\n"
+  // At this level the rect spans at most 2x2 texels
+  "  ivec2 size = textureSize(uPyramid, level);\n"
+  "  ivec2 t0 = min(ivec2(p0) >> level, size - 1);\n"
+  "  ivec2 t1 = min(ivec2(p1) >> level, size - 1);\n"
+  "  float farthest = 0.0f;\n"
+  "  for (int y = t0.y; y <= t1.y; y++)\n"
+  "    for (int x = t0.x; x <= t1.x; x++)\n"
+  "      farthest = max(farthest, texelFetch(uPyramid, ivec2(x, y), level).r);\n"
+  "  return nearest > farthest;\n"
+  "}\n"
+  "\n"
+  "void main(void) {\n"
+  "  uint id = gl_GlobalInvocationID.x;\n"
+  "  if (id >= uInstanceCount) return;\n"
+  "  vec4 sphere = instances[id].sphere;\n"
+  "  for (int i = 0; i < 6; i++)\n"
+  "    if (dot(uPlanes[i].xyz, sphere.xyz) + uPlanes[i].w < -sphere.w) return;\n"
+  "  if (uOcclusion && occluded(sphere.xyz, sphere.w)) return;\n"
+  "  uint lod = 0u;\n"
+  "  float distance = length(uCamera - sphere.xyz);\n"
+  "  if (uPixelsPerUnit > 0.0f && distance > 0.0f) {\n"
+  "    float pixels_per_error = instances[id].color_scale.w * uPixelsPerUnit / distance;\n"
+  "    for (uint i = uLodCount - 1u; i > 0u; i--) {\n"
+  "      if (uLodError[i] * pixels_per_error <= uMaxPixelError) { lod = i; break; }\n"
+  "    }\n"
+  "  }\n"
+  "  uint slot = atomicCounterIncrement(draw_count);\n"
+  "  atomicCounterAdd(triangle_count, uLodIndices[lod] / 3u);\n"
+  "  commands[slot] = Command(uLodIndices[lod], 1u, uLodFirst[lod], 0, id);\n"
+  "}\0"
+;
+
+// Level 0 copies the depth buffer, every other level keeps the max of its footprint
+static const char *pyramid_compute_src =
+  "#version 460 core\n"
+  "layout (local_size_x = 8, local_size_y = 8) in;\n"
+  "layout (binding = 0) uniform sampler2D uSrc;\n"
+  "layout (r32f, binding = 0) writeonly uniform image2D uDst;\n"
+  "layout (location = 0) uniform bool uCopy;\n"
+  "layout (location = 1) uniform int uSrcLevel;\n"
+  "void main(void) {\n"
+  "  ivec2 p = ivec2(gl_GlobalInvocationID.xy);\n"
+  "  ivec2 size = imageSize(uDst);\n"
+  "  if (any(greaterThanEqual(p, size))) return;\n"
+  "  if (uCopy) {\n"
+  "    imageStore(uDst, p, vec4(texelFetch(uSrc, p, 0).r));\n"
+  "    return;\n"
+  "  }\n"
+  "  ivec2 src_size = textureSize(uSrc, uSrcLevel);\n"
+  // Odd sources fold their last row / column into the last texel
+  "  ivec2 s = p * 2;\n"
+  "  ivec2 e = min(mix(s + 1, src_size - 1, equal(p, size - 1)), src_size - 1);\n"
+  "  float depth = 0.0f;\n"
+  "  for (int y = s.y; y <= e.y; y++)\n"
+  "    for (int x = s.x; x <= e.x; x++)\n"
+  "      depth = max(depth, texelFetch(uSrc, ivec2(x, y), uSrcLevel).r);\n"
+  "  imageStore(uDst, p, vec4(depth));\n"
+  "}\0"
+;
+
+bool gpu_cull_create(GpuCull *cull, const GpuCullInstance *instances, uint32_t instance_count)
+{
+  memset(cull, 0, sizeof(*cull));
+
+  if (!gl_shader_compute(&cull->cull_program, cull_compute_src) ||
+      !gl_shader_compute(&cull->pyramid_program, pyramid_compute_src)) {
+    gpu_cull_destroy(cull);
+    return false;
+  }
+
+  cull->instance_count = instance_count;
+
+  glCreateBuffers(1, &cull->instance_buffer);
+  glNamedBufferStorage(cull->instance_buffer, sizeof(GpuCullInstance) * instance_count, instances, 0);
+
+  glCreateBuffers(1, &cull->command_buffer);
+  glNamedBufferStorage(cull->command_buffer, sizeof(DrawElementsIndirectCommand) * instance_count, NULL, 0);
+
+  glCreateBuffers(1, &cull->counter_buffer);
+  glNamedBufferStorage(cull->counter_buffer, sizeof(GpuCullStats), NULL, GL_DYNAMIC_STORAGE_BIT);
+
+  const GLbitfield map_flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glCreateBuffers(1, &cull->stats_buffer);
+  glNamedBufferStorage(cull->stats_buffer, sizeof(GpuCullStats) * GPU_CULL_STATS_LATENCY, NULL, map_flags);
+  cull->stats_mapped = glMapNamedBufferRange(cull->stats_buffer, 0, sizeof(GpuCullStats) * GPU_CULL_STATS_LATENCY, map_flags);
+
+  if (cull->stats_mapped == NULL) {
+    fprintf(stderr, "[ERROR]: Could not map GPU cull stats buffer\n");
+    gpu_cull_destroy(cull);
+    return false;
+  }
+
+  return true;
+}
+
+void gpu_cull_destroy(GpuCull *cull)
+{
+  for (uint32_t i = 0; i < GPU_CULL_STATS_LATENCY; i++)
+    if (cull->stats_fences[i] != NULL) glDeleteSync((GLsync)cull->stats_fences[i]);
+
+  if (cull->stats_mapped != NULL) glUnmapNamedBuffer(cull->stats_buffer);
+
+  uint32_t buffers[] = {cull->instance_buffer, cull->command_buffer, cull->counter_buffer, cull->stats_buffer};
+  glDeleteBuffers(sizeof(buffers) / sizeof(buffers[0]), buffers);
+  glDeleteTextures(1, &cull->pyramid);
+
+  if (cull->cull_program != 0) glDeleteProgram(cull->cull_program);
+  if (cull->pyramid_program != 0) glDeleteProgram(cull->pyramid_program);
+
+  memset(cull, 0, sizeof(*cull));
+}
+
+bool gpu_cull_resize(GpuCull *cull, int32_t width, int32_t height)
+{
+  if (width <= 0 || height <= 0) return false;
+  if (cull->pyramid != 0 && width == cull->pyramid_width && height == cull->pyramid_height) return true;
+
+  glDeleteTextures(1, &cull->pyramid);
+
+  int32_t levels = 1;
+  for (int32_t size = width > height ? width : height; size > 1; size >>= 1) levels++;
+
+  glCreateTextures(GL_TEXTURE_2D, 1, &cull->pyramid);
+  glTextureStorage2D(cull->pyramid, levels, GL_R32F, width, height);
+  glTextureParameteri(cull->pyramid, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+  glTextureParameteri(cull->pyramid, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTextureParameteri(cull->pyramid, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTextureParameteri(cull->pyramid, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  cull->pyramid_width = width;
+  cull->pyramid_height = height;
+  cull->pyramid_levels = levels;
+  cull->pyramid_valid = false;  // Nothing to occlude with until the next build
+  return true;
+}
+
+void gpu_cull_build_pyramid(GpuCull *cull, uint32_t depth_texture)
+{
+  if (cull->pyramid == 0) return;
+
+  glUseProgram(cull->pyramid_program);
+
+  for (int32_t level = 0; level < cull->pyramid_levels; level++) {
+    int32_t width = cull->pyramid_width >> level;
+    int32_t height = cull->pyramid_height >> level;
+    if (width < 1) width = 1;
+    if (height < 1) height = 1;
+
+    glBindTextureUnit(0, level == 0 ? depth_texture : cull->pyramid);
+    glBindImageTexture(0, cull->pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    glProgramUniform1i(cull->pyramid_program, PYRAMID_U_COPY, level == 0);
+    glProgramUniform1i(cull->pyramid_program, PYRAMID_U_SRC_LEVEL, level - 1);
+
+    glDispatchCompute(
+      (width + GPU_PYRAMID_GROUP_SIZE - 1) / GPU_PYRAMID_GROUP_SIZE,
+      (height + GPU_PYRAMID_GROUP_SIZE - 1) / GPU_PYRAMID_GROUP_SIZE,
+      1
+    );
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+  }
+
+  glBindTextureUnit(0, 0);
+  cull->pyramid_valid = true;
+}
+
+// Picks up counters of an older frame once its fence passed, returns whether the slot is free
+static bool gpu_cull_poll_stats(GpuCull *cull, uint32_t slot)
+{
+  if (cull->stats_fences[slot] == NULL) return true;
+
+  GLenum status = glClientWaitSync((GLsync)cull->stats_fences[slot], 0, 0);
+  if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return false;
+
+  cull->stats = cull->stats_mapped[slot];
+  glDeleteSync((GLsync)cull->stats_fences[slot]);
+  cull->stats_fences[slot] = NULL;
+  return true;
+}
+
+void gpu_cull_dispatch(
+  GpuCull *cull, const Mesh *mesh,
+  Matrix view_projection, Vector3 camera,
+  const LodSelector *selector, bool occlusion)
+{
+  const uint32_t program = cull->cull_program;
+  const uint32_t slot = cull->stats_frame++ % GPU_CULL_STATS_LATENCY;
+  const bool slot_free = gpu_cull_poll_stats(cull, slot);
+
+  const GpuCullStats zero = {0, 0};
+  glNamedBufferSubData(cull->counter_buffer, 0, sizeof(zero), &zero);
+
+  Frustum frustum = frustum_from_matrix(view_projection);
+  glProgramUniform4fv(program, CULL_U_PLANES, 6, (const float *)frustum.planes);
+  glProgramUniformMatrix4fv(program, CULL_U_VIEW_PROJECTION, 1, GL_FALSE, MatrixToFloat(view_projection));
+  glProgramUniform3f(program, CULL_U_CAMERA, camera.x, camera.y, camera.z);
+  glProgramUniform1ui(program, CULL_U_INSTANCE_COUNT, cull->instance_count);
+
+  // pixels_per_unit 0 disables LOD selection in the shader
+  glProgramUniform1f(program, CULL_U_PIXELS_PER_UNIT, selector->enabled ? selector->pixels_per_unit : 0.0f);
+  glProgramUniform1f(program, CULL_U_MAX_PIXEL_ERROR, selector->max_pixel_error);
+
+  uint32_t lod_first[MESH_MAX_LODS], lod_indices[MESH_MAX_LODS];
+  float lod_error[MESH_MAX_LODS];
+  for (uint32_t i = 0; i < mesh->lod_count; i++) {
+    lod_first[i] = mesh->lods[i].index_offset;
+    lod_indices[i] = mesh->lods[i].index_count;
+    lod_error[i] = mesh->lods[i].error;
+  }
+  glProgramUniform1ui(program, CULL_U_LOD_COUNT, mesh->lod_count);
+  glProgramUniform1uiv(program, CULL_U_LOD_FIRST, mesh->lod_count, lod_first);
+  glProgramUniform1uiv(program, CULL_U_LOD_INDICES, mesh->lod_count, lod_indices);
+  glProgramUniform1fv(program, CULL_U_LOD_ERROR, mesh->lod_count, lod_error);
+
+  bool use_pyramid = occlusion && cull->pyramid_valid;
+  glProgramUniform1i(program, CULL_U_OCCLUSION, use_pyramid);
+  glProgramUniform2i(program, CULL_U_PYRAMID_SIZE, cull->pyramid_width, cull->pyramid_height);
+  glProgramUniform1i(program, CULL_U_PYRAMID_LEVELS, cull->pyramid_levels);
+
+  glUseProgram(program);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, cull->instance_buffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, cull->command_buffer);
+  glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, cull->counter_buffer);
+  glBindTextureUnit(0, use_pyramid ? cull->pyramid : 0);
+
+  glDispatchCompute((cull->instance_count + GPU_CULL_GROUP_SIZE - 1) / GPU_CULL_GROUP_SIZE, 1, 1);
+
+  // Commands and the count are consumed as indirect / parameter buffers and copied below
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+  if (slot_free) {
+    glCopyNamedBufferSubData(cull->counter_buffer, cull->stats_buffer, 0, slot * sizeof(GpuCullStats), sizeof(GpuCullStats));
+    cull->stats_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+
+  glBindTextureUnit(0, 0);
+}
+
+void gpu_cull_draw(const GpuCull *cull, const Mesh *mesh)
+{
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, cull->instance_buffer);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, cull->command_buffer);
+  glBindBuffer(GL_PARAMETER_BUFFER, cull->counter_buffer);
+
+  mesh_bind(mesh);
+  glMultiDrawElementsIndirectCount(GL_TRIANGLES, mesh->index_type, NULL, 0, cull->instance_count, 0);
+
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindBuffer(GL_PARAMETER_BUFFER, 0);
+}
+
+GpuCullStats gpu_cull_stats(const GpuCull *cull)
+{
+  return cull->stats;
+}
@@ -0,0 +1,344 @@
+#include <image_ops.h>
+
+#include <string.h>
+#include <math.h>
+
+#if defined(__AVX2__)
+#define IMAGE_OPS_AVX2
+#endif
+#if defined(__SSSE3__)
+#define IMAGE_OPS_SSSE3
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define IMAGE_OPS_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define IMAGE_OPS_NEON
+#endif
+
+const char *image_ops_isa(void)
+{
+#if defined(IMAGE_OPS_AVX2)
+  return "avx2";
+#elif defined(IMAGE_OPS_SSSE3)
+  return "ssse3";
+#elif defined(IMAGE_OPS_SSE2)
+  return "sse2";
+#elif defined(IMAGE_OPS_NEON)
+  return "neon";
+#else
+  return "scalar";
+#endif
+}
+
+static inline void image_swap_rows(uint8_t *a, uint8_t *b, size_t size)
+{
+  size_t i = 0;
+#if defined(IMAGE_OPS_AVX2)
+  for (; i + 32 <= size; i += 32) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+    __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+    _mm256_storeu_si256((__m256i *)(a + i), y);
+    _mm256_storeu_si256((__m256i *)(b + i), x);
+  }
+#endif
+#if defined(IMAGE_OPS_SSE2)
+  for (; i + 16 <= size; i += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+    __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+    _mm_storeu_si128((__m128i *)(a + i), y);
+    _mm_storeu_si128((__m128i *)(b + i), x);
+  }
+#elif defined(IMAGE_OPS_NEON)
+  for (; i + 16 <= size; i += 16) {
+    uint8x16_t x = vld1q_u8(a + i);
+    uint8x16_t y = vld1q_u8(b + i);
+    vst1q_u8(a + i, y);
+    vst1q_u8(b + i, x);
+  }
+#endif
+  for (; i + 8 <= size; i += 8) {
+    uint64_t x, y;
+    memcpy(&x, a + i, 8);
+    memcpy(&y, b + i, 8);
+    memcpy(a + i, &y, 8);
+    memcpy(b + i, &x, 8);
+  }
+  for (; i < size; i++) {
+    uint8_t t = a[i];
+    a[i] = b[i];
+    b[i] = t;
+  }
+}
+
+void image_flip_vertical(uint8_t *pixels, size_t stride, int32_t height)
+{
+  for (int32_t y = 0; y < height / 2; y++)
+    image_swap_rows(pixels + (size_t)y * stride, pixels + (size_t)(height - 1 - y) * stride, stride);
+}
+
+static void image_rgb_to_rgba_row(uint8_t *dst, const uint8_t *src, int32_t width)
+{
+  int32_t x = 0;
+#if defined(IMAGE_OPS_AVX2)
+  const __m256i shuffle8 = _mm256_setr_epi8(
+    0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+    0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m256i alpha8 = _mm256_set1_epi32((int)0xff000000u);
+  // Two 16 byte loads 12 bytes apart, the second one ends 28 bytes in
+  for (; x + 10 <= width; x += 8) {
+    __m128i lo = _mm_loadu_si128((const __m128i *)(src + x * 3));
+    __m128i hi = _mm_loadu_si128((const __m128i *)(src + x * 3 + 12));
+    __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    _mm256_storeu_si256((__m256i *)(dst + x * 4), _mm256_or_si256(_mm256_shuffle_epi8(in, shuffle8), alpha8));
+  }
+#endif
+#if defined(IMAGE_OPS_SSSE3)
+  const __m128i shuffle4 = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m128i alpha4 = _mm_set1_epi32((int)0xff000000u);
+  // 16 byte loads for 12 bytes of pixels, stop before reading past the row
+  for (; x + 6 <= width; x += 4) {
+    __m128i in = _mm_loadu_si128((const __m128i *)(src + x * 3));
+    _mm_storeu_si128((__m128i *)(dst + x * 4), _mm_or_si128(_mm_shuffle_epi8(in, shuffle4), alpha4));
+  }
+#elif defined(IMAGE_OPS_NEON)
+  uint8x16x4_t out;
+  out.val[3] = vdupq_n_u8(255);
+  for (; x + 16 <= width; x += 16) {
+    uint8x16x3_t in = vld3q_u8(src + x * 3);
+    out.val[0] = in.val[0];
+    out.val[1] = in.val[1];
+    out.val[2] = in.val[2];
+    vst4q_u8(dst + x * 4, out);
+  }
+#endif
+  // One 4 byte load per pixel with the alpha byte forced, the last pixel per byte to stay in the row
+  uint32_t alpha;
+  memcpy(&alpha, (const uint8_t[4]){0, 0, 0, 255}, 4);
+  for (; x + 1 < width; x++) {
+    uint32_t pixel;
+    memcpy(&pixel, src + x * 3, 4);
+    pixel |= alpha;
+    memcpy(dst + x * 4, &pixel, 4);
+  }
+  for (; x < width; x++) {
+    dst[x * 4 + 0] = src[x * 3 + 0];
+    dst[x * 4 + 1] = src[x * 3 + 1];
+    dst[x * 4 + 2] = src[x * 3 + 2];
+    dst[x * 4 + 3] = 255;
+  }
+}
+
+void image_rgb_to_rgba(uint8_t *dst, size_t dst_stride, const uint8_t *src, size_t src_stride,
+                       int32_t width, int32_t height, bool flip)
+{
+  for (int32_t y = 0; y < height; y++) {
+    int32_t out = flip ? height - 1 - y : y;
+    image_rgb_to_rgba_row(dst + (size_t)out * dst_stride, src + (size_t)y * src_stride, width);
+  }
+}
+
+void image_swap_red_blue(uint8_t *rgba, size_t count)
+{
+  size_t i = 0;
+#if defined(IMAGE_OPS_AVX2)
+  const __m256i keep8 = _mm256_set1_epi32((int)0xff00ff00u);
+  const __m256i low8 = _mm256_set1_epi32(0xff);
+  for (; i + 8 <= count; i += 8) {
+    __m256i p = _mm256_loadu_si256((const __m256i *)(rgba + i * 4));
+    __m256i swapped = _mm256_or_si256(
+      _mm256_and_si256(p, keep8),
+      _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(p, 16), low8), _mm256_slli_epi32(_mm256_and_si256(p, low8), 16)));
+    _mm256_storeu_si256((__m256i *)(rgba + i * 4), swapped);
+  }
+#endif
+#if defined(IMAGE_OPS_SSE2)
+  const __m128i keep4 = _mm_set1_epi32((int)0xff00ff00u);
+  const __m128i low4 = _mm_set1_epi32(0xff);
+  for (; i + 4 <= count; i += 4) {
+    __m128i p = _mm_loadu_si128((const __m128i *)(rgba + i * 4));
+    __m128i swapped = _mm_or_si128(
+      _mm_and_si128(p, keep4),
+      _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16), low4), _mm_slli_epi32(_mm_and_si128(p, low4), 16)));
+    _mm_storeu_si128((__m128i *)(rgba + i * 4), swapped);
+  }
+#elif defined(IMAGE_OPS_NEON)
+  for (; i + 16 <= count; i += 16) {
+    uint8x16x4_t p = vld4q_u8(rgba + i * 4);
+    uint8x16_t red = p.val[0];
+    p.val[0] = p.val[2];
+    p.val[2] = red;
+    vst4q_u8(rgba + i * 4, p);
+  }
+#endif
+  for (; i < count; i++) {
+    uint8_t red = rgba[i * 4 + 0];
+    rgba[i * 4 + 0] = rgba[i * 4 + 2];
+    rgba[i * 4 + 2] = red;
+  }
+}
+
+// c * a / 255 rounded to nearest, exact for every 8 bit pair: t = c * a + 128, (t + (t >> 8)) >> 8
+static inline uint8_t image_mul255(uint32_t c, uint32_t a)
+{
+  uint32_t t = c * a + 128;
+  return (uint8_t)((t + (t >> 8)) >> 8);
+}
+
+#if defined(IMAGE_OPS_SSE2)
+// Alpha broadcast to its pixel's words, 255 in the alpha word itself so alpha comes out unchanged
+static inline __m128i image_premultiply_words(__m128i words)
+{
+  const __m128i alpha_words = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+  const __m128i bias = _mm_set1_epi16(128);
+  __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(words, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+  alpha = _mm_or_si128(_mm_andnot_si128(alpha_words, alpha), _mm_and_si128(alpha_words, _mm_set1_epi16(255)));
+  __m128i t = _mm_add_epi16(_mm_mullo_epi16(words, alpha), bias);
+  return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+#endif
+
+#if defined(IMAGE_OPS_AVX2)
+static inline __m256i image_premultiply_words8(__m256i words)
+{
+  const __m256i alpha_words = _mm256_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1);
+  const __m256i bias = _mm256_set1_epi16(128);
+  __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(words, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+  alpha = _mm256_or_si256(_mm256_andnot_si256(alpha_words, alpha), _mm256_and_si256(alpha_words, _mm256_set1_epi16(255)));
+  __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(words, alpha), bias);
+  return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+#endif
+
+#if defined(IMAGE_OPS_NEON)
+static inline uint8x8_t image_premultiply_neon(uint8x8_t c, uint8x8_t a)
+{
+  uint16x8_t t = vmlal_u8(vdupq_n_u16(128), c, a);
+  return vshrn_n_u16(vsraq_n_u16(t, t, 8), 8);
+}
+#endif
+
+void image_premultiply_alpha(uint8_t *rgba, size_t count)
+{
+  size_t i = 0;
+#if defined(IMAGE_OPS_AVX2)
+  const __m256i zero8 = _mm256_setzero_si256();
+  for (; i + 8 <= count; i += 8) {
+    __m256i p = _mm256_loadu_si256((const __m256i *)(rgba + i * 4));
+    __m256i lo = image_premultiply_words8(_mm256_unpacklo_epi8(p, zero8));
+    __m256i hi = image_premultiply_words8(_mm256_unpackhi_epi8(p, zero8));
+    _mm256_storeu_si256((__m256i *)(rgba + i * 4), _mm256_packus_epi16(lo, hi));
+  }
+#endif
+#if defined(IMAGE_OPS_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 4 <= count; i += 4) {
+    __m128i p = _mm_loadu_si128((const __m128i *)(rgba + i * 4));
+    __m128i lo = image_premultiply_words(_mm_unpacklo_epi8(p, zero));
+    __m128i hi = image_premultiply_words(_mm_unpackhi_epi8(p, zero));
+    _mm_storeu_si128((__m128i *)(rgba + i * 4), _mm_packus_epi16(lo, hi));
+  }
+#elif defined(IMAGE_OPS_NEON)
+  for (; i + 16 <= count; i += 16) {
+    uint8x16x4_t p = vld4q_u8(rgba + i * 4);
+    for (uint32_t c = 0; c < 3; c++) {
+      p.val[c] = vcombine_u8(
+        image_premultiply_neon(vget_low_u8(p.val[c]), vget_low_u8(p.val[3])),
+        image_premultiply_neon(vget_high_u8(p.val[c]), vget_high_u8(p.val[3])));
+    }
+    vst4q_u8(rgba + i * 4, p);
+  }
+#endif
+  for (; i < count; i++) {
+    uint8_t *p = rgba + i * 4;
+    p[0] = image_mul255(p[0], p[3]);
+    p[1] = image_mul255(p[1], p[3]);
+    p[2] = image_mul255(p[2], p[3]);
+  }
+}
+
+static inline float image_srgb_decode(float c)
+{
+  return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+void image_srgb_to_linear(float *dst, const uint8_t *rgba, size_t count)
+{
+  // Color values then alpha values, built per call: cheap next to an image and nothing shared between loader threads
+  float table[512];
+  for (uint32_t i = 0; i < 256; i++) {
+    table[i] = image_srgb_decode(i / 255.0f);
+    table[256 + i] = i / 255.0f;
+  }
+
+  size_t i = 0;
+#if defined(IMAGE_OPS_AVX2)
+  const __m256i alpha_offset = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+  for (; i + 2 <= count; i += 2) {
+    __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(rgba + i * 4)));
+    _mm256_storeu_ps(dst + i * 4, _mm256_i32gather_ps(table, _mm256_add_epi32(index, alpha_offset), 4));
+  }
+#endif
+  for (; i < count; i++) {
+    const uint8_t *p = rgba + i * 4;
+    float *out = dst + i * 4;
+    out[0] = table[p[0]];
+    out[1] = table[p[1]];
+    out[2] = table[p[2]];
+    out[3] = table[256 + p[3]];
+  }
+}
+
+void image_flip_vertical_reference(uint8_t *pixels, size_t stride, int32_t height)
+{
+  for (int32_t y = 0; y < height / 2; y++) {
+    uint8_t *a = pixels + (size_t)y * stride;
+    uint8_t *b = pixels + (size_t)(height - 1 - y) * stride;
+    for (size_t i = 0; i < stride; i++) {
+      uint8_t t = a[i];
+      a[i] = b[i];
+      b[i] = t;
+    }
+  }
+}
+
+void image_rgb_to_rgba_reference(uint8_t *dst, size_t dst_stride, const uint8_t *src, size_t src_stride,
+                                 int32_t width, int32_t height, bool flip)
+{
+  for (int32_t y = 0; y < height; y++) {
+    uint8_t *out = dst + (size_t)(flip ? height - 1 - y : y) * dst_stride;
+    const uint8_t *in = src + (size_t)y * src_stride;
+    for (int32_t x = 0; x < width; x++) {
+      out[x * 4 + 0] = in[x * 3 + 0];
+      out[x * 4 + 1] = in[x * 3 + 1];
+      out[x * 4 + 2] = in[x * 3 + 2];
+      out[x * 4 + 3] = 255;
+    }
+  }
+}
+
+void image_swap_red_blue_reference(uint8_t *rgba, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    uint8_t red = rgba[i * 4 + 0];
+    rgba[i * 4 + 0] = rgba[i * 4 + 2];
+    rgba[i * 4 + 2] = red;
+  }
+}
+
+void image_premultiply_alpha_reference(uint8_t *rgba, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    uint8_t *p = rgba + i * 4;
+    for (uint32_t c = 0; c < 3; c++) p[c] = (uint8_t)((p[c] * p[3] + 127) / 255);
+  }
+}
+
+void image_srgb_to_linear_reference(float *dst, const uint8_t *rgba, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    for (uint32_t c = 0; c < 3; c++) dst[i * 4 + c] = image_srgb_decode(rgba[i * 4 + c] / 255.0f);
+    dst[i * 4 + 3] = rgba[i * 4 + 3] / 255.0f;
+  }
+}
@@ -0,0 +1,349 @@
+#include <image_write.h>
+#include <allocator.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define DEFLATE_WINDOW     32768
+#define DEFLATE_MIN_MATCH  3
+#define DEFLATE_MAX_MATCH  258
+
+static const uint16_t length_base[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t length_extra[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t distance_base[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distance_extra[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static inline uint32_t reverse_bits(uint32_t code, uint32_t length)
+{
+  uint32_t reversed = 0;
+  for (uint32_t i = 0; i < length; i++) reversed |= ((code >> i) & 1u) << (length - 1 - i);
+  return reversed;
+}
+
+void image_writer_init(ImageWriter *writer)
+{
+  memset(writer, 0, sizeof(*writer));
+
+  // Fixed literal/length code (RFC 1951 3.2.6), emitted LSB first so stored reversed
+  for (uint32_t symbol = 0; symbol < 288; symbol++) {
+    uint32_t code, length;
+    if (symbol < 144)      { code = 0x30 + symbol;          length = 8; }
+    else if (symbol < 256) { code = 0x190 + symbol - 144;   length = 9; }
+    else if (symbol < 280) { code = symbol - 256;           length = 7; }
+    else                   { code = 0xc0 + symbol - 280;    length = 8; }
+    writer->literal_codes[symbol] = (uint16_t)reverse_bits(code, length);
+    writer->literal_lengths[symbol] = (uint8_t)length;
+  }
+
+  for (uint32_t code = 0; code < 29; code++) {
+    uint32_t end = code == 28 ? 259 : length_base[code + 1];
+    for (uint32_t length = length_base[code]; length < end; length++) writer->length_symbols[length] = (uint8_t)code;
+  }
+
+  // Indexed like zlib's: distance - 1 below 256, else 256 + ((distance - 1) >> 7)
+  for (uint32_t code = 0; code < 30; code++) {
+    writer->distance_codes[code] = (uint8_t)reverse_bits(code, 5);
+    uint32_t first = distance_base[code] - 1;
+    uint32_t last = first + (1u << distance_extra[code]);
+    for (uint32_t d = first; d < last; d++) {
+      if (d < 256) writer->distance_symbols[d] = (uint8_t)code;
+      else writer->distance_symbols[256 + (d >> 7)] = (uint8_t)code;
+    }
+  }
+
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (uint32_t k = 0; k < 8; k++) crc = (crc & 1u) ? 0xedb88320u ^ (crc >> 1) : crc >> 1;
+    writer->crc_table[i] = crc;
+  }
+}
+
+void image_writer_free(ImageWriter *writer)
+{
+  mem_free(writer->rows);
+  mem_free(writer->filtered);
+  mem_free(writer->out);
+  mem_free(writer->hash);
+  memset(writer, 0, sizeof(*writer));
+}
+
+static bool image_writer_reserve(uint8_t **buffer, size_t *capacity, size_t size)
+{
+  if (size <= *capacity) return true;
+
+  uint8_t *grown = mem_realloc(*buffer, size);
+  if (grown == NULL) return false;
+  *buffer = grown;
+  *capacity = size;
+  return true;
+}
+
+// Converts RGBA row y (in output order) to packed RGB
+static inline void image_row_rgb(uint8_t *dst, const uint8_t *rgba, size_t stride, int32_t width, int32_t height, int32_t y, bool bottom_up)
+{
+  const uint8_t *src = rgba + stride * (size_t)(bottom_up ? height - 1 - y : y);
+  for (int32_t x = 0; x < width; x++) {
+    dst[x * 3 + 0] = src[x * 4 + 0];
+    dst[x * 3 + 1] = src[x * 4 + 1];
+    dst[x * 3 + 2] = src[x * 4 + 2];
+  }
+}
+
+bool image_write_ppm(ImageWriter *writer, const char *path, int32_t width, int32_t height, const uint8_t *rgba, size_t stride, bool bottom_up)
+{
+  size_t row_size = (size_t)width * 3;
+  if (!image_writer_reserve(&writer->rows, &writer->rows_capacity, row_size * 2)) return false;
+
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "[ERROR]: Could not open \"%s\" for writing\n", path);
+    return false;
+  }
+
+  bool ok = fprintf(file, "P6\n%d %d\n255\n", width, height) > 0;
+  for (int32_t y = 0; ok && y < height; y++) {
+    image_row_rgb(writer->rows, rgba, stride, width, height, y, bottom_up);
+    ok = fwrite(writer->rows, 1, row_size, file) == row_size;
+  }
+
+  if (fclose(file) != 0) ok = false;
+  if (!ok) fprintf(stderr, "[ERROR]: Writing \"%s\" failed\n", path);
+  return ok;
+}
+
+typedef struct {
+  uint8_t *out;
+  size_t size;
+  uint64_t bits;
+  uint32_t count;
+} BitWriter;
+
+static inline void bits_put(BitWriter *bw, uint32_t value, uint32_t length)
+{
+  bw->bits |= (uint64_t)value << bw->count;
+  bw->count += length;
+  while (bw->count >= 8) {
+    bw->out[bw->size++] = (uint8_t)bw->bits;
+    bw->bits >>= 8;
+    bw->count -= 8;
+  }
+}
+
+static inline void bits_flush(BitWriter *bw)
+{
+  if (bw->count > 0) bits_put(bw, 0, 8 - bw->count);
+}
+
+static inline void deflate_literal(const ImageWriter *writer, BitWriter *bw, uint32_t symbol)
+{
+  bits_put(bw, writer->literal_codes[symbol], writer->literal_lengths[symbol]);
+}
+
+static inline void deflate_match(const ImageWriter *writer, BitWriter *bw, uint32_t length, uint32_t distance)
+{
+  uint32_t code = writer->length_symbols[length];
+  deflate_literal(writer, bw, 257 + code);
+  if (length_extra[code] > 0) bits_put(bw, length - length_base[code], length_extra[code]);
+
+  uint32_t d = distance - 1;
+  uint32_t dcode = d < 256 ? writer->distance_symbols[d] : writer->distance_symbols[256 + (d >> 7)];
+  bits_put(bw, writer->distance_codes[dcode], 5);
+  if (distance_extra[dcode] > 0) bits_put(bw, distance - distance_base[dcode], distance_extra[dcode]);
+}
+
+static inline uint32_t deflate_hash(const uint8_t *p)
+{
+  uint32_t v = (uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2];
+  return (v * 2654435761u) >> (32 - IMAGE_WRITE_HASH_BITS);
+}
+
+// Zlib stream of a single fixed Huffman block, returns its size or 0
+static size_t image_deflate(ImageWriter *writer, const uint8_t *data, size_t size)
+{
+  // Fixed codes never take more than 9 bits per byte
+  size_t bound = size + size / 8 + 64;
+  if (!image_writer_reserve(&writer->out, &writer->out_capacity, bound)) return 0;
+  if (writer->hash == NULL) {
+    writer->hash = mem_alloc(sizeof(int32_t) << IMAGE_WRITE_HASH_BITS);
+    if (writer->hash == NULL) return 0;
+  }
+  memset(writer->hash, 0xff, sizeof(int32_t) << IMAGE_WRITE_HASH_BITS);
+
+  BitWriter bw = {writer->out, 0, 0, 0};
+  bw.out[bw.size++] = 0x78;  // Deflate, 32K window
+  bw.out[bw.size++] = 0x01;  // Fastest compression, no dictionary
+  bits_put(&bw, 1, 1);       // Final block
+  bits_put(&bw, 1, 2);       // Fixed Huffman codes
+
+  size_t i = 0;
+  while (i < size) {
+    uint32_t best = 0;
+    size_t candidate = 0;
+
+    if (i + DEFLATE_MIN_MATCH <= size) {
+      uint32_t h = deflate_hash(data + i);
+      int32_t previous = writer->hash[h];
+      writer->hash[h] = (int32_t)i;
+
+      if (previous >= 0 && i - (size_t)previous <= DEFLATE_WINDOW) {
+        candidate = (size_t)previous;
+        size_t limit = size - i < DEFLATE_MAX_MATCH ? size - i : DEFLATE_MAX_MATCH;
+        while (best < limit && data[candidate + best] == data[i + best]) best++;
+      }
+    }
+
+    if (best < DEFLATE_MIN_MATCH) {
+      deflate_literal(writer, &bw, data[i]);
+      i++;
+      continue;
+    }
+
+    deflate_match(writer, &bw, best, (uint32_t)(i - candidate));
+
+    // Later matches may start inside this one
+    size_t end = i + best;
+    for (i++; i < end; i++)
+      if (i + DEFLATE_MIN_MATCH <= size) writer->hash[deflate_hash(data + i)] = (int32_t)i;
+  }
+
+  deflate_literal(writer, &bw, 256);
+  bits_flush(&bw);
+
+  uint32_t a = 1, b = 0;
+  for (size_t k = 0; k < size;) {
+    // Largest run before the sums may overflow
+    size_t run = size - k < 5552 ? size - k : 5552;
+    for (size_t end = k + run; k < end; k++) {
+      a += data[k];
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  uint32_t adler = b << 16 | a;
+  bw.out[bw.size++] = (uint8_t)(adler >> 24);
+  bw.out[bw.size++] = (uint8_t)(adler >> 16);
+  bw.out[bw.size++] = (uint8_t)(adler >> 8);
+  bw.out[bw.size++] = (uint8_t)adler;
+  return bw.size;
+}
+
+static inline void put_be32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static uint32_t png_crc(const ImageWriter *writer, uint32_t crc, const uint8_t *data, size_t size)
+{
+  for (size_t i = 0; i < size; i++) crc = writer->crc_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+  return crc;
+}
+
+static bool png_chunk(const ImageWriter *writer, FILE *file, const char *type, const uint8_t *data, size_t size)
+{
+  uint8_t header[8];
+  put_be32(header, (uint32_t)size);
+  memcpy(header + 4, type, 4);
+
+  uint32_t crc = png_crc(writer, 0xffffffffu, header + 4, 4);
+  crc = png_crc(writer, crc, data, size) ^ 0xffffffffu;
+  uint8_t footer[4];
+  put_be32(footer, crc);
+
+  return fwrite(header, 1, 8, file) == 8 &&
+         (size == 0 || fwrite(data, 1, size, file) == size) &&
+         fwrite(footer, 1, 4, file) == 4;
+}
+
+static inline uint32_t filter_cost(const uint8_t *row, size_t size)
+{
+  uint32_t cost = 0;
+  for (size_t i = 0; i < size; i++) cost += row[i] < 128 ? row[i] : 256 - row[i];
+  return cost;
+}
+
+bool image_write_png(ImageWriter *writer, const char *path, int32_t width, int32_t height, const uint8_t *rgba, size_t stride, bool bottom_up)
+{
+  size_t row_size = (size_t)width * 3;
+  size_t filtered_size = (row_size + 1) * (size_t)height;
+  if (!image_writer_reserve(&writer->rows, &writer->rows_capacity, row_size * 2) ||
+      !image_writer_reserve(&writer->filtered, &writer->filtered_capacity, filtered_size)) {
+    fprintf(stderr, "[ERROR]: Out of memory encoding \"%s\"\n", path);
+    return false;
+  }
+
+  // Per row, the cheaper of Sub and Up by the usual sum of absolute differences
+  uint8_t *current = writer->rows;
+  uint8_t *previous = writer->rows + row_size;
+  for (int32_t y = 0; y < height; y++) {
+    image_row_rgb(current, rgba, stride, width, height, y, bottom_up);
+    uint8_t *sub = writer->filtered + (row_size + 1) * (size_t)y;
+
+    sub[0] = 1;
+    for (size_t i = 0; i < row_size; i++) sub[1 + i] = (uint8_t)(current[i] - (i >= 3 ? current[i - 3] : 0));
+
+    if (y > 0) {
+      uint32_t sub_cost = filter_cost(sub + 1, row_size);
+      uint32_t up_cost = 0;
+      for (size_t i = 0; i < row_size; i++) {
+        uint8_t d = (uint8_t)(current[i] - previous[i]);
+        up_cost += d < 128 ? d : 256 - d;
+      }
+
+      if (up_cost < sub_cost) {
+        sub[0] = 2;
+        for (size_t i = 0; i < row_size; i++) sub[1 + i] = (uint8_t)(current[i] - previous[i]);
+      }
+    }
+
+    uint8_t *swap = current;
+    current = previous;
+    previous = swap;
+  }
+
+  size_t compressed = image_deflate(writer, writer->filtered, filtered_size);
+  if (compressed == 0) {
+    fprintf(stderr, "[ERROR]: Out of memory encoding \"%s\"\n", path);
+    return false;
+  }
+
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "[ERROR]: Could not open \"%s\" for writing\n", path);
+    return false;
+  }
+
+  static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  uint8_t header[13];
+  put_be32(header, (uint32_t)width);
+  put_be32(header + 4, (uint32_t)height);
+  header[8] = 8;    // Bit depth
+  header[9] = 2;    // RGB
+  header[10] = 0;   // Deflate
+  header[11] = 0;   // Adaptive filtering
+  header[12] = 0;   // No interlace
+
+  bool ok = fwrite(signature, 1, 8, file) == 8 &&
+            png_chunk(writer, file, "IHDR", header, sizeof(header)) &&
+            png_chunk(writer, file, "IDAT", writer->out, compressed) &&
+            png_chunk(writer, file, "IEND", NULL, 0);
+
+  if (fclose(file) != 0) ok = false;
+  if (!ok) fprintf(stderr, "[ERROR]: Writing \"%s\" failed\n", path);
+  return ok;
+}
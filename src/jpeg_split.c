@@ -0,0 +1,195 @@
+#include <jpeg_split.h>
+
+#include <string.h>
+
+#include <allocator.h>
+
+#define JPEG_MARKER_SOF0 0xc0
+#define JPEG_MARKER_SOF1 0xc1
+#define JPEG_MARKER_DHT  0xc4
+#define JPEG_MARKER_DAC  0xcc
+#define JPEG_MARKER_RST0 0xd0
+#define JPEG_MARKER_RST7 0xd7
+#define JPEG_MARKER_SOI  0xd8
+#define JPEG_MARKER_EOI  0xd9
+#define JPEG_MARKER_SOS  0xda
+#define JPEG_MARKER_DRI  0xdd
+
+static inline uint32_t jpeg_u16(const uint8_t *p)
+{
+  return ((uint32_t)p[0] << 8) | p[1];
+}
+
+static inline bool jpeg_restart(uint8_t marker)
+{
+  return marker >= JPEG_MARKER_RST0 && marker <= JPEG_MARKER_RST7;
+}
+
+// Huffman coded frames other than baseline and extended sequential are progressive, lossless or arithmetic
+static inline bool jpeg_other_frame(uint8_t marker)
+{
+  return marker >= 0xc2 && marker <= 0xcf && marker != JPEG_MARKER_DHT && marker != JPEG_MARKER_DAC;
+}
+
+// Walks the segments up to the first scan, false if the frame or scan can't be split
+static bool jpeg_split_headers(JpegSplit *split, uint32_t *restart_interval, uint32_t *mcus_per_row)
+{
+  const uint8_t *file = split->file;
+  size_t size = split->size;
+  uint32_t h_max = 1, v_max = 1, v_min = 4;
+  bool frame = false;
+
+  size_t pos = 2;
+  for (;;) {
+    if (pos + 4 > size || file[pos] != 0xff) return false;
+    while (pos + 4 < size && file[pos + 1] == 0xff) pos++;
+
+    uint8_t marker = file[pos + 1];
+    pos += 2;
+    if (marker == JPEG_MARKER_SOI || jpeg_restart(marker)) continue;
+    if (marker == JPEG_MARKER_EOI || jpeg_other_frame(marker)) return false;
+
+    uint32_t length = jpeg_u16(file + pos);
+    if (length < 2 || pos + length > size) return false;
+
+    if (marker == JPEG_MARKER_SOF0 || marker == JPEG_MARKER_SOF1) {
+      if (length < 8) return false;
+      split->height_offset = pos + 3;
+      split->height = (int32_t)jpeg_u16(file + pos + 3);
+      split->width = (int32_t)jpeg_u16(file + pos + 5);
+      split->components = file[pos + 7];
+      if (split->components == 0 || length < 8 + 3 * split->components) return false;
+
+      for (uint32_t c = 0; c < split->components; c++) {
+        uint32_t h = file[pos + 9 + c * 3] >> 4, v = file[pos + 9 + c * 3] & 15;
+        if (h > h_max) h_max = h;
+        if (v > v_max) v_max = v;
+        if (v < v_min) v_min = v;
+      }
+      frame = true;
+    } else if (marker == JPEG_MARKER_DRI) {
+      if (length < 4) return false;
+      *restart_interval = jpeg_u16(file + pos + 2);
+    } else if (marker == JPEG_MARKER_SOS) {
+      // One interleaved scan holding every component, or there is more than one scan to split
+      if (!frame || length < 3 || file[pos + 2] != split->components) return false;
+      split->header_size = pos + length;
+      break;
+    }
+    pos += length;
+  }
+
+  // Zero height means a DNL marker, the height comes after the scan
+  if (split->width == 0 || split->height == 0) return false;
+
+  // A single component scan is not interleaved, every 8x8 block is an MCU
+  if (split->components == 1) h_max = v_max = v_min = 1;
+  split->mcu_height = 8 * v_max;
+  split->mcu_rows = ((uint32_t)split->height + split->mcu_height - 1) / split->mcu_height;
+  split->subsampled = v_min < v_max;
+  *mcus_per_row = ((uint32_t)split->width + 8 * h_max - 1) / (8 * h_max);
+  return true;
+}
+
+bool jpeg_split_parse(JpegSplit *split, const uint8_t *file, size_t size)
+{
+  memset(split, 0, sizeof(*split));
+  split->file = file;
+  split->size = size;
+  if (size < 4 || file[0] != 0xff || file[1] != JPEG_MARKER_SOI) return false;
+
+  uint32_t restart_interval = 0, mcus_per_row = 0;
+  if (!jpeg_split_headers(split, &restart_interval, &mcus_per_row) || restart_interval == 0) return false;
+
+  split->row_offsets = mem_alloc(split->mcu_rows * sizeof(size_t));
+  if (split->row_offsets == NULL) return false;
+  memset(split->row_offsets, 0, split->mcu_rows * sizeof(size_t));
+  split->row_offsets[0] = split->header_size;
+
+  // 0xff00 is a stuffed byte, 0xffff fill, RSTn ends an interval, anything else ends the scan
+  uint64_t interval = 0;
+  const uint8_t *end = file + size;
+  const uint8_t *p = file + split->header_size;
+  while ((p = memchr(p, 0xff, (size_t)(end - p))) != NULL && p + 1 < end) {
+    uint8_t marker = p[1];
+    if (marker == 0x00 || marker == 0xff) {
+      p += marker == 0x00 ? 2 : 1;
+      continue;
+    }
+    if (!jpeg_restart(marker)) {
+      split->entropy_end = (size_t)(p - file);
+      break;
+    }
+
+    uint64_t mcu = ++interval * restart_interval;
+    if (mcu % mcus_per_row == 0 && mcu / mcus_per_row < split->mcu_rows)
+      split->row_offsets[mcu / mcus_per_row] = (size_t)(p - file) + 2;
+    p += 2;
+  }
+
+  // Only a single scan followed by EOI, more scans would carry data for rows of every band
+  if (split->entropy_end == 0 || file[split->entropy_end + 1] != JPEG_MARKER_EOI) {
+    jpeg_split_free(split);
+    return false;
+  }
+  return true;
+}
+
+void jpeg_split_free(JpegSplit *split)
+{
+  mem_free(split->row_offsets);
+  split->row_offsets = NULL;
+}
+
+uint32_t jpeg_split_bands(const JpegSplit *split, uint32_t max_bands, uint32_t *boundaries)
+{
+  uint32_t count = 0;
+  boundaries[0] = 0;
+
+  // First row start at or after each even split, restarts every few rows keep bands close to even
+  for (uint32_t b = 1; b < max_bands; b++) {
+    uint32_t row = (uint32_t)((uint64_t)split->mcu_rows * b / max_bands);
+    if (row <= boundaries[count]) row = boundaries[count] + 1;
+    while (row < split->mcu_rows && !jpeg_split_row_start(split, row)) row++;
+    if (row >= split->mcu_rows) break;
+    boundaries[++count] = row;
+  }
+
+  boundaries[++count] = split->mcu_rows;
+  return count;
+}
+
+uint8_t *jpeg_split_band(const JpegSplit *split, uint32_t row_begin, uint32_t row_end, JpegBand *band, size_t *size)
+{
+  uint32_t decode_begin = row_begin, decode_end = row_end;
+  if (split->subsampled) {
+    if (decode_begin > 0)
+      do decode_begin--; while (!jpeg_split_row_start(split, decode_begin));
+    if (decode_end < split->mcu_rows)
+      do decode_end++; while (decode_end < split->mcu_rows && !jpeg_split_row_start(split, decode_end));
+  }
+
+  uint32_t height = (uint32_t)split->height;
+  uint32_t decode_top = decode_begin * split->mcu_height;
+  uint32_t decode_bottom = decode_end * split->mcu_height < height ? decode_end * split->mcu_height : height;
+
+  band->first_row = row_begin * split->mcu_height;
+  band->row_count = (row_end * split->mcu_height < height ? row_end * split->mcu_height : height) - band->first_row;
+  band->skip_rows = band->first_row - decode_top;
+
+  // Up to the restart marker starting the next row, which is left out
+  size_t entropy_begin = split->row_offsets[decode_begin];
+  size_t entropy_end = decode_end < split->mcu_rows ? split->row_offsets[decode_end] - 2 : split->entropy_end;
+
+  *size = split->header_size + (entropy_end - entropy_begin) + 2;
+  uint8_t *stream = mem_alloc(*size);
+  if (stream == NULL) return NULL;
+
+  memcpy(stream, split->file, split->header_size);
+  stream[split->height_offset] = (uint8_t)((decode_bottom - decode_top) >> 8);
+  stream[split->height_offset + 1] = (uint8_t)(decode_bottom - decode_top);
+  memcpy(stream + split->header_size, split->file + entropy_begin, entropy_end - entropy_begin);
+  stream[*size - 2] = 0xff;
+  stream[*size - 1] = JPEG_MARKER_EOI;
+  return stream;
+}
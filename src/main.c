@@ -4,38 +4,134 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include <gl_debug.h>
+#include <gl_shader.h>
 #include <shaders.h>
+#include <vertex_format.h>
+#include <vertex_layout.h>
+#include <mesh.h>
+#include <mesh_optimizer.h>
+#include <scene.h>
+#include <bench.h>
+#include <threading.h>
+#include <render_queue.h>
+#include <render_thread.h>
+#include <gl_loader.h>
+#include <frame_pacer.h>
+#include <damage.h>
+#include <render_target.h>
+#include <frame_graph.h>
+#include <render_scale.h>
+#include <frame_capture.h>
+#include <texture_load.h>
+#include <image_ops.h>
 
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
 #define WINDOW_TITLE "OpenGL Template"
 
+#define BENCH_DEFAULT_FRAMES 600
+#define BENCH_GRID_SIZE 64
+#define BENCH_DEFAULT_BUDGET_MS 16.67
+
+#define PACING_DEFAULT_FRAMES_AHEAD 2
+
+// Idle mode still wakes up this often, to poll background loads
+#define IDLE_WAIT_TIMEOUT 0.5
+
+typedef struct {
+  const char *mesh_path;
+  const char *texture_path;
+  bool bench;
+  uint32_t bench_frames;
+  double bench_budget_ms;       // GPU frame budget of the dynamic resolution run
+  RenderUpscale bench_upscale;
+  FramePresentMode present_mode;
+  double target_fps;
+  uint32_t frames_ahead;
+  bool idle;            // Event driven, redraw only damaged frames
+  bool partial;         // Redraw only the damaged rects (through an offscreen target)
+  int32_t width;
+  int32_t height;
+  bool hidden;          // Headless runs, the window is never shown
+  const char *capture_prefix;   // Every drawn frame is written out when set
+  FrameCaptureFormat capture_format;
+} Options;
+
 typedef struct {
   GLFWwindow *window;
-  uint32_t vao;
-  uint32_t vbo;
+  VertexLayout layout;
+  Mesh mesh;
   uint32_t shader;
+  RenderQueue queue;
+  FramePacer pacer;
+
+  // Resizes are only recorded by the callback and applied once per frame
+  RenderResize resize;
+  RenderTexturePool textures;
+
+  // Idle mode, the offscreen copy keeps undamaged pixels across swaps
+  DamageTracker damage;
+  RenderTarget idle_target;
+
+  // Rebuilt every frame, the template is one pass (two with --partial)
+  FrameGraph graph;
+
+  FrameCapture capture;
+  bool capturing;
+
+  // Background .mesh load, the template triangle is drawn until it is published
+  GlLoader loader;
+  GlLoadJob mesh_job;
+  Mesh loaded_mesh;
+  const char *mesh_path;
+  bool loader_running;
+  bool mesh_loading;
+
+  // Background texture load (--texture), decoded, converted and uploaded on the loader thread
+  GlLoadJob texture_job;
+  TextureLoad texture;
+  ThreadPool *texture_pool;   // Splits decoding and conversion of large images
+  bool texture_loading;
 } Context;
 
 // Forward Declarations
 
 static void glfw_error_cb(int error, const char *desc);
 static void glfw_framebuffer_size_cb(GLFWwindow *window, int width, int height);
+static void glfw_window_refresh_cb(GLFWwindow *window);
+
+static bool parse_options(Options *options, int argc, char **argv);
+static bool run_bench(GLFWwindow *window, RenderTexturePool *textures, const Options *options);
+static bool start_capture(FrameCapture *capture, const Options *options);
+static bool run_bench_threaded(GLFWwindow *window, Scene *scene, uint32_t flags, Bench *bench);
+
+static bool load_mesh_job(void *user);
+static void use_loaded_mesh(Context *ctx);
+static void report_loaded_texture(const TextureLoad *texture);
+
+static void damage_mesh(Context *ctx, const Mesh *mesh);
+static void draw_frame(Context *ctx, const RenderCommand *draw, bool partial);
 
-static inline void create_buffers(uint32_t *vao, uint32_t *vbo);
-static inline void delete_buffers(uint32_t *vao, uint32_t *vbo);
-static inline void bind_buffers(uint32_t vao, uint32_t vbo);
 static inline void unbind_buffers(void);
-static inline void setup_vertex_attrs(void);
-static inline bool create_shader(uint32_t *shader);
+static inline bool create_mesh(Mesh *mesh, const VertexLayout *layout, const float *src, size_t count);
 
 // Vertex Data
 
 #define VERTEX_COMPONENTS 7
+#define VERTEX_COUNT 3
 
-const float triangle_data[VERTEX_COMPONENTS * 3] = 
+// GPU side storage: 8 byte half position + 4 byte color = 12 bytes per vertex
+static const VertexAttribFormat vertex_attribs[] = {
+  {VERTEX_FORMAT_HALF16, 3},  // Position
+  {VERTEX_FORMAT_UNORM8, 4},  // Color
+};
+
+#define VERTEX_ATTRIBS (sizeof(vertex_attribs) / sizeof(vertex_attribs[0]))
+
+const float triangle_data[VERTEX_COMPONENTS * VERTEX_COUNT] = 
 { 
 //  X      Y     Z       R     G     B     A
   -0.5f, -0.5f, 0.0f,   1.0f, 0.0f, 0.0f, 1.0f,
@@ -45,7 +141,10 @@ const float triangle_data[VERTEX_COMPONENTS * 3] =
 
 int main(int argc, char **argv) 
 {
-  Context ctx = {NULL, 0, 0, 0};
+  Context ctx = {0};
+  Options options;
+
+  if (!parse_options(&options, argc, argv)) exit(EXIT_FAILURE);
 
   glfwSetErrorCallback(glfw_error_cb);
   if (!glfwInit()) exit(EXIT_FAILURE);
@@ -53,9 +152,10 @@ int main(int argc, char **argv)
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  if (options.hidden) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
   ctx.window = glfwCreateWindow(
-    WINDOW_WIDTH, WINDOW_HEIGHT,
+    options.width, options.height,
     WINDOW_TITLE,
     NULL, NULL
   );
@@ -74,44 +174,171 @@ int main(int argc, char **argv)
   opengl_print_info();
   opengl_debug_enable();
   
-  glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+  int framebuffer_width, framebuffer_height;
+  glfwGetFramebufferSize(ctx.window, &framebuffer_width, &framebuffer_height);
+  damage_init(&ctx.damage, framebuffer_width, framebuffer_height);
+  render_resize_init(&ctx.resize, framebuffer_width, framebuffer_height);
+  render_texture_pool_init(&ctx.textures);
+  render_target_init(&ctx.idle_target, GL_RGBA8, 0);
+  frame_graph_init(&ctx.graph);
+
+  glViewport(0, 0, framebuffer_width, framebuffer_height);
+  glfwSetWindowUserPointer(ctx.window, &ctx);
   glfwSetFramebufferSizeCallback(ctx.window, glfw_framebuffer_size_cb);
+  glfwSetWindowRefreshCallback(ctx.window, glfw_window_refresh_cb);
+
+  if (options.bench) {
+    bool ok = run_bench(ctx.window, &ctx.textures, &options);
+    render_texture_pool_destroy(&ctx.textures);
+    vertex_layout_cache_clear();
+    glfwDestroyWindow(ctx.window);
+    glfwTerminate();
+    return ok ? 0 : EXIT_FAILURE;
+  }
   
-  if (!create_shader(&ctx.shader)) {
+  if (!gl_shader_program(&ctx.shader, vertex_shader_src, fragment_shader_src)) {
     fprintf(stderr, "[ERROR]: Shader creation failed\n");
     exit(EXIT_FAILURE);
   }
   
-  create_buffers(&ctx.vao, &ctx.vbo);
-  bind_buffers(ctx.vao, ctx.vbo);
-
-  glBufferData(
-    GL_ARRAY_BUFFER, 
-    VERTEX_COMPONENTS * 3 * sizeof(float),
-    triangle_data,
-    GL_STATIC_DRAW
-  );
+  if (!vertex_layout_interleaved(&ctx.layout, vertex_attribs, VERTEX_ATTRIBS)) {
+    fprintf(stderr, "[ERROR]: Invalid vertex layout\n");
+    exit(EXIT_FAILURE);
+  }
 
-  setup_vertex_attrs();
-  unbind_buffers();
+  if (!create_mesh(&ctx.mesh, &ctx.layout, triangle_data, VERTEX_COUNT)) {
+    fprintf(stderr, "[ERROR]: Mesh creation failed\n");
+    exit(EXIT_FAILURE);
+  }
 
-  while (!glfwWindowShouldClose(ctx.window)) {
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+  if (options.mesh_path != NULL || options.texture_path != NULL)
+    ctx.loader_running = gl_loader_create(&ctx.loader, ctx.window, 1);
+
+  // Optional .mesh file (see tools/meshconv) replaces the template triangle once uploaded
+  if (options.mesh_path != NULL) {
+    ctx.mesh_path = options.mesh_path;
+
+    if (ctx.loader_running) {
+      gl_loader_submit(&ctx.loader, &ctx.mesh_job, load_mesh_job, &ctx);
+      ctx.mesh_loading = true;
+    } else if (load_mesh_job(&ctx)) {
+      use_loaded_mesh(&ctx);
+    } else {
+      fprintf(stderr, "[ERROR]: Mesh loading failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
 
-    bind_buffers(ctx.vao, ctx.vbo);
+  if (options.texture_path != NULL) {
+    ctx.texture_pool = thread_pool_create(0);
+    ctx.texture = (TextureLoad){
+      .path = options.texture_path,
+      .flags = TEXTURE_LOAD_FLIP | TEXTURE_LOAD_SRGB | TEXTURE_LOAD_MIPMAPS,
+      .pool = ctx.texture_pool
+    };
+
+    if (ctx.loader_running) {
+      gl_loader_submit(&ctx.loader, &ctx.texture_job, texture_load_job, &ctx.texture);
+      ctx.texture_loading = true;
+    } else if (texture_load_job(&ctx.texture)) {
+      report_loaded_texture(&ctx.texture);
+    } else {
+      fprintf(stderr, "[ERROR]: Texture loading failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
 
-    glUseProgram(ctx.shader);
-    glDrawArrays(GL_TRIANGLES, 0, 3);
+  if (!render_queue_init(&ctx.queue, 1)) {
+    fprintf(stderr, "[ERROR]: Render queue creation failed\n");
+    exit(EXIT_FAILURE);
+  }
 
-    unbind_buffers();
+  // The template shaders take no uniforms
+  const RenderCommand draw = {
+    .mesh = &ctx.mesh, .program = ctx.shader, .lod = 0, .u_mvp = -1, .u_color = -1
+  };
 
-    glfwSwapBuffers(ctx.window);
-    glfwPollEvents();
+  frame_pacer_init(&ctx.pacer, ctx.window, options.present_mode, options.target_fps, options.frames_ahead);
+
+  if (options.capture_prefix != NULL) {
+    if (!start_capture(&ctx.capture, &options)) exit(EXIT_FAILURE);
+    ctx.capturing = true;
+  }
+
+  double start_time = glfwGetTime();
+
+  while (!glfwWindowShouldClose(ctx.window)) {
+    if (ctx.mesh_loading && gl_load_poll(&ctx.loader, &ctx.mesh_job)) {
+      ctx.mesh_loading = false;
+      if (ctx.mesh_job.ok)
+        use_loaded_mesh(&ctx);
+      else
+        fprintf(stderr, "[ERROR]: Mesh loading failed, keeping the template triangle\n");
+    }
+
+    if (ctx.texture_loading && gl_load_poll(&ctx.loader, &ctx.texture_job)) {
+      ctx.texture_loading = false;
+      if (ctx.texture_job.ok)
+        report_loaded_texture(&ctx.texture);
+      else
+        fprintf(stderr, "[ERROR]: Texture loading failed\n");
+    }
+
+    // A burst of size events (drag resize) costs one viewport and target change
+    int32_t width, height;
+    if (render_resize_apply(&ctx.resize, &width, &height)) {
+      glViewport(0, 0, width, height);
+      damage_resize(&ctx.damage, width, height);
+    }
+
+    // Without idle mode every frame is a full redraw
+    if (!options.idle) damage_invalidate(&ctx.damage);
+
+    if (damage_pending(&ctx.damage)) {
+      frame_pacer_begin(&ctx.pacer);
+      draw_frame(&ctx, &draw, options.partial);
+      if (ctx.capturing) frame_capture_frame(&ctx.capture, ctx.damage.width, ctx.damage.height);
+      damage_clear(&ctx.damage);
+      frame_pacer_present(&ctx.pacer);
+      if (options.idle) frame_pacer_drain(&ctx.pacer);
+    }
+    render_texture_pool_frame(&ctx.textures);
+
+    if (options.idle)
+      glfwWaitEventsTimeout(IDLE_WAIT_TIMEOUT);
+    else
+      glfwPollEvents();
+    ctx.damage.wakeups++;
   }
 
+  damage_report(&ctx.damage, glfwGetTime() - start_time);
+  frame_pacer_report(&ctx.pacer);
+  render_targets_report(&ctx.textures, &ctx.resize);
+  frame_graph_report(&ctx.graph);
+  frame_pacer_destroy(&ctx.pacer);
+
+  if (ctx.capturing) {
+    frame_capture_stop(&ctx.capture);
+    frame_capture_report(&ctx.capture);
+  }
+
+  if (ctx.mesh_loading) {
+    gl_load_wait(&ctx.loader, &ctx.mesh_job);
+    if (ctx.mesh_job.ok) mesh_destroy(&ctx.loaded_mesh);
+  }
+  if (ctx.texture_loading) gl_load_wait(&ctx.loader, &ctx.texture_job);
+  if (ctx.loader_running) gl_loader_destroy(&ctx.loader);
+  if (ctx.texture_pool != NULL) thread_pool_destroy(ctx.texture_pool);
+  if (ctx.texture.texture != 0) glDeleteTextures(1, &ctx.texture.texture);
+
+  frame_graph_destroy(&ctx.graph);
+  render_target_destroy(&ctx.idle_target, &ctx.textures);
+  render_texture_pool_destroy(&ctx.textures);
+
+  render_queue_free(&ctx.queue);
   glDeleteProgram(ctx.shader);
-  delete_buffers(&ctx.vao, &ctx.vbo);
+  mesh_destroy(&ctx.mesh);
+  vertex_layout_cache_clear();
 
   glfwDestroyWindow(ctx.window);
   glfwTerminate();
@@ -123,100 +350,495 @@ static void glfw_error_cb(int error, const char *desc)
   fprintf(stderr, "[ERROR]: GLFW Error %d -> %s\n", error, desc);
 }
 
+// Called for every step of a drag resize, GL state is left to the main loop
 void glfw_framebuffer_size_cb(GLFWwindow *window, int width, int height)
 {
-  glViewport(0, 0, width, height);
+  Context *ctx = glfwGetWindowUserPointer(window);
+  if (ctx != NULL) render_resize_request(&ctx->resize, width, height);
 }
 
-static inline void create_buffers(uint32_t *vao, uint32_t *vbo)
+// The window system lost the contents (uncovered, restored...)
+static void glfw_window_refresh_cb(GLFWwindow *window)
 {
-  glGenVertexArrays(1, vao);
-  glGenBuffers(1, vbo);
+  Context *ctx = glfwGetWindowUserPointer(window);
+  if (ctx != NULL) damage_invalidate(&ctx->damage);
 }
 
-static inline void delete_buffers(uint32_t *vao, uint32_t *vbo)
+static bool parse_options(Options *options, int argc, char **argv)
 {
-  glDeleteVertexArrays(1, vao);
-  glDeleteBuffers(1, vbo);
+  options->mesh_path = NULL;
+  options->texture_path = NULL;
+  options->bench = false;
+  options->bench_frames = BENCH_DEFAULT_FRAMES;
+  options->bench_budget_ms = BENCH_DEFAULT_BUDGET_MS;
+  options->bench_upscale = RENDER_UPSCALE_BILINEAR;
+  options->present_mode = FRAME_PRESENT_VSYNC;
+  options->target_fps = 0.0;
+  options->frames_ahead = PACING_DEFAULT_FRAMES_AHEAD;
+  options->idle = false;
+  options->partial = false;
+  options->width = WINDOW_WIDTH;
+  options->height = WINDOW_HEIGHT;
+  options->hidden = false;
+  options->capture_prefix = NULL;
+  options->capture_format = FRAME_CAPTURE_PPM;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--bench") == 0) {
+      options->bench = true;
+    } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      long frames = strtol(argv[++i], NULL, 10);
+      if (frames <= 0) {
+        fprintf(stderr, "[ERROR]: Invalid frame count \"%s\"\n", argv[i]);
+        return false;
+      }
+      options->bench_frames = (uint32_t)frames;
+    } else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+      double budget = strtod(argv[++i], NULL);
+      if (budget <= 0.0) {
+        fprintf(stderr, "[ERROR]: Invalid frame budget \"%s\"\n", argv[i]);
+        return false;
+      }
+      options->bench_budget_ms = budget;
+    } else if (strcmp(argv[i], "--upscale") == 0 && i + 1 < argc) {
+      if (!render_upscale_parse(argv[++i], &options->bench_upscale)) {
+        fprintf(stderr, "[ERROR]: Invalid upscale filter \"%s\" (bilinear, sharpen)\n", argv[i]);
+        return false;
+      }
+    } else if (strcmp(argv[i], "--idle") == 0) {
+      options->idle = true;
+    } else if (strcmp(argv[i], "--partial") == 0) {
+      options->idle = true;
+      options->partial = true;
+    } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &options->width, &options->height) != 2 || options->width <= 0 || options->height <= 0) {
+        fprintf(stderr, "[ERROR]: Invalid window size \"%s\" (WxH)\n", argv[i]);
+        return false;
+      }
+    } else if (strcmp(argv[i], "--hidden") == 0) {
+      options->hidden = true;
+    } else if (strcmp(argv[i], "--texture") == 0 && i + 1 < argc) {
+      options->texture_path = argv[++i];
+    } else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+      options->capture_prefix = argv[++i];
+    } else if (strcmp(argv[i], "--capture-format") == 0 && i + 1 < argc) {
+      if (!frame_capture_format_parse(argv[++i], &options->capture_format)) {
+        fprintf(stderr, "[ERROR]: Invalid capture format \"%s\" (ppm, png)\n", argv[i]);
+        return false;
+      }
+    } else if (strcmp(argv[i], "--present") == 0 && i + 1 < argc) {
+      if (!frame_present_mode_parse(argv[++i], &options->present_mode)) {
+        fprintf(stderr, "[ERROR]: Invalid present mode \"%s\" (vsync, adaptive, uncapped)\n", argv[i]);
+        return false;
+      }
+    } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+      double fps = strtod(argv[++i], NULL);
+      if (fps < 0.0) {
+        fprintf(stderr, "[ERROR]: Invalid frame rate \"%s\"\n", argv[i]);
+        return false;
+      }
+      options->target_fps = fps;
+    } else if (strcmp(argv[i], "--frames-ahead") == 0 && i + 1 < argc) {
+      long ahead = strtol(argv[++i], NULL, 10);
+      if (ahead < 1 || ahead > FRAME_PACER_MAX_FRAMES_AHEAD) {
+        fprintf(stderr, "[ERROR]: Frames ahead must be in [1, %d]\n", FRAME_PACER_MAX_FRAMES_AHEAD);
+        return false;
+      }
+      options->frames_ahead = (uint32_t)ahead;
+    } else if (argv[i][0] == '-') {
+      fprintf(stderr, "[ERROR]: Unknown option \"%s\"\n", argv[i]);
+      fprintf(stderr,
+        "Usage: %s [--bench] [--frames N] [--budget MS] [--upscale bilinear|sharpen]\n"
+        "          [--present vsync|adaptive|uncapped] [--fps N] [--frames-ahead N]\n"
+        "          [--idle] [--partial] [--size WxH] [--hidden]\n"
+        "          [--capture PREFIX] [--capture-format ppm|png] [--texture IMAGE] [file.mesh]\n", argv[0]);
+      return false;
+    } else {
+      options->mesh_path = argv[i];
+    }
+  }
+
+  return true;
 }
 
-static inline void bind_buffers(uint32_t vao, uint32_t vbo)
+// The texture pool is only touched from the GL thread, so it ticks here
+static RenderQueueStats bench_submit_frame(void *user, const RenderFrame *frame)
 {
-  glBindVertexArray(vao);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  Scene *scene = user;
+  RenderQueueStats stats = scene_submit(scene, &frame->queue, frame->width, frame->height);
+  render_texture_pool_frame(scene->textures);
+  return stats;
 }
 
-inline void unbind_buffers(void)
+/*
+  Same camera path as the serial runs, but the main thread only polls,
+  simulates and records while a render thread submits the previous frame.
+  Draw counts and latency come back through the frame slots.
+*/
+static bool run_bench_threaded(GLFWwindow *window, Scene *scene, uint32_t flags, Bench *bench)
 {
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+  RenderThread rt;
+  if (!render_thread_start(&rt, window, thread_pool_size(scene->pool), bench_submit_frame, scene))
+    return false;
+
+  bool ok = true;
+  bool done = false;
+  double input_time = glfwGetTime();
+
+  for (uint32_t frame = 0; !done; frame++) {
+    if (glfwWindowShouldClose(window)) {
+      ok = false;
+      break;
+    }
+
+    bench_frame_begin(bench);
+
+    RenderFrame *render_frame = render_thread_acquire(&rt);
+    if (render_frame->presented) {
+      bench_count_draws(bench, render_frame->stats.draws, render_frame->stats.triangles);
+      bench_count_latency(bench, render_frame->latency_ms);
+    }
+
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    render_frame->width = width;
+    render_frame->height = height;
+    render_frame->input_time = input_time;
+
+    scene_update(scene, frame / 60.0f, width, height);
+    scene_record(scene, flags, &render_frame->queue);
+
+    render_thread_submit(&rt, render_frame);
+
+    glfwPollEvents();
+    input_time = glfwGetTime();
+
+    done = bench_frame_end(bench);
+  }
+
+  render_thread_stop(&rt);
+
+  // Frames still in flight when the loop ended
+  for (uint32_t i = 0; i < RENDER_THREAD_FRAMES; i++) {
+    const RenderFrame *render_frame = &rt.frames[i];
+    if (!render_frame->presented) continue;
+    bench_count_draws(bench, render_frame->stats.draws, render_frame->stats.triangles);
+    bench_count_latency(bench, render_frame->latency_ms);
+  }
+
+  return ok;
 }
 
-static inline void setup_vertex_attrs(void) 
+/*
+  Renders the scene for frame_count frames with GPU driven culling and LOD,
+  CPU culling (linear SIMD, then through the BVH) and LOD selection, the
+  same with a dedicated render thread, then with dynamic resolution
+  keeping the GPU time within the budget, LOD selection only, then
+  neither, and reports every run.
+  VSync is disabled so frame times reflect the actual work.
+*/
+static bool run_bench(GLFWwindow *window, RenderTexturePool *textures, const Options *options)
 {
-  glVertexAttribPointer(
-    0, 3, GL_FLOAT, GL_TRUE, 
-    VERTEX_COMPONENTS * sizeof(float),
-    (void*)0
-  );
-  glEnableVertexAttribArray(0);
+  ThreadPool *pool = thread_pool_create(0);
+  if (pool == NULL) return false;
 
-  glVertexAttribPointer(
-    1, 4, GL_FLOAT, GL_TRUE,
-    VERTEX_COMPONENTS * sizeof(float),
-    (void*)(3 * sizeof(float))
-  );
-  glEnableVertexAttribArray(1);
+  Scene scene;
+  if (!scene_create(&scene, BENCH_GRID_SIZE, pool, textures)) {
+    fprintf(stderr, "[ERROR]: Scene creation failed\n");
+    thread_pool_destroy(pool);
+    return false;
+  }
+
+  glfwSwapInterval(0);
+
+  // Serial runs only, the render thread owns the context in the threaded one
+  FrameCapture capture;
+  bool capturing = options->capture_prefix != NULL;
+  if (capturing && !start_capture(&capture, options)) {
+    scene_destroy(&scene);
+    thread_pool_destroy(pool);
+    return false;
+  }
+
+  static const struct { const char *name; uint32_t flags; bool render_thread; bool dynamic_resolution; } runs[] = {
+    {"gpu-cull+lod", SCENE_DRAW_GPU | SCENE_DRAW_LOD, false, false},
+    {"cull+lod", SCENE_DRAW_CULL | SCENE_DRAW_LOD, false, false},
+    {"cull+lod+render-thread", SCENE_DRAW_CULL | SCENE_DRAW_LOD, true, false},
+    {"cull+lod+dynres", SCENE_DRAW_CULL | SCENE_DRAW_LOD, false, true},
+    {"bvh-cull+lod", SCENE_DRAW_CULL | SCENE_DRAW_BVH | SCENE_DRAW_LOD, false, false},
+    {"lod", SCENE_DRAW_LOD, false, false},
+    {"none", 0, false, false},
+  };
+
+  bool ok = true;
+  for (size_t r = 0; ok && r < sizeof(runs) / sizeof(runs[0]); r++) {
+    Bench bench;
+    if (!bench_begin(&bench, runs[r].name, options->bench_frames)) {
+      ok = false;
+      break;
+    }
+
+    if (runs[r].render_thread) {
+      ok = run_bench_threaded(window, &scene, runs[r].flags, &bench);
+      if (ok) bench_report(&bench);
+      bench_end(&bench);
+      continue;
+    }
+
+    // A fresh controller per run, it starts at full resolution
+    RenderScale scale;
+    if (runs[r].dynamic_resolution) {
+      if (!render_scale_init(&scale, options->bench_budget_ms, options->bench_upscale)) {
+        bench_end(&bench);
+        ok = false;
+        break;
+      }
+      scene.scale = &scale;
+    }
+
+    // Same camera path for every run
+    bool done = false;
+    double input_time = glfwGetTime();
+    for (uint32_t frame = 0; !done; frame++) {
+      if (glfwWindowShouldClose(window)) {
+        ok = false;
+        break;
+      }
+
+      int width, height;
+      glfwGetFramebufferSize(window, &width, &height);
+
+      bench_frame_begin(&bench);
+
+      scene_update(&scene, frame / 60.0f, width, height);
+
+      scene_draw(&scene, runs[r].flags, &bench);
+      render_texture_pool_frame(textures);
+      if (capturing) frame_capture_frame(&capture, width, height);
+
+      glfwSwapBuffers(window);
+      bench_count_latency(&bench, (glfwGetTime() - input_time) * 1000.0);
+
+      glfwPollEvents();
+      input_time = glfwGetTime();
+
+      done = bench_frame_end(&bench);
+    }
+
+    if (ok) {
+      bench_report(&bench);
+      frame_graph_report(&scene.graph);
+    }
+    bench_end(&bench);
+
+    if (scene.scale != NULL) {
+      if (ok) render_scale_report(&scale);
+      render_scale_destroy(&scale);
+      scene.scale = NULL;
+    }
+  }
+
+  if (capturing) {
+    frame_capture_stop(&capture);
+    frame_capture_report(&capture);
+  }
+
+  scene_destroy(&scene);
+  thread_pool_destroy(pool);
+  return ok;
 }
 
-static inline bool shader_ok(uint32_t shader) 
+// PNG encoding is the bottleneck, PPM writes are bound by the disk
+static bool start_capture(FrameCapture *capture, const Options *options)
 {
-  int32_t status = 0;
-  char diagnostic[512] = {0};
+  uint32_t writers = options->capture_format == FRAME_CAPTURE_PNG ? FRAME_CAPTURE_MAX_WRITERS : 1;
+  if (!frame_capture_start(capture, options->capture_prefix, options->capture_format, writers)) {
+    fprintf(stderr, "[ERROR]: Frame capture could not start\n");
+    return false;
+  }
+  return true;
+}
 
-  if (glIsProgram(shader)) {
-    glGetProgramiv(shader, GL_LINK_STATUS, &status);
-    glGetProgramInfoLog(shader, 512, NULL, diagnostic);
-  } else {
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
-    glGetShaderInfoLog(shader, 512, NULL, diagnostic);
+// Runs on the loader thread, VAOs are not shared so only the buffers are created here
+static bool load_mesh_job(void *user)
+{
+  Context *ctx = user;
+  return mesh_load_buffers(&ctx->loaded_mesh, ctx->mesh_path);
+}
+
+// The template shaders sample nothing yet, the texture is kept for user code
+static void report_loaded_texture(const TextureLoad *texture)
+{
+  printf("[INFO]: Texture \"%s\" %dx%d: decode %.2f ms (%u band(s)), convert %.2f ms (%s), upload %.2f ms\n",
+         texture->path, texture->width, texture->height, texture->decode_ms, texture->bands,
+         texture->convert_ms, image_ops_isa(), texture->upload_ms);
+}
+
+static void use_loaded_mesh(Context *ctx)
+{
+  mesh_attach_vao(&ctx->loaded_mesh);
+
+  // Only where either mesh covers needs to be redrawn
+  damage_mesh(ctx, &ctx->mesh);
+  damage_mesh(ctx, &ctx->loaded_mesh);
+
+  mesh_destroy(&ctx->mesh);
+  ctx->mesh = ctx->loaded_mesh;
+
+  // Meshes without vertex colors fetch this constant instead
+  glVertexAttrib4f(MESH_ATTRIB_COLOR, 1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+// The template shaders output positions as is, so mesh bounds are NDC bounds
+static void damage_mesh(Context *ctx, const Mesh *mesh)
+{
+  if (mesh->bounds_min[0] >= mesh->bounds_max[0] || mesh->bounds_min[1] >= mesh->bounds_max[1]) {
+    damage_invalidate(&ctx->damage);
+    return;
+  }
+  damage_add_ndc(&ctx->damage, mesh->bounds_min[0], mesh->bounds_min[1], mesh->bounds_max[0], mesh->bounds_max[1]);
+}
+
+static void template_pass(const FrameGraph *graph, uint32_t pass, void *user)
+{
+  Context *ctx = user;
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  render_queue_execute(&ctx->queue);
+  unbind_buffers();
+}
+
+static void damaged_pass(const FrameGraph *graph, uint32_t pass, void *user)
+{
+  Context *ctx = user;
+  const DamageTracker *damage = &ctx->damage;
+
+  if (damage->full) {
+    template_pass(graph, pass, user);
+    return;
   }
 
-  if (status == 0) {
-    fprintf(
-      stderr, "[ERROR]: %s =>\n\t%s\n",
-      glIsProgram(shader) ? 
-        "Program linking failed" :
-        "Shader compilation failed",
-      diagnostic
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  glEnable(GL_SCISSOR_TEST);
+  for (uint32_t i = 0; i < damage->rect_count; i++) {
+    const DamageRect *rect = &damage->rects[i];
+    glScissor(rect->x, rect->y, rect->width, rect->height);
+    glClear(GL_COLOR_BUFFER_BIT);
+    render_queue_execute(&ctx->queue);
+  }
+  glDisable(GL_SCISSOR_TEST);
+  unbind_buffers();
+}
+
+static void present_pass(const FrameGraph *graph, uint32_t pass, void *user)
+{
+  Context *ctx = user;
+  render_target_blit(&ctx->idle_target);
+}
+
+/*
+  Full redraws are a single pass into the back buffer. Partial ones
+  redraw the damaged rects of a persistent offscreen copy under a
+  scissor, then a second pass blits it whole: the back buffer contents
+  are undefined after a swap.
+*/
+static void draw_frame(Context *ctx, const RenderCommand *draw, bool partial)
+{
+  const DamageTracker *damage = &ctx->damage;
+  if (damage->width <= 0 || damage->height <= 0) return;
+
+  render_queue_reset(&ctx->queue);
+  render_buffer_push(render_queue_buffer(&ctx->queue, 0), render_key(0, draw->program, 0, 0.0f), draw);
+  if (!render_queue_sort(&ctx->queue)) return;
+
+  FrameGraph *graph = &ctx->graph;
+  frame_graph_reset(graph);
+  uint32_t backbuffer = frame_graph_import_backbuffer(graph, damage->width, damage->height);
+
+  if (!partial) {
+    uint32_t pass = frame_graph_add_pass(graph, "template", 0, template_pass, ctx);
+    frame_graph_write(graph, pass, backbuffer, FRAME_GRAPH_ATTACHMENT);
+  } else {
+    // New attachments hold nothing worth keeping
+    if (render_target_resize(&ctx->idle_target, &ctx->textures, damage->width, damage->height))
+      damage_invalidate(&ctx->damage);
+    if (!render_target_valid(&ctx->idle_target)) return;
+
+    uint32_t copy = frame_graph_import_texture(
+      graph, "idle copy", ctx->idle_target.color, GL_RGBA8, damage->width, damage->height
     );
 
-    return false;
+    uint32_t pass = frame_graph_add_pass(graph, "damaged", 0, damaged_pass, ctx);
+    frame_graph_read(graph, pass, copy, FRAME_GRAPH_ATTACHMENT);
+    frame_graph_write(graph, pass, copy, FRAME_GRAPH_ATTACHMENT);
+
+    uint32_t present = frame_graph_add_pass(graph, "present", 0, present_pass, ctx);
+    frame_graph_read(graph, present, copy, FRAME_GRAPH_TRANSFER);
+    frame_graph_write(graph, present, backbuffer, FRAME_GRAPH_TRANSFER);
   }
 
-  return true;
+  if (!frame_graph_compile(graph) || !frame_graph_execute(graph, &ctx->textures))
+    fprintf(stderr, "[ERROR]: Frame graph execution failed\n");
 }
 
-static inline bool create_shader(uint32_t *shader) 
+inline void unbind_buffers(void)
+{
+  glBindVertexArray(0);
+}
+
+/*
+  Packs the float source data into the compact GPU formats, welds and
+  reorders it for the post-transform cache, then uploads it indexed.
+*/
+static inline bool create_mesh(Mesh *mesh, const VertexLayout *layout, const float *src, size_t count)
 {
-  uint32_t vert = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(vert, 1, &vertex_shader_src, NULL);
-  glCompileShader(vert);
-  if (!shader_ok(vert)) return false;
+  const uint32_t stride = layout->bindings[0].stride;
+  uint8_t *packed = malloc(stride * count);
+  uint32_t *indices = malloc(count * sizeof(uint32_t));
+  bool ok = false;
+
+  if (packed == NULL || indices == NULL) goto cleanup;
 
-  uint32_t frag = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(frag, 1, &fragment_shader_src, NULL);
-  glCompileShader(frag);
-  if (!shader_ok(frag)) return false;
+  const float *streams[VERTEX_LAYOUT_MAX_ATTRIBS];
+  size_t strides[VERTEX_LAYOUT_MAX_ATTRIBS];
+  size_t src_offset = 0;
 
-  *shader = glCreateProgram();
-  glAttachShader(*shader, vert);
-  glAttachShader(*shader, frag);
-  glLinkProgram(*shader);
-  if (!shader_ok(*shader)) return false;
+  for (uint32_t i = 0; i < layout->attrib_count; i++) {
+    streams[i] = src + src_offset;
+    strides[i] = VERTEX_COMPONENTS * sizeof(float);
+    src_offset += layout->attribs[i].format.components;
+  }
 
-  glDeleteShader(vert);
-  glDeleteShader(frag);
+  void *dst[1] = {packed};
+  if (!vertex_layout_pack(layout, dst, streams, strides, count)) goto cleanup;
 
-  return true;
-}
\ No newline at end of file
+  for (uint32_t i = 0; i < count; i++) indices[i] = i;
+
+  MeshStream stream = {packed, stride, stride};
+  MeshOptimizeStats stats;
+  uint32_t vertex_count = mesh_optimize(&stream, 1, count, indices, count, &stats);
+  if (vertex_count == 0) goto cleanup;
+
+  printf(
+    "[INFO]: Mesh optimized: %u -> %u vertices, ACMR %.3f -> %.3f\n",
+    stats.vertices_before, stats.vertices_after,
+    stats.acmr_before, stats.acmr_after
+  );
+
+  const void *vertices[1] = {packed};
+  ok = mesh_create(mesh, layout, vertices, vertex_count, indices, count);
+
+  for (uint32_t c = 0; ok && c < 3; c++) {
+    mesh->bounds_min[c] = mesh->bounds_max[c] = src[c];
+    for (size_t i = 1; i < count; i++) {
+      float value = src[i * VERTEX_COMPONENTS + c];
+      if (value < mesh->bounds_min[c]) mesh->bounds_min[c] = value;
+      if (value > mesh->bounds_max[c]) mesh->bounds_max[c] = value;
+    }
+  }
+
+cleanup:
+  free(packed);
+  free(indices);
+  return ok;
+}
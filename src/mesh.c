@@ -0,0 +1,172 @@
+#include <mesh.h>
+#include <mesh_file.h>
+#include <platform.h>
+#include <glad/glad.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint32_t mesh_index_type(uint32_t vertex_count)
+{
+  return vertex_count <= 0xffffu ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+uint32_t mesh_index_size(uint32_t index_type)
+{
+  switch (index_type) {
+    case GL_UNSIGNED_SHORT: return 2;
+    case GL_UNSIGNED_INT:   return 4;
+  }
+  return 0;
+}
+
+static bool mesh_upload_indices(Mesh *mesh, const uint32_t *indices, uint32_t index_count)
+{
+  mesh->index_type = mesh_index_type(mesh->vertex_count);
+  mesh->index_count = index_count;
+
+  glCreateBuffers(1, &mesh->ebo);
+
+  if (mesh->index_type == GL_UNSIGNED_INT) {
+    glNamedBufferStorage(mesh->ebo, (size_t)index_count * 4, indices, 0);
+    return true;
+  }
+
+  uint16_t *narrow = malloc((size_t)index_count * sizeof(uint16_t));
+  if (narrow == NULL) return false;
+
+  for (uint32_t i = 0; i < index_count; i++) narrow[i] = (uint16_t)indices[i];
+  glNamedBufferStorage(mesh->ebo, (size_t)index_count * 2, narrow, 0);
+
+  free(narrow);
+  return true;
+}
+
+bool mesh_create(
+  Mesh *mesh, const VertexLayout *layout,
+  const void *const *vertices, uint32_t vertex_count,
+  const uint32_t *indices, uint32_t index_count)
+{
+  MeshLodRange lod = {0, index_count, 0.0f};
+  return mesh_create_lods(mesh, layout, vertices, vertex_count, indices, index_count, &lod, 1);
+}
+
+bool mesh_create_lods(
+  Mesh *mesh, const VertexLayout *layout,
+  const void *const *vertices, uint32_t vertex_count,
+  const uint32_t *indices, uint32_t index_count,
+  const MeshLodRange *lods, uint32_t lod_count)
+{
+  memset(mesh, 0, sizeof(*mesh));
+  mesh->layout = *layout;
+  mesh->vertex_count = vertex_count;
+  mesh->vao = vertex_layout_vao(layout, &mesh->owns_vao);
+
+  glCreateBuffers(layout->binding_count, mesh->vbos);
+  for (uint32_t i = 0; i < layout->binding_count; i++) {
+    size_t size = (size_t)layout->bindings[i].stride * vertex_count;
+    glNamedBufferStorage(mesh->vbos[i], size, vertices[i], 0);
+  }
+
+  if (indices != NULL) {
+    if (lod_count > MESH_MAX_LODS) lod_count = MESH_MAX_LODS;
+    memcpy(mesh->lods, lods, lod_count * sizeof(MeshLodRange));
+    mesh->lod_count = lod_count;
+
+    if (!mesh_upload_indices(mesh, indices, index_count)) {
+      mesh_destroy(mesh);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void mesh_destroy(Mesh *mesh)
+{
+  glDeleteBuffers(mesh->layout.binding_count, mesh->vbos);
+  if (mesh->ebo != 0) glDeleteBuffers(1, &mesh->ebo);
+  if (mesh->owns_vao) glDeleteVertexArrays(1, &mesh->vao);
+  memset(mesh, 0, sizeof(*mesh));
+}
+
+bool mesh_load(Mesh *mesh, const char *path)
+{
+  if (!mesh_load_buffers(mesh, path)) return false;
+  mesh_attach_vao(mesh);
+  return true;
+}
+
+void mesh_attach_vao(Mesh *mesh)
+{
+  mesh->vao = vertex_layout_vao(&mesh->layout, &mesh->owns_vao);
+}
+
+bool mesh_load_buffers(Mesh *mesh, const char *path)
+{
+  PlatformFileMap map;
+  if (!platform_map_file(&map, path)) return false;
+
+  const MeshFileHeader *header = mesh_file_header(map.data, map.size);
+  if (header == NULL) {
+    fprintf(stderr, "[ERROR]: \"%s\" is not a valid mesh file\n", path);
+    platform_unmap_file(&map);
+    return false;
+  }
+
+  const uint8_t *file = (const uint8_t *)map.data;
+
+  memset(mesh, 0, sizeof(*mesh));
+  mesh_file_layout(header, &mesh->layout);
+  mesh->vertex_count = header->vertex_count;
+  memcpy(mesh->bounds_min, header->bounds_min, sizeof(mesh->bounds_min));
+  memcpy(mesh->bounds_max, header->bounds_max, sizeof(mesh->bounds_max));
+
+  glCreateBuffers(header->binding_count, mesh->vbos);
+  for (uint32_t i = 0; i < header->binding_count; i++) {
+    const MeshFileBinding *binding = &header->bindings[i];
+    glNamedBufferStorage(mesh->vbos[i], binding->size, file + binding->offset, 0);
+  }
+
+  if (header->index_count > 0) {
+    mesh->index_type  = header->index_size == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    mesh->index_count = header->index_count;
+    mesh->lod_count   = header->lod_count;
+    for (uint32_t i = 0; i < header->lod_count; i++) {
+      const MeshFileLod *lod = &header->lods[i];
+      mesh->lods[i] = (MeshLodRange){lod->index_offset, lod->index_count, lod->error};
+    }
+    glCreateBuffers(1, &mesh->ebo);
+    glNamedBufferStorage(mesh->ebo, header->index_size_bytes, file + header->index_offset, 0);
+  }
+
+  platform_unmap_file(&map);
+  return true;
+}
+
+void mesh_bind(const Mesh *mesh)
+{
+  for (uint32_t i = 0; i < mesh->layout.binding_count; i++)
+    vertex_layout_bind_buffer(mesh->vao, &mesh->layout, i, mesh->vbos[i], 0);
+
+  glVertexArrayElementBuffer(mesh->vao, mesh->ebo);
+  glBindVertexArray(mesh->vao);
+}
+
+void mesh_draw(const Mesh *mesh)
+{
+  if (mesh->index_type != 0)
+    mesh_draw_lod(mesh, 0);
+  else
+    glDrawArrays(GL_TRIANGLES, 0, mesh->vertex_count);
+}
+
+void mesh_draw_lod(const Mesh *mesh, uint32_t lod)
+{
+  if (lod >= mesh->lod_count) lod = mesh->lod_count - 1;
+
+  const MeshLodRange *range = &mesh->lods[lod];
+  size_t offset = (size_t)range->index_offset * mesh_index_size(mesh->index_type);
+  glDrawElements(GL_TRIANGLES, range->index_count, mesh->index_type, (void *)offset);
+}
@@ -0,0 +1,214 @@
+#include <mesh_file.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline uint64_t align_up(uint64_t value, uint64_t alignment)
+{
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static bool write_padding(FILE *file, uint64_t *cursor, uint64_t target)
+{
+  static const uint8_t zeros[256] = {0};
+
+  while (*cursor < target) {
+    uint64_t chunk = target - *cursor;
+    if (chunk > sizeof(zeros)) chunk = sizeof(zeros);
+    if (fwrite(zeros, 1, (size_t)chunk, file) != chunk) return false;
+    *cursor += chunk;
+  }
+  return true;
+}
+
+static bool write_blob(FILE *file, uint64_t *cursor, const void *data, uint64_t size)
+{
+  if (fwrite(data, 1, (size_t)size, file) != size) return false;
+  *cursor += size;
+  return true;
+}
+
+bool mesh_file_write(const char *path, const MeshFileData *data)
+{
+  const VertexLayout *layout = data->layout;
+  MeshFileHeader header;
+  memset(&header, 0, sizeof(header));
+
+  header.magic         = MESH_FILE_MAGIC;
+  header.version       = MESH_FILE_VERSION;
+  header.header_size   = sizeof(MeshFileHeader);
+  header.vertex_count  = data->vertex_count;
+  header.attrib_count  = layout->attrib_count;
+  header.binding_count = layout->binding_count;
+  memcpy(header.bounds_min, data->bounds_min, sizeof(header.bounds_min));
+  memcpy(header.bounds_max, data->bounds_max, sizeof(header.bounds_max));
+
+  for (uint32_t i = 0; i < layout->attrib_count; i++) {
+    const VertexLayoutAttrib *attrib = &layout->attribs[i];
+    header.attribs[i] = (MeshFileAttrib) {
+      (uint32_t)attrib->format.format, attrib->format.components,
+      attrib->location, attrib->binding, attrib->offset
+    };
+  }
+
+  uint64_t offset = align_up(sizeof(MeshFileHeader), MESH_FILE_ALIGNMENT);
+  for (uint32_t i = 0; i < layout->binding_count; i++) {
+    MeshFileBinding *binding = &header.bindings[i];
+    binding->stride  = layout->bindings[i].stride;
+    binding->divisor = layout->bindings[i].divisor;
+    binding->offset  = offset;
+    binding->size    = (uint64_t)binding->stride * data->vertex_count;
+    offset = align_up(offset + binding->size, MESH_FILE_ALIGNMENT);
+  }
+
+  // Narrow indices up front so the blob is GPU ready
+  void *index_blob = NULL;
+  if (data->indices != NULL && data->index_count > 0) {
+    header.index_count = data->index_count;
+    header.index_size  = data->vertex_count <= 0xffffu ? 2 : 4;
+    header.index_offset = offset;
+    header.index_size_bytes = (uint64_t)header.index_size * data->index_count;
+
+    if (data->lods != NULL && data->lod_count > 0) {
+      header.lod_count = data->lod_count > MESH_MAX_LODS ? MESH_MAX_LODS : data->lod_count;
+      for (uint32_t i = 0; i < header.lod_count; i++) {
+        const MeshLodRange *lod = &data->lods[i];
+        header.lods[i] = (MeshFileLod){lod->index_offset, lod->index_count, lod->error};
+      }
+    } else {
+      header.lod_count = 1;
+      header.lods[0] = (MeshFileLod){0, data->index_count, 0.0f};
+    }
+
+    if (header.index_size == 2) {
+      uint16_t *narrow = malloc((size_t)header.index_size_bytes);
+      if (narrow == NULL) return false;
+      for (uint32_t i = 0; i < data->index_count; i++) narrow[i] = (uint16_t)data->indices[i];
+      index_blob = narrow;
+    }
+  }
+
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "[ERROR]: Could not open \"%s\" for writing\n", path);
+    free(index_blob);
+    return false;
+  }
+
+  uint64_t cursor = 0;
+  bool ok = write_blob(file, &cursor, &header, sizeof(header));
+
+  for (uint32_t i = 0; ok && i < layout->binding_count; i++) {
+    ok = write_padding(file, &cursor, header.bindings[i].offset) &&
+         write_blob(file, &cursor, data->vertices[i], header.bindings[i].size);
+  }
+
+  if (ok && header.index_count > 0) {
+    ok = write_padding(file, &cursor, header.index_offset) &&
+         write_blob(file, &cursor, index_blob ? index_blob : data->indices, header.index_size_bytes);
+  }
+
+  if (fclose(file) != 0) ok = false;
+  free(index_blob);
+
+  if (!ok) fprintf(stderr, "[ERROR]: Failed writing mesh file \"%s\"\n", path);
+  return ok;
+}
+
+static inline bool blob_in_file(uint64_t offset, uint64_t size, size_t file_size)
+{
+  return offset <= file_size && size <= file_size - offset;
+}
+
+// Out of range indices would have the GPU fetch past the vertex buffers
+static bool indices_in_range(const MeshFileHeader *header, const uint8_t *file)
+{
+  const uint8_t *blob = file + header->index_offset;
+  uint32_t max_index = 0;
+
+  if (header->index_size == 2) {
+    for (uint32_t i = 0; i < header->index_count; i++) {
+      uint16_t index;
+      memcpy(&index, blob + (size_t)i * 2, 2);
+      if (index > max_index) max_index = index;
+    }
+  } else {
+    for (uint32_t i = 0; i < header->index_count; i++) {
+      uint32_t index;
+      memcpy(&index, blob + (size_t)i * 4, 4);
+      if (index > max_index) max_index = index;
+    }
+  }
+
+  return max_index < header->vertex_count;
+}
+
+const MeshFileHeader *mesh_file_header(const void *file, size_t size)
+{
+  if (size < sizeof(MeshFileHeader)) return NULL;
+
+  const MeshFileHeader *header = (const MeshFileHeader *)file;
+  if (header->magic != MESH_FILE_MAGIC) return NULL;
+  if (header->version != MESH_FILE_VERSION) return NULL;
+  if (header->header_size != sizeof(MeshFileHeader)) return NULL;
+  if (header->attrib_count > VERTEX_LAYOUT_MAX_ATTRIBS) return NULL;
+  if (header->binding_count > VERTEX_LAYOUT_MAX_BINDINGS) return NULL;
+
+  for (uint32_t i = 0; i < header->attrib_count; i++) {
+    const MeshFileAttrib *attrib = &header->attribs[i];
+    if (attrib->format >= VERTEX_FORMAT_COUNT) return NULL;
+    if (attrib->components == 0 || attrib->components > 4) return NULL;
+    if (attrib->binding >= header->binding_count) return NULL;
+
+    // The attribute has to fit inside its binding's vertex
+    VertexAttribFormat format = {(VertexFormat)attrib->format, attrib->components};
+    if ((uint64_t)attrib->offset + vertex_attrib_size(format) > header->bindings[attrib->binding].stride) return NULL;
+  }
+
+  for (uint32_t i = 0; i < header->binding_count; i++) {
+    const MeshFileBinding *binding = &header->bindings[i];
+    if ((uint64_t)binding->stride * header->vertex_count != binding->size) return NULL;
+    if (!blob_in_file(binding->offset, binding->size, size)) return NULL;
+  }
+
+  if (header->index_count > 0) {
+    if (header->index_size != 2 && header->index_size != 4) return NULL;
+    if ((uint64_t)header->index_size * header->index_count != header->index_size_bytes) return NULL;
+    if (!blob_in_file(header->index_offset, header->index_size_bytes, size)) return NULL;
+
+    if (header->lod_count == 0 || header->lod_count > MESH_MAX_LODS) return NULL;
+    for (uint32_t i = 0; i < header->lod_count; i++) {
+      const MeshFileLod *lod = &header->lods[i];
+      if (lod->index_offset > header->index_count) return NULL;
+      if (lod->index_count > header->index_count - lod->index_offset) return NULL;
+    }
+
+    if (!indices_in_range(header, file)) return NULL;
+  }
+
+  return header;
+}
+
+void mesh_file_layout(const MeshFileHeader *header, VertexLayout *layout)
+{
+  vertex_layout_init(layout);
+
+  for (uint32_t i = 0; i < header->attrib_count; i++) {
+    const MeshFileAttrib *src = &header->attribs[i];
+    VertexLayoutAttrib *attrib = &layout->attribs[i];
+    attrib->format.format     = (VertexFormat)src->format;
+    attrib->format.components = src->components;
+    attrib->location = src->location;
+    attrib->binding  = src->binding;
+    attrib->offset   = src->offset;
+  }
+
+  for (uint32_t i = 0; i < header->binding_count; i++) {
+    layout->bindings[i].stride  = header->bindings[i].stride;
+    layout->bindings[i].divisor = header->bindings[i].divisor;
+  }
+
+  layout->attrib_count  = header->attrib_count;
+  layout->binding_count = header->binding_count;
+}
@@ -0,0 +1,28 @@
+#include <mesh_lod.h>
+
+LodSelector lod_selector_create(Matrix projection, float viewport_height, float max_pixel_error)
+{
+  LodSelector selector;
+  selector.pixels_per_unit = projection.m5 * viewport_height * 0.5f;
+  selector.max_pixel_error = max_pixel_error;
+  selector.enabled = true;
+  return selector;
+}
+
+uint32_t lod_select(const LodSelector *selector, const Mesh *mesh, Vector3 camera, Vector3 center, float scale)
+{
+  if (!selector->enabled || mesh->lod_count <= 1) return 0;
+
+  float distance = Vector3Distance(camera, center);
+  if (distance <= EPSILON) return 0;
+
+  // Error shrinks linearly with distance under perspective
+  float pixels_per_error = scale * selector->pixels_per_unit / distance;
+
+  for (uint32_t lod = mesh->lod_count - 1; lod > 0; lod--) {
+    if (mesh->lods[lod].error * pixels_per_error <= selector->max_pixel_error)
+      return lod;
+  }
+
+  return 0;
+}
@@ -0,0 +1,628 @@
+#include <mesh_optimizer.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Welding
+
+static inline uint64_t hash_bytes(uint64_t hash, const uint8_t *data, size_t size)
+{
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+static inline uint64_t vertex_hash(const MeshStream *streams, uint32_t stream_count, uint32_t vertex)
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (uint32_t s = 0; s < stream_count; s++) {
+    const uint8_t *data = (const uint8_t *)streams[s].data + vertex * streams[s].stride;
+    hash = hash_bytes(hash, data, streams[s].size);
+  }
+  return hash;
+}
+
+static inline bool vertex_equal(const MeshStream *streams, uint32_t stream_count, uint32_t a, uint32_t b)
+{
+  for (uint32_t s = 0; s < stream_count; s++) {
+    const uint8_t *data = (const uint8_t *)streams[s].data;
+    if (memcmp(data + a * streams[s].stride, data + b * streams[s].stride, streams[s].size) != 0)
+      return false;
+  }
+  return true;
+}
+
+uint32_t mesh_weld(uint32_t *remap, const MeshStream *streams, uint32_t stream_count, uint32_t vertex_count)
+{
+  size_t capacity = 1;
+  while (capacity < (size_t)vertex_count * 2) capacity <<= 1;
+
+  // Open addressing table of first occurrences (old vertex index)
+  uint32_t *table = malloc(capacity * sizeof(uint32_t));
+  if (table == NULL) return 0;
+  memset(table, 0xff, capacity * sizeof(uint32_t));
+
+  uint32_t unique = 0;
+
+  for (uint32_t v = 0; v < vertex_count; v++) {
+    size_t slot = (size_t)vertex_hash(streams, stream_count, v) & (capacity - 1);
+
+    while (table[slot] != MESH_REMAP_UNUSED &&
+           !vertex_equal(streams, stream_count, table[slot], v))
+      slot = (slot + 1) & (capacity - 1);
+
+    if (table[slot] == MESH_REMAP_UNUSED) {
+      table[slot] = v;
+      remap[v] = unique++;
+    } else {
+      remap[v] = remap[table[slot]];
+    }
+  }
+
+  free(table);
+  return unique;
+}
+
+bool mesh_remap_stream(MeshStream *stream, uint32_t vertex_count, const uint32_t *remap)
+{
+  uint8_t *data = (uint8_t *)stream->data;
+  uint8_t *scratch = malloc((size_t)vertex_count * stream->size);
+  if (scratch == NULL) return false;
+
+  uint32_t used = 0;
+  for (uint32_t v = 0; v < vertex_count; v++) {
+    if (remap[v] == MESH_REMAP_UNUSED) continue;
+    memcpy(scratch + (size_t)remap[v] * stream->size, data + (size_t)v * stream->stride, stream->size);
+    if (remap[v] + 1 > used) used = remap[v] + 1;
+  }
+
+  for (uint32_t v = 0; v < used; v++)
+    memcpy(data + (size_t)v * stream->stride, scratch + (size_t)v * stream->size, stream->size);
+
+  free(scratch);
+  return true;
+}
+
+void mesh_remap_indices(uint32_t *indices, uint32_t index_count, const uint32_t *remap)
+{
+  for (uint32_t i = 0; i < index_count; i++) indices[i] = remap[indices[i]];
+}
+
+// Tipsify (Sander, Nehab, Barczak 2007)
+
+typedef struct {
+  uint32_t *offsets;    // vertex_count + 1 entries
+  uint32_t *triangles;  // index_count entries
+} MeshAdjacency;
+
+static bool mesh_adjacency_build(MeshAdjacency *adj, const uint32_t *indices, uint32_t index_count, uint32_t vertex_count, uint32_t *live)
+{
+  adj->offsets   = calloc(vertex_count + 1, sizeof(uint32_t));
+  adj->triangles = malloc((size_t)index_count * sizeof(uint32_t));
+  if (adj->offsets == NULL || adj->triangles == NULL) return false;
+
+  memset(live, 0, vertex_count * sizeof(uint32_t));
+  for (uint32_t i = 0; i < index_count; i++) live[indices[i]]++;
+
+  uint32_t sum = 0;
+  for (uint32_t v = 0; v < vertex_count; v++) {
+    adj->offsets[v] = sum;
+    sum += live[v];
+  }
+  adj->offsets[vertex_count] = sum;
+
+  // Fill using offsets as cursors, then shift them back
+  for (uint32_t i = 0; i < index_count; i++)
+    adj->triangles[adj->offsets[indices[i]]++] = i / 3;
+  for (uint32_t v = vertex_count; v > 0; v--)
+    adj->offsets[v] = adj->offsets[v - 1];
+  adj->offsets[0] = 0;
+
+  return true;
+}
+
+static void mesh_adjacency_free(MeshAdjacency *adj)
+{
+  free(adj->offsets);
+  free(adj->triangles);
+}
+
+bool mesh_optimize_vertex_cache(
+  uint32_t *dst, const uint32_t *indices, uint32_t index_count,
+  uint32_t vertex_count, uint32_t cache_size)
+{
+  const uint32_t triangle_count = index_count / 3;
+  if (triangle_count == 0) return true;
+
+  MeshAdjacency adj = {NULL, NULL};
+  uint32_t *live       = malloc(vertex_count * sizeof(uint32_t));
+  uint32_t *cache_time = calloc(vertex_count, sizeof(uint32_t));
+  uint32_t *dead_end   = malloc((size_t)index_count * sizeof(uint32_t));
+  uint32_t *candidates = malloc((size_t)index_count * sizeof(uint32_t));
+  bool *emitted        = calloc(triangle_count, sizeof(bool));
+  bool ok = false;
+
+  if (!live || !cache_time || !dead_end || !candidates || !emitted) goto cleanup;
+  if (!mesh_adjacency_build(&adj, indices, index_count, vertex_count, live)) goto cleanup;
+
+  // Source indices may alias dst, keep a copy
+  uint32_t *source = (uint32_t *)indices;
+  if (dst == indices) {
+    source = malloc((size_t)index_count * sizeof(uint32_t));
+    if (source == NULL) goto cleanup;
+    memcpy(source, indices, (size_t)index_count * sizeof(uint32_t));
+  }
+
+  uint32_t time = cache_size + 1;
+  uint32_t cursor = 0;
+  uint32_t dead_end_top = 0;
+  uint32_t out = 0;
+  int64_t fanning = 0;
+
+  while (fanning >= 0) {
+    uint32_t f = (uint32_t)fanning;
+    uint32_t candidate_count = 0;
+
+    for (uint32_t k = adj.offsets[f]; k < adj.offsets[f + 1]; k++) {
+      uint32_t t = adj.triangles[k];
+      if (emitted[t]) continue;
+
+      for (uint32_t c = 0; c < 3; c++) {
+        uint32_t v = source[t * 3 + c];
+        dst[out++] = v;
+        dead_end[dead_end_top++] = v;
+        candidates[candidate_count++] = v;
+        live[v]--;
+
+        if (time - cache_time[v] > cache_size) cache_time[v] = time++;
+      }
+      emitted[t] = true;
+    }
+
+    // Pick the candidate most likely to still be in cache
+    int64_t best = -1;
+    int64_t best_priority = -1;
+    for (uint32_t i = 0; i < candidate_count; i++) {
+      uint32_t v = candidates[i];
+      if (live[v] == 0) continue;
+
+      int64_t priority = 0;
+      if (time - cache_time[v] + 2 * live[v] <= cache_size) priority = time - cache_time[v];
+      if (priority > best_priority) {
+        best = v;
+        best_priority = priority;
+      }
+    }
+
+    // Dead end: most recently used vertex with live triangles, else next in input order
+    while (best < 0 && dead_end_top > 0) {
+      uint32_t v = dead_end[--dead_end_top];
+      if (live[v] > 0) best = v;
+    }
+    while (best < 0 && cursor < vertex_count) {
+      if (live[cursor] > 0) best = cursor;
+      else cursor++;
+    }
+
+    fanning = best;
+  }
+
+  if (source != indices) free(source);
+  ok = true;
+
+cleanup:
+  mesh_adjacency_free(&adj);
+  free(live);
+  free(cache_time);
+  free(dead_end);
+  free(candidates);
+  free(emitted);
+  return ok;
+}
+
+uint32_t mesh_optimize_vertex_fetch(uint32_t *remap, const uint32_t *indices, uint32_t index_count, uint32_t vertex_count)
+{
+  memset(remap, 0xff, vertex_count * sizeof(uint32_t));
+
+  uint32_t next = 0;
+  for (uint32_t i = 0; i < index_count; i++) {
+    uint32_t v = indices[i];
+    if (remap[v] == MESH_REMAP_UNUSED) remap[v] = next++;
+  }
+
+  return next;
+}
+
+float mesh_acmr(const uint32_t *indices, uint32_t index_count, uint32_t vertex_count, uint32_t cache_size)
+{
+  if (index_count < 3) return 0.0f;
+
+  uint32_t *cache_time = calloc(vertex_count, sizeof(uint32_t));
+  if (cache_time == NULL) return 0.0f;
+
+  uint32_t time = cache_size + 1;
+  uint32_t misses = 0;
+
+  for (uint32_t i = 0; i < index_count; i++) {
+    uint32_t v = indices[i];
+    if (time - cache_time[v] > cache_size) {
+      cache_time[v] = time++;
+      misses++;
+    }
+  }
+
+  free(cache_time);
+  return (float)misses / (float)(index_count / 3);
+}
+
+uint32_t mesh_optimize(
+  MeshStream *streams, uint32_t stream_count, uint32_t vertex_count,
+  uint32_t *indices, uint32_t index_count,
+  MeshOptimizeStats *stats)
+{
+  uint32_t *remap = malloc(vertex_count * sizeof(uint32_t));
+  if (remap == NULL) return 0;
+
+  if (stats) {
+    stats->vertices_before = vertex_count;
+    stats->acmr_before = mesh_acmr(indices, index_count, vertex_count, MESH_DEFAULT_CACHE_SIZE);
+  }
+
+  uint32_t unique = mesh_weld(remap, streams, stream_count, vertex_count);
+  if (unique == 0) goto fail;
+
+  mesh_remap_indices(indices, index_count, remap);
+  for (uint32_t s = 0; s < stream_count; s++)
+    if (!mesh_remap_stream(&streams[s], vertex_count, remap)) goto fail;
+  vertex_count = unique;
+
+  if (!mesh_optimize_vertex_cache(indices, indices, index_count, vertex_count, MESH_DEFAULT_CACHE_SIZE))
+    goto fail;
+
+  vertex_count = mesh_optimize_vertex_fetch(remap, indices, index_count, vertex_count);
+  mesh_remap_indices(indices, index_count, remap);
+  for (uint32_t s = 0; s < stream_count; s++)
+    if (!mesh_remap_stream(&streams[s], unique, remap)) goto fail;
+
+  if (stats) {
+    stats->vertices_after = vertex_count;
+    stats->acmr_after = mesh_acmr(indices, index_count, vertex_count, MESH_DEFAULT_CACHE_SIZE);
+  }
+
+  free(remap);
+  return vertex_count;
+
+fail:
+  free(remap);
+  return 0;
+}
+
+// Simplification (Garland & Heckbert quadric error metric, edge collapse)
+
+typedef struct {
+  double a2, b2, c2, d2, ab, ac, ad, bc, bd, cd;
+} Quadric;
+
+typedef struct {
+  uint32_t from;
+  uint32_t to;
+  double cost;
+} MeshCollapse;
+
+static inline const float *vertex_position(const float *positions, size_t stride, uint32_t v)
+{
+  return (const float *)((const uint8_t *)positions + (size_t)v * stride);
+}
+
+static inline void quadric_add_plane(Quadric *q, double a, double b, double c, double d, double w)
+{
+  q->a2 += w * a * a; q->b2 += w * b * b; q->c2 += w * c * c; q->d2 += w * d * d;
+  q->ab += w * a * b; q->ac += w * a * c; q->ad += w * a * d;
+  q->bc += w * b * c; q->bd += w * b * d; q->cd += w * c * d;
+}
+
+static inline void quadric_add(Quadric *q, const Quadric *r)
+{
+  q->a2 += r->a2; q->b2 += r->b2; q->c2 += r->c2; q->d2 += r->d2;
+  q->ab += r->ab; q->ac += r->ac; q->ad += r->ad;
+  q->bc += r->bc; q->bd += r->bd; q->cd += r->cd;
+}
+
+static inline double quadric_error(const Quadric *q, const Quadric *r, const float *p)
+{
+  Quadric s = *q;
+  quadric_add(&s, r);
+
+  double x = p[0], y = p[1], z = p[2];
+  double e =
+    s.a2 * x * x + s.b2 * y * y + s.c2 * z * z +
+    2.0 * (s.ab * x * y + s.ac * x * z + s.bc * y * z) +
+    2.0 * (s.ad * x + s.bd * y + s.cd * z) + s.d2;
+
+  return e < 0.0 ? 0.0 : e;
+}
+
+static inline void triangle_normal(const float *p0, const float *p1, const float *p2, double n[3])
+{
+  double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+  double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+  n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+  n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+  n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+// Open addressing set of directed edges, used to find boundaries
+static inline uint64_t edge_key(uint32_t a, uint32_t b)
+{
+  return ((uint64_t)a << 32) | b;
+}
+
+static inline size_t edge_slot(uint64_t key, size_t mask)
+{
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdull;
+  key ^= key >> 33;
+  return (size_t)key & mask;
+}
+
+static bool edge_set_contains(const uint64_t *set, size_t mask, uint64_t key)
+{
+  for (size_t slot = edge_slot(key, mask); set[slot] != UINT64_MAX; slot = (slot + 1) & mask)
+    if (set[slot] == key) return true;
+  return false;
+}
+
+static void edge_set_insert(uint64_t *set, size_t mask, uint64_t key)
+{
+  size_t slot = edge_slot(key, mask);
+  while (set[slot] != UINT64_MAX && set[slot] != key) slot = (slot + 1) & mask;
+  set[slot] = key;
+}
+
+static int collapse_compare(const void *a, const void *b)
+{
+  double x = ((const MeshCollapse *)a)->cost;
+  double y = ((const MeshCollapse *)b)->cost;
+  return (x > y) - (x < y);
+}
+
+static bool mesh_simplify_quadrics(
+  Quadric *quadrics, const uint32_t *indices, uint32_t index_count,
+  const float *positions, size_t stride)
+{
+  size_t capacity = 1;
+  while (capacity < (size_t)index_count * 2) capacity <<= 1;
+
+  uint64_t *edges = malloc(capacity * sizeof(uint64_t));
+  if (edges == NULL) return false;
+  memset(edges, 0xff, capacity * sizeof(uint64_t));
+
+  for (uint32_t i = 0; i < index_count; i++) {
+    uint32_t a = indices[i];
+    uint32_t b = indices[i - i % 3 + (i + 1) % 3];
+    edge_set_insert(edges, capacity - 1, edge_key(a, b));
+  }
+
+  for (uint32_t t = 0; t < index_count; t += 3) {
+    const float *p[3];
+    for (int c = 0; c < 3; c++) p[c] = vertex_position(positions, stride, indices[t + c]);
+
+    double n[3];
+    triangle_normal(p[0], p[1], p[2], n);
+    double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (length <= 0.0) continue;
+    n[0] /= length; n[1] /= length; n[2] /= length;
+
+    double d = -(n[0] * p[0][0] + n[1] * p[0][1] + n[2] * p[0][2]);
+    for (int c = 0; c < 3; c++) quadric_add_plane(&quadrics[indices[t + c]], n[0], n[1], n[2], d, 1.0);
+
+    // Open edges get a perpendicular plane so borders don't shrink
+    for (int c = 0; c < 3; c++) {
+      uint32_t a = indices[t + c];
+      uint32_t b = indices[t + (c + 1) % 3];
+      if (edge_set_contains(edges, capacity - 1, edge_key(b, a))) continue;
+
+      double e[3] = {p[(c + 1) % 3][0] - p[c][0], p[(c + 1) % 3][1] - p[c][1], p[(c + 1) % 3][2] - p[c][2]};
+      double m[3] = {e[1] * n[2] - e[2] * n[1], e[2] * n[0] - e[0] * n[2], e[0] * n[1] - e[1] * n[0]};
+      double ml = sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+      if (ml <= 0.0) continue;
+      m[0] /= ml; m[1] /= ml; m[2] /= ml;
+
+      double md = -(m[0] * p[c][0] + m[1] * p[c][1] + m[2] * p[c][2]);
+      quadric_add_plane(&quadrics[a], m[0], m[1], m[2], md, 10.0);
+      quadric_add_plane(&quadrics[b], m[0], m[1], m[2], md, 10.0);
+    }
+  }
+
+  free(edges);
+  return true;
+}
+
+// Moving from onto to must not flip any remaining triangle around from
+static bool collapse_flips(
+  const MeshAdjacency *adj, const uint32_t *indices, const uint32_t *remap,
+  const float *positions, size_t stride, uint32_t from, uint32_t to, uint32_t *removed)
+{
+  uint32_t collapsed = 0;
+
+  for (uint32_t k = adj->offsets[from]; k < adj->offsets[from + 1]; k++) {
+    uint32_t t = adj->triangles[k];
+    uint32_t v[3];
+    for (int c = 0; c < 3; c++) v[c] = remap[indices[t * 3 + c]];
+
+    if (v[0] == to || v[1] == to || v[2] == to) {
+      collapsed++;
+      continue;
+    }
+
+    const float *p[3], *q[3];
+    for (int c = 0; c < 3; c++) {
+      p[c] = vertex_position(positions, stride, v[c]);
+      q[c] = vertex_position(positions, stride, v[c] == from ? to : v[c]);
+    }
+
+    double before[3], after[3];
+    triangle_normal(p[0], p[1], p[2], before);
+    triangle_normal(q[0], q[1], q[2], after);
+
+    double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+    if (dot <= 0.0) return true;
+  }
+
+  *removed = collapsed;
+  return false;
+}
+
+uint32_t mesh_simplify(
+  uint32_t *dst, const uint32_t *indices, uint32_t index_count,
+  const float *positions, size_t stride, uint32_t vertex_count,
+  uint32_t target_index_count, float max_error, float *result_error)
+{
+  if (dst != indices) memmove(dst, indices, (size_t)index_count * sizeof(uint32_t));
+  if (result_error) *result_error = 0.0f;
+
+  target_index_count -= target_index_count % 3;
+  if (index_count <= target_index_count) return index_count;
+
+  Quadric *quadrics     = calloc(vertex_count, sizeof(Quadric));
+  uint32_t *remap       = malloc(vertex_count * sizeof(uint32_t));
+  uint32_t *live        = malloc(vertex_count * sizeof(uint32_t));
+  bool *locked          = calloc(vertex_count, sizeof(bool));
+  bool *dirty           = malloc(vertex_count * sizeof(bool));
+  MeshCollapse *collapses = malloc((size_t)index_count * sizeof(MeshCollapse));
+  uint32_t result = 0;
+  double worst = 0.0;
+
+  if (!quadrics || !remap || !live || !locked || !dirty || !collapses) goto cleanup;
+  if (!mesh_simplify_quadrics(quadrics, dst, index_count, positions, stride)) goto cleanup;
+
+  // Attribute seams (same position, different vertex) are locked to avoid cracks
+  MeshStream position_stream = {(void *)positions, 3 * sizeof(float), stride};
+  mesh_weld(remap, &position_stream, 1, vertex_count);
+  memset(live, 0, vertex_count * sizeof(uint32_t));
+  for (uint32_t v = 0; v < vertex_count; v++) live[remap[v]]++;
+  for (uint32_t v = 0; v < vertex_count; v++) locked[v] = live[remap[v]] > 1;
+
+  const double error_limit = (double)max_error * (double)max_error;
+
+  while (index_count > target_index_count) {
+    MeshAdjacency adj = {NULL, NULL};
+    if (!mesh_adjacency_build(&adj, dst, index_count, vertex_count, live)) {
+      mesh_adjacency_free(&adj);
+      goto cleanup;
+    }
+
+    uint32_t collapse_count = 0;
+    for (uint32_t i = 0; i < index_count; i++) {
+      uint32_t a = dst[i];
+      uint32_t b = dst[i - i % 3 + (i + 1) % 3];
+      if (a > b) continue;
+
+      const float *pa = vertex_position(positions, stride, a);
+      const float *pb = vertex_position(positions, stride, b);
+      double cost_ab = locked[a] ? INFINITY : quadric_error(&quadrics[a], &quadrics[b], pb);
+      double cost_ba = locked[b] ? INFINITY : quadric_error(&quadrics[a], &quadrics[b], pa);
+      if (isinf(cost_ab) && isinf(cost_ba)) continue;
+
+      collapses[collapse_count++] = cost_ab <= cost_ba ?
+        (MeshCollapse){a, b, cost_ab} :
+        (MeshCollapse){b, a, cost_ba};
+    }
+
+    qsort(collapses, collapse_count, sizeof(MeshCollapse), collapse_compare);
+
+    for (uint32_t v = 0; v < vertex_count; v++) remap[v] = v;
+    memset(dirty, 0, vertex_count * sizeof(bool));
+
+    uint32_t triangles_needed = (index_count - target_index_count) / 3;
+    uint32_t triangles_removed = 0;
+    uint32_t performed = 0;
+
+    for (uint32_t i = 0; i < collapse_count && triangles_removed < triangles_needed; i++) {
+      const MeshCollapse *c = &collapses[i];
+      if (c->cost > error_limit) break;
+      if (dirty[c->from] || dirty[c->to]) continue;
+
+      uint32_t removed = 0;
+      if (collapse_flips(&adj, dst, remap, positions, stride, c->from, c->to, &removed)) continue;
+
+      remap[c->from] = c->to;
+      quadric_add(&quadrics[c->to], &quadrics[c->from]);
+      dirty[c->from] = dirty[c->to] = true;
+
+      triangles_removed += removed;
+      if (c->cost > worst) worst = c->cost;
+      performed++;
+    }
+
+    mesh_adjacency_free(&adj);
+    if (performed == 0) break;
+
+    // Rewrite indices, dropping the triangles that collapsed
+    uint32_t out = 0;
+    for (uint32_t t = 0; t < index_count; t += 3) {
+      uint32_t a = remap[dst[t]], b = remap[dst[t + 1]], c = remap[dst[t + 2]];
+      if (a == b || b == c || a == c) continue;
+      dst[out++] = a;
+      dst[out++] = b;
+      dst[out++] = c;
+    }
+    index_count = out;
+  }
+
+  if (result_error) *result_error = (float)sqrt(worst);
+  result = index_count;
+
+cleanup:
+  free(quadrics);
+  free(remap);
+  free(live);
+  free(locked);
+  free(dirty);
+  free(collapses);
+  return result;
+}
+
+uint32_t mesh_build_lods(
+  uint32_t *lod_indices, uint32_t lod_index_capacity,
+  MeshLodRange *lods, uint32_t max_lods,
+  const uint32_t *indices, uint32_t index_count,
+  const float *positions, size_t stride, uint32_t vertex_count,
+  float reduction, float max_error)
+{
+  if (max_lods == 0 || lod_index_capacity < index_count) return 0;
+
+  memcpy(lod_indices, indices, (size_t)index_count * sizeof(uint32_t));
+  lods[0] = (MeshLodRange){0, index_count, 0.0f};
+
+  uint32_t lod_count = 1;
+  uint32_t offset = index_count;
+
+  while (lod_count < max_lods) {
+    const MeshLodRange *previous = &lods[lod_count - 1];
+    uint32_t target = (uint32_t)((float)previous->index_count * reduction);
+    if (target < 3 || offset + previous->index_count > lod_index_capacity) break;
+
+    float error = 0.0f;
+    uint32_t count = mesh_simplify(
+      lod_indices + offset, lod_indices + previous->index_offset, previous->index_count,
+      positions, stride, vertex_count, target, max_error, &error
+    );
+
+    // Stop once the error bound keeps the simplifier from making real progress
+    if (count == 0 || (float)count > (float)previous->index_count * 0.9f) break;
+
+    if (!mesh_optimize_vertex_cache(lod_indices + offset, lod_indices + offset, count, vertex_count, MESH_DEFAULT_CACHE_SIZE))
+      break;
+
+    // Each level is simplified from the previous one, their errors add up (triangle inequality bound)
+    lods[lod_count] = (MeshLodRange){offset, count, previous->error + error};
+    offset += count;
+    lod_count++;
+  }
+
+  return lod_count;
+}
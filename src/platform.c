@@ -0,0 +1,181 @@
+#include <platform.h>
+
+#include <stdio.h>
+
+#if defined(_WIN32)
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+bool platform_map_file(PlatformFileMap *map, const char *path)
+{
+  map->data = NULL;
+  map->size = 0;
+
+  HANDLE file = CreateFileA(
+    path, GENERIC_READ, FILE_SHARE_READ, NULL,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL
+  );
+  if (file == INVALID_HANDLE_VALUE) {
+    fprintf(stderr, "[ERROR]: Could not open \"%s\" (error %lu)\n", path, GetLastError());
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (mapping == NULL) {
+    fprintf(stderr, "[ERROR]: Could not map \"%s\" (error %lu)\n", path, GetLastError());
+    return false;
+  }
+
+  // The view keeps the mapping object alive
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (data == NULL) return false;
+
+  map->data = data;
+  map->size = (size_t)size.QuadPart;
+  return true;
+}
+
+void platform_unmap_file(PlatformFileMap *map)
+{
+  if (map->data != NULL) UnmapViewOfFile(map->data);
+  map->data = NULL;
+  map->size = 0;
+}
+
+size_t platform_page_size(void)
+{
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwPageSize;
+}
+
+uint32_t platform_cpu_count(void)
+{
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors > 0 ? (uint32_t)info.dwNumberOfProcessors : 1;
+}
+
+double platform_time(void)
+{
+  LARGE_INTEGER frequency, counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+void platform_sleep(double seconds)
+{
+  if (seconds <= 0.0) return;
+
+  // High resolution timers (Windows 10 1803+) avoid Sleep's 15.6 ms scheduler tick
+  static HANDLE timer = NULL;
+  static bool timer_checked = false;
+  if (!timer_checked) {
+    timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    timer_checked = true;
+  }
+
+  if (timer != NULL) {
+    LARGE_INTEGER due;
+    due.QuadPart = -(LONGLONG)(seconds * 1e7);  // Relative, 100 ns units
+    if (SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE)) {
+      WaitForSingleObject(timer, INFINITE);
+      return;
+    }
+  }
+
+  Sleep((DWORD)(seconds * 1000.0));
+}
+
+#else   // POSIX
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <errno.h>
+
+bool platform_map_file(PlatformFileMap *map, const char *path)
+{
+  map->data = NULL;
+  map->size = 0;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "[ERROR]: Could not open \"%s\"\n", path);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+
+  void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    fprintf(stderr, "[ERROR]: Could not map \"%s\"\n", path);
+    return false;
+  }
+
+  // Blobs are read front to back exactly once when uploaded
+  madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+  madvise(data, (size_t)st.st_size, MADV_WILLNEED);
+
+  map->data = data;
+  map->size = (size_t)st.st_size;
+  return true;
+}
+
+void platform_unmap_file(PlatformFileMap *map)
+{
+  if (map->data != NULL) munmap((void *)map->data, map->size);
+  map->data = NULL;
+  map->size = 0;
+}
+
+size_t platform_page_size(void)
+{
+  return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+uint32_t platform_cpu_count(void)
+{
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (uint32_t)count : 1;
+}
+
+double platform_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void platform_sleep(double seconds)
+{
+  if (seconds <= 0.0) return;
+
+  struct timespec ts;
+  ts.tv_sec = (time_t)seconds;
+  ts.tv_nsec = (long)((seconds - (double)ts.tv_sec) * 1e9);
+  while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+#endif  //!_WIN32
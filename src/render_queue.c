@@ -0,0 +1,174 @@
+#include <render_queue.h>
+#include <allocator.h>
+#include <glad/glad.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define RENDER_BUFFER_MIN_CAPACITY 256
+
+bool render_queue_init(RenderQueue *queue, uint32_t buffer_count)
+{
+  memset(queue, 0, sizeof(*queue));
+  if (buffer_count == 0) buffer_count = 1;
+
+  queue->buffers = mem_calloc(buffer_count, sizeof(RenderBuffer));
+  if (queue->buffers == NULL) return false;
+  queue->buffer_count = buffer_count;
+  return true;
+}
+
+void render_queue_free(RenderQueue *queue)
+{
+  for (uint32_t i = 0; i < queue->buffer_count; i++) {
+    mem_free(queue->buffers[i].commands);
+    mem_free(queue->buffers[i].keys);
+  }
+  mem_free(queue->buffers);
+  mem_free(queue->items);
+  mem_free(queue->scratch);
+  memset(queue, 0, sizeof(*queue));
+}
+
+void render_queue_reset(RenderQueue *queue)
+{
+  for (uint32_t i = 0; i < queue->buffer_count; i++) queue->buffers[i].count = 0;
+  queue->item_count = 0;
+}
+
+bool render_buffer_push(RenderBuffer *buffer, uint64_t key, const RenderCommand *command)
+{
+  if (buffer->count == buffer->capacity) {
+    uint32_t capacity = buffer->capacity ? buffer->capacity * 2 : RENDER_BUFFER_MIN_CAPACITY;
+
+    RenderCommand *commands = mem_realloc(buffer->commands, capacity * sizeof(RenderCommand));
+    if (commands == NULL) return false;
+    buffer->commands = commands;
+
+    uint64_t *keys = mem_realloc(buffer->keys, capacity * sizeof(uint64_t));
+    if (keys == NULL) return false;
+    buffer->keys = keys;
+
+    buffer->capacity = capacity;
+  }
+
+  buffer->keys[buffer->count] = key;
+  buffer->commands[buffer->count] = *command;
+  buffer->count++;
+  return true;
+}
+
+/*
+  LSD radix sort, 8 bits per pass. All histograms come from a single
+  read of the keys, and passes where every key shares the same byte
+  (typically the layer and program bytes) are skipped.
+*/
+static RenderSortItem *render_radix_sort(RenderSortItem *items, RenderSortItem *scratch, uint32_t count)
+{
+  uint32_t histograms[8][256];
+  memset(histograms, 0, sizeof(histograms));
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint64_t key = items[i].key;
+    for (uint32_t pass = 0; pass < 8; pass++) histograms[pass][(key >> (pass * 8)) & 0xff]++;
+  }
+
+  RenderSortItem *src = items;
+  RenderSortItem *dst = scratch;
+
+  for (uint32_t pass = 0; pass < 8; pass++) {
+    uint32_t *histogram = histograms[pass];
+    const uint32_t shift = pass * 8;
+    if (histogram[(src[0].key >> shift) & 0xff] == count) continue;
+
+    uint32_t offset = 0;
+    for (uint32_t b = 0; b < 256; b++) {
+      uint32_t bucket = histogram[b];
+      histogram[b] = offset;
+      offset += bucket;
+    }
+
+    for (uint32_t i = 0; i < count; i++) dst[histogram[(src[i].key >> shift) & 0xff]++] = src[i];
+
+    RenderSortItem *swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  return src;
+}
+
+bool render_queue_sort(RenderQueue *queue)
+{
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < queue->buffer_count; i++) count += queue->buffers[i].count;
+
+  if (count > queue->item_capacity) {
+    RenderSortItem *items = mem_realloc(queue->items, count * sizeof(RenderSortItem));
+    if (items == NULL) return false;
+    queue->items = items;
+
+    RenderSortItem *scratch = mem_realloc(queue->scratch, count * sizeof(RenderSortItem));
+    if (scratch == NULL) return false;
+    queue->scratch = scratch;
+
+    queue->item_capacity = count;
+  }
+
+  uint32_t item = 0;
+  for (uint32_t i = 0; i < queue->buffer_count; i++) {
+    const RenderBuffer *buffer = &queue->buffers[i];
+    for (uint32_t c = 0; c < buffer->count; c++)
+      queue->items[item++] = (RenderSortItem){buffer->keys[c], &buffer->commands[c]};
+  }
+  queue->item_count = count;
+  if (count == 0) return true;
+
+  // Sorted data may end up in scratch, swap so items always holds it
+  if (render_radix_sort(queue->items, queue->scratch, count) == queue->scratch) {
+    RenderSortItem *swap = queue->items;
+    queue->items = queue->scratch;
+    queue->scratch = swap;
+  }
+  return true;
+}
+
+RenderQueueStats render_queue_execute(const RenderQueue *queue)
+{
+  RenderQueueStats stats = {0};
+  uint32_t program = 0;
+  const Mesh *mesh = NULL;
+
+  for (uint32_t i = 0; i < queue->item_count; i++) {
+    const RenderCommand *command = queue->items[i].command;
+
+    if (command->program != program || i == 0) {
+      program = command->program;
+      glUseProgram(program);
+      stats.program_binds++;
+    }
+
+    if (command->mesh != mesh) {
+      mesh = command->mesh;
+      mesh_bind(mesh);
+      stats.mesh_binds++;
+    }
+
+    if (command->u_mvp >= 0)
+      glUniformMatrix4fv(command->u_mvp, 1, GL_FALSE, MatrixToFloat(command->mvp));
+    if (command->u_color >= 0)
+      glUniform3f(command->u_color, command->color.x, command->color.y, command->color.z);
+
+    if (mesh->index_type != 0) {
+      mesh_draw_lod(mesh, command->lod);
+      uint32_t lod = command->lod < mesh->lod_count ? command->lod : mesh->lod_count - 1;
+      stats.triangles += mesh->lods[lod].index_count / 3;
+    } else {
+      mesh_draw(mesh);
+      stats.triangles += mesh->vertex_count / 3;
+    }
+    stats.draws++;
+  }
+
+  return stats;
+}
@@ -0,0 +1,235 @@
+#include <render_scale.h>
+#include <gl_shader.h>
+#include <glad/glad.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// Full screen triangle, uUvMax maps it to the rendered part of the source
+static const char *upscale_vertex_src =
+  "#version 330 core\n"
+  "uniform vec2 uUvMax;\n"
+  "out vec2 vUv;\n"
+  "void main(void) {\n"
+  "  vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+  "  vUv = corner * uUvMax;\n"
+  "  gl_Position = vec4(corner * 2.0f - 1.0f, 0.0f, 1.0f);\n"
+  "}\0"
+;
+
+// Taps are clamped to the rendered part, texels past it hold older frames
+static const char *upscale_sharpen_fragment_src =
+  "#version 330 core\n"
+  "uniform sampler2D uSource;\n"
+  "uniform vec2 uUvMax;\n"
+  "uniform float uSharpness;\n"
+  "in vec2 vUv;\n"
+  "out vec4 FragColor;\n"
+  "vec3 tap(vec2 uv, vec2 texel) {\n"
+  "  return texture(uSource, clamp(uv, texel * 0.5f, uUvMax - texel * 0.5f)).rgb;\n"
+  "}\n"
+  "void main(void) {\n"
+  "  vec2 texel = 1.0f / vec2(textureSize(uSource, 0));\n"
+  "  vec3 center = tap(vUv, texel);\n"
+  "  vec3 neighbors = tap(vUv + vec2(texel.x, 0.0f), texel) + tap(vUv - vec2(texel.x, 0.0f), texel) +\n"
+  "                   tap(vUv + vec2(0.0f, texel.y), texel) + tap(vUv - vec2(0.0f, texel.y), texel);\n"
+  "  vec3 sharpened = center + uSharpness * (center - neighbors * 0.25f);\n"
+  "  FragColor = vec4(clamp(sharpened, 0.0f, 1.0f), 1.0f);\n"
+  "}\0"
+;
+
+bool render_scale_init(RenderScale *rs, double budget_ms, RenderUpscale upscale)
+{
+  memset(rs, 0, sizeof(*rs));
+  rs->upscale = upscale;
+  rs->budget_ms = budget_ms;
+  rs->scale = 1.0f;
+  rs->scale_low = 1.0f;
+  rs->max_scale = 1.0f;
+  rs->min_scale = budget_ms > 0.0 ? RENDER_SCALE_MIN : 1.0f;
+
+  glCreateQueries(GL_TIME_ELAPSED, RENDER_SCALE_QUERIES, rs->queries);
+
+  if (upscale == RENDER_UPSCALE_SHARPEN) {
+    if (!gl_shader_program(&rs->program, upscale_vertex_src, upscale_sharpen_fragment_src)) {
+      render_scale_destroy(rs);
+      return false;
+    }
+    rs->u_uv_max = glGetUniformLocation(rs->program, "uUvMax");
+    rs->u_sharpness = glGetUniformLocation(rs->program, "uSharpness");
+
+    // Pool textures sample nearest, the upscale needs filtering
+    glCreateSamplers(1, &rs->sampler);
+    glSamplerParameteri(rs->sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glSamplerParameteri(rs->sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(rs->sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(rs->sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Attributeless draw, core profile still wants a VAO bound
+    glCreateVertexArrays(1, &rs->vao);
+  }
+
+  return true;
+}
+
+void render_scale_destroy(RenderScale *rs)
+{
+  if (rs->timing) glEndQuery(GL_TIME_ELAPSED);
+  glDeleteQueries(RENDER_SCALE_QUERIES, rs->queries);
+  if (rs->program != 0) glDeleteProgram(rs->program);
+  if (rs->sampler != 0) glDeleteSamplers(1, &rs->sampler);
+  if (rs->vao != 0) glDeleteVertexArrays(1, &rs->vao);
+  memset(rs->queries, 0, sizeof(rs->queries));
+  rs->program = rs->sampler = rs->vao = 0;
+  rs->query_count = 0;
+  rs->timing = false;
+}
+
+void render_scale_size(const RenderScale *rs, int32_t width, int32_t height, int32_t *scaled_width, int32_t *scaled_height)
+{
+  *scaled_width = (int32_t)(width * rs->scale + 0.5f);
+  *scaled_height = (int32_t)(height * rs->scale + 0.5f);
+  if (*scaled_width < 1) *scaled_width = 1;
+  if (*scaled_height < 1) *scaled_height = 1;
+}
+
+static void render_scale_update(RenderScale *rs, double gpu_ms)
+{
+  rs->gpu_ms = rs->samples == 0 ? gpu_ms : rs->gpu_ms + (gpu_ms - rs->gpu_ms) * RENDER_SCALE_SMOOTHING;
+  rs->gpu_ms_sum += gpu_ms;
+  rs->samples++;
+
+  if (rs->budget_ms <= 0.0 || rs->gpu_ms <= 0.0) return;
+  if (rs->cooldown > 0) {
+    rs->cooldown--;
+    return;
+  }
+
+  // Only react outside a dead band, otherwise the scale hunts around the target
+  double target = rs->budget_ms * RENDER_SCALE_HEADROOM;
+  if (rs->gpu_ms <= rs->budget_ms && rs->gpu_ms >= target * 0.75) return;
+
+  // GPU time follows the pixel count, the square of the scale. Grow in small steps
+  float next = rs->scale * (float)sqrt(target / rs->gpu_ms);
+  if (next > rs->scale + 2.0f * RENDER_SCALE_STEP) next = rs->scale + 2.0f * RENDER_SCALE_STEP;
+
+  next = floorf(next / RENDER_SCALE_STEP + 1e-3f) * RENDER_SCALE_STEP;
+  if (next < rs->min_scale) next = rs->min_scale;
+  if (next > rs->max_scale) next = rs->max_scale;
+
+  if (fabsf(next - rs->scale) > RENDER_SCALE_STEP * 0.5f) {
+    rs->scale = next;
+    rs->changes++;
+    rs->cooldown = RENDER_SCALE_COOLDOWN;
+    if (next < rs->scale_low) rs->scale_low = next;
+  }
+}
+
+// Oldest first, stops at the first query whose result isn't there yet
+static void render_scale_poll(RenderScale *rs)
+{
+  while (rs->query_count > 0) {
+    uint32_t query = rs->queries[rs->query_head];
+
+    int32_t available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) break;
+
+    uint64_t elapsed_ns = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+    rs->query_head = (rs->query_head + 1) % RENDER_SCALE_QUERIES;
+    rs->query_count--;
+
+    render_scale_update(rs, (double)elapsed_ns / 1e6);
+  }
+}
+
+void render_scale_begin(RenderScale *rs)
+{
+  render_scale_poll(rs);
+
+  rs->frames++;
+  rs->scale_sum += rs->scale;
+
+  // Every query still in flight, skip timing this frame rather than wait
+  rs->timing = rs->query_count < RENDER_SCALE_QUERIES;
+  if (rs->timing)
+    glBeginQuery(GL_TIME_ELAPSED, rs->queries[(rs->query_head + rs->query_count) % RENDER_SCALE_QUERIES]);
+}
+
+void render_scale_end(RenderScale *rs)
+{
+  if (!rs->timing) return;
+  glEndQuery(GL_TIME_ELAPSED);
+  rs->query_count++;
+  rs->timing = false;
+}
+
+void render_scale_upscale(const RenderScale *rs, const RenderTarget *source, int32_t width, int32_t height)
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, width, height);
+
+  bool native = source->width == width && source->height == height;
+  if (native || rs->upscale == RENDER_UPSCALE_BILINEAR || rs->program == 0) {
+    glBlitNamedFramebuffer(
+      source->fbo, 0,
+      0, 0, source->width, source->height,
+      0, 0, width, height,
+      GL_COLOR_BUFFER_BIT, native ? GL_NEAREST : GL_LINEAR
+    );
+    return;
+  }
+
+  glUseProgram(rs->program);
+  glUniform2f(rs->u_uv_max,
+    (float)source->width / (float)source->alloc_width,
+    (float)source->height / (float)source->alloc_height);
+  glUniform1f(rs->u_sharpness, RENDER_SCALE_SHARPNESS);
+  glBindTextureUnit(0, source->color);
+  glBindSampler(0, rs->sampler);
+  glBindVertexArray(rs->vao);
+
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+
+  glBindVertexArray(0);
+  glBindSampler(0, 0);
+  glBindTextureUnit(0, 0);
+}
+
+void render_scale_report(const RenderScale *rs)
+{
+  printf(
+    "[INFO]: Render scale (%s, budget %.2f ms)\n"
+    "  - Scale         : avg %.2f, low %.2f, last %.2f, %llu change(s)\n"
+    "  - GPU time      : avg %.3f ms, smoothed %.3f, %llu sample(s)\n",
+    render_upscale_name(rs->upscale), rs->budget_ms,
+    rs->frames > 0 ? rs->scale_sum / rs->frames : 1.0, rs->scale_low, rs->scale,
+    (unsigned long long)rs->changes,
+    rs->samples > 0 ? rs->gpu_ms_sum / rs->samples : 0.0, rs->gpu_ms,
+    (unsigned long long)rs->samples
+  );
+}
+
+const char *render_upscale_name(RenderUpscale upscale)
+{
+  switch (upscale) {
+    case RENDER_UPSCALE_BILINEAR: return "bilinear";
+    case RENDER_UPSCALE_SHARPEN:  return "sharpen";
+  }
+  return "unknown";
+}
+
+bool render_upscale_parse(const char *name, RenderUpscale *upscale)
+{
+  static const RenderUpscale modes[] = {RENDER_UPSCALE_BILINEAR, RENDER_UPSCALE_SHARPEN};
+
+  for (uint32_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+    if (strcmp(name, render_upscale_name(modes[i])) == 0) {
+      *upscale = modes[i];
+      return true;
+    }
+  }
+  return false;
+}
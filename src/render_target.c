@@ -0,0 +1,234 @@
+#include <render_target.h>
+#include <glad/glad.h>
+
+#include <stdio.h>
+#include <string.h>
+
+void render_texture_pool_init(RenderTexturePool *pool)
+{
+  memset(pool, 0, sizeof(*pool));
+}
+
+void render_texture_pool_destroy(RenderTexturePool *pool)
+{
+  for (uint32_t i = 0; i < pool->texture_count; i++) {
+    if (pool->textures[i].in_use)
+      fprintf(stderr, "[WARNING]: Render texture %u still in use at pool destruction\n", pool->textures[i].texture);
+    glDeleteTextures(1, &pool->textures[i].texture);
+  }
+  memset(pool, 0, sizeof(*pool));
+}
+
+static void render_texture_pool_evict(RenderTexturePool *pool, uint32_t index)
+{
+  glDeleteTextures(1, &pool->textures[index].texture);
+  pool->textures[index] = pool->textures[--pool->texture_count];
+  pool->evictions++;
+}
+
+uint32_t render_texture_acquire(RenderTexturePool *pool, uint32_t format, int32_t width, int32_t height)
+{
+  for (uint32_t i = 0; i < pool->texture_count; i++) {
+    RenderPoolTexture *entry = &pool->textures[i];
+    if (entry->in_use || entry->format != format || entry->width != width || entry->height != height) continue;
+
+    entry->in_use = true;
+    pool->reuses++;
+    return entry->texture;
+  }
+
+  // Make room by dropping the least recently released texture
+  if (pool->texture_count == RENDER_POOL_MAX_TEXTURES) {
+    uint32_t oldest = RENDER_POOL_MAX_TEXTURES;
+    for (uint32_t i = 0; i < pool->texture_count; i++) {
+      if (pool->textures[i].in_use) continue;
+      if (oldest == RENDER_POOL_MAX_TEXTURES || pool->textures[i].last_used < pool->textures[oldest].last_used)
+        oldest = i;
+    }
+
+    if (oldest == RENDER_POOL_MAX_TEXTURES) {
+      fprintf(stderr, "[ERROR]: Render texture pool full (%u textures in use)\n", RENDER_POOL_MAX_TEXTURES);
+      return 0;
+    }
+    render_texture_pool_evict(pool, oldest);
+  }
+
+  // Immutable storage: the driver validates the allocation once instead of on every use
+  uint32_t texture = 0;
+  glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+  if (texture == 0) return 0;
+  glTextureStorage2D(texture, 1, format, width, height);
+  glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  pool->textures[pool->texture_count++] = (RenderPoolTexture){
+    .texture = texture, .format = format, .width = width, .height = height, .in_use = true, .last_used = pool->frame
+  };
+  pool->allocations++;
+  return texture;
+}
+
+void render_texture_release(RenderTexturePool *pool, uint32_t texture)
+{
+  if (texture == 0) return;
+
+  for (uint32_t i = 0; i < pool->texture_count; i++) {
+    if (pool->textures[i].texture != texture) continue;
+    pool->textures[i].in_use = false;
+    pool->textures[i].last_used = pool->frame;
+    return;
+  }
+
+  fprintf(stderr, "[WARNING]: Releasing texture %u not owned by the pool\n", texture);
+  glDeleteTextures(1, &texture);
+}
+
+void render_texture_pool_frame(RenderTexturePool *pool)
+{
+  pool->frame++;
+
+  for (uint32_t i = 0; i < pool->texture_count;) {
+    const RenderPoolTexture *entry = &pool->textures[i];
+    if (!entry->in_use && pool->frame - entry->last_used > RENDER_POOL_MAX_AGE)
+      render_texture_pool_evict(pool, i);
+    else
+      i++;
+  }
+}
+
+void render_target_init(RenderTarget *target, uint32_t color_format, uint32_t depth_format)
+{
+  memset(target, 0, sizeof(*target));
+  target->color_format = color_format;
+  target->depth_format = depth_format;
+}
+
+static void render_target_release(RenderTarget *target, RenderTexturePool *pool)
+{
+  render_texture_release(pool, target->color);
+  render_texture_release(pool, target->depth);
+  target->color = 0;
+  target->depth = 0;
+  target->width = 0;
+  target->height = 0;
+  target->alloc_width = 0;
+  target->alloc_height = 0;
+}
+
+void render_target_destroy(RenderTarget *target, RenderTexturePool *pool)
+{
+  render_target_release(target, pool);
+  if (target->fbo != 0) glDeleteFramebuffers(1, &target->fbo);
+  target->fbo = 0;
+}
+
+bool render_target_resize(RenderTarget *target, RenderTexturePool *pool, int32_t width, int32_t height)
+{
+  if (width <= 0 || height <= 0) return false;
+
+  // Shrinking far below the allocation gives the memory back, anything else keeps it
+  int64_t needed = (int64_t)width * height;
+  int64_t allocated = (int64_t)target->alloc_width * target->alloc_height;
+  if (target->fbo != 0 && width <= target->alloc_width && height <= target->alloc_height && allocated <= needed * 4) {
+    target->width = width;
+    target->height = height;
+    return false;
+  }
+
+  // Released first so a full pool can evict them, reused as is if resized back within RENDER_POOL_MAX_AGE frames
+  render_target_release(target, pool);
+  if (target->fbo == 0) glCreateFramebuffers(1, &target->fbo);
+
+  int32_t alloc_width = render_target_round(width);
+  int32_t alloc_height = render_target_round(height);
+
+  if (target->color_format != 0) {
+    target->color = render_texture_acquire(pool, target->color_format, alloc_width, alloc_height);
+    if (target->color == 0) goto fail;
+  }
+  if (target->depth_format != 0) {
+    target->depth = render_texture_acquire(pool, target->depth_format, alloc_width, alloc_height);
+    if (target->depth == 0) goto fail;
+  }
+
+  glNamedFramebufferTexture(target->fbo, GL_COLOR_ATTACHMENT0, target->color, 0);
+  glNamedFramebufferTexture(target->fbo, GL_DEPTH_ATTACHMENT, target->depth, 0);
+
+  if (glCheckNamedFramebufferStatus(target->fbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    fprintf(stderr, "[ERROR]: Render target framebuffer incomplete\n");
+    goto fail;
+  }
+
+  target->width = width;
+  target->height = height;
+  target->alloc_width = alloc_width;
+  target->alloc_height = alloc_height;
+  return true;
+
+fail:
+  render_target_release(target, pool);
+  return false;
+}
+
+void render_target_bind(const RenderTarget *target)
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+  glViewport(0, 0, target->width, target->height);
+}
+
+void render_target_blit(const RenderTarget *target)
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glBlitNamedFramebuffer(
+    target->fbo, 0,
+    0, 0, target->width, target->height,
+    0, 0, target->width, target->height,
+    GL_COLOR_BUFFER_BIT, GL_NEAREST
+  );
+}
+
+void render_resize_init(RenderResize *resize, int32_t width, int32_t height)
+{
+  memset(resize, 0, sizeof(*resize));
+  resize->width = width;
+  resize->height = height;
+}
+
+void render_resize_request(RenderResize *resize, int32_t width, int32_t height)
+{
+  resize->pending_width = width;
+  resize->pending_height = height;
+  resize->pending = true;
+  resize->events++;
+}
+
+bool render_resize_apply(RenderResize *resize, int32_t *width, int32_t *height)
+{
+  if (!resize->pending) return false;
+  resize->pending = false;
+
+  // A drag may end where it started
+  if (resize->pending_width == resize->width && resize->pending_height == resize->height) return false;
+
+  resize->width = resize->pending_width;
+  resize->height = resize->pending_height;
+  resize->applied++;
+
+  *width = resize->width;
+  *height = resize->height;
+  return true;
+}
+
+void render_targets_report(const RenderTexturePool *pool, const RenderResize *resize)
+{
+  printf(
+    "[INFO]: Render targets\n"
+    "  - Resizes       : %llu event(s), %llu applied\n"
+    "  - Textures      : %llu allocated, %llu reused, %llu evicted, %u pooled\n",
+    (unsigned long long)resize->events, (unsigned long long)resize->applied,
+    (unsigned long long)pool->allocations, (unsigned long long)pool->reuses,
+    (unsigned long long)pool->evictions, pool->texture_count
+  );
+}
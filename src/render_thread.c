@@ -0,0 +1,107 @@
+#include <render_thread.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static void render_thread_main(void *user)
+{
+  RenderThread *rt = user;
+  glfwMakeContextCurrent(rt->window);
+
+  for (;;) {
+    mutex_lock(&rt->mutex);
+    uint32_t slot = (uint32_t)(rt->rendered % RENDER_THREAD_FRAMES);
+    // Pending frames are still presented after quit was requested
+    while (rt->states[slot] != RENDER_FRAME_READY && !rt->quit) cond_wait(&rt->cond, &rt->mutex);
+    bool ready = rt->states[slot] == RENDER_FRAME_READY;
+    mutex_unlock(&rt->mutex);
+    if (!ready) break;
+
+    RenderFrame *frame = &rt->frames[slot];
+    frame->stats = rt->submit(rt->user, frame);
+    glfwSwapBuffers(rt->window);
+    frame->latency_ms = (glfwGetTime() - frame->input_time) * 1000.0;
+    frame->presented = true;
+
+    mutex_lock(&rt->mutex);
+    rt->states[slot] = RENDER_FRAME_FREE;
+    rt->rendered++;
+    cond_broadcast(&rt->cond);
+    mutex_unlock(&rt->mutex);
+  }
+
+  glfwMakeContextCurrent(NULL);
+}
+
+bool render_thread_start(
+  RenderThread *rt, GLFWwindow *window, uint32_t buffer_count,
+  RenderSubmitFn submit, void *user)
+{
+  memset(rt, 0, sizeof(*rt));
+  rt->window = window;
+  rt->submit = submit;
+  rt->user = user;
+
+  for (uint32_t i = 0; i < RENDER_THREAD_FRAMES; i++) {
+    if (!render_queue_init(&rt->frames[i].queue, buffer_count)) {
+      for (uint32_t j = 0; j < i; j++) render_queue_free(&rt->frames[j].queue);
+      return false;
+    }
+  }
+
+  mutex_init(&rt->mutex);
+  cond_init(&rt->cond);
+
+  // A context can only be current on one thread at a time
+  glfwMakeContextCurrent(NULL);
+  if (!thread_create(&rt->thread, render_thread_main, rt)) {
+    fprintf(stderr, "[ERROR]: Render thread creation failed\n");
+    glfwMakeContextCurrent(window);
+    cond_destroy(&rt->cond);
+    mutex_destroy(&rt->mutex);
+    for (uint32_t i = 0; i < RENDER_THREAD_FRAMES; i++) render_queue_free(&rt->frames[i].queue);
+    return false;
+  }
+
+  return true;
+}
+
+void render_thread_stop(RenderThread *rt)
+{
+  mutex_lock(&rt->mutex);
+  rt->quit = true;
+  cond_broadcast(&rt->cond);
+  mutex_unlock(&rt->mutex);
+
+  thread_join(&rt->thread);
+  glfwMakeContextCurrent(rt->window);
+
+  cond_destroy(&rt->cond);
+  mutex_destroy(&rt->mutex);
+  for (uint32_t i = 0; i < RENDER_THREAD_FRAMES; i++) render_queue_free(&rt->frames[i].queue);
+}
+
+RenderFrame *render_thread_acquire(RenderThread *rt)
+{
+  mutex_lock(&rt->mutex);
+  uint32_t slot = (uint32_t)(rt->acquired % RENDER_THREAD_FRAMES);
+  while (rt->states[slot] != RENDER_FRAME_FREE) cond_wait(&rt->cond, &rt->mutex);
+  rt->states[slot] = RENDER_FRAME_RECORDING;
+  mutex_unlock(&rt->mutex);
+
+  RenderFrame *frame = &rt->frames[slot];
+  frame->index = rt->acquired++;
+  return frame;
+}
+
+void render_thread_submit(RenderThread *rt, RenderFrame *frame)
+{
+  frame->presented = false;
+
+  mutex_lock(&rt->mutex);
+  rt->states[frame - rt->frames] = RENDER_FRAME_READY;
+  cond_broadcast(&rt->cond);
+  mutex_unlock(&rt->mutex);
+}
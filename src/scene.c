@@ -0,0 +1,549 @@
+#include <scene.h>
+#include <allocator.h>
+#include <gl_shader.h>
+#include <glad/glad.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <stdatomic.h>
+
+#define SCENE_SPACING       4.0f
+#define SCENE_SPHERE_RINGS  96
+#define SCENE_SPHERE_SEGS   192
+#define SCENE_FOVY          (60.0f * DEG2RAD)
+#define SCENE_PIXEL_ERROR   1.0f
+#define SCENE_FRAME_ARENA_SLACK (64u * 1024u)
+#define SCENE_RECORD_CHUNK  512
+
+static const char *scene_vertex_src =
+  "#version 330 core\n"
+  "layout (location = 0) in vec3 aPos;\n"
+  "layout (location = 2) in vec3 aNormal;\n"
+  "uniform mat4 uMvp;\n"
+  "uniform vec3 uColor;\n"
+  "out vec3 outColor;\n"
+  "void main(void) {\n"
+  "  gl_Position = uMvp * vec4(aPos, 1.0f);\n"
+  "  float light = max(dot(normalize(aNormal), normalize(vec3(0.4f, 0.8f, 0.5f))), 0.0f);\n"
+  "  outColor = uColor * (0.25f + 0.75f * light);\n"
+  "}\0"
+;
+
+// Instances come from the GPU cull buffer, indexed by the command's base instance
+static const char *scene_gpu_vertex_src =
+  "#version 460 core\n"
+  "layout (location = 0) in vec3 aPos;\n"
+  "layout (location = 2) in vec3 aNormal;\n"
+  "struct Instance { vec4 sphere; vec4 color_scale; };\n"
+  "layout (std430, binding = 0) readonly buffer Instances { Instance instances[]; };\n"
+  "uniform mat4 uViewProjection;\n"
+  "out vec3 outColor;\n"
+  "void main(void) {\n"
+  "  Instance instance = instances[gl_BaseInstance + gl_InstanceID];\n"
+  "  gl_Position = uViewProjection * vec4(aPos * instance.color_scale.w + instance.sphere.xyz, 1.0f);\n"
+  "  float light = max(dot(normalize(aNormal), normalize(vec3(0.4f, 0.8f, 0.5f))), 0.0f);\n"
+  "  outColor = instance.color_scale.xyz * (0.25f + 0.75f * light);\n"
+  "}\0"
+;
+
+static const char *scene_fragment_src =
+  "#version 330 core\n"
+  "in vec3 outColor;\n"
+  "out vec4 FragColor;\n"
+  "void main(void) {\n"
+  "  FragColor = vec4(outColor, 1.0f);\n"
+  "}\0"
+;
+
+/*
+  Unit UV sphere packed as half positions + 10_10_10_2 normals,
+  welded, cache optimized and simplified into a LOD chain.
+*/
+static bool scene_build_sphere(Mesh *mesh, uint32_t rings, uint32_t segments)
+{
+  const uint32_t vertex_count = (rings + 1) * (segments + 1);
+  const uint32_t max_indices = rings * segments * 6;
+
+  float *positions = mem_alloc(vertex_count * 3 * sizeof(float));
+  uint32_t *indices = mem_alloc(max_indices * sizeof(uint32_t));
+  uint32_t *lod_indices = mem_alloc(max_indices * 2 * sizeof(uint32_t));
+  uint8_t *packed = NULL;
+  bool ok = false;
+
+  if (positions == NULL || indices == NULL || lod_indices == NULL) goto cleanup;
+
+  for (uint32_t r = 0; r <= rings; r++) {
+    for (uint32_t s = 0; s <= segments; s++) {
+      float theta = PI * (float)r / (float)rings;
+      float phi = 2.0f * PI * (float)(s % segments) / (float)segments;
+      float *p = positions + (r * (segments + 1) + s) * 3;
+
+      // Exact poles so welding collapses them to a single vertex
+      bool pole = (r == 0 || r == rings);
+      p[0] = pole ? 0.0f : sinf(theta) * cosf(phi);
+      p[1] = r == 0 ? 1.0f : (r == rings ? -1.0f : cosf(theta));
+      p[2] = pole ? 0.0f : sinf(theta) * sinf(phi);
+    }
+  }
+
+  uint32_t index_count = 0;
+  for (uint32_t r = 0; r < rings; r++) {
+    for (uint32_t s = 0; s < segments; s++) {
+      uint32_t a = r * (segments + 1) + s;
+      uint32_t b = a + 1;
+      uint32_t c = a + segments + 1;
+      uint32_t d = c + 1;
+
+      if (r != 0) {
+        indices[index_count++] = a; indices[index_count++] = c; indices[index_count++] = b;
+      }
+      if (r != rings - 1) {
+        indices[index_count++] = b; indices[index_count++] = c; indices[index_count++] = d;
+      }
+    }
+  }
+
+  VertexLayout layout;
+  vertex_layout_init(&layout);
+  vertex_layout_add(&layout, MESH_ATTRIB_POSITION, (VertexAttribFormat){VERTEX_FORMAT_HALF16, 3}, 0);
+  vertex_layout_add(&layout, MESH_ATTRIB_NORMAL, (VertexAttribFormat){VERTEX_FORMAT_SNORM10_10_10_2, 3}, 0);
+
+  const uint32_t stride = layout.bindings[0].stride;
+  packed = mem_alloc((size_t)stride * vertex_count);
+  if (packed == NULL) goto cleanup;
+
+  // On a unit sphere the normal is the position
+  void *dst[1] = {packed};
+  const float *src[2] = {positions, positions};
+  if (!vertex_layout_pack(&layout, dst, src, NULL, vertex_count)) goto cleanup;
+
+  MeshStream streams[2] = {
+    {packed, stride, stride},
+    {positions, 3 * sizeof(float), 3 * sizeof(float)},
+  };
+  uint32_t welded = mesh_optimize(streams, 2, vertex_count, indices, index_count, NULL);
+  if (welded == 0) goto cleanup;
+
+  MeshLodRange lods[MESH_MAX_LODS];
+  uint32_t lod_count = mesh_build_lods(
+    lod_indices, max_indices * 2, lods, MESH_MAX_LODS,
+    indices, index_count,
+    positions, 3 * sizeof(float), welded,
+    0.5f, 0.5f
+  );
+  if (lod_count == 0) goto cleanup;
+
+  uint32_t total = lods[lod_count - 1].index_offset + lods[lod_count - 1].index_count;
+  const void *vertices[1] = {packed};
+  ok = mesh_create_lods(mesh, &layout, vertices, welded, lod_indices, total, lods, lod_count);
+
+  if (ok) {
+    printf("[INFO]: Scene mesh: %u vertices, %u LODs (", welded, lod_count);
+    for (uint32_t i = 0; i < lod_count; i++)
+      printf("%s%u", i ? ", " : "", lods[i].index_count / 3);
+    printf(" triangles)\n");
+  }
+
+cleanup:
+  mem_free(positions);
+  mem_free(indices);
+  mem_free(lod_indices);
+  mem_free(packed);
+  return ok;
+}
+
+// Small deterministic hash so the scene is identical across runs
+static inline float scene_random(uint32_t seed)
+{
+  seed ^= seed >> 16; seed *= 0x7feb352du;
+  seed ^= seed >> 15; seed *= 0x846ca68bu;
+  seed ^= seed >> 16;
+  return (float)(seed & 0xffffffu) / (float)0xffffff;
+}
+
+bool scene_create(Scene *scene, uint32_t grid_size, ThreadPool *pool, RenderTexturePool *textures)
+{
+  memset(scene, 0, sizeof(*scene));
+  scene->pool = pool;
+  scene->textures = textures;
+  frame_graph_init(&scene->graph);
+
+  if (!gl_shader_program(&scene->program, scene_vertex_src, scene_fragment_src)) return false;
+  scene->u_mvp = glGetUniformLocation(scene->program, "uMvp");
+  scene->u_color = glGetUniformLocation(scene->program, "uColor");
+
+  if (!gl_shader_program(&scene->gpu_program, scene_gpu_vertex_src, scene_fragment_src)) {
+    scene_destroy(scene);
+    return false;
+  }
+  scene->u_view_projection = glGetUniformLocation(scene->gpu_program, "uViewProjection");
+
+  if (!scene_build_sphere(&scene->mesh, SCENE_SPHERE_RINGS, SCENE_SPHERE_SEGS)) {
+    scene_destroy(scene);
+    return false;
+  }
+  scene->mesh_radius = 1.0f;
+
+  scene->object_count = grid_size * grid_size;
+  scene->objects = mem_alloc(scene->object_count * sizeof(SceneObject));
+  if (scene->objects == NULL ||
+      !frame_arena_init(&scene->frame, scene->object_count * sizeof(uint32_t) + SCENE_FRAME_ARENA_SLACK) ||
+      !render_queue_init(&scene->queue, thread_pool_size(pool)) ||
+      !cull_spheres_init(&scene->bounds, scene->object_count) ||
+      !transform_graph_init(&scene->transforms, scene->object_count)) {
+    scene_destroy(scene);
+    return false;
+  }
+
+  const float half = (float)(grid_size - 1) * SCENE_SPACING * 0.5f;
+  for (uint32_t z = 0; z < grid_size; z++) {
+    for (uint32_t x = 0; x < grid_size; x++) {
+      uint32_t i = z * grid_size + x;
+      SceneObject *object = &scene->objects[i];
+      object->position = (Vector3){x * SCENE_SPACING - half, 0.0f, z * SCENE_SPACING - half};
+      object->scale = 0.6f + scene_random(i * 4 + 0) * 0.9f;
+      object->color = (Vector3){
+        0.3f + 0.7f * scene_random(i * 4 + 1),
+        0.3f + 0.7f * scene_random(i * 4 + 2),
+        0.3f + 0.7f * scene_random(i * 4 + 3),
+      };
+
+      cull_spheres_set(&scene->bounds, i, object->position, scene->mesh_radius * object->scale);
+      transform_add(
+        &scene->transforms, TRANSFORM_NONE,
+        object->position, QuaternionIdentity(), Vector3Scale(Vector3One(), object->scale)
+      );
+    }
+  }
+  transform_graph_update(&scene->transforms);
+
+  BvhBounds *boxes = mem_alloc(scene->object_count * sizeof(BvhBounds));
+  if (boxes == NULL) {
+    scene_destroy(scene);
+    return false;
+  }
+
+  for (uint32_t i = 0; i < scene->object_count; i++) {
+    Vector3 extent = Vector3Scale(Vector3One(), scene->bounds.radius[i]);
+    boxes[i] = (BvhBounds){Vector3Subtract(scene->objects[i].position, extent), Vector3Add(scene->objects[i].position, extent)};
+  }
+
+  bool built = bvh_build(&scene->bvh, boxes, scene->object_count, pool);
+  mem_free(boxes);
+
+  GpuCullInstance *instances = mem_alloc(scene->object_count * sizeof(GpuCullInstance));
+  if (!built || instances == NULL) {
+    mem_free(instances);
+    scene_destroy(scene);
+    return false;
+  }
+
+  for (uint32_t i = 0; i < scene->object_count; i++) {
+    const SceneObject *object = &scene->objects[i];
+    instances[i] = (GpuCullInstance){
+      {object->position.x, object->position.y, object->position.z},
+      scene->mesh_radius * object->scale,
+      {object->color.x, object->color.y, object->color.z},
+      object->scale,
+    };
+  }
+
+  bool ok = gpu_cull_create(&scene->gpu, instances, scene->object_count);
+  mem_free(instances);
+  if (!ok) {
+    scene_destroy(scene);
+    return false;
+  }
+
+  return true;
+}
+
+void scene_destroy(Scene *scene)
+{
+  if (scene->program != 0) glDeleteProgram(scene->program);
+  if (scene->gpu_program != 0) glDeleteProgram(scene->gpu_program);
+  gpu_cull_destroy(&scene->gpu);
+  frame_graph_destroy(&scene->graph);
+  mesh_destroy(&scene->mesh);
+  mem_free(scene->objects);
+  frame_arena_free(&scene->frame);
+  render_queue_free(&scene->queue);
+  cull_spheres_free(&scene->bounds);
+  bvh_free(&scene->bvh);
+  transform_graph_free(&scene->transforms);
+  memset(scene, 0, sizeof(*scene));
+}
+
+void scene_update(Scene *scene, float time, int width, int height)
+{
+  float extent = sqrtf((float)scene->object_count) * SCENE_SPACING;
+  float angle = time * 0.2f;
+
+  scene->camera = (Vector3){cosf(angle) * extent * 0.35f, extent * 0.08f + 4.0f, sinf(angle) * extent * 0.35f};
+  scene->view = MatrixLookAt(scene->camera, (Vector3){0.0f, 0.0f, 0.0f}, (Vector3){0.0f, 1.0f, 0.0f});
+
+  float aspect = height > 0 ? (float)width / (float)height : 1.0f;
+  scene->far_plane = extent * 2.0f;
+  scene->projection = MatrixPerspective(SCENE_FOVY, aspect, 0.1, scene->far_plane);
+  scene->viewport_height = (float)height;
+  scene->frame_width = width;
+  scene->frame_height = height;
+
+  // Free while nothing moves
+  transform_graph_update(&scene->transforms);
+}
+
+typedef struct {
+  Scene *scene;
+  RenderQueue *queue;
+  const LodSelector *selector;
+  Matrix view_projection;
+  atomic_bool ok;
+} SceneRecordJob;
+
+// Records the draws of a range of the visible list into the worker's buffer
+static void scene_record_draws(void *user, uint32_t begin, uint32_t end, uint32_t worker)
+{
+  SceneRecordJob *job = user;
+  Scene *scene = job->scene;
+  RenderBuffer *buffer = render_queue_buffer(job->queue, worker);
+
+  for (uint32_t i = begin; i < end; i++) {
+    const uint32_t index = scene->visible[i];
+    const SceneObject *object = &scene->objects[index];
+
+    RenderCommand command = {
+      .mesh = &scene->mesh,
+      .program = scene->program,
+      .lod = lod_select(job->selector, &scene->mesh, scene->camera, object->position, object->scale),
+      .u_mvp = scene->u_mvp,
+      .u_color = scene->u_color,
+      .mvp = MatrixMultiply(scene->transforms.world[index], job->view_projection),
+      .color = object->color,
+    };
+
+    float depth = Vector3Distance(scene->camera, object->position) / scene->far_plane;
+    uint64_t key = render_key(0, command.program, command.lod, depth);
+    if (!render_buffer_push(buffer, key, &command)) atomic_store_explicit(&job->ok, false, memory_order_relaxed);
+  }
+}
+
+static inline LodSelector scene_lod_selector(const Scene *scene, uint32_t flags)
+{
+  LodSelector selector = lod_selector_create(scene->projection, scene->viewport_height, SCENE_PIXEL_ERROR);
+  selector.enabled = (flags & SCENE_DRAW_LOD) != 0;
+  return selector;
+}
+
+bool scene_record(Scene *scene, uint32_t flags, RenderQueue *queue)
+{
+  render_queue_reset(queue);
+  frame_arena_begin(&scene->frame);
+
+  LodSelector selector = scene_lod_selector(scene, flags);
+  Matrix view_projection = MatrixMultiply(scene->view, scene->projection);
+
+  scene->visible = frame_alloc(&scene->frame, scene->object_count * sizeof(uint32_t));
+  scene->visible_count = 0;
+  if (scene->visible == NULL) return false;
+
+  if ((flags & SCENE_DRAW_CULL) && (flags & SCENE_DRAW_BVH)) {
+    Frustum frustum = frustum_from_matrix(view_projection);
+    scene->visible_count = bvh_query_frustum(&scene->bvh, &frustum, scene->visible, scene->object_count);
+  } else if (flags & SCENE_DRAW_CULL) {
+    Frustum frustum = frustum_from_matrix(view_projection);
+    scene->visible_count = cull_spheres_parallel(scene->pool, &frustum, &scene->bounds, scene->visible);
+  } else {
+    for (uint32_t i = 0; i < scene->object_count; i++) scene->visible[i] = i;
+    scene->visible_count = scene->object_count;
+  }
+
+  SceneRecordJob job = {scene, queue, &selector, view_projection};
+  atomic_init(&job.ok, true);
+  thread_pool_parallel_for(scene->pool, scene->visible_count, SCENE_RECORD_CHUNK, scene_record_draws, &job);
+
+  if (!atomic_load(&job.ok) || !render_queue_sort(queue)) {
+    fprintf(stderr, "[ERROR]: Render queue allocation failed\n");
+    render_queue_reset(queue);
+    return false;
+  }
+  return true;
+}
+
+typedef struct {
+  Scene *scene;
+  const RenderQueue *queue;   // CPU path, NULL for the GPU driven one
+  uint32_t flags;
+  uint32_t color;             // Graph resources
+  uint32_t depth;
+  int32_t width;              // Output size
+  int32_t height;
+  RenderQueueStats stats;
+} SceneFrame;
+
+static void scene_pass(const FrameGraph *graph, uint32_t pass, void *user)
+{
+  SceneFrame *frame = user;
+  Scene *scene = frame->scene;
+
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  glEnable(GL_DEPTH_TEST);
+
+  if (frame->queue != NULL) {
+    frame->stats = render_queue_execute(frame->queue);
+  } else {
+    LodSelector selector = scene_lod_selector(scene, frame->flags);
+    Matrix view_projection = MatrixMultiply(scene->view, scene->projection);
+    gpu_cull_dispatch(&scene->gpu, &scene->mesh, view_projection, scene->camera, &selector, true);
+
+    glUseProgram(scene->gpu_program);
+    glUniformMatrix4fv(scene->u_view_projection, 1, GL_FALSE, MatrixToFloat(view_projection));
+    gpu_cull_draw(&scene->gpu, &scene->mesh);
+  }
+
+  glBindVertexArray(0);
+  glDisable(GL_DEPTH_TEST);
+}
+
+// This frame's depth occludes next frame's instances
+static void scene_pyramid_pass(const FrameGraph *graph, uint32_t pass, void *user)
+{
+  SceneFrame *frame = user;
+  gpu_cull_build_pyramid(&frame->scene->gpu, frame_graph_texture(graph, frame->depth));
+}
+
+static void scene_output_pass(const FrameGraph *graph, uint32_t pass, void *user)
+{
+  SceneFrame *frame = user;
+  const FrameGraphResource *color = &graph->resources[frame->color];
+
+  // The transient seen as a render target, for the blit and upscale helpers
+  RenderTarget source = {
+    .fbo = frame_graph_read_framebuffer(graph),
+    .color = frame_graph_texture(graph, frame->color),
+    .width = color->width,
+    .height = color->height,
+    .alloc_width = color->alloc_width,
+    .alloc_height = color->alloc_height,
+  };
+
+  if (frame->scene->scale == NULL)
+    render_target_blit(&source);
+  else
+    render_scale_upscale(frame->scene->scale, &source, frame->width, frame->height);
+}
+
+static bool scene_run_graph(Scene *scene, SceneFrame *frame)
+{
+  int32_t render_width = frame->width, render_height = frame->height;
+  if (scene->scale != NULL) render_scale_size(scene->scale, frame->width, frame->height, &render_width, &render_height);
+  if (render_width <= 0 || render_height <= 0) return false;
+
+  // The pyramid mirrors the rendered area, not the allocation
+  if (render_width != scene->render_width || render_height != scene->render_height) {
+    gpu_cull_resize(&scene->gpu, render_width, render_height);
+    scene->render_width = render_width;
+    scene->render_height = render_height;
+  }
+
+  FrameGraph *graph = &scene->graph;
+  frame_graph_reset(graph);
+  frame->color = frame_graph_create_texture(graph, "scene color", GL_RGBA8, render_width, render_height);
+  frame->depth = frame_graph_create_texture(graph, "scene depth", GL_DEPTH_COMPONENT32F, render_width, render_height);
+  uint32_t backbuffer = frame_graph_import_backbuffer(graph, frame->width, frame->height);
+
+  uint32_t pass = frame_graph_add_pass(graph, "scene", 0, scene_pass, frame);
+  frame_graph_write(graph, pass, frame->color, FRAME_GRAPH_ATTACHMENT);
+  frame_graph_write(graph, pass, frame->depth, FRAME_GRAPH_ATTACHMENT);
+
+  if (frame->queue == NULL) {
+    uint32_t pyramid = frame_graph_import_texture(
+      graph, "hi-z pyramid", scene->gpu.pyramid, GL_R32F, scene->gpu.pyramid_width, scene->gpu.pyramid_height
+    );
+    pass = frame_graph_add_pass(graph, "hi-z", 0, scene_pyramid_pass, frame);
+    frame_graph_read(graph, pass, frame->depth, FRAME_GRAPH_SAMPLED);
+    frame_graph_write(graph, pass, pyramid, FRAME_GRAPH_IMAGE);
+  }
+
+  // Blits read the color through a framebuffer, the sharpening upscale samples it
+  pass = frame_graph_add_pass(graph, "output", 0, scene_output_pass, frame);
+  frame_graph_read(graph, pass, frame->color, FRAME_GRAPH_TRANSFER);
+  if (scene->scale != NULL) frame_graph_read(graph, pass, frame->color, FRAME_GRAPH_SAMPLED);
+  frame_graph_write(graph, pass, backbuffer, FRAME_GRAPH_TRANSFER);
+
+  // The upscale is part of the frame's GPU cost, time it too
+  if (scene->scale != NULL) render_scale_begin(scene->scale);
+  bool ok = frame_graph_compile(graph) && frame_graph_execute(graph, scene->textures);
+  if (scene->scale != NULL) render_scale_end(scene->scale);
+
+  if (!ok) fprintf(stderr, "[ERROR]: Scene frame graph execution failed\n");
+  return ok;
+}
+
+RenderQueueStats scene_submit(Scene *scene, const RenderQueue *queue, int width, int height)
+{
+  SceneFrame frame = {.scene = scene, .queue = queue, .width = width, .height = height};
+  scene_run_graph(scene, &frame);
+  return frame.stats;
+}
+
+static void scene_draw_gpu(Scene *scene, uint32_t flags, Bench *bench)
+{
+  SceneFrame frame = {.scene = scene, .flags = flags, .width = scene->frame_width, .height = scene->frame_height};
+  if (!scene_run_graph(scene, &frame)) return;
+
+  if (bench) {
+    GpuCullStats stats = gpu_cull_stats(&scene->gpu);
+    bench_count_draws(bench, stats.draws, stats.triangles);
+  }
+}
+
+void scene_draw(Scene *scene, uint32_t flags, Bench *bench)
+{
+  if (flags & SCENE_DRAW_GPU) {
+    scene_draw_gpu(scene, flags, bench);
+    return;
+  }
+
+  if (!scene_record(scene, flags, &scene->queue)) return;
+
+  RenderQueueStats stats = scene_submit(scene, &scene->queue, scene->frame_width, scene->frame_height);
+  if (bench) bench_count_draws(bench, stats.draws, stats.triangles);
+}
+
+static bool scene_ray_sphere(void *user, uint32_t primitive, Vector3 origin, Vector3 direction, float *t)
+{
+  const Scene *scene = user;
+  const CullSpheres *spheres = &scene->bounds;
+  Vector3 center = {spheres->x[primitive], spheres->y[primitive], spheres->z[primitive]};
+  float radius = spheres->radius[primitive];
+
+  // direction is normalized: t^2 + 2bt + c = 0
+  Vector3 oc = Vector3Subtract(origin, center);
+  float b = Vector3DotProduct(oc, direction);
+  float c = Vector3DotProduct(oc, oc) - radius * radius;
+  float discriminant = b * b - c;
+  if (discriminant < 0.0f) return false;
+
+  float root = sqrtf(discriminant);
+  float hit = -b - root;
+  if (hit < 0.0f) hit = -b + root;
+  if (hit < 0.0f) return false;
+
+  *t = hit;
+  return true;
+}
+
+bool scene_pick(const Scene *scene, Vector3 origin, Vector3 direction, uint32_t *object)
+{
+  BvhHit hit;
+  Vector3 dir = Vector3Normalize(direction);
+  if (!bvh_raycast(&scene->bvh, origin, dir, FLT_MAX, scene_ray_sphere, (void *)scene, &hit)) return false;
+
+  *object = hit.primitive;
+  return true;
+}
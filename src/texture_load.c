@@ -0,0 +1,265 @@
+#include <texture_load.h>
+
+#include <glad/glad.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <stdatomic.h>
+
+#include <stb_image.h>
+
+#include <allocator.h>
+#include <image_ops.h>
+#include <jpeg_split.h>
+#include <platform.h>
+
+// Rows per conversion job of whole image decodes
+#define TEXTURE_CONVERT_ROWS 64
+// Bands are handed out dynamically, a few per thread evens out bands of uneven cost
+#define TEXTURE_BANDS_PER_THREAD 2
+
+typedef struct {
+  const TextureImage *image;
+  bool flip;
+  int channels;               // Of the decoded rows, 3 or 4
+  uint8_t *rgba;              // Final image, or the staging one before linearization
+  float *linear;
+
+  const uint8_t *decoded;     // Whole image decodes
+  const JpegSplit *split;     // Banded decodes
+  const uint32_t *boundaries;
+  atomic_uint failures;
+} TextureConvert;
+
+static inline uint32_t texture_mip_levels(int32_t width, int32_t height)
+{
+  uint32_t levels = 1;
+  for (int32_t size = width > height ? width : height; size > 1; size >>= 1) levels++;
+  return levels;
+}
+
+// Top down rows [first_row, first_row + rows) of src, flipped rows land reversed at the mirrored position
+static void texture_convert_rows(const TextureConvert *convert, const uint8_t *src, uint32_t first_row, uint32_t rows)
+{
+  int32_t width = convert->image->width;
+  uint32_t height = (uint32_t)convert->image->height;
+  uint32_t flags = convert->image->flags;
+  size_t stride = (size_t)width * 4;
+
+  uint32_t dst_row = convert->flip ? height - first_row - rows : first_row;
+  uint8_t *dst = convert->rgba + dst_row * stride;
+
+  if (convert->channels == 3) {
+    image_rgb_to_rgba(dst, stride, src, (size_t)width * 3, width, (int32_t)rows, convert->flip);
+  } else if (src != dst) {
+    for (uint32_t y = 0; y < rows; y++)
+      memcpy(dst + (convert->flip ? rows - 1 - y : y) * stride, src + y * stride, stride);
+  }
+
+  size_t count = (size_t)width * rows;
+  if (flags & TEXTURE_LOAD_PREMULTIPLY) image_premultiply_alpha(dst, count);
+  if (flags & TEXTURE_LOAD_LINEAR)
+    image_srgb_to_linear(convert->linear + (size_t)dst_row * width * 4, dst, count);
+  else if (flags & TEXTURE_LOAD_BGRA)
+    image_swap_red_blue(dst, count);
+}
+
+static void texture_convert_range(void *user, uint32_t begin, uint32_t end, uint32_t worker)
+{
+  const TextureConvert *convert = user;
+  size_t src_stride = (size_t)convert->image->width * convert->channels;
+  texture_convert_rows(convert, convert->decoded + begin * src_stride, begin, end - begin);
+}
+
+// Each band is decoded as a standalone JPEG and converted straight into the final image
+static void texture_decode_bands(void *user, uint32_t begin, uint32_t end, uint32_t worker)
+{
+  TextureConvert *convert = user;
+  int32_t width = convert->image->width;
+  stbi_set_flip_vertically_on_load_thread(0);
+
+  for (uint32_t b = begin; b < end; b++) {
+    JpegBand band;
+    size_t size;
+    uint8_t *stream = jpeg_split_band(convert->split, convert->boundaries[b], convert->boundaries[b + 1], &band, &size);
+
+    int band_width = 0, band_height = 0, channels;
+    uint8_t *pixels = stream != NULL
+      ? stbi_load_from_memory(stream, (int)size, &band_width, &band_height, &channels, convert->channels)
+      : NULL;
+    mem_free(stream);
+
+    if (pixels == NULL || band_width != width || (uint32_t)band_height < band.skip_rows + band.row_count) {
+      atomic_fetch_add_explicit(&convert->failures, 1, memory_order_relaxed);
+    } else {
+      const uint8_t *rows = pixels + (size_t)band.skip_rows * width * convert->channels;
+      texture_convert_rows(convert, rows, band.first_row, band.row_count);
+    }
+    stbi_image_free(pixels);
+  }
+}
+
+bool texture_decode(TextureImage *image, const char *path, uint32_t flags, ThreadPool *pool)
+{
+  memset(image, 0, sizeof(*image));
+
+  PlatformFileMap map;
+  if (!platform_map_file(&map, path)) return false;
+  const uint8_t *file = map.data;
+
+  // The flip is ours, fused with the expansion, the flag is per thread so other decodes keep theirs
+  stbi_set_flip_vertically_on_load_thread(0);
+
+  int width, height, channels;
+  if (map.size > INT_MAX || !stbi_info_from_memory(file, (int)map.size, &width, &height, &channels)) {
+    fprintf(stderr, "[ERROR]: \"%s\": %s\n", path, map.size > INT_MAX ? "too large" : stbi_failure_reason());
+    platform_unmap_file(&map);
+    return false;
+  }
+
+  image->width = width;
+  image->height = height;
+  image->flags = flags;
+  image->bands = 1;
+
+  double start = platform_time();
+  size_t count = (size_t)width * (size_t)height;
+  TextureConvert convert = {.image = image, .flip = (flags & TEXTURE_LOAD_FLIP) != 0, .channels = channels == 3 ? 3 : 4};
+  atomic_init(&convert.failures, 0);
+
+  // Large JPEGs with restart markers decode as bands on the pool, anything else as a whole
+  JpegSplit split;
+  uint32_t boundaries[TEXTURE_MAX_BANDS + 1];
+  uint32_t threads = pool != NULL ? thread_pool_size(pool) : 1;
+  bool banded = threads > 1 && count >= TEXTURE_SPLIT_MIN_PIXELS && jpeg_split_parse(&split, file, map.size);
+  if (banded) {
+    uint32_t max_bands = threads * TEXTURE_BANDS_PER_THREAD;
+    image->bands = jpeg_split_bands(&split, max_bands < TEXTURE_MAX_BANDS ? max_bands : TEXTURE_MAX_BANDS, boundaries);
+    if (image->bands == 1) {
+      jpeg_split_free(&split);
+      banded = false;
+    }
+  }
+
+  uint8_t *decoded = NULL;
+  if (!banded) {
+    decoded = stbi_load_from_memory(file, (int)map.size, &width, &height, &channels, convert.channels);
+    if (decoded == NULL) {
+      fprintf(stderr, "[ERROR]: \"%s\": %s\n", path, stbi_failure_reason());
+      platform_unmap_file(&map);
+      return false;
+    }
+  }
+  double decoded_time = platform_time();
+
+  // 4 channel whole decodes are converted in place
+  bool in_place = decoded != NULL && convert.channels == 4;
+  convert.rgba = in_place ? decoded : mem_alloc(count * 4);
+  convert.linear = (flags & TEXTURE_LOAD_LINEAR) ? mem_alloc(count * 4 * sizeof(float)) : NULL;
+  bool ok = convert.rgba != NULL && (convert.linear != NULL || !(flags & TEXTURE_LOAD_LINEAR));
+
+  if (ok && banded) {
+    convert.split = &split;
+    convert.boundaries = boundaries;
+    thread_pool_parallel_for(pool, image->bands, 1, texture_decode_bands, &convert);
+    uint32_t failures = atomic_load(&convert.failures);
+    if (failures > 0) {
+      fprintf(stderr, "[ERROR]: \"%s\": %u of %u bands failed to decode\n", path, failures, image->bands);
+      ok = false;
+    }
+  } else if (ok) {
+    // Rows are converted in place, so the flip can't be done per row range
+    if (in_place && convert.flip) {
+      image_flip_vertical(decoded, (size_t)width * 4, height);
+      convert.flip = false;
+    }
+    convert.decoded = decoded;
+    thread_pool_parallel_for(pool, (uint32_t)height, TEXTURE_CONVERT_ROWS, texture_convert_range, &convert);
+  }
+
+  if (banded) jpeg_split_free(&split);
+  platform_unmap_file(&map);
+  if (!in_place) stbi_image_free(decoded);
+
+  // The RGBA image is only staging for linear float ones
+  if (!ok || (flags & TEXTURE_LOAD_LINEAR)) {
+    if (in_place) stbi_image_free(convert.rgba); else mem_free(convert.rgba);
+  }
+  if (!ok) {
+    mem_free(convert.linear);
+    return false;
+  }
+
+  if (flags & TEXTURE_LOAD_LINEAR) {
+    image->pixels = convert.linear;
+    image->size = count * 4 * sizeof(float);
+  } else {
+    image->pixels = convert.rgba;
+    image->size = count * 4;
+    image->from_stb = in_place;
+  }
+
+  // Banded decodes convert each band as it is decoded, it all counts as decoding
+  double end = platform_time();
+  image->decode_ms = (decoded_time - start) * 1000.0;
+  image->convert_ms = (end - decoded_time) * 1000.0;
+  if (banded) {
+    image->decode_ms += image->convert_ms;
+    image->convert_ms = 0.0;
+  }
+  return true;
+}
+
+void texture_image_free(TextureImage *image)
+{
+  if (image->from_stb)
+    stbi_image_free(image->pixels);
+  else
+    mem_free(image->pixels);
+  image->pixels = NULL;
+}
+
+uint32_t texture_upload(const TextureImage *image)
+{
+  bool linear = (image->flags & TEXTURE_LOAD_LINEAR) != 0;
+  GLenum internal_format = linear ? GL_RGBA16F : (image->flags & TEXTURE_LOAD_SRGB) ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+  GLenum format = !linear && (image->flags & TEXTURE_LOAD_BGRA) ? GL_BGRA : GL_RGBA;
+  GLenum type = linear ? GL_FLOAT : GL_UNSIGNED_BYTE;
+  bool mipmaps = (image->flags & TEXTURE_LOAD_MIPMAPS) != 0;
+
+  uint32_t texture;
+  glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+  if (texture == 0) return 0;
+
+  glTextureStorage2D(texture, mipmaps ? texture_mip_levels(image->width, image->height) : 1,
+                     internal_format, image->width, image->height);
+
+  // Rows are tightly packed and 4 byte aligned, the default unpack state
+  glTextureSubImage2D(texture, 0, 0, 0, image->width, image->height, format, type, image->pixels);
+
+  glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  if (mipmaps) glGenerateTextureMipmap(texture);
+  return texture;
+}
+
+bool texture_load_job(void *user)
+{
+  TextureLoad *load = user;
+
+  TextureImage image;
+  if (!texture_decode(&image, load->path, load->flags, load->pool)) return false;
+
+  double start = platform_time();
+  load->texture = texture_upload(&image);
+  load->upload_ms = (platform_time() - start) * 1000.0;
+
+  load->width = image.width;
+  load->height = image.height;
+  load->decode_ms = image.decode_ms;
+  load->convert_ms = image.convert_ms;
+  load->bands = image.bands;
+  texture_image_free(&image);
+  return load->texture != 0;
+}
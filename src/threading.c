@@ -0,0 +1,247 @@
+#include <threading.h>
+#include <platform.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#if defined(_WIN32)
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+typedef struct {
+  ThreadFn fn;
+  void *user;
+} ThreadStart;
+
+static DWORD WINAPI thread_entry(LPVOID param)
+{
+  ThreadStart start = *(ThreadStart *)param;
+  free(param);
+  start.fn(start.user);
+  return 0;
+}
+
+bool thread_create(Thread *thread, ThreadFn fn, void *user)
+{
+  ThreadStart *start = malloc(sizeof(ThreadStart));
+  if (start == NULL) return false;
+  start->fn = fn;
+  start->user = user;
+
+  thread->handle = CreateThread(NULL, 0, thread_entry, start, 0, NULL);
+  if (thread->handle == NULL) {
+    fprintf(stderr, "[ERROR]: Could not create thread (error %lu)\n", GetLastError());
+    free(start);
+    return false;
+  }
+  return true;
+}
+
+void thread_join(Thread *thread)
+{
+  WaitForSingleObject(thread->handle, INFINITE);
+  CloseHandle(thread->handle);
+  thread->handle = NULL;
+}
+
+void mutex_init(Mutex *mutex)      { InitializeSRWLock((PSRWLOCK)&mutex->handle); }
+void mutex_destroy(Mutex *mutex)   { (void)mutex; }
+void mutex_lock(Mutex *mutex)      { AcquireSRWLockExclusive((PSRWLOCK)&mutex->handle); }
+void mutex_unlock(Mutex *mutex)    { ReleaseSRWLockExclusive((PSRWLOCK)&mutex->handle); }
+
+void cond_init(Cond *cond)         { InitializeConditionVariable((PCONDITION_VARIABLE)&cond->handle); }
+void cond_destroy(Cond *cond)      { (void)cond; }
+void cond_signal(Cond *cond)       { WakeConditionVariable((PCONDITION_VARIABLE)&cond->handle); }
+void cond_broadcast(Cond *cond)    { WakeAllConditionVariable((PCONDITION_VARIABLE)&cond->handle); }
+
+void cond_wait(Cond *cond, Mutex *mutex)
+{
+  SleepConditionVariableSRW((PCONDITION_VARIABLE)&cond->handle, (PSRWLOCK)&mutex->handle, INFINITE, 0);
+}
+
+#else   // POSIX
+
+typedef struct {
+  ThreadFn fn;
+  void *user;
+} ThreadStart;
+
+static void *thread_entry(void *param)
+{
+  ThreadStart start = *(ThreadStart *)param;
+  free(param);
+  start.fn(start.user);
+  return NULL;
+}
+
+bool thread_create(Thread *thread, ThreadFn fn, void *user)
+{
+  ThreadStart *start = malloc(sizeof(ThreadStart));
+  if (start == NULL) return false;
+  start->fn = fn;
+  start->user = user;
+
+  if (pthread_create(&thread->handle, NULL, thread_entry, start) != 0) {
+    fprintf(stderr, "[ERROR]: Could not create thread\n");
+    free(start);
+    return false;
+  }
+  return true;
+}
+
+void thread_join(Thread *thread)
+{
+  pthread_join(thread->handle, NULL);
+}
+
+void mutex_init(Mutex *mutex)      { pthread_mutex_init(&mutex->handle, NULL); }
+void mutex_destroy(Mutex *mutex)   { pthread_mutex_destroy(&mutex->handle); }
+void mutex_lock(Mutex *mutex)      { pthread_mutex_lock(&mutex->handle); }
+void mutex_unlock(Mutex *mutex)    { pthread_mutex_unlock(&mutex->handle); }
+
+void cond_init(Cond *cond)         { pthread_cond_init(&cond->handle, NULL); }
+void cond_destroy(Cond *cond)      { pthread_cond_destroy(&cond->handle); }
+void cond_signal(Cond *cond)       { pthread_cond_signal(&cond->handle); }
+void cond_broadcast(Cond *cond)    { pthread_cond_broadcast(&cond->handle); }
+
+void cond_wait(Cond *cond, Mutex *mutex)
+{
+  pthread_cond_wait(&cond->handle, &mutex->handle);
+}
+
+#endif  //!_WIN32
+
+// Thread pool
+
+typedef struct {
+  ThreadPool *pool;
+  uint32_t index;
+} ThreadPoolWorker;
+
+struct ThreadPool {
+  Thread threads[THREAD_POOL_MAX_WORKERS];
+  ThreadPoolWorker workers[THREAD_POOL_MAX_WORKERS];
+  uint32_t thread_count;
+
+  Mutex mutex;
+  Cond wake;
+  Cond done;
+  uint64_t generation;  // Bumped for every published job
+  uint32_t busy;        // Pool threads still inside the current job
+  bool quit;
+
+  // Current job, written under mutex before generation is bumped
+  ThreadPoolFn fn;
+  void *user;
+  uint32_t count;
+  uint32_t chunk;
+  atomic_uint next;
+};
+
+static void thread_pool_run(ThreadPool *pool, uint32_t worker)
+{
+  for (;;) {
+    uint32_t begin = atomic_fetch_add_explicit(&pool->next, pool->chunk, memory_order_relaxed);
+    if (begin >= pool->count) break;
+
+    uint32_t end = pool->count - begin < pool->chunk ? pool->count : begin + pool->chunk;
+    pool->fn(pool->user, begin, end, worker);
+  }
+}
+
+static void thread_pool_worker(void *user)
+{
+  ThreadPoolWorker *worker = user;
+  ThreadPool *pool = worker->pool;
+  uint64_t seen = 0;
+
+  mutex_lock(&pool->mutex);
+  for (;;) {
+    while (!pool->quit && pool->generation == seen) cond_wait(&pool->wake, &pool->mutex);
+    if (pool->quit) break;
+    seen = pool->generation;
+    mutex_unlock(&pool->mutex);
+
+    thread_pool_run(pool, worker->index);
+
+    mutex_lock(&pool->mutex);
+    if (--pool->busy == 0) cond_signal(&pool->done);
+  }
+  mutex_unlock(&pool->mutex);
+}
+
+ThreadPool *thread_pool_create(uint32_t thread_count)
+{
+  if (thread_count == 0) thread_count = platform_cpu_count() - 1;
+  if (thread_count > THREAD_POOL_MAX_WORKERS) thread_count = THREAD_POOL_MAX_WORKERS;
+
+  ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+  if (pool == NULL) return NULL;
+
+  mutex_init(&pool->mutex);
+  cond_init(&pool->wake);
+  cond_init(&pool->done);
+  atomic_init(&pool->next, 0);
+
+  for (uint32_t i = 0; i < thread_count; i++) {
+    pool->workers[i] = (ThreadPoolWorker){pool, i + 1};
+    if (!thread_create(&pool->threads[i], thread_pool_worker, &pool->workers[i])) break;
+    pool->thread_count++;
+  }
+
+  return pool;
+}
+
+void thread_pool_destroy(ThreadPool *pool)
+{
+  if (pool == NULL) return;
+
+  mutex_lock(&pool->mutex);
+  pool->quit = true;
+  cond_broadcast(&pool->wake);
+  mutex_unlock(&pool->mutex);
+
+  for (uint32_t i = 0; i < pool->thread_count; i++) thread_join(&pool->threads[i]);
+
+  cond_destroy(&pool->done);
+  cond_destroy(&pool->wake);
+  mutex_destroy(&pool->mutex);
+  free(pool);
+}
+
+uint32_t thread_pool_size(const ThreadPool *pool)
+{
+  return pool ? pool->thread_count + 1 : 1;
+}
+
+void thread_pool_parallel_for(ThreadPool *pool, uint32_t count, uint32_t chunk, ThreadPoolFn fn, void *user)
+{
+  if (count == 0) return;
+  if (chunk == 0) chunk = 1;
+
+  // Not worth waking anyone for a single chunk
+  if (pool == NULL || pool->thread_count == 0 || count <= chunk) {
+    for (uint32_t begin = 0; begin < count; begin += chunk)
+      fn(user, begin, count - begin < chunk ? count : begin + chunk, 0);
+    return;
+  }
+
+  mutex_lock(&pool->mutex);
+  pool->fn = fn;
+  pool->user = user;
+  pool->count = count;
+  pool->chunk = chunk;
+  atomic_store_explicit(&pool->next, 0, memory_order_relaxed);
+  pool->busy = pool->thread_count;
+  pool->generation++;
+  cond_broadcast(&pool->wake);
+  mutex_unlock(&pool->mutex);
+
+  thread_pool_run(pool, 0);
+
+  mutex_lock(&pool->mutex);
+  while (pool->busy > 0) cond_wait(&pool->done, &pool->mutex);
+  mutex_unlock(&pool->mutex);
+}
@@ -0,0 +1,177 @@
+#include <transform.h>
+#include <allocator.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+static inline void transform_mark(TransformGraph *graph, uint32_t node)
+{
+  graph->dirty[node] = 1;
+  if (node < graph->first_dirty) graph->first_dirty = node;
+}
+
+static bool transform_graph_grow(TransformGraph *graph, uint32_t capacity)
+{
+  uint32_t *parents = mem_realloc(graph->parents, capacity * sizeof(uint32_t));
+  if (parents) graph->parents = parents;
+  Vector3 *translations = mem_realloc(graph->translations, capacity * sizeof(Vector3));
+  if (translations) graph->translations = translations;
+  Quaternion *rotations = mem_realloc(graph->rotations, capacity * sizeof(Quaternion));
+  if (rotations) graph->rotations = rotations;
+  Vector3 *scales = mem_realloc(graph->scales, capacity * sizeof(Vector3));
+  if (scales) graph->scales = scales;
+  Matrix *world = mem_realloc(graph->world, capacity * sizeof(Matrix));
+  if (world) graph->world = world;
+  uint8_t *dirty = mem_realloc(graph->dirty, capacity * sizeof(uint8_t));
+  if (dirty) graph->dirty = dirty;
+
+  // Arrays that did grow are simply larger than needed on failure
+  if (!parents || !translations || !rotations || !scales || !world || !dirty) return false;
+
+  graph->capacity = capacity;
+  return true;
+}
+
+bool transform_graph_init(TransformGraph *graph, uint32_t capacity)
+{
+  memset(graph, 0, sizeof(*graph));
+  if (capacity == 0) capacity = 64;
+
+  if (!transform_graph_grow(graph, capacity)) {
+    transform_graph_free(graph);
+    return false;
+  }
+  return true;
+}
+
+void transform_graph_free(TransformGraph *graph)
+{
+  mem_free(graph->parents);
+  mem_free(graph->translations);
+  mem_free(graph->rotations);
+  mem_free(graph->scales);
+  mem_free(graph->world);
+  mem_free(graph->dirty);
+  memset(graph, 0, sizeof(*graph));
+}
+
+uint32_t transform_add(TransformGraph *graph, uint32_t parent, Vector3 translation, Quaternion rotation, Vector3 scale)
+{
+  if (parent != TRANSFORM_NONE && parent >= graph->count) return TRANSFORM_NONE;
+  if (graph->count == graph->capacity && !transform_graph_grow(graph, graph->capacity * 2)) return TRANSFORM_NONE;
+
+  uint32_t node = graph->count++;
+  graph->parents[node] = parent;
+  graph->translations[node] = translation;
+  graph->rotations[node] = rotation;
+  graph->scales[node] = scale;
+  graph->world[node] = MatrixIdentity();
+  transform_mark(graph, node);
+  return node;
+}
+
+void transform_set_local(TransformGraph *graph, uint32_t node, Vector3 translation, Quaternion rotation, Vector3 scale)
+{
+  graph->translations[node] = translation;
+  graph->rotations[node] = rotation;
+  graph->scales[node] = scale;
+  transform_mark(graph, node);
+}
+
+void transform_set_translation(TransformGraph *graph, uint32_t node, Vector3 translation)
+{
+  graph->translations[node] = translation;
+  transform_mark(graph, node);
+}
+
+void transform_set_rotation(TransformGraph *graph, uint32_t node, Quaternion rotation)
+{
+  graph->rotations[node] = rotation;
+  transform_mark(graph, node);
+}
+
+void transform_set_scale(TransformGraph *graph, uint32_t node, Vector3 scale)
+{
+  graph->scales[node] = scale;
+  transform_mark(graph, node);
+}
+
+void transform_graph_update(TransformGraph *graph)
+{
+  graph->changed_begin = graph->changed_end = 0;
+  if (graph->first_dirty >= graph->count) return;
+
+  uint32_t begin = graph->first_dirty;
+  uint32_t end = begin;
+
+  // Parents come first, so a parent's flag is final by the time its children are visited
+  for (uint32_t i = begin; i < graph->count; i++) {
+    uint32_t parent = graph->parents[i];
+    if (!graph->dirty[i] && (parent == TRANSFORM_NONE || !graph->dirty[parent])) continue;
+
+    graph->dirty[i] = 1;
+    Matrix local = MatrixCompose(graph->translations[i], graph->rotations[i], graph->scales[i]);
+    graph->world[i] = parent == TRANSFORM_NONE ? local : MatrixMultiply(local, graph->world[parent]);
+    end = i + 1;
+  }
+
+  memset(graph->dirty + begin, 0, graph->count - begin);
+  graph->first_dirty = graph->count;
+  graph->changed_begin = begin;
+  graph->changed_end = end;
+}
+
+bool transform_graph_sort(TransformGraph *graph, uint32_t *remap)
+{
+  const uint32_t count = graph->count;
+  if (count == 0) return true;
+
+  uint32_t *depth = mem_alloc(count * sizeof(uint32_t));
+  uint32_t *order = mem_alloc(count * sizeof(uint32_t));
+  uint32_t *offsets = mem_calloc(count + 1, sizeof(uint32_t));
+  void *scratch = mem_alloc(count * sizeof(Matrix));
+  if (depth == NULL || order == NULL || offsets == NULL || scratch == NULL) {
+    mem_free(depth); mem_free(order); mem_free(offsets); mem_free(scratch);
+    return false;
+  }
+
+  // Counting sort on depth keeps the relative order inside a level
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t parent = graph->parents[i];
+    depth[i] = parent == TRANSFORM_NONE ? 0 : depth[parent] + 1;
+    offsets[depth[i] + 1]++;
+  }
+  for (uint32_t d = 0; d < count; d++) offsets[d + 1] += offsets[d];
+  for (uint32_t i = 0; i < count; i++) order[offsets[depth[i]]++] = i;
+
+  // depth now holds old -> new
+  for (uint32_t i = 0; i < count; i++) depth[order[i]] = i;
+
+  uint32_t *parents = scratch;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t parent = graph->parents[order[i]];
+    parents[i] = parent == TRANSFORM_NONE ? TRANSFORM_NONE : depth[parent];
+  }
+  memcpy(graph->parents, parents, count * sizeof(uint32_t));
+
+#define TRANSFORM_PERMUTE(array, type) do {                          \
+    type *tmp = scratch;                                             \
+    for (uint32_t i = 0; i < count; i++) tmp[i] = graph->array[order[i]]; \
+    memcpy(graph->array, tmp, count * sizeof(type));                 \
+  } while (0)
+
+  TRANSFORM_PERMUTE(translations, Vector3);
+  TRANSFORM_PERMUTE(rotations, Quaternion);
+  TRANSFORM_PERMUTE(scales, Vector3);
+  TRANSFORM_PERMUTE(world, Matrix);
+
+#undef TRANSFORM_PERMUTE
+
+  if (remap != NULL) memcpy(remap, depth, count * sizeof(uint32_t));
+
+  memset(graph->dirty, 1, count);
+  graph->first_dirty = 0;
+
+  mem_free(depth); mem_free(order); mem_free(offsets); mem_free(scratch);
+  return true;
+}
@@ -0,0 +1,393 @@
+#include <vertex_format.h>
+#include <glad/glad.h>
+
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VERTEX_FORMAT_SSE2
+#endif
+
+#if defined(__F16C__) && defined(__AVX__)
+#include <immintrin.h>
+#define VERTEX_FORMAT_F16C
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define VERTEX_FORMAT_NEON
+#endif
+
+static const VertexFormatInfo vertex_format_table[VERTEX_FORMAT_COUNT] = {
+  [VERTEX_FORMAT_FLOAT32]         = {"FLOAT32",  GL_FLOAT,                 4, 0, false},
+  [VERTEX_FORMAT_HALF16]          = {"HALF16",   GL_HALF_FLOAT,            2, 0, false},
+  [VERTEX_FORMAT_UNORM8]          = {"UNORM8",   GL_UNSIGNED_BYTE,         1, 0, true },
+  [VERTEX_FORMAT_SNORM8]          = {"SNORM8",   GL_BYTE,                  1, 0, true },
+  [VERTEX_FORMAT_SNORM10_10_10_2] = {"SNORM10",  GL_INT_2_10_10_10_REV,    0, 4, true },
+};
+
+const VertexFormatInfo *vertex_format_info(VertexFormat format)
+{
+  if (format >= VERTEX_FORMAT_COUNT) return NULL;
+  return &vertex_format_table[format];
+}
+
+static inline uint32_t vertex_attrib_raw_size(VertexAttribFormat attrib)
+{
+  const VertexFormatInfo *info = &vertex_format_table[attrib.format];
+  return info->packed_size ? info->packed_size : info->component_size * attrib.components;
+}
+
+uint32_t vertex_attrib_size(VertexAttribFormat attrib)
+{
+  return (vertex_attrib_raw_size(attrib) + 3u) & ~3u;
+}
+
+uint32_t vertex_attrib_gl_size(VertexAttribFormat attrib)
+{
+  return vertex_format_table[attrib.format].packed_size ? 4 : attrib.components;
+}
+
+// Scalar Conversions
+
+static inline uint32_t f32_bits(float f)   { uint32_t u; memcpy(&u, &f, 4); return u; }
+static inline float    f32_from(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
+
+/*
+  Round-to-nearest-even float -> half, handles denormals, inf and NaN.
+  Same algorithm as the SSE2 kernel below, one lane at a time.
+*/
+static inline uint16_t f32_to_f16(float value)
+{
+  uint32_t x = f32_bits(value);
+  uint32_t sign = x & 0x80000000u;
+  uint32_t out;
+  x ^= sign;
+
+  if (x >= 0x47800000u) {
+    out = (x > 0x7f800000u) ? 0x7e00u : 0x7c00u;
+  } else if (x < 0x38800000u) {
+    const float denorm_magic = 0.5f;
+    out = f32_bits(f32_from(x) + denorm_magic) - f32_bits(denorm_magic);
+  } else {
+    uint32_t mant_odd = (x >> 13) & 1u;
+    x += ((uint32_t)(15 - 127) << 23) + 0xfffu;
+    x += mant_odd;
+    out = x >> 13;
+  }
+
+  return (uint16_t)(out | (sign >> 16));
+}
+
+static inline float f16_to_f32(uint16_t half)
+{
+  const uint32_t shifted_exp = 0x7c00u << 13;
+  uint32_t out = ((uint32_t)half & 0x7fffu) << 13;
+  uint32_t exp = out & shifted_exp;
+  out += (uint32_t)(127 - 15) << 23;
+
+  if (exp == shifted_exp) {
+    out += (uint32_t)(128 - 16) << 23;
+  } else if (exp == 0) {
+    out += 1u << 23;
+    out = f32_bits(f32_from(out) - f32_from(113u << 23));
+  }
+
+  return f32_from(out | (((uint32_t)half & 0x8000u) << 16));
+}
+
+static inline float clampf(float v, float lo, float hi)
+{
+  return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static inline int32_t snorm_quantize(float v, float scale)
+{
+  return (int32_t)lrintf(clampf(v, -1.0f, 1.0f) * scale);
+}
+
+// Contiguous Kernels
+
+void vertex_convert_f32_to_f16(uint16_t *dst, const float *src, size_t count)
+{
+  size_t i = 0;
+
+#if defined(VERTEX_FORMAT_F16C)
+  for (; i + 8 <= count; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128((__m128i *)(dst + i), h);
+  }
+#elif defined(VERTEX_FORMAT_NEON)
+  for (; i + 4 <= count; i += 4) {
+    vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+  }
+#elif defined(VERTEX_FORMAT_SSE2)
+  const __m128i sign_mask    = _mm_set1_epi32((int)0x80000000u);
+  const __m128i overflow     = _mm_set1_epi32(0x477fffff);
+  const __m128i infinity     = _mm_set1_epi32(0x7f800000);
+  const __m128i denorm_limit = _mm_set1_epi32(0x38800000);
+  const __m128  denorm_magic = _mm_set1_ps(0.5f);
+  const __m128i rebias       = _mm_set1_epi32((int)(((uint32_t)(15 - 127) << 23) + 0xfffu));
+  const __m128i one          = _mm_set1_epi32(1);
+  const __m128i half_inf     = _mm_set1_epi32(0x7c00);
+  const __m128i half_qnan    = _mm_set1_epi32(0x0200);
+
+  for (; i + 8 <= count; i += 8) {
+    __m128i packed[2];
+
+    for (int j = 0; j < 2; j++) {
+      __m128i x    = _mm_castps_si128(_mm_loadu_ps(src + i + j * 4));
+      __m128i sign = _mm_and_si128(x, sign_mask);
+      x = _mm_xor_si128(x, sign);
+
+      __m128i normal = _mm_add_epi32(x, rebias);
+      normal = _mm_add_epi32(normal, _mm_and_si128(_mm_srli_epi32(x, 13), one));
+      normal = _mm_srli_epi32(normal, 13);
+
+      __m128i denorm = _mm_sub_epi32(
+        _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(x), denorm_magic)),
+        _mm_castps_si128(denorm_magic)
+      );
+
+      __m128i is_nan = _mm_cmpgt_epi32(x, infinity);
+      __m128i special = _mm_or_si128(half_inf, _mm_and_si128(is_nan, half_qnan));
+
+      __m128i is_over   = _mm_cmpgt_epi32(x, overflow);
+      __m128i is_denorm = _mm_cmplt_epi32(x, denorm_limit);
+
+      __m128i r = _mm_or_si128(_mm_andnot_si128(is_denorm, normal), _mm_and_si128(is_denorm, denorm));
+      r = _mm_or_si128(_mm_andnot_si128(is_over, r), _mm_and_si128(is_over, special));
+      r = _mm_or_si128(r, _mm_srli_epi32(sign, 16));
+
+      // Sign extend so the signed saturating pack keeps all 16 bits
+      packed[j] = _mm_srai_epi32(_mm_slli_epi32(r, 16), 16);
+    }
+
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(packed[0], packed[1]));
+  }
+#endif
+
+  for (; i < count; i++) dst[i] = f32_to_f16(src[i]);
+}
+
+void vertex_convert_f16_to_f32(float *dst, const uint16_t *src, size_t count)
+{
+  size_t i = 0;
+
+#if defined(VERTEX_FORMAT_F16C)
+  for (; i + 8 <= count; i += 8) {
+    __m128i h = _mm_loadu_si128((const __m128i *)(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+#elif defined(VERTEX_FORMAT_NEON)
+  for (; i + 4 <= count; i += 4) {
+    vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+  }
+#elif defined(VERTEX_FORMAT_SSE2)
+  const __m128i mag_mask    = _mm_set1_epi32(0x7fff);
+  const __m128i shifted_exp = _mm_set1_epi32(0x7c00 << 13);
+  const __m128i rebias      = _mm_set1_epi32((127 - 15) << 23);
+  const __m128i inf_adjust  = _mm_set1_epi32((128 - 16) << 23);
+  const __m128i den_adjust  = _mm_set1_epi32(1 << 23);
+  const __m128  magic       = _mm_castsi128_ps(_mm_set1_epi32(113 << 23));
+  const __m128i zero        = _mm_setzero_si128();
+
+  for (; i + 8 <= count; i += 8) {
+    __m128i h16 = _mm_loadu_si128((const __m128i *)(src + i));
+    __m128i halves[2] = {
+      _mm_unpacklo_epi16(h16, zero),
+      _mm_unpackhi_epi16(h16, zero),
+    };
+
+    for (int j = 0; j < 2; j++) {
+      __m128i h   = halves[j];
+      __m128i o   = _mm_slli_epi32(_mm_and_si128(h, mag_mask), 13);
+      __m128i exp = _mm_and_si128(o, shifted_exp);
+      o = _mm_add_epi32(o, rebias);
+
+      __m128i is_inf = _mm_cmpeq_epi32(exp, shifted_exp);
+      __m128i is_den = _mm_cmpeq_epi32(exp, zero);
+
+      o = _mm_add_epi32(o, _mm_and_si128(is_inf, inf_adjust));
+
+      __m128 den = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(o, den_adjust)), magic);
+      o = _mm_or_si128(_mm_andnot_si128(is_den, o), _mm_and_si128(is_den, _mm_castps_si128(den)));
+      o = _mm_or_si128(o, _mm_slli_epi32(_mm_srli_epi32(h, 15), 31));
+
+      _mm_storeu_ps(dst + i + j * 4, _mm_castsi128_ps(o));
+    }
+  }
+#endif
+
+  for (; i < count; i++) dst[i] = f16_to_f32(src[i]);
+}
+
+void vertex_convert_f32_to_unorm8(uint8_t *dst, const float *src, size_t count)
+{
+  size_t i = 0;
+
+#if defined(VERTEX_FORMAT_SSE2)
+  const __m128 lo    = _mm_setzero_ps();
+  const __m128 hi    = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(255.0f);
+
+  for (; i + 16 <= count; i += 16) {
+    __m128i q[4];
+    for (int j = 0; j < 4; j++) {
+      __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + j * 4), lo), hi);
+      q[j] = _mm_cvtps_epi32(_mm_mul_ps(v, scale));
+    }
+    __m128i w0 = _mm_packs_epi32(q[0], q[1]);
+    __m128i w1 = _mm_packs_epi32(q[2], q[3]);
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(w0, w1));
+  }
+#elif defined(VERTEX_FORMAT_NEON)
+  for (; i + 8 <= count; i += 8) {
+    float32x4_t a = vminq_f32(vmaxq_f32(vld1q_f32(src + i), vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+    float32x4_t b = vminq_f32(vmaxq_f32(vld1q_f32(src + i + 4), vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+    uint32x4_t qa = vcvtnq_u32_f32(vmulq_n_f32(a, 255.0f));
+    uint32x4_t qb = vcvtnq_u32_f32(vmulq_n_f32(b, 255.0f));
+    vst1_u8(dst + i, vmovn_u16(vcombine_u16(vmovn_u32(qa), vmovn_u32(qb))));
+  }
+#endif
+
+  for (; i < count; i++) dst[i] = (uint8_t)lrintf(clampf(src[i], 0.0f, 1.0f) * 255.0f);
+}
+
+void vertex_convert_f32_to_snorm8(int8_t *dst, const float *src, size_t count)
+{
+  size_t i = 0;
+
+#if defined(VERTEX_FORMAT_SSE2)
+  const __m128 lo    = _mm_set1_ps(-1.0f);
+  const __m128 hi    = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(127.0f);
+
+  for (; i + 16 <= count; i += 16) {
+    __m128i q[4];
+    for (int j = 0; j < 4; j++) {
+      __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + j * 4), lo), hi);
+      q[j] = _mm_cvtps_epi32(_mm_mul_ps(v, scale));
+    }
+    __m128i w0 = _mm_packs_epi32(q[0], q[1]);
+    __m128i w1 = _mm_packs_epi32(q[2], q[3]);
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi16(w0, w1));
+  }
+#endif
+
+  for (; i < count; i++) dst[i] = (int8_t)snorm_quantize(src[i], 127.0f);
+}
+
+/*
+  Packs xyz triples into GL_INT_2_10_10_10_REV (x in the low bits, w = 0).
+  Quantization runs 4 wide over the flat float stream, bit packing per normal.
+*/
+void vertex_convert_f32_to_snorm10(uint32_t *dst, const float *xyz, size_t count)
+{
+  size_t i = 0;
+
+#if defined(VERTEX_FORMAT_SSE2)
+  const __m128 lo    = _mm_set1_ps(-1.0f);
+  const __m128 hi    = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(511.0f);
+  const __m128i mask = _mm_set1_epi32(0x3ff);
+
+  for (; i + 4 <= count; i += 4) {
+    int32_t q[12];
+    for (int j = 0; j < 3; j++) {
+      __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(xyz + i * 3 + j * 4), lo), hi);
+      __m128i r = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(v, scale)), mask);
+      _mm_storeu_si128((__m128i *)(q + j * 4), r);
+    }
+    for (int j = 0; j < 4; j++) {
+      dst[i + j] =
+        (uint32_t)q[j * 3 + 0] |
+        ((uint32_t)q[j * 3 + 1] << 10) |
+        ((uint32_t)q[j * 3 + 2] << 20);
+    }
+  }
+#endif
+
+  for (; i < count; i++) {
+    const float *n = xyz + i * 3;
+    dst[i] =
+      ((uint32_t)snorm_quantize(n[0], 511.0f) & 0x3ffu) |
+      (((uint32_t)snorm_quantize(n[1], 511.0f) & 0x3ffu) << 10) |
+      (((uint32_t)snorm_quantize(n[2], 511.0f) & 0x3ffu) << 20);
+  }
+}
+
+// Strided Packing
+
+#define VERTEX_PACK_CHUNK 256
+
+static inline void vertex_convert_run(VertexAttribFormat attrib, void *dst, const float *src, size_t count)
+{
+  size_t scalars = count * attrib.components;
+
+  switch (attrib.format) {
+    case VERTEX_FORMAT_FLOAT32:         memcpy(dst, src, scalars * sizeof(float));                 break;
+    case VERTEX_FORMAT_HALF16:          vertex_convert_f32_to_f16((uint16_t *)dst, src, scalars);    break;
+    case VERTEX_FORMAT_UNORM8:          vertex_convert_f32_to_unorm8((uint8_t *)dst, src, scalars);  break;
+    case VERTEX_FORMAT_SNORM8:          vertex_convert_f32_to_snorm8((int8_t *)dst, src, scalars);   break;
+    case VERTEX_FORMAT_SNORM10_10_10_2: vertex_convert_f32_to_snorm10((uint32_t *)dst, src, count);  break;
+    default: break;
+  }
+}
+
+bool vertex_attrib_pack(
+  VertexAttribFormat attrib,
+  void *dst, size_t dst_stride,
+  const float *src, size_t src_stride,
+  size_t count)
+{
+  if (attrib.format >= VERTEX_FORMAT_COUNT) return false;
+  if (attrib.components == 0 || attrib.components > 4) return false;
+  if (attrib.format == VERTEX_FORMAT_SNORM10_10_10_2 && attrib.components != 3) return false;
+
+  const size_t src_size = attrib.components * sizeof(float);
+  const size_t raw_size = vertex_attrib_raw_size(attrib);
+  const size_t padded   = vertex_attrib_size(attrib);
+
+  if (src_stride == 0) src_stride = src_size;
+  if (dst_stride == 0) dst_stride = padded;
+
+  // Tightly packed on both sides, convert in place with no staging
+  if (src_stride == src_size && dst_stride == raw_size) {
+    vertex_convert_run(attrib, dst, src, count);
+    return true;
+  }
+
+  /*
+    Interleaved destination (or strided source): gather into a contiguous
+    staging chunk so the kernels stay vectorized, then scatter per vertex.
+  */
+  float   staging_src[VERTEX_PACK_CHUNK * 4];
+  uint8_t staging_dst[VERTEX_PACK_CHUNK * 16];
+
+  const uint8_t *src_bytes = (const uint8_t *)src;
+  uint8_t *dst_bytes = (uint8_t *)dst;
+
+  for (size_t base = 0; base < count; base += VERTEX_PACK_CHUNK) {
+    size_t n = count - base;
+    if (n > VERTEX_PACK_CHUNK) n = VERTEX_PACK_CHUNK;
+
+    const float *run = (const float *)(src_bytes + base * src_stride);
+    if (src_stride != src_size) {
+      for (size_t i = 0; i < n; i++)
+        memcpy(staging_src + i * attrib.components, src_bytes + (base + i) * src_stride, src_size);
+      run = staging_src;
+    }
+
+    vertex_convert_run(attrib, staging_dst, run, n);
+
+    for (size_t i = 0; i < n; i++) {
+      uint8_t *out = dst_bytes + (base + i) * dst_stride;
+      memcpy(out, staging_dst + i * raw_size, raw_size);
+      if (padded != raw_size) memset(out + raw_size, 0, padded - raw_size);
+    }
+  }
+
+  return true;
+}
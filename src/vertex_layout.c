@@ -0,0 +1,207 @@
+#include <vertex_layout.h>
+#include <glad/glad.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define VERTEX_LAYOUT_CACHE_SIZE 64
+
+typedef struct {
+  uint64_t hash;
+  VertexLayout layout;
+  uint32_t vao;
+} VertexLayoutCacheEntry;
+
+static VertexLayoutCacheEntry layout_cache[VERTEX_LAYOUT_CACHE_SIZE];
+static uint32_t layout_cache_count = 0;
+static bool layout_cache_warned = false;
+
+void vertex_layout_init(VertexLayout *layout)
+{
+  memset(layout, 0, sizeof(*layout));
+}
+
+bool vertex_layout_add(VertexLayout *layout, uint32_t location, VertexAttribFormat format, uint32_t binding)
+{
+  if (layout->attrib_count >= VERTEX_LAYOUT_MAX_ATTRIBS) return false;
+  if (binding >= VERTEX_LAYOUT_MAX_BINDINGS) return false;
+  if (vertex_format_info(format.format) == NULL) return false;
+
+  VertexLayoutAttrib *attrib = &layout->attribs[layout->attrib_count++];
+  attrib->format   = format;
+  attrib->location = location;
+  attrib->binding  = binding;
+  attrib->offset   = layout->bindings[binding].stride;
+
+  layout->bindings[binding].stride += vertex_attrib_size(format);
+  if (binding >= layout->binding_count) layout->binding_count = binding + 1;
+
+  return true;
+}
+
+bool vertex_layout_set_divisor(VertexLayout *layout, uint32_t binding, uint32_t divisor)
+{
+  if (binding >= VERTEX_LAYOUT_MAX_BINDINGS) return false;
+  layout->bindings[binding].divisor = divisor;
+  return true;
+}
+
+bool vertex_layout_interleaved(VertexLayout *layout, const VertexAttribFormat *formats, uint32_t count)
+{
+  vertex_layout_init(layout);
+  for (uint32_t i = 0; i < count; i++)
+    if (!vertex_layout_add(layout, i, formats[i], 0)) return false;
+  return true;
+}
+
+bool vertex_layout_deinterleaved(VertexLayout *layout, const VertexAttribFormat *formats, uint32_t count)
+{
+  vertex_layout_init(layout);
+  for (uint32_t i = 0; i < count; i++)
+    if (!vertex_layout_add(layout, i, formats[i], i)) return false;
+  return true;
+}
+
+// FNV-1a over the used fields only, so padding/unused slots never matter
+static inline uint64_t hash_u32(uint64_t hash, uint32_t value)
+{
+  for (int i = 0; i < 4; i++) {
+    hash ^= (value >> (i * 8)) & 0xffu;
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+uint64_t vertex_layout_hash(const VertexLayout *layout)
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+
+  hash = hash_u32(hash, layout->attrib_count);
+  for (uint32_t i = 0; i < layout->attrib_count; i++) {
+    const VertexLayoutAttrib *a = &layout->attribs[i];
+    hash = hash_u32(hash, (uint32_t)a->format.format);
+    hash = hash_u32(hash, a->format.components);
+    hash = hash_u32(hash, a->location);
+    hash = hash_u32(hash, a->binding);
+    hash = hash_u32(hash, a->offset);
+  }
+
+  // Strides are bound with the buffer, only divisors are VAO state
+  hash = hash_u32(hash, layout->binding_count);
+  for (uint32_t i = 0; i < layout->binding_count; i++)
+    hash = hash_u32(hash, layout->bindings[i].divisor);
+
+  return hash;
+}
+
+bool vertex_layout_equal(const VertexLayout *a, const VertexLayout *b)
+{
+  if (a->attrib_count != b->attrib_count) return false;
+  if (a->binding_count != b->binding_count) return false;
+
+  for (uint32_t i = 0; i < a->attrib_count; i++) {
+    const VertexLayoutAttrib *x = &a->attribs[i];
+    const VertexLayoutAttrib *y = &b->attribs[i];
+    if (x->format.format != y->format.format ||
+        x->format.components != y->format.components ||
+        x->location != y->location ||
+        x->binding != y->binding ||
+        x->offset != y->offset) return false;
+  }
+
+  for (uint32_t i = 0; i < a->binding_count; i++)
+    if (a->bindings[i].divisor != b->bindings[i].divisor) return false;
+
+  return true;
+}
+
+bool vertex_layout_pack(
+  const VertexLayout *layout,
+  void *const *binding_dst,
+  const float *const *attrib_src,
+  const size_t *src_strides,
+  size_t vertex_count)
+{
+  for (uint32_t i = 0; i < layout->attrib_count; i++) {
+    const VertexLayoutAttrib *attrib = &layout->attribs[i];
+    uint8_t *dst = (uint8_t *)binding_dst[attrib->binding] + attrib->offset;
+
+    if (!vertex_attrib_pack(
+      attrib->format,
+      dst, layout->bindings[attrib->binding].stride,
+      attrib_src[i], src_strides ? src_strides[i] : 0,
+      vertex_count
+    )) return false;
+  }
+
+  return true;
+}
+
+static uint32_t vertex_layout_create_vao(const VertexLayout *layout)
+{
+  uint32_t vao = 0;
+  glCreateVertexArrays(1, &vao);
+
+  for (uint32_t i = 0; i < layout->attrib_count; i++) {
+    const VertexLayoutAttrib *attrib = &layout->attribs[i];
+    const VertexFormatInfo *info = vertex_format_info(attrib->format.format);
+
+    glEnableVertexArrayAttrib(vao, attrib->location);
+    glVertexArrayAttribFormat(
+      vao, attrib->location,
+      vertex_attrib_gl_size(attrib->format),
+      info->gl_type,
+      info->normalized ? GL_TRUE : GL_FALSE,
+      attrib->offset
+    );
+    glVertexArrayAttribBinding(vao, attrib->location, attrib->binding);
+  }
+
+  for (uint32_t i = 0; i < layout->binding_count; i++)
+    glVertexArrayBindingDivisor(vao, i, layout->bindings[i].divisor);
+
+  return vao;
+}
+
+uint32_t vertex_layout_vao(const VertexLayout *layout, bool *owned)
+{
+  uint64_t hash = vertex_layout_hash(layout);
+  *owned = false;
+
+  for (uint32_t i = 0; i < layout_cache_count; i++) {
+    VertexLayoutCacheEntry *entry = &layout_cache[i];
+    if (entry->hash == hash && vertex_layout_equal(&entry->layout, layout))
+      return entry->vao;
+  }
+
+  uint32_t vao = vertex_layout_create_vao(layout);
+
+  if (layout_cache_count < VERTEX_LAYOUT_CACHE_SIZE) {
+    VertexLayoutCacheEntry *entry = &layout_cache[layout_cache_count++];
+    entry->hash = hash;
+    entry->layout = *layout;
+    entry->vao = vao;
+  } else {
+    // Handed over to the caller, the cache has no slot to delete it from
+    *owned = true;
+    if (!layout_cache_warned) {
+      fprintf(stderr, "[WARNING]: Vertex layout cache full, further layouts get their own VAO\n");
+      layout_cache_warned = true;
+    }
+  }
+
+  return vao;
+}
+
+void vertex_layout_bind_buffer(uint32_t vao, const VertexLayout *layout, uint32_t binding, uint32_t buffer, size_t offset)
+{
+  glVertexArrayVertexBuffer(vao, binding, buffer, (GLintptr)offset, layout->bindings[binding].stride);
+}
+
+void vertex_layout_cache_clear(void)
+{
+  for (uint32_t i = 0; i < layout_cache_count; i++)
+    glDeleteVertexArrays(1, &layout_cache[i].vao);
+  layout_cache_count = 0;
+  layout_cache_warned = false;
+}
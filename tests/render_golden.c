@@ -0,0 +1,465 @@
+/*
+  Golden image regression tests for the render paths. Every case draws
+  the benchmark scene from a fixed camera into a hidden window, reads the
+  back buffer and compares it with tests/golden/<case>.png:
+    - a pixel differs when any channel is more than GOLDEN_CHANNEL_TOLERANCE
+      away, a case fails past GOLDEN_MAX_DIFF_FRACTION differing pixels, so
+      rasterization differences along edges don't fail it;
+    - cases that only change how the frame is produced (culling, the BVH,
+      GPU driven draws) must also match the image of their reference case;
+    - failures leave <case>.png and <case>.diff.png in the output directory.
+  The scene goes through a frame graph, a synthetic graph then checks what
+  its chain doesn't reach (aliasing, culling, image store barriers).
+  Goldens are rendered by Mesa's llvmpipe (see `make test`), other drivers
+  may differ past the tolerance. --update rewrites them from this run.
+  Usage: render_golden [--golden DIR] [--output DIR] [--update]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb_image.h>
+
+#include <scene.h>
+#include <threading.h>
+#include <image_write.h>
+#include <render_target.h>
+#include <render_scale.h>
+#include <frame_graph.h>
+
+#define GOLDEN_WIDTH              320
+#define GOLDEN_HEIGHT             240
+#define GOLDEN_GRID_SIZE          24
+#define GOLDEN_TIME               2.0f   // Camera position along the orbit, in seconds
+#define GOLDEN_FRAMES             3      // The GPU path occludes with the previous frame's depth
+#define GOLDEN_CHANNEL_TOLERANCE  8
+#define GOLDEN_MAX_DIFF_FRACTION  0.005
+#define GOLDEN_PATH_MAX           1024
+#define GRAPH_CHECK_SIZE          64
+
+typedef struct {
+  const char *name;
+  uint32_t flags;
+  float render_scale;       // 0 renders at the output size
+  RenderUpscale upscale;
+  const char *reference;    // Case whose image this one must match, NULL if none
+} GoldenCase;
+
+static const GoldenCase golden_cases[] = {
+  {"none", 0, 0.0f, RENDER_UPSCALE_BILINEAR, NULL},
+  {"lod", SCENE_DRAW_LOD, 0.0f, RENDER_UPSCALE_BILINEAR, NULL},
+  {"cull+lod", SCENE_DRAW_CULL | SCENE_DRAW_LOD, 0.0f, RENDER_UPSCALE_BILINEAR, "lod"},
+  {"bvh-cull+lod", SCENE_DRAW_CULL | SCENE_DRAW_BVH | SCENE_DRAW_LOD, 0.0f, RENDER_UPSCALE_BILINEAR, "lod"},
+  {"gpu-cull+lod", SCENE_DRAW_GPU | SCENE_DRAW_LOD, 0.0f, RENDER_UPSCALE_BILINEAR, "lod"},
+  {"dynres-bilinear", SCENE_DRAW_CULL | SCENE_DRAW_LOD, 0.5f, RENDER_UPSCALE_BILINEAR, NULL},
+  {"dynres-sharpen", SCENE_DRAW_CULL | SCENE_DRAW_LOD, 0.5f, RENDER_UPSCALE_SHARPEN, NULL},
+};
+
+#define GOLDEN_CASES (sizeof(golden_cases) / sizeof(golden_cases[0]))
+
+typedef struct {
+  const char *golden_dir;
+  const char *output_dir;
+  bool update;
+} Options;
+
+typedef struct {
+  uint32_t differing;
+  uint32_t max_delta;
+} ImageDiff;
+
+static bool parse_options(Options *options, int argc, char **argv)
+{
+  options->golden_dir = "tests/golden";
+  options->output_dir = "build/tests";
+  options->update = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+      options->golden_dir = argv[++i];
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      options->output_dir = argv[++i];
+    } else if (strcmp(argv[i], "--update") == 0) {
+      options->update = true;
+    } else {
+      fprintf(stderr, "[ERROR]: Unknown option \"%s\"\n", argv[i]);
+      fprintf(stderr, "Usage: %s [--golden DIR] [--output DIR] [--update]\n", argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool golden_path(char *path, const char *dir, const char *name, const char *suffix)
+{
+  int length = snprintf(path, GOLDEN_PATH_MAX, "%s/%s%s", dir, name, suffix);
+  if (length < 0 || length >= GOLDEN_PATH_MAX) {
+    fprintf(stderr, "[ERROR]: Path too long for \"%s\"\n", name);
+    return false;
+  }
+  return true;
+}
+
+// Back buffer to top down RGBA rows, the layout image files use
+static void read_back(uint8_t *pixels, uint8_t *scratch, int32_t width, int32_t height)
+{
+  size_t stride = (size_t)width * 4;
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, scratch);
+
+  for (int32_t y = 0; y < height; y++)
+    memcpy(pixels + (size_t)y * stride, scratch + (size_t)(height - 1 - y) * stride, stride);
+}
+
+static ImageDiff image_diff(const uint8_t *a, const uint8_t *b, uint8_t *visual, int32_t width, int32_t height)
+{
+  ImageDiff diff = {0};
+
+  for (size_t i = 0; i < (size_t)width * height; i++) {
+    const uint8_t *pa = a + i * 4;
+    const uint8_t *pb = b + i * 4;
+
+    uint32_t delta = 0;
+    for (uint32_t c = 0; c < 3; c++) {
+      uint32_t d = pa[c] > pb[c] ? pa[c] - pb[c] : pb[c] - pa[c];
+      if (d > delta) delta = d;
+    }
+    if (delta > diff.max_delta) diff.max_delta = delta;
+
+    // Differing pixels in red over a dimmed copy of the expected image
+    bool differs = delta > GOLDEN_CHANNEL_TOLERANCE;
+    if (differs) diff.differing++;
+    if (visual != NULL) {
+      uint8_t gray = (uint8_t)((pb[0] + pb[1] + pb[2]) / 12);
+      visual[i * 4 + 0] = differs ? 255 : gray;
+      visual[i * 4 + 1] = differs ? 0 : gray;
+      visual[i * 4 + 2] = differs ? 0 : gray;
+      visual[i * 4 + 3] = 255;
+    }
+  }
+
+  return diff;
+}
+
+static inline bool image_diff_passes(ImageDiff diff, int32_t width, int32_t height)
+{
+  return diff.differing <= (uint32_t)(GOLDEN_MAX_DIFF_FRACTION * width * height);
+}
+
+static void report_diff(const char *name, const char *against, ImageDiff diff, int32_t width, int32_t height, bool passed)
+{
+  fprintf(passed ? stdout : stderr,
+    "%s: %-16s vs %-14s %6u pixel(s) differ (%.3f%%), max delta %u\n",
+    passed ? "[INFO]" : "[ERROR]", name, against,
+    diff.differing, 100.0 * diff.differing / ((double)width * height), diff.max_delta);
+}
+
+static bool render_case(Scene *scene, RenderTexturePool *textures, const GoldenCase *test, int32_t width, int32_t height)
+{
+  RenderScale scale;
+  if (test->render_scale > 0.0f) {
+    // No budget keeps the controller still, the scale is pinned by hand
+    if (!render_scale_init(&scale, 0.0, test->upscale)) return false;
+    scale.scale = scale.min_scale = scale.max_scale = test->render_scale;
+    scene->scale = &scale;
+  }
+
+  scene_update(scene, GOLDEN_TIME, width, height);
+  for (uint32_t frame = 0; frame < GOLDEN_FRAMES; frame++) {
+    glViewport(0, 0, width, height);
+    scene_draw(scene, test->flags, NULL);
+    render_texture_pool_frame(textures);
+  }
+  glFinish();
+
+  if (scene->scale != NULL) {
+    render_scale_destroy(&scale);
+    scene->scale = NULL;
+  }
+
+  GLenum error = glGetError();
+  if (error != GL_NO_ERROR) {
+    fprintf(stderr, "[ERROR]: %s: GL error 0x%04x\n", test->name, error);
+    return false;
+  }
+  return true;
+}
+
+static bool check_golden(ImageWriter *writer, const Options *options, const GoldenCase *test,
+                         const uint8_t *pixels, uint8_t *visual, int32_t width, int32_t height)
+{
+  char path[GOLDEN_PATH_MAX];
+  if (!golden_path(path, options->golden_dir, test->name, ".png")) return false;
+
+  if (options->update) {
+    if (!image_write_png(writer, path, width, height, pixels, (size_t)width * 4, false)) return false;
+    printf("[INFO]: %-16s golden written to %s\n", test->name, path);
+    return true;
+  }
+
+  int golden_width, golden_height, channels;
+  uint8_t *golden = stbi_load(path, &golden_width, &golden_height, &channels, 4);
+  if (golden == NULL) {
+    fprintf(stderr, "[ERROR]: %s: could not load %s (%s), run with --update to create it\n",
+      test->name, path, stbi_failure_reason());
+    return false;
+  }
+
+  bool passed = golden_width == width && golden_height == height;
+  if (!passed) {
+    fprintf(stderr, "[ERROR]: %s: golden is %dx%d, rendered %dx%d\n",
+      test->name, golden_width, golden_height, width, height);
+  } else {
+    ImageDiff diff = image_diff(pixels, golden, visual, width, height);
+    passed = image_diff_passes(diff, width, height);
+    report_diff(test->name, "golden", diff, width, height, passed);
+  }
+  stbi_image_free(golden);
+
+  if (!passed) {
+    bool written = golden_path(path, options->output_dir, test->name, ".png") &&
+      image_write_png(writer, path, width, height, pixels, (size_t)width * 4, false);
+    if (written && golden_width == width && golden_height == height) {
+      written = golden_path(path, options->output_dir, test->name, ".diff.png") &&
+        image_write_png(writer, path, width, height, visual, (size_t)width * 4, false);
+    }
+    if (written) fprintf(stderr, "  - Rendered image and diff written to %s\n", options->output_dir);
+  }
+  return passed;
+}
+
+static const GoldenCase *find_case(const char *name, uint32_t *index)
+{
+  for (uint32_t i = 0; i < GOLDEN_CASES; i++) {
+    if (strcmp(golden_cases[i].name, name) == 0) {
+      *index = i;
+      return &golden_cases[i];
+    }
+  }
+  return NULL;
+}
+
+static uint32_t run_cases(Scene *scene, RenderTexturePool *textures, const Options *options, int32_t width, int32_t height)
+{
+  size_t image_size = (size_t)width * height * 4;
+  uint8_t *images = malloc(image_size * GOLDEN_CASES);
+  uint8_t *scratch = malloc(image_size);
+  uint8_t *visual = malloc(image_size);
+  if (images == NULL || scratch == NULL || visual == NULL) {
+    fprintf(stderr, "[ERROR]: Out of memory\n");
+    free(images);
+    free(scratch);
+    free(visual);
+    return GOLDEN_CASES;
+  }
+
+  ImageWriter writer;
+  image_writer_init(&writer);
+
+  bool rendered[GOLDEN_CASES] = {0};
+  uint32_t failures = 0;
+
+  for (uint32_t i = 0; i < GOLDEN_CASES; i++) {
+    const GoldenCase *test = &golden_cases[i];
+    uint8_t *pixels = images + image_size * i;
+
+    if (!render_case(scene, textures, test, width, height)) {
+      failures++;
+      continue;
+    }
+    read_back(pixels, scratch, width, height);
+    rendered[i] = true;
+
+    if (!check_golden(&writer, options, test, pixels, visual, width, height)) failures++;
+
+    // Golden or not, these paths must not change the image
+    uint32_t reference = 0;
+    if (test->reference != NULL && find_case(test->reference, &reference) != NULL && rendered[reference]) {
+      ImageDiff diff = image_diff(pixels, images + image_size * reference, NULL, width, height);
+      bool passed = image_diff_passes(diff, width, height);
+      report_diff(test->name, test->reference, diff, width, height, passed);
+      if (!passed) failures++;
+    }
+  }
+
+  image_writer_free(&writer);
+  free(images);
+  free(scratch);
+  free(visual);
+  return failures;
+}
+
+typedef struct {
+  const char *order[FRAME_GRAPH_MAX_PASSES];  // Pass names as they ran
+  uint32_t order_count;
+  uint32_t written[FRAME_GRAPH_MAX_RESOURCES]; // Physical texture each transient was written to
+} GraphCheck;
+
+static void graph_check_pass(const FrameGraph *graph, uint32_t pass, void *user)
+{
+  GraphCheck *check = user;
+  const FrameGraphPass *p = &graph->passes[pass];
+  check->order[check->order_count++] = p->name;
+
+  for (uint32_t i = 0; i < p->use_count; i++)
+    if (p->uses[i].write) check->written[p->uses[i].resource] = frame_graph_texture(graph, p->uses[i].resource);
+}
+
+/*
+  image -> first -> second -> third -> output, declared backwards, plus a
+  pass whose result nothing reads. "third" writes a transient of the same
+  format and size as "first" once it is dead, so they share a texture, and
+  "first" samples what "image" stored through image writes, so a barrier
+  goes in before it. "unused" is culled.
+*/
+static bool check_frame_graph(RenderTexturePool *textures)
+{
+  static const char *expected[] = {"image", "first", "second", "third", "output"};
+  const int32_t size = GRAPH_CHECK_SIZE;
+
+  uint32_t target = render_texture_acquire(textures, GL_RGBA8, size, size);
+  if (target == 0) return false;
+
+  FrameGraph graph;
+  GraphCheck check = {0};
+  frame_graph_init(&graph);
+
+  uint32_t output = frame_graph_import_texture(&graph, "target", target, GL_RGBA8, size, size);
+  uint32_t stored = frame_graph_create_texture(&graph, "stored", GL_R32F, size, size);
+  uint32_t a = frame_graph_create_texture(&graph, "a", GL_RGBA8, size, size);
+  uint32_t b = frame_graph_create_texture(&graph, "b", GL_RGBA16F, size, size);
+  uint32_t c = frame_graph_create_texture(&graph, "c", GL_RGBA8, size, size);
+  uint32_t spare = frame_graph_create_texture(&graph, "spare", GL_RGBA8, size, size);
+
+  uint32_t pass = frame_graph_add_pass(&graph, "output", 0, graph_check_pass, &check);
+  frame_graph_read(&graph, pass, c, FRAME_GRAPH_TRANSFER);
+  frame_graph_write(&graph, pass, output, FRAME_GRAPH_TRANSFER);
+
+  pass = frame_graph_add_pass(&graph, "third", 0, graph_check_pass, &check);
+  frame_graph_read(&graph, pass, b, FRAME_GRAPH_SAMPLED);
+  frame_graph_write(&graph, pass, c, FRAME_GRAPH_ATTACHMENT);
+
+  pass = frame_graph_add_pass(&graph, "unused", 0, graph_check_pass, &check);
+  frame_graph_read(&graph, pass, a, FRAME_GRAPH_SAMPLED);
+  frame_graph_write(&graph, pass, spare, FRAME_GRAPH_ATTACHMENT);
+
+  pass = frame_graph_add_pass(&graph, "second", 0, graph_check_pass, &check);
+  frame_graph_read(&graph, pass, a, FRAME_GRAPH_SAMPLED);
+  frame_graph_write(&graph, pass, b, FRAME_GRAPH_ATTACHMENT);
+
+  pass = frame_graph_add_pass(&graph, "first", 0, graph_check_pass, &check);
+  frame_graph_read(&graph, pass, stored, FRAME_GRAPH_SAMPLED);
+  frame_graph_write(&graph, pass, a, FRAME_GRAPH_ATTACHMENT);
+
+  pass = frame_graph_add_pass(&graph, "image", 0, graph_check_pass, &check);
+  frame_graph_write(&graph, pass, stored, FRAME_GRAPH_IMAGE);
+
+  bool ok = frame_graph_compile(&graph) && frame_graph_execute(&graph, textures);
+  if (!ok) fprintf(stderr, "[ERROR]: frame graph: compile or execute failed\n");
+
+  bool ordered = ok && check.order_count == sizeof(expected) / sizeof(expected[0]);
+  for (uint32_t i = 0; ordered && i < check.order_count; i++) ordered = strcmp(check.order[i], expected[i]) == 0;
+  if (ok && !ordered) {
+    fprintf(stderr, "[ERROR]: frame graph: passes ran as");
+    for (uint32_t i = 0; i < check.order_count; i++) fprintf(stderr, " %s", check.order[i]);
+    fprintf(stderr, "\n");
+    ok = false;
+  }
+
+  const FrameGraphStats *stats = &graph.stats;
+  if (ok && (stats->passes != 5 || stats->culled != 1 || stats->barriers != 1)) {
+    fprintf(stderr, "[ERROR]: frame graph: %u passes, %u culled, %u barriers, expected 5, 1 and 1\n",
+      stats->passes, stats->culled, stats->barriers);
+    ok = false;
+  }
+  if (ok && (stats->transients != 4 || stats->textures != 3 || check.written[c] != check.written[a])) {
+    fprintf(stderr, "[ERROR]: frame graph: %u transients on %u textures, \"c\" %s \"a\", expected 4 on 3 aliased\n",
+      stats->transients, stats->textures, check.written[c] == check.written[a] ? "aliases" : "doesn't alias");
+    ok = false;
+  }
+
+  GLenum error = glGetError();
+  if (error != GL_NO_ERROR) {
+    fprintf(stderr, "[ERROR]: frame graph: GL error 0x%04x\n", error);
+    ok = false;
+  }
+
+  if (ok) printf("[INFO]: frame graph: ordered, 1 pass culled, 1 barrier, 4 transients on 3 textures\n");
+  frame_graph_destroy(&graph);
+  render_texture_release(textures, target);
+  return ok;
+}
+
+static void glfw_error_cb(int error, const char *description)
+{
+  fprintf(stderr, "[ERROR]: GLFW error %d: %s\n", error, description);
+}
+
+int main(int argc, char **argv)
+{
+  Options options;
+  if (!parse_options(&options, argc, argv)) return EXIT_FAILURE;
+
+  glfwSetErrorCallback(glfw_error_cb);
+  if (!glfwInit()) return EXIT_FAILURE;
+
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+
+  GLFWwindow *window = glfwCreateWindow(GOLDEN_WIDTH, GOLDEN_HEIGHT, "render_golden", NULL, NULL);
+  if (window == NULL) {
+    glfwTerminate();
+    return EXIT_FAILURE;
+  }
+  glfwMakeContextCurrent(window);
+
+  if (gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) == 0) {
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return EXIT_FAILURE;
+  }
+
+  const char *renderer = (const char *)glGetString(GL_RENDERER);
+  printf("[INFO]: Rendering goldens on %s (OpenGL %d.%d)\n", renderer, GLVersion.major, GLVersion.minor);
+  if (strstr(renderer, "llvmpipe") == NULL)
+    printf("[WARNING]: Goldens come from llvmpipe, this driver may not match within tolerance\n");
+
+  int32_t width, height;
+  glfwGetFramebufferSize(window, &width, &height);
+
+  // Workers record the draws, so the multi-buffer queue merge is covered too
+  ThreadPool *pool = thread_pool_create(0);
+  RenderTexturePool textures;
+  render_texture_pool_init(&textures);
+
+  uint32_t failures = GOLDEN_CASES;
+  Scene scene;
+  if (pool != NULL && scene_create(&scene, GOLDEN_GRID_SIZE, pool, &textures)) {
+    failures = run_cases(&scene, &textures, &options, width, height);
+    if (!check_frame_graph(&textures)) failures++;
+    scene_destroy(&scene);
+  } else {
+    fprintf(stderr, "[ERROR]: Scene creation failed\n");
+  }
+
+  render_texture_pool_destroy(&textures);
+  if (pool != NULL) thread_pool_destroy(pool);
+  glfwDestroyWindow(window);
+  glfwTerminate();
+
+  if (failures > 0) {
+    fprintf(stderr, "[ERROR]: %u golden check(s) failed\n", failures);
+    return EXIT_FAILURE;
+  }
+  printf("[INFO]: All %u golden case(s) passed\n", (uint32_t)GOLDEN_CASES);
+  return 0;
+}
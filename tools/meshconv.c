@@ -0,0 +1,346 @@
+/*
+  meshconv: converts Wavefront OBJ files into the binary .mesh container.
+  Geometry is packed into compact vertex formats, welded and reordered
+  for the vertex cache offline so loading is a straight upload.
+
+  Usage: meshconv <input.obj> <output.mesh> [--half-positions] [--deinterleave] [--no-lods]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+#include <mesh.h>
+#include <mesh_file.h>
+#include <mesh_optimizer.h>
+#include <vertex_layout.h>
+
+typedef struct {
+  float *data;
+  size_t count;
+  size_t capacity;
+} FloatArray;
+
+typedef struct {
+  FloatArray positions;  // xyz
+  FloatArray normals;    // xyz
+  FloatArray texcoords;  // uv
+  // Per triangle corner, unindexed
+  FloatArray corner_positions;
+  FloatArray corner_normals;
+  FloatArray corner_texcoords;
+} ObjData;
+
+static bool float_array_push(FloatArray *array, const float *values, size_t count)
+{
+  if (array->count + count > array->capacity) {
+    size_t capacity = array->capacity ? array->capacity * 2 : 1024;
+    while (capacity < array->count + count) capacity *= 2;
+
+    float *data = realloc(array->data, capacity * sizeof(float));
+    if (data == NULL) return false;
+
+    array->data = data;
+    array->capacity = capacity;
+  }
+
+  memcpy(array->data + array->count, values, count * sizeof(float));
+  array->count += count;
+  return true;
+}
+
+static char *read_file(const char *path, size_t *size)
+{
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) return NULL;
+
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  char *text = malloc((size_t)length + 1);
+  if (text != NULL && fread(text, 1, (size_t)length, file) == (size_t)length) {
+    text[length] = '\0';
+    *size = (size_t)length;
+  } else {
+    free(text);
+    text = NULL;
+  }
+
+  fclose(file);
+  return text;
+}
+
+// Resolves 1 based (or negative, relative) OBJ indices, -1 when absent
+static long obj_index(const char **cursor, size_t count)
+{
+  char *end = NULL;
+  long index = strtol(*cursor, &end, 10);
+  if (end == *cursor) return -1;
+  *cursor = end;
+
+  if (index < 0) index += (long)count;
+  else index -= 1;
+
+  return (index >= 0 && (size_t)index < count) ? index : -1;
+}
+
+typedef struct {
+  long v, t, n;
+} ObjCorner;
+
+static bool obj_parse_corner(const char **cursor, const ObjData *obj, ObjCorner *corner)
+{
+  corner->v = obj_index(cursor, obj->positions.count / 3);
+  corner->t = -1;
+  corner->n = -1;
+  if (corner->v < 0) return false;
+
+  if (**cursor == '/') {
+    (*cursor)++;
+    if (**cursor != '/') corner->t = obj_index(cursor, obj->texcoords.count / 2);
+    if (**cursor == '/') {
+      (*cursor)++;
+      corner->n = obj_index(cursor, obj->normals.count / 3);
+    }
+  }
+
+  return true;
+}
+
+static bool obj_emit_corner(ObjData *obj, const ObjCorner *corner)
+{
+  static const float zero[3] = {0.0f, 0.0f, 0.0f};
+
+  return
+    float_array_push(&obj->corner_positions, obj->positions.data + corner->v * 3, 3) &&
+    float_array_push(&obj->corner_normals, corner->n >= 0 ? obj->normals.data + corner->n * 3 : zero, 3) &&
+    float_array_push(&obj->corner_texcoords, corner->t >= 0 ? obj->texcoords.data + corner->t * 2 : zero, 2);
+}
+
+static bool obj_parse(ObjData *obj, char *text)
+{
+  size_t line_number = 0;
+  char *line = text;
+
+  while (line != NULL && *line != '\0') {
+    char *next = strchr(line, '\n');
+    if (next != NULL) *next++ = '\0';
+    line_number++;
+
+    const char *cursor = line;
+    float values[3] = {0.0f, 0.0f, 0.0f};
+
+    if (strncmp(cursor, "v ", 2) == 0) {
+      sscanf(cursor + 2, "%f %f %f", &values[0], &values[1], &values[2]);
+      if (!float_array_push(&obj->positions, values, 3)) return false;
+    } else if (strncmp(cursor, "vn ", 3) == 0) {
+      sscanf(cursor + 3, "%f %f %f", &values[0], &values[1], &values[2]);
+      if (!float_array_push(&obj->normals, values, 3)) return false;
+    } else if (strncmp(cursor, "vt ", 3) == 0) {
+      sscanf(cursor + 3, "%f %f", &values[0], &values[1]);
+      if (!float_array_push(&obj->texcoords, values, 2)) return false;
+    } else if (strncmp(cursor, "f ", 2) == 0) {
+      // Polygons are triangulated as fans around the first corner
+      ObjCorner first, previous, current;
+      uint32_t corners = 0;
+      cursor += 2;
+
+      while (*cursor != '\0') {
+        while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r') cursor++;
+        if (*cursor == '\0') break;
+
+        if (!obj_parse_corner(&cursor, obj, &current)) {
+          fprintf(stderr, "[ERROR]: Invalid face at line %zu\n", line_number);
+          return false;
+        }
+
+        if (corners == 0) first = current;
+        if (corners >= 2) {
+          if (!obj_emit_corner(obj, &first) ||
+              !obj_emit_corner(obj, &previous) ||
+              !obj_emit_corner(obj, &current)) return false;
+        }
+
+        previous = current;
+        corners++;
+      }
+    }
+
+    line = next;
+  }
+
+  return true;
+}
+
+static void obj_free(ObjData *obj)
+{
+  free(obj->positions.data);
+  free(obj->normals.data);
+  free(obj->texcoords.data);
+  free(obj->corner_positions.data);
+  free(obj->corner_normals.data);
+  free(obj->corner_texcoords.data);
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 3) {
+    fprintf(stderr, "Usage: %s <input.obj> <output.mesh> [--half-positions] [--deinterleave] [--no-lods]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  bool half_positions = false;
+  bool deinterleave = false;
+  bool lods = true;
+  for (int i = 3; i < argc; i++) {
+    if (strcmp(argv[i], "--half-positions") == 0) half_positions = true;
+    else if (strcmp(argv[i], "--deinterleave") == 0) deinterleave = true;
+    else if (strcmp(argv[i], "--no-lods") == 0) lods = false;
+    else {
+      fprintf(stderr, "[ERROR]: Unknown option \"%s\"\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  size_t text_size = 0;
+  char *text = read_file(argv[1], &text_size);
+  if (text == NULL) {
+    fprintf(stderr, "[ERROR]: Could not read \"%s\"\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  ObjData obj;
+  memset(&obj, 0, sizeof(obj));
+  bool parsed = obj_parse(&obj, text);
+  free(text);
+
+  uint32_t corner_count = (uint32_t)(obj.corner_positions.count / 3);
+  if (!parsed || corner_count == 0) {
+    fprintf(stderr, "[ERROR]: No triangles found in \"%s\"\n", argv[1]);
+    obj_free(&obj);
+    return EXIT_FAILURE;
+  }
+
+  // Pick the attributes present in the source and their compact formats
+  VertexAttribFormat formats[3];
+  const float *sources[3];
+  uint32_t locations[3];
+  uint32_t attrib_count = 0;
+
+  formats[attrib_count] = (VertexAttribFormat){half_positions ? VERTEX_FORMAT_HALF16 : VERTEX_FORMAT_FLOAT32, 3};
+  sources[attrib_count] = obj.corner_positions.data;
+  locations[attrib_count++] = MESH_ATTRIB_POSITION;
+
+  if (obj.normals.count > 0) {
+    formats[attrib_count] = (VertexAttribFormat){VERTEX_FORMAT_SNORM10_10_10_2, 3};
+    sources[attrib_count] = obj.corner_normals.data;
+    locations[attrib_count++] = MESH_ATTRIB_NORMAL;
+  }
+
+  if (obj.texcoords.count > 0) {
+    formats[attrib_count] = (VertexAttribFormat){VERTEX_FORMAT_HALF16, 2};
+    sources[attrib_count] = obj.corner_texcoords.data;
+    locations[attrib_count++] = MESH_ATTRIB_TEXCOORD;
+  }
+
+  VertexLayout layout;
+  vertex_layout_init(&layout);
+  for (uint32_t i = 0; i < attrib_count; i++)
+    vertex_layout_add(&layout, locations[i], formats[i], deinterleave ? i : 0);
+
+  void *blobs[VERTEX_LAYOUT_MAX_BINDINGS] = {NULL};
+  MeshStream streams[VERTEX_LAYOUT_MAX_BINDINGS + 1];
+  uint32_t *indices = malloc(corner_count * sizeof(uint32_t));
+  uint32_t lod_capacity = corner_count * 4;
+  uint32_t *lod_indices = lods ? malloc((size_t)lod_capacity * sizeof(uint32_t)) : NULL;
+  int result = EXIT_FAILURE;
+
+  if (indices == NULL || (lods && lod_indices == NULL)) goto cleanup;
+
+  for (uint32_t i = 0; i < layout.binding_count; i++) {
+    uint32_t stride = layout.bindings[i].stride;
+    blobs[i] = malloc((size_t)stride * corner_count);
+    if (blobs[i] == NULL) goto cleanup;
+    streams[i] = (MeshStream){blobs[i], stride, stride};
+  }
+
+  // Full precision positions ride along so the simplifier sees the final vertex order
+  streams[layout.binding_count] = (MeshStream){obj.corner_positions.data, 3 * sizeof(float), 3 * sizeof(float)};
+
+  if (!vertex_layout_pack(&layout, blobs, sources, NULL, corner_count)) goto cleanup;
+
+  for (uint32_t i = 0; i < corner_count; i++) indices[i] = i;
+
+  MeshOptimizeStats stats;
+  uint32_t vertex_count = mesh_optimize(streams, layout.binding_count + 1, corner_count, indices, corner_count, &stats);
+  if (vertex_count == 0) goto cleanup;
+
+  MeshFileData data = {
+    .layout = &layout,
+    .vertices = (const void *const *)blobs,
+    .vertex_count = vertex_count,
+    .indices = indices,
+    .index_count = corner_count,
+    .bounds_min = {FLT_MAX, FLT_MAX, FLT_MAX},
+    .bounds_max = {-FLT_MAX, -FLT_MAX, -FLT_MAX},
+  };
+
+  for (uint32_t i = 0; i < vertex_count; i++) {
+    const float *p = obj.corner_positions.data + i * 3;
+    for (int k = 0; k < 3; k++) {
+      if (p[k] < data.bounds_min[k]) data.bounds_min[k] = p[k];
+      if (p[k] > data.bounds_max[k]) data.bounds_max[k] = p[k];
+    }
+  }
+
+  MeshLodRange lod_ranges[MESH_MAX_LODS];
+  if (lods) {
+    float extent = 0.0f;
+    for (int k = 0; k < 3; k++) {
+      float size = data.bounds_max[k] - data.bounds_min[k];
+      if (size > extent) extent = size;
+    }
+
+    data.lod_count = mesh_build_lods(
+      lod_indices, lod_capacity, lod_ranges, MESH_MAX_LODS,
+      indices, corner_count,
+      obj.corner_positions.data, 3 * sizeof(float), vertex_count,
+      0.5f, extent * 0.25f
+    );
+    if (data.lod_count == 0) goto cleanup;
+
+    data.lods = lod_ranges;
+    data.indices = lod_indices;
+    data.index_count = lod_ranges[data.lod_count - 1].index_offset + lod_ranges[data.lod_count - 1].index_count;
+  }
+
+  if (!mesh_file_write(argv[2], &data)) goto cleanup;
+
+  printf(
+    "[INFO]: %s -> %s\n"
+    "  - Triangles : %u\n"
+    "  - Vertices  : %u -> %u\n"
+    "  - ACMR      : %.3f -> %.3f\n"
+    "  - Layout    : %s, %u bindings\n",
+    argv[1], argv[2],
+    corner_count / 3,
+    stats.vertices_before, stats.vertices_after,
+    stats.acmr_before, stats.acmr_after,
+    deinterleave ? "deinterleaved" : "interleaved", layout.binding_count
+  );
+
+  for (uint32_t i = 0; lods && i < data.lod_count; i++)
+    printf("  - LOD %u     : %u triangles, error %g\n", i, lod_ranges[i].index_count / 3, lod_ranges[i].error);
+
+  result = EXIT_SUCCESS;
+
+cleanup:
+  if (result != EXIT_SUCCESS) fprintf(stderr, "[ERROR]: Conversion failed\n");
+  for (uint32_t i = 0; i < VERTEX_LAYOUT_MAX_BINDINGS; i++) free(blobs[i]);
+  free(indices);
+  free(lod_indices);
+  obj_free(&obj);
+  return result;
+}